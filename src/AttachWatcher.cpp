@@ -0,0 +1,170 @@
+#include "AttachWatcher.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+/**
+ * @brief open_proc_connector subscribes to the kernel's process events
+ * @return the socket or -1 if not permitted
+ */
+int open_proc_connector() {
+    int fd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    if (fd < 0) {
+        return -1;
+    }
+    sockaddr_nl address{};
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = CN_IDX_PROC;
+    if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    alignas(nlmsghdr) char buffer[NLMSG_SPACE(sizeof(cn_msg) + sizeof(proc_cn_mcast_op))] = {};
+    auto *header = reinterpret_cast<nlmsghdr *>(buffer);
+    header->nlmsg_len = NLMSG_LENGTH(sizeof(cn_msg) + sizeof(proc_cn_mcast_op));
+    header->nlmsg_type = NLMSG_DONE;
+    auto *message = static_cast<cn_msg *>(NLMSG_DATA(header));
+    message->id.idx = CN_IDX_PROC;
+    message->id.val = CN_VAL_PROC;
+    message->len = sizeof(proc_cn_mcast_op);
+    const proc_cn_mcast_op op = PROC_CN_MCAST_LISTEN;
+    std::memcpy(message->data, &op, sizeof(op));
+    if (send(fd, header, header->nlmsg_len, 0) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+}
+
+std::optional<attach_rule> attach_rule::make(const std::string &pattern, bool cmdline) {
+    try {
+        return attach_rule{pattern, cmdline, std::regex(pattern, std::regex::ECMAScript)};
+    } catch (const std::regex_error &e) {
+        fprintf(stderr, "Invalid attach rule %s: %s\n", pattern.c_str(), e.what());
+        return std::nullopt;
+    }
+}
+
+bool attach_rule::matches(const process_info &info) const {
+    return std::regex_search(cmdline ? info.cmdline : info.comm, compiled);
+}
+
+AttachWatcher::~AttachWatcher() {
+    stop();
+}
+
+void AttachWatcher::start(std::vector<attach_rule> rules, callback on_match,
+                          std::chrono::milliseconds interval) {
+    stop();
+    rules_ = std::move(rules);
+    on_match_ = std::move(on_match);
+    interval_ = interval;
+    seen_.clear();
+    stop_ = false;
+    thread_ = std::thread(&AttachWatcher::run, this);
+}
+
+void AttachWatcher::stop() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    stop_ = true;
+    thread_.join();
+}
+
+bool AttachWatcher::check(pid_t pid) {
+    process_info info{};
+    if (!read_process_info(-1, pid, info)) {
+        return false;
+    }
+    for (const attach_rule &rule : rules_) {
+        if (rule.matches(info)) {
+            on_match_(info);
+            return true;
+        }
+    }
+    return false;
+}
+
+void AttachWatcher::poll_proc() {
+    std::vector<pid_t> pids = list_pids();
+    std::unordered_map<pid_t, unsigned> current;
+    current.reserve(pids.size());
+    for (pid_t pid : pids) {
+        if (stop_) {
+            return;
+        }
+        // Exited pids are dropped, they may come back as another process
+        auto it = seen_.find(pid);
+        unsigned polls = it != seen_.end() ? it->second : 0;
+        if (polls < recheck_polls) {
+            polls = check(pid) ? recheck_polls : polls + 1;
+        }
+        current.emplace(pid, polls);
+    }
+    seen_ = std::move(current);
+}
+
+void AttachWatcher::watch_netlink(int fd) {
+    alignas(nlmsghdr) char buffer[4096];
+    while (!stop_) {
+        pollfd pfd{fd, POLLIN, 0};
+        // The timeout only bounds how long stop() waits
+        if (poll(&pfd, 1, 100) <= 0) {
+            continue;
+        }
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n < 0) {
+            if (errno == ENOBUFS) {
+                // Events were dropped, catch up by listing /proc
+                poll_proc();
+            }
+            continue;
+        }
+        for (auto *header = reinterpret_cast<nlmsghdr *>(buffer);
+             NLMSG_OK(header, static_cast<unsigned>(n));
+             header = NLMSG_NEXT(header, n)) {
+            auto *message = static_cast<cn_msg *>(NLMSG_DATA(header));
+            auto *event = reinterpret_cast<proc_event *>(message->data);
+            // A new program or a renamed one, comm is final either way
+            if (event->what == proc_event::PROC_EVENT_EXEC) {
+                check(event->event_data.exec.process_tgid);
+            } else if (event->what == proc_event::PROC_EVENT_COMM &&
+                       event->event_data.comm.process_pid ==
+                           event->event_data.comm.process_tgid) {
+                check(event->event_data.comm.process_tgid);
+            }
+        }
+    }
+}
+
+void AttachWatcher::run() {
+    // Subscribe before listing so nothing starting meanwhile is missed
+    int fd = open_proc_connector();
+    netlink_ = fd >= 0;
+    poll_proc();
+    if (fd >= 0) {
+        watch_netlink(fd);
+        close(fd);
+        return;
+    }
+    while (!stop_) {
+        for (auto slept = std::chrono::milliseconds{0}; slept < interval_ && !stop_;
+             slept += std::chrono::milliseconds{10}) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        }
+        if (!stop_) {
+            poll_proc();
+        }
+    }
+}
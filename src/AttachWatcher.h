@@ -0,0 +1,97 @@
+#pragma once
+#include "ProcessList.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <regex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/types.h>
+
+/**
+ * Which processes to attach to, matched against comm or the command line
+ * instead of a pid so the rule still holds after the target restarts
+ */
+struct attach_rule {
+    std::string pattern;
+
+    /** Match the command line instead of comm */
+    bool        cmdline;
+
+    std::regex  compiled;
+
+    /**
+     * @brief make compiles `pattern`
+     * @return nullopt if the pattern isn't a valid regex, the error is
+     * reported on stderr
+     */
+    static std::optional<attach_rule> make(const std::string &pattern, bool cmdline);
+
+    bool matches(const process_info &info) const;
+};
+
+/**
+ * Watches for processes matching a set of attach rules on its own thread.
+ *
+ * Where the netlink proc connector can be subscribed to, which takes
+ * CAP_NET_ADMIN, every exec is reported by the kernel the moment it
+ * happens. Elsewhere /proc is listed every poll interval and only pids not
+ * seen before are read, so a poll costs one getdents64 walk.
+ */
+class AttachWatcher {
+public:
+    using callback = std::function<void(const process_info &)>;
+
+    static constexpr std::chrono::milliseconds default_interval{100};
+
+    /**
+     * Polls a new pid is read again for, a pid seen between fork and exec
+     * still has the comm of its parent
+     */
+    static constexpr unsigned recheck_polls = 3;
+
+    AttachWatcher() = default;
+    ~AttachWatcher();
+    AttachWatcher(const AttachWatcher &) = delete;
+    AttachWatcher &operator=(const AttachWatcher &) = delete;
+
+    /**
+     * @brief start watches for `rules`, replacing the previous watch.
+     * Processes already running are reported first.
+     * @param on_match called on the watcher thread for every new matching
+     * process
+     * @param interval poll interval when the proc connector isn't available
+     */
+    void start(std::vector<attach_rule> rules, callback on_match,
+               std::chrono::milliseconds interval = default_interval);
+
+    void stop();
+
+    bool running() const {
+        return thread_.joinable();
+    }
+
+    /** @brief netlink tells if the proc connector is used instead of polling */
+    bool netlink() const {
+        return netlink_;
+    }
+
+private:
+    std::vector<attach_rule>    rules_{};
+    callback                    on_match_{};
+    std::chrono::milliseconds   interval_{default_interval};
+    /** Polls each pid was read in, so a poll only reads new processes */
+    std::unordered_map<pid_t, unsigned> seen_{};
+    std::atomic<bool>           stop_{};
+    std::atomic<bool>           netlink_{};
+    std::thread                 thread_{};
+
+    void run();
+    void poll_proc();
+    bool check(pid_t pid);
+    void watch_netlink(int fd);
+};
@@ -0,0 +1,209 @@
+#include "CodeReferences.h"
+#include "ElfSymbols.h"
+#include "ProcessMemory.h"
+#include "X86Code.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <optional>
+#include <tuple>
+
+namespace {
+/** How far back to look for an endbr64 when a module has no symbols */
+constexpr std::size_t max_function_distance = 64 * 1024;
+
+bool is_prefix(std::uint8_t b) {
+    switch (b) {
+    case 0x26: case 0x2e: case 0x36: case 0x3e: case 0x64: case 0x65:
+    case 0x66: case 0x67: case 0xf0: case 0xf2: case 0xf3:
+        return true;
+    default:
+        return b >= 0x40 && b <= 0x4f;
+    }
+}
+
+/**
+ * @brief decode_at decodes the instruction at `code` and checks that its rip
+ * relative operand is the displacement at `disp`
+ */
+bool decode_at(csh handle, cs_insn *insn, const std::uint8_t *code, std::size_t size,
+               std::uintptr_t address, std::uintptr_t disp_address, std::uintptr_t &target) {
+    std::uint64_t addr = address;
+    if (!cs_disasm_iter(handle, &code, &size, &addr, insn) ||
+        insn->address + insn->size < disp_address + 4) {
+        return false;
+    }
+    const cs_x86 &x86 = insn->detail->x86;
+    for (std::uint8_t i = 0; i < x86.op_count; ++i) {
+        const cs_x86_op &op = x86.operands[i];
+        if (op.type == X86_OP_MEM && op.mem.base == X86_REG_RIP) {
+            target = insn->address + insn->size + static_cast<std::uintptr_t>(op.mem.disp);
+            return true;
+        }
+    }
+    return false;
+}
+
+}
+
+std::vector<code_reference> find_code_references(pid_t pid, const maps_snapshot &maps,
+                                                 std::uintptr_t lo, std::uintptr_t hi,
+                                                 const std::function<void(size_t, size_t)> &progress) {
+    struct chunk {
+        std::uintptr_t  start;
+        std::uintptr_t  end;
+        /** Bounds of the range, reads may not cross them */
+        std::uintptr_t  range_start;
+        std::uintptr_t  range_end;
+    };
+    std::vector<chunk> chunks;
+    std::size_t total = 0;
+    for (const address_range &range : maps.ranges) {
+        if (!(range.perms & PERM_EXECUTE) || !(range.perms & PERM_READ)) {
+            continue;
+        }
+        const auto start = reinterpret_cast<std::uintptr_t>(range.start);
+        const std::uintptr_t end = start + range.length;
+        for (std::uintptr_t cur = start; cur < end; cur += code_chunk_size) {
+            chunks.push_back({cur, std::min(cur + code_chunk_size, end), start, end});
+        }
+        total += range.length;
+    }
+
+    std::vector<code_reference> found;
+    std::atomic<std::size_t> done = 0;
+    #pragma omp parallel
+    {
+        capstone cs;
+        std::vector<code_reference> local;
+        std::vector<std::uint8_t> buf;
+        #pragma omp for schedule(dynamic, 1)
+        for (std::size_t c = 0; c < chunks.size(); ++c) {
+            const chunk &ch = chunks[c];
+            done.fetch_add(ch.end - ch.start);
+            if (progress) {
+                progress(done.load(), total);
+            }
+            // Include the function start search window before the chunk and
+            // enough after it to finish the last instruction
+            const std::uintptr_t read_start = ch.start - std::min<std::uintptr_t>(
+                ch.start - ch.range_start, max_function_distance);
+            const std::uintptr_t read_end = std::min<std::uintptr_t>(ch.end + max_instruction,
+                                                                     ch.range_end);
+            buf.resize(read_end - read_start);
+            if (!cs.ok || ProcessMemory::read_process_memory_nosplit(
+                    pid, reinterpret_cast<void *>(read_start), buf.data(), buf.size()) !=
+                    static_cast<ssize_t>(buf.size())) {
+                continue;
+            }
+
+            // i is the offset of a displacement, the ModRM byte right before
+            // it must be mod=00 rm=101
+            const std::size_t first = std::max<std::size_t>(ch.start - read_start, 2);
+            const std::size_t last = std::min<std::size_t>(ch.end - read_start, buf.size() - 4);
+            std::uintptr_t previous_end = 0;
+            for (std::size_t i = first; i < last; ++i) {
+                if ((buf[i - 1] & 0xc7) != 0x05) {
+                    continue;
+                }
+                std::int32_t disp;
+                std::memcpy(&disp, &buf[i], sizeof(disp));
+                // Up to 4 bytes of immediate may follow the displacement
+                const std::uintptr_t next = read_start + i + 4 + static_cast<std::uintptr_t>(
+                    static_cast<std::intptr_t>(disp));
+                if (next + 4 < lo || next > hi) {
+                    continue;
+                }
+
+                // Nearest start that decodes to this operand, then extend
+                // over any prefixes in front of it
+                const std::uintptr_t disp_address = read_start + i;
+                std::uintptr_t target = 0;
+                std::optional<std::size_t> start;
+                for (std::size_t s = i - 2; s + max_instruction > i && s < i; --s) {
+                    if (decode_at(cs.handle, cs.insn, &buf[s], buf.size() - s,
+                                  read_start + s, disp_address, target)) {
+                        start = s;
+                        break;
+                    }
+                    if (s == 0) {
+                        break;
+                    }
+                }
+                if (!start || target < lo || target > hi) {
+                    continue;
+                }
+                while (*start > 0 && i - *start < max_instruction - 1 && is_prefix(buf[*start - 1])) {
+                    std::uintptr_t t = 0;
+                    if (!decode_at(cs.handle, cs.insn, &buf[*start - 1], buf.size() - *start + 1,
+                                   read_start + *start - 1, disp_address, t) || t != target) {
+                        break;
+                    }
+                    --*start;
+                }
+                decode_at(cs.handle, cs.insn, &buf[*start], buf.size() - *start,
+                          read_start + *start, disp_address, target);
+                const std::uintptr_t from = read_start + *start;
+                if (from < previous_end) {
+                    continue;
+                }
+                previous_end = from + cs.insn->size;
+
+                code_reference ref{from, target, static_cast<std::uint8_t>(cs.insn->size),
+                                   {}, {}, cs.insn->mnemonic};
+                if (cs.insn->op_str[0] != '\0') {
+                    ref.text += ' ';
+                    ref.text += cs.insn->op_str;
+                }
+                // Remember the nearest endbr64 for modules without symbols
+                for (std::size_t s = *start; s >= 4; --s) {
+                    if (buf[s - 4] == 0xf3 && buf[s - 3] == 0x0f &&
+                        buf[s - 2] == 0x1e && buf[s - 1] == 0xfa) {
+                        char name[32];
+                        snprintf(name, sizeof(name), "sub_%" PRIxPTR, read_start + s - 4);
+                        ref.function = name;
+                        break;
+                    }
+                }
+                local.push_back(std::move(ref));
+            }
+        }
+        #pragma omp critical
+        found.insert(found.end(), std::make_move_iterator(local.begin()),
+                     std::make_move_iterator(local.end()));
+    }
+
+    std::map<std::string, std::optional<elf_symbols>> symbols;
+    for (code_reference &ref : found) {
+        const std::string *name = maps.index.name(ref.from);
+        if (name == nullptr || name->empty()) {
+            continue;
+        }
+        ref.module = basename_of(*name);
+        if ((*name)[0] != '/') {
+            continue;
+        }
+        auto it = symbols.find(*name);
+        if (it == symbols.end()) {
+            it = symbols.emplace(*name, elf_symbols::load(*name)).first;
+        }
+        if (!it->second) {
+            continue;
+        }
+        const std::uintptr_t bias = it->second->load_bias(maps.index.module_base(ref.from));
+        if (const elf_symbols::symbol *sym = it->second->function_at(ref.from - bias)) {
+            char offset[32];
+            snprintf(offset, sizeof(offset), "+0x%" PRIxPTR, ref.from - bias - sym->address);
+            ref.function = sym->name + offset;
+        }
+    }
+
+    std::sort(found.begin(), found.end(), [](const code_reference &a, const code_reference &b) {
+        return std::tie(a.module, a.from) < std::tie(b.module, b.from);
+    });
+    return found;
+}
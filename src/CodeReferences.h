@@ -0,0 +1,50 @@
+#pragma once
+#include "maps.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+/**
+ * An instruction whose rip relative memory operand resolves to a scanned
+ * address
+ */
+struct code_reference {
+    std::uintptr_t  from;
+    std::uintptr_t  target;
+    std::uint8_t    size;
+
+    /** Basename of the mapping the instruction is in */
+    std::string     module;
+
+    /**
+     * Function containing the instruction, "name+0x12" when the module has
+     * symbols and "sub_<address>" from the nearest endbr64 otherwise, empty
+     * if neither is known
+     */
+    std::string     function;
+
+    /** e.g. "mov eax, dword ptr [rip + 0x2f1a]" */
+    std::string     text;
+};
+
+/**
+ * @brief find_code_references finds every instruction in the executable
+ * ranges of `maps` that accesses memory in [lo, hi] through a rip relative
+ * operand. The ranges are split into chunks scanned in parallel.
+ *
+ * Candidates are found by looking for a ModRM byte encoding [rip + disp32]
+ * followed by a displacement that lands in the window, only those are
+ * decoded with capstone. This finds references even in code a linear sweep
+ * would decode misaligned.
+ *
+ * @param progress called with (bytes done, bytes total), may be empty
+ * @return the references sorted by module and address, so the ones in the
+ * same function are next to each other
+ */
+std::vector<code_reference> find_code_references(pid_t pid, const maps_snapshot &maps,
+                                                 std::uintptr_t lo, std::uintptr_t hi,
+                                                 const std::function<void(size_t, size_t)> &progress = {});
@@ -0,0 +1,107 @@
+#include "ElfSymbols.h"
+
+#include <algorithm>
+#include <cstring>
+#include <elf.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+std::optional<elf_symbols> elf_symbols::load(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return std::nullopt;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || std::size_t(st.st_size) < sizeof(Elf64_Ehdr)) {
+        close(fd);
+        return std::nullopt;
+    }
+    const auto size = static_cast<std::size_t>(st.st_size);
+    void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return std::nullopt;
+    }
+    const auto *data = static_cast<const std::uint8_t *>(map);
+    auto in_file = [size](std::uint64_t offset, std::uint64_t length) {
+        return offset <= size && length <= size - offset;
+    };
+
+    std::optional<elf_symbols> result;
+    const auto *eh = reinterpret_cast<const Elf64_Ehdr *>(data);
+    if (std::memcmp(eh->e_ident, ELFMAG, SELFMAG) != 0 || eh->e_ident[EI_CLASS] != ELFCLASS64 ||
+        eh->e_shentsize != sizeof(Elf64_Shdr) || eh->e_phentsize != sizeof(Elf64_Phdr) ||
+        !in_file(eh->e_shoff, std::uint64_t(eh->e_shnum) * sizeof(Elf64_Shdr)) ||
+        !in_file(eh->e_phoff, std::uint64_t(eh->e_phnum) * sizeof(Elf64_Phdr))) {
+        munmap(map, size);
+        return result;
+    }
+
+    elf_symbols symbols;
+    symbols.position_independent_ = eh->e_type == ET_DYN;
+    symbols.lowest_load_ = UINTPTR_MAX;
+    const auto *ph = reinterpret_cast<const Elf64_Phdr *>(data + eh->e_phoff);
+    for (std::size_t i = 0; i < eh->e_phnum; ++i) {
+        if (ph[i].p_type == PT_LOAD) {
+            symbols.lowest_load_ = std::min<std::uintptr_t>(symbols.lowest_load_,
+                                                            ph[i].p_vaddr & ~(ph[i].p_align - 1));
+        }
+    }
+    if (symbols.lowest_load_ == UINTPTR_MAX) {
+        symbols.lowest_load_ = 0;
+    }
+
+    const auto *sh = reinterpret_cast<const Elf64_Shdr *>(data + eh->e_shoff);
+    for (std::size_t i = 0; i < eh->e_shnum; ++i) {
+        if ((sh[i].sh_type != SHT_SYMTAB && sh[i].sh_type != SHT_DYNSYM) ||
+            sh[i].sh_link >= eh->e_shnum || sh[i].sh_entsize != sizeof(Elf64_Sym) ||
+            !in_file(sh[i].sh_offset, sh[i].sh_size)) {
+            continue;
+        }
+        const Elf64_Shdr &strtab = sh[sh[i].sh_link];
+        if (!in_file(strtab.sh_offset, strtab.sh_size)) {
+            continue;
+        }
+        const char *strings = reinterpret_cast<const char *>(data + strtab.sh_offset);
+        const auto *sym = reinterpret_cast<const Elf64_Sym *>(data + sh[i].sh_offset);
+        const std::size_t count = sh[i].sh_size / sizeof(Elf64_Sym);
+        for (std::size_t s = 0; s < count; ++s) {
+            if (ELF64_ST_TYPE(sym[s].st_info) != STT_FUNC || sym[s].st_shndx == SHN_UNDEF ||
+                sym[s].st_name >= strtab.sh_size) {
+                continue;
+            }
+            const char *name = strings + sym[s].st_name;
+            symbols.symbols_.push_back({sym[s].st_value, sym[s].st_size,
+                                        std::string(name, strnlen(name, strtab.sh_size - sym[s].st_name))});
+        }
+    }
+    munmap(map, size);
+
+    // .symtab and .dynsym overlap, keep one symbol per address preferring
+    // the one with a size
+    std::sort(symbols.symbols_.begin(), symbols.symbols_.end(), [](const symbol &a, const symbol &b) {
+        return a.address < b.address || (a.address == b.address && a.size > b.size);
+    });
+    symbols.symbols_.erase(std::unique(symbols.symbols_.begin(), symbols.symbols_.end(),
+                                       [](const symbol &a, const symbol &b) {
+                                           return a.address == b.address;
+                                       }),
+                           symbols.symbols_.end());
+    result = std::move(symbols);
+    return result;
+}
+
+const elf_symbols::symbol *elf_symbols::function_at(std::uintptr_t address) const {
+    auto it = std::upper_bound(symbols_.begin(), symbols_.end(), address,
+                               [](std::uintptr_t a, const symbol &s) { return a < s.address; });
+    if (it == symbols_.begin()) {
+        return nullptr;
+    }
+    --it;
+    if (it->size != 0 && address >= it->address + it->size) {
+        return nullptr;
+    }
+    return &*it;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * Function symbols of an ELF file from both .symtab and .dynsym, for naming
+ * code addresses. Addresses are the link time virtual addresses, see
+ * `load_bias` for how they relate to a mapped image.
+ */
+class elf_symbols {
+public:
+    struct symbol {
+        std::uintptr_t  address;
+        std::size_t     size;
+        std::string     name;
+    };
+
+    /**
+     * @brief load reads the symbols of the file at `path`
+     * @return nullopt if the file is not a 64-bit ELF file, errors are not
+     * reported since most callers try every mapping
+     */
+    static std::optional<elf_symbols> load(const std::string &path);
+
+    /**
+     * @brief load_bias is what to add to a symbol address to get its address
+     * in a process that mapped the file at `module_base`
+     */
+    std::uintptr_t load_bias(std::uintptr_t module_base) const {
+        return position_independent_ ? module_base - lowest_load_ : 0;
+    }
+
+    /**
+     * @brief function_at returns the function containing the link time
+     * address `address`. Symbols without a size match up to the next symbol.
+     */
+    const symbol *function_at(std::uintptr_t address) const;
+
+    std::size_t size() const {
+        return symbols_.size();
+    }
+
+private:
+    std::vector<symbol> symbols_{};
+    std::uintptr_t      lowest_load_{};
+    bool                position_independent_{};
+};
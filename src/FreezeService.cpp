@@ -0,0 +1,202 @@
+#include "FreezeService.h"
+#include "ProcessMemory.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <ctime>
+
+static std::int64_t thread_cpu_time() {
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return std::int64_t{ts.tv_sec} * 1000000000 + ts.tv_nsec;
+}
+
+FreezeService::FreezeService() {
+    started_ = clock::now().time_since_epoch().count();
+    thread_ = std::thread(&FreezeService::run, this);
+}
+
+FreezeService::~FreezeService() {
+    {
+        std::lock_guard lock{lock_};
+        quit_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+void FreezeService::pid(pid_t pid) {
+    std::lock_guard lock{lock_};
+    if (pid != pid_) {
+        entries_.clear();
+        pid_ = pid;
+    }
+}
+
+void FreezeService::freeze(void *address, const void *bytes, std::size_t size,
+                           std::chrono::microseconds interval) {
+    interval = std::max(interval, min_interval);
+    const auto *begin = static_cast<const std::uint8_t *>(bytes);
+    {
+        std::lock_guard lock{lock_};
+        auto it = std::find_if(entries_.begin(), entries_.end(),
+                               [address](const entry &e) { return e.address == address; });
+        if (it == entries_.end()) {
+            it = entries_.insert(entries_.end(), entry{});
+        }
+        *it = {address, {begin, begin + size}, interval, clock::now(), false};
+    }
+    wake_.notify_one();
+}
+
+void FreezeService::unfreeze(void *address) {
+    std::lock_guard lock{lock_};
+    std::erase_if(entries_, [address](const entry &e) { return e.address == address; });
+}
+
+void FreezeService::clear() {
+    std::lock_guard lock{lock_};
+    entries_.clear();
+}
+
+bool FreezeService::frozen(void *address) const {
+    std::lock_guard lock{lock_};
+    return std::any_of(entries_.begin(), entries_.end(),
+                       [address](const entry &e) { return e.address == address; });
+}
+
+void FreezeService::set_interval(std::chrono::microseconds interval) {
+    interval = std::max(interval, min_interval);
+    {
+        std::lock_guard lock{lock_};
+        for (entry &e : entries_) {
+            e.interval = interval;
+            e.deadline = std::min(e.deadline, clock::now() + e.interval);
+        }
+    }
+    wake_.notify_one();
+}
+
+FreezeService::stats FreezeService::statistics() const {
+    stats s{};
+    {
+        std::lock_guard lock{lock_};
+        s.entries = entries_.size();
+        s.failing = static_cast<std::size_t>(std::count_if(
+            entries_.begin(), entries_.end(), [](const entry &e) { return e.failing; }));
+    }
+    s.cycles = cycles_.load();
+    s.syscalls = syscalls_.load();
+    s.writes = writes_.load();
+    s.failed_writes = failed_writes_.load();
+    s.bytes = bytes_.load();
+    s.cpu_time = std::chrono::nanoseconds{cpu_now_.load() - cpu_base_.load()};
+    s.elapsed = clock::now() - clock::time_point{clock::duration{started_.load()}};
+    s.average_lag = std::chrono::nanoseconds{s.cycles ? lag_total_.load() / s.cycles : 0};
+    s.max_lag = std::chrono::nanoseconds{lag_max_.load()};
+    return s;
+}
+
+void FreezeService::reset_statistics() {
+    cycles_ = 0;
+    syscalls_ = 0;
+    writes_ = 0;
+    failed_writes_ = 0;
+    bytes_ = 0;
+    lag_total_ = 0;
+    lag_max_ = 0;
+    cpu_base_ = cpu_now_.load();
+    started_ = clock::now().time_since_epoch().count();
+}
+
+void FreezeService::run() {
+    static const auto max_iov = static_cast<std::size_t>(sysconf(_SC_IOV_MAX));
+    cpu_base_ = thread_cpu_time();
+    cpu_now_ = cpu_base_.load();
+
+    std::vector<std::uint8_t> buffer;
+    std::vector<WriteRequest> requests;
+    std::vector<std::size_t> due;
+
+    std::unique_lock lock{lock_};
+    while (!quit_) {
+        if (entries_.empty() || pid_ <= 0) {
+            wake_.wait(lock);
+            continue;
+        }
+
+        clock::time_point now = clock::now();
+        clock::time_point next = clock::time_point::max();
+        for (const entry &e : entries_) {
+            next = std::min(next, e.deadline);
+        }
+        if (next > now) {
+            wake_.wait_until(lock, next);
+            continue;
+        }
+
+        // Everything due is written in one go. Copy the bytes out so the
+        // lock isn't held over the syscalls.
+        due.clear();
+        std::size_t size = 0;
+        for (std::size_t i = 0; i < entries_.size(); ++i) {
+            if (entries_[i].deadline <= now) {
+                due.push_back(i);
+                size += entries_[i].bytes.size();
+            }
+        }
+        buffer.resize(size);
+        requests.resize(due.size());
+        std::uint64_t lag = 0;
+        std::size_t offset = 0;
+        for (std::size_t i = 0; i < due.size(); ++i) {
+            entry &e = entries_[due[i]];
+            std::memcpy(buffer.data() + offset, e.bytes.data(), e.bytes.size());
+            requests[i] = {e.address, buffer.data() + offset, e.bytes.size()};
+            offset += e.bytes.size();
+            lag = std::max<std::uint64_t>(lag, static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(now - e.deadline).count()));
+            // Schedule from the previous deadline so the cadence doesn't
+            // drift, unless we've fallen a whole interval behind
+            e.deadline += e.interval;
+            if (e.deadline <= now) {
+                e.deadline = now + e.interval;
+            }
+        }
+        const pid_t pid = pid_;
+        lock.unlock();
+
+        const std::size_t written = ProcessMemory::write_many(pid, requests);
+        std::size_t bytes = 0;
+        for (const WriteRequest &req : requests) {
+            if (req.result > 0) {
+                bytes += req.size;
+            }
+        }
+
+        // write_many makes one call per IOV_MAX batch and restarts after
+        // every failed address
+        cycles_.fetch_add(1, std::memory_order_relaxed);
+        syscalls_.fetch_add((requests.size() + max_iov - 1) / max_iov +
+                                (requests.size() - written),
+                            std::memory_order_relaxed);
+        writes_.fetch_add(written, std::memory_order_relaxed);
+        failed_writes_.fetch_add(requests.size() - written, std::memory_order_relaxed);
+        bytes_.fetch_add(bytes, std::memory_order_relaxed);
+        lag_total_.fetch_add(lag, std::memory_order_relaxed);
+        if (lag > lag_max_.load(std::memory_order_relaxed)) {
+            lag_max_.store(lag, std::memory_order_relaxed);
+        }
+        cpu_now_.store(thread_cpu_time(), std::memory_order_relaxed);
+
+        lock.lock();
+        // The entries may have changed while writing, match them by address
+        for (std::size_t i = 0; i < due.size(); ++i) {
+            const std::size_t index = due[i];
+            if (index < entries_.size() && entries_[index].address == requests[i].address) {
+                entries_[index].failing = requests[i].result < 0;
+            }
+        }
+    }
+}
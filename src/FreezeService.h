@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/types.h>
+
+/**
+ * Keeps values in the target process frozen by rewriting them from a
+ * dedicated thread. Every wakeup collects the entries that are due and
+ * writes all of them with a handful of process_vm_writev calls, so the cost
+ * on the target grows with the amount of wakeups rather than the amount of
+ * frozen values.
+ */
+class FreezeService {
+public:
+    using clock = std::chrono::steady_clock;
+
+    /** Shortest interval accepted, keeps a misconfigured entry from spinning */
+    static constexpr std::chrono::microseconds min_interval{100};
+
+    struct stats {
+        /** Entries currently frozen */
+        std::size_t     entries;
+
+        /** Entries whose last write failed */
+        std::size_t     failing;
+
+        /** Wakeups that wrote something */
+        std::uint64_t   cycles;
+
+        /** process_vm_writev calls, counting a restart after a failed address as one */
+        std::uint64_t   syscalls;
+
+        /** Values written, and values that could not be written */
+        std::uint64_t   writes;
+        std::uint64_t   failed_writes;
+        std::uint64_t   bytes;
+
+        /** CPU time spent by the freeze thread */
+        std::chrono::nanoseconds cpu_time;
+
+        /** Wall time since the counters were last reset */
+        std::chrono::nanoseconds elapsed;
+
+        /** How late the writes were compared to their deadline, on average and at worst */
+        std::chrono::nanoseconds average_lag;
+        std::chrono::nanoseconds max_lag;
+    };
+
+    FreezeService();
+    ~FreezeService();
+    FreezeService(const FreezeService &) = delete;
+    FreezeService &operator=(const FreezeService &) = delete;
+
+    /**
+     * @brief pid sets the process written to, drops all frozen values when
+     * it changes
+     */
+    void pid(pid_t pid);
+
+    /**
+     * @brief freeze starts rewriting `size` bytes of `bytes` to `address`
+     * every `interval`, replaces the entry if the address is already frozen
+     */
+    void freeze(void *address, const void *bytes, std::size_t size,
+                std::chrono::microseconds interval);
+
+    void unfreeze(void *address);
+    void clear();
+
+    bool frozen(void *address) const;
+
+    /** @brief set_interval changes the interval of every frozen value */
+    void set_interval(std::chrono::microseconds interval);
+
+    stats statistics() const;
+    void reset_statistics();
+
+private:
+    struct entry {
+        void                        *address;
+        std::vector<std::uint8_t>   bytes;
+        clock::duration             interval;
+        clock::time_point           deadline;
+        bool                        failing;
+    };
+
+    mutable std::mutex          lock_{};
+    std::condition_variable     wake_{};
+    std::vector<entry>          entries_{};
+    pid_t                       pid_{-1};
+    bool                        quit_{};
+    std::thread                 thread_{};
+
+    // Counters, written by the freeze thread only
+    std::atomic<std::uint64_t>  cycles_{};
+    std::atomic<std::uint64_t>  syscalls_{};
+    std::atomic<std::uint64_t>  writes_{};
+    std::atomic<std::uint64_t>  failed_writes_{};
+    std::atomic<std::uint64_t>  bytes_{};
+    std::atomic<std::uint64_t>  lag_total_{};
+    std::atomic<std::uint64_t>  lag_max_{};
+    std::atomic<std::int64_t>   cpu_base_{};
+    std::atomic<std::int64_t>   cpu_now_{};
+    std::atomic<clock::rep>     started_{};
+
+    void run();
+};
@@ -0,0 +1,312 @@
+#include "InstructionIndex.h"
+#include "ProcessMemory.h"
+#include "X86Code.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <omp.h>
+#include <parallel/algorithm>
+
+namespace {
+struct chunk {
+    /** Instructions starting in [start, end) are decoded */
+    std::uintptr_t                              start;
+    std::uintptr_t                              end;
+    /** End of the range the chunk is in, reads may not cross it */
+    std::uintptr_t                              limit;
+    bool                                        first_in_range;
+    std::vector<instruction_index::instruction> insns;
+    std::vector<instruction_reference>          refs;
+};
+
+/**
+ * @brief collect_references records where `insn` points to, immediates and
+ * absolute displacements only when they land in mapped memory
+ */
+void collect_references(const cs_insn *insn, const maps_snapshot &maps,
+                        std::vector<instruction_reference> &refs) {
+    const cs_x86 &x86 = insn->detail->x86;
+    for (std::uint8_t i = 0; i < x86.op_count; ++i) {
+        const cs_x86_op &op = x86.operands[i];
+        std::uintptr_t target = 0;
+        if (op.type == X86_OP_IMM) {
+            target = static_cast<std::uintptr_t>(op.imm);
+        } else if (op.type == X86_OP_MEM && op.mem.base == X86_REG_RIP) {
+            target = insn->address + insn->size + static_cast<std::uintptr_t>(op.mem.disp);
+        } else if (op.type == X86_OP_MEM && op.mem.base == X86_REG_INVALID &&
+                   op.mem.index == X86_REG_INVALID) {
+            target = static_cast<std::uintptr_t>(op.mem.disp);
+        } else {
+            continue;
+        }
+        if (maps.index.find(target) != address_range_index::npos) {
+            refs.push_back({target, insn->address});
+        }
+    }
+}
+
+/**
+ * @brief decode linearly disassembles `size` bytes of `code` located at
+ * `address`, stopping at the first instruction starting at or after `end`
+ * or, if `sync` is given, at the first address found in it
+ * @return the address decoding stopped at
+ */
+std::uintptr_t decode(csh handle, cs_insn *insn, const maps_snapshot &maps,
+                      const std::uint8_t *code, std::size_t size,
+                      std::uintptr_t address, std::uintptr_t end,
+                      const std::vector<instruction_index::instruction> *sync,
+                      std::vector<instruction_index::instruction> &insns,
+                      std::vector<instruction_reference> &refs) {
+    const std::uintptr_t base = address;
+    while (address < end && address < base + size) {
+        if (sync != nullptr) {
+            auto it = std::lower_bound(sync->begin(), sync->end(), address,
+                                       [](const instruction_index::instruction &i, std::uintptr_t a) {
+                                           return i.address < a;
+                                       });
+            if (it != sync->end() && it->address == address) {
+                break;
+            }
+        }
+        const std::uint8_t *p = code + (address - base);
+        std::size_t left = size - (address - base);
+        std::uint64_t addr = address;
+        if (cs_disasm_iter(handle, &p, &left, &addr, insn)) {
+            insns.push_back({address, static_cast<std::uint8_t>(insn->size),
+                             static_cast<std::uint16_t>(insn->id)});
+            collect_references(insn, maps, refs);
+            address += insn->size;
+        } else {
+            // Data or garbage, step a byte and try again
+            insns.push_back({address, 1, X86_INS_INVALID});
+            address += 1;
+        }
+    }
+    return address;
+}
+
+bool read_bytes(pid_t pid, std::uintptr_t start, std::size_t size, std::vector<std::uint8_t> &buf) {
+    buf.resize(size);
+    return ProcessMemory::read_process_memory_nosplit(pid, reinterpret_cast<void *>(start),
+                                                      buf.data(), size) ==
+           static_cast<ssize_t>(size);
+}
+
+/**
+ * @brief resync makes `c` continue where the previous chunk's last
+ * instruction ended. Chunks are decoded from their first byte, which may be
+ * the middle of an instruction, but linear sweep falls back in step within a
+ * few instructions so usually only a short prefix has to be replaced.
+ */
+void resync(pid_t pid, const maps_snapshot &maps, capstone &cs, chunk &c, std::uintptr_t entry) {
+    auto first = std::lower_bound(c.insns.begin(), c.insns.end(), entry,
+                                  [](const instruction_index::instruction &i, std::uintptr_t a) {
+                                      return i.address < a;
+                                  });
+    std::vector<instruction_index::instruction> prefix;
+    std::vector<instruction_reference> prefix_refs;
+    if (first != c.insns.end() && first->address != entry && entry < c.end) {
+        std::vector<std::uint8_t> buf;
+        const std::size_t size = std::min<std::uintptr_t>(c.end + max_instruction, c.limit) - entry;
+        if (read_bytes(pid, entry, size, buf)) {
+            std::vector<instruction_index::instruction> rest(first, c.insns.end());
+            decode(cs.handle, cs.insn, maps, buf.data(), buf.size(), entry, c.end,
+                   &rest, prefix, prefix_refs);
+            if (!prefix.empty()) {
+                const std::uintptr_t synced = prefix.back().address + prefix.back().length;
+                first = std::lower_bound(c.insns.begin(), c.insns.end(), synced,
+                                         [](const instruction_index::instruction &i, std::uintptr_t a) {
+                                             return i.address < a;
+                                         });
+                entry = synced;
+            }
+        }
+    }
+
+    c.insns.erase(c.insns.begin(), first);
+    c.insns.insert(c.insns.begin(), prefix.begin(), prefix.end());
+    std::erase_if(c.refs, [entry](const instruction_reference &r) { return r.from < entry; });
+    c.refs.insert(c.refs.end(), prefix_refs.begin(), prefix_refs.end());
+}
+}
+
+instruction_index instruction_index::build(pid_t pid, const maps_snapshot &maps,
+                                           const std::function<void(size_t, size_t)> &progress) {
+    std::vector<chunk> chunks;
+    std::size_t total = 0;
+    for (const address_range &range : maps.ranges) {
+        if (!(range.perms & PERM_EXECUTE)) {
+            continue;
+        }
+        const auto start = reinterpret_cast<std::uintptr_t>(range.start);
+        const std::uintptr_t end = start + range.length;
+        for (std::uintptr_t cur = start; cur < end; cur += chunk_size) {
+            chunks.push_back({cur, std::min(cur + chunk_size, end), end, cur == start, {}, {}});
+        }
+        total += range.length;
+    }
+
+    // Decoded chunks hold 16 bytes per instruction against the index's 3, so
+    // only a few chunks per thread are decoded at a time and each is merged
+    // and released before the next pass
+    const std::size_t per_pass = 4 * static_cast<std::size_t>(omp_get_max_threads());
+    std::atomic<std::size_t> done = 0;
+    instruction_index index;
+    capstone cs;
+    /** End of the last instruction of the previous chunk, 0 if it had none */
+    std::uintptr_t previous_end = 0;
+    std::uintptr_t next = 0;
+    std::size_t in_block = 0;
+    for (std::size_t first = 0; first < chunks.size(); first += per_pass) {
+        const std::size_t last = std::min(first + per_pass, chunks.size());
+        #pragma omp parallel
+        {
+            capstone local;
+            std::vector<std::uint8_t> buf;
+            #pragma omp for schedule(dynamic, 1)
+            for (std::size_t i = first; i < last; ++i) {
+                chunk &c = chunks[i];
+                // Read a little past the end to finish the last instruction
+                const std::size_t size = std::min<std::uintptr_t>(c.end + max_instruction, c.limit) - c.start;
+                if (local.ok && read_bytes(pid, c.start, size, buf)) {
+                    decode(local.handle, local.insn, maps, buf.data(), buf.size(), c.start, c.end,
+                           nullptr, c.insns, c.refs);
+                }
+                done.fetch_add(c.end - c.start);
+                if (progress) {
+                    progress(done.load(), total);
+                }
+            }
+        }
+
+        for (std::size_t i = first; i < last; ++i) {
+            chunk &c = chunks[i];
+            if (!c.first_in_range && previous_end != 0 && cs.ok) {
+                resync(pid, maps, cs, c, previous_end);
+            }
+            previous_end = c.insns.empty() ? 0 : c.insns.back().address + c.insns.back().length;
+            for (const instruction &insn : c.insns) {
+                if (insn.address != next || in_block == block_instructions) {
+                    index.blocks_.push_back({insn.address, index.lengths_.size()});
+                    in_block = 0;
+                }
+                index.lengths_.push_back(insn.length);
+                index.ids_.push_back(insn.id);
+                next = insn.address + insn.length;
+                ++in_block;
+            }
+            index.refs_.insert(index.refs_.end(), c.refs.begin(), c.refs.end());
+            c = {};
+        }
+    }
+    index.lengths_.shrink_to_fit();
+    index.ids_.shrink_to_fit();
+    index.blocks_.shrink_to_fit();
+    __gnu_parallel::sort(index.refs_.begin(), index.refs_.end(),
+                         [](const instruction_reference &a, const instruction_reference &b) {
+                             return a.target < b.target ||
+                                    (a.target == b.target && a.from < b.from);
+                         });
+    return index;
+}
+
+std::size_t instruction_index::block_of(std::size_t i) const {
+    auto it = std::upper_bound(blocks_.begin(), blocks_.end(), i,
+                               [](std::size_t v, const block &b) { return v < b.first; });
+    return static_cast<std::size_t>(it - blocks_.begin()) - 1;
+}
+
+instruction_index::instruction instruction_index::at(std::size_t i) const {
+    const block &b = blocks_[block_of(i)];
+    std::uintptr_t address = b.address;
+    for (std::size_t j = b.first; j < i; ++j) {
+        address += lengths_[j];
+    }
+    return {address, lengths_[i], ids_[i]};
+}
+
+std::optional<std::size_t> instruction_index::find(std::uintptr_t address) const {
+    auto it = std::upper_bound(blocks_.begin(), blocks_.end(), address,
+                               [](std::uintptr_t a, const block &b) { return a < b.address; });
+    if (it == blocks_.begin()) {
+        return std::nullopt;
+    }
+    const std::size_t last = it == blocks_.end() ? lengths_.size() : it->first;
+    --it;
+    std::uintptr_t cur = it->address;
+    for (std::size_t i = it->first; i < last; ++i) {
+        if (address < cur + lengths_[i]) {
+            return i;
+        }
+        cur += lengths_[i];
+    }
+    return std::nullopt;
+}
+
+std::vector<instruction_reference> instruction_index::references_to(std::uintptr_t lo,
+                                                                    std::uintptr_t hi) const {
+    auto first = std::lower_bound(refs_.begin(), refs_.end(), lo,
+                                  [](const instruction_reference &r, std::uintptr_t v) {
+                                      return r.target < v;
+                                  });
+    auto last = std::upper_bound(first, refs_.end(), hi,
+                                 [](std::uintptr_t v, const instruction_reference &r) {
+                                     return v < r.target;
+                                 });
+    std::vector<instruction_reference> refs(first, last);
+    std::sort(refs.begin(), refs.end(), [](const auto &a, const auto &b) {
+        return a.from < b.from;
+    });
+    return refs;
+}
+
+std::vector<std::uintptr_t> instruction_index::find_instructions(unsigned id) const {
+    std::vector<std::uintptr_t> found;
+    #pragma omp parallel
+    {
+        std::vector<std::uintptr_t> local;
+        #pragma omp for schedule(static)
+        for (std::size_t b = 0; b < blocks_.size(); ++b) {
+            const std::size_t last = b + 1 < blocks_.size() ? blocks_[b + 1].first : lengths_.size();
+            std::uintptr_t address = blocks_[b].address;
+            for (std::size_t i = blocks_[b].first; i < last; ++i) {
+                if (ids_[i] == id) {
+                    local.push_back(address);
+                }
+                address += lengths_[i];
+            }
+        }
+        #pragma omp critical
+        found.insert(found.end(), local.begin(), local.end());
+    }
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+unsigned instruction_index::instruction_id(const std::string &mnemonic) {
+    static std::mutex lock;
+    static std::vector<std::string> names;
+    std::lock_guard guard{lock};
+    if (names.empty()) {
+        capstone cs;
+        if (!cs.ok) {
+            return 0;
+        }
+        names.resize(X86_INS_ENDING);
+        for (unsigned id = 1; id < X86_INS_ENDING; ++id) {
+            if (const char *name = cs_insn_name(cs.handle, id)) {
+                names[id] = name;
+            }
+        }
+    }
+    auto it = std::find(names.begin() + 1, names.end(), mnemonic);
+    return it == names.end() ? 0 : static_cast<unsigned>(it - names.begin());
+}
+
+std::size_t instruction_index::memory_usage() const {
+    return blocks_.capacity() * sizeof(block) + lengths_.capacity() +
+           ids_.capacity() * sizeof(std::uint16_t) +
+           refs_.capacity() * sizeof(instruction_reference);
+}
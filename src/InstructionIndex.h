@@ -0,0 +1,95 @@
+#pragma once
+#include "X86Code.h"
+#include "maps.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+/**
+ * An instruction referring to an address, either through a rip relative or
+ * absolute memory operand or an immediate such as a call or jump target
+ */
+struct instruction_reference {
+    std::uintptr_t  target;
+    std::uintptr_t  from;
+};
+
+/**
+ * Linear sweep disassembly of every executable mapping, stored compactly.
+ *
+ * Only the length and capstone instruction id of each instruction are kept,
+ * addresses are recovered from the lengths starting at the nearest block
+ * (a block is at most `block_instructions` contiguous instructions). That
+ * makes the index about 3 bytes per instruction. References are kept in a
+ * separate table sorted by target so "who references X" is a binary search.
+ */
+class instruction_index {
+public:
+    struct instruction {
+        std::uintptr_t  address;
+        std::uint8_t    length;
+        std::uint16_t   id;
+    };
+
+    static constexpr std::size_t block_instructions = 64;
+
+    /** Amount of bytes each thread decodes at a time */
+    static constexpr std::size_t chunk_size = code_chunk_size;
+
+    instruction_index() = default;
+
+    /**
+     * @brief build disassembles all executable ranges of `maps` in parallel,
+     * one capstone handle per thread
+     * @param progress called with (bytes done, bytes total), may be empty
+     */
+    static instruction_index build(pid_t pid, const maps_snapshot &maps,
+                                   const std::function<void(size_t, size_t)> &progress = {});
+
+    std::size_t size() const {
+        return lengths_.size();
+    }
+
+    instruction at(std::size_t i) const;
+
+    /** @brief find returns the index of the instruction containing `address` */
+    std::optional<std::size_t> find(std::uintptr_t address) const;
+
+    /**
+     * @brief references_to returns the instructions referencing an address
+     * in [lo, hi], sorted by address
+     */
+    std::vector<instruction_reference> references_to(std::uintptr_t lo, std::uintptr_t hi) const;
+    std::vector<instruction_reference> references_to(std::uintptr_t target) const {
+        return references_to(target, target);
+    }
+
+    /**
+     * @brief find_instructions returns the address of every instruction
+     * with the given capstone id
+     */
+    std::vector<std::uintptr_t> find_instructions(unsigned id) const;
+
+    /** @brief instruction_id looks up a mnemonic such as "syscall", 0 if unknown */
+    static unsigned instruction_id(const std::string &mnemonic);
+
+    std::size_t memory_usage() const;
+
+private:
+    struct block {
+        std::uintptr_t  address;
+        std::size_t     first;
+    };
+
+    std::vector<block>                  blocks_{};
+    std::vector<std::uint8_t>           lengths_{};
+    std::vector<std::uint16_t>          ids_{};
+    std::vector<instruction_reference>  refs_{};
+
+    std::size_t block_of(std::size_t i) const;
+};
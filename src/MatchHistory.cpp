@@ -0,0 +1,41 @@
+#include "MatchHistory.h"
+
+#include <algorithm>
+
+void MatchHistory::reset(std::size_t count, std::size_t width, std::size_t depth) {
+    // One validity bit per column
+    depth = std::min<std::size_t>(depth, 8);
+    columns_.assign(depth, {});
+    valid_ = {};
+    count_ = depth > 0 ? count : 0;
+    width_ = width;
+    head_ = depth > 0 ? depth - 1 : 0;
+    filled_ = 0;
+}
+
+void MatchHistory::begin_column() {
+    if (columns_.empty()) {
+        return;
+    }
+    head_ = (head_ + 1) % columns_.size();
+    filled_ = std::min(filled_ + 1, columns_.size());
+    // Columns that were never written are allocated on first use
+    if (valid_.empty()) {
+        valid_.assign(count_, 0);
+    }
+    columns_[head_].resize(count_ * width_);
+}
+
+void MatchHistory::resize(std::size_t count) {
+    for (std::vector<std::uint8_t> &column : columns_) {
+        if (!column.empty()) {
+            column.resize(count * width_);
+            column.shrink_to_fit();
+        }
+    }
+    if (!valid_.empty()) {
+        valid_.resize(count);
+        valid_.shrink_to_fit();
+    }
+    count_ = count;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/**
+ * Values of every match over the last few scans and refreshes, kept next to
+ * the match list with the same indices.
+ *
+ * Columnar ring: each column holds one value per match at the match's value
+ * width, column validity is a bitmask per match. Columns are allocated the
+ * first time they are written, so a u32 history costs 5 bytes per match
+ * after one scan and 17 once all 4 columns of the default depth are filled.
+ * begin_column() reuses the oldest column, the caller must then set() or
+ * invalidate() every match.
+ */
+class MatchHistory {
+public:
+    static constexpr std::size_t default_depth = 4;
+
+    /**
+     * @brief reset drops all history and sizes it for `count` matches,
+     * nothing is allocated until the first begin_column
+     */
+    void reset(std::size_t count, std::size_t width, std::size_t depth = default_depth);
+
+    void clear() {
+        reset(0, 0, 0);
+    }
+
+    std::size_t size() const {
+        return count_;
+    }
+
+    std::size_t width() const {
+        return width_;
+    }
+
+    std::size_t depth() const {
+        return columns_.size();
+    }
+
+    /** Amount of columns holding data, at most depth() */
+    std::size_t filled() const {
+        return filled_;
+    }
+
+    /** @brief begin_column makes the oldest column the newest */
+    void begin_column();
+
+    /** @brief set stores the value of `match` in the newest column */
+    void set(std::size_t match, const void *value) {
+        std::memcpy(&columns_[head_][match * width_], value, width_);
+        valid_[match] = static_cast<std::uint8_t>(valid_[match] | (1u << head_));
+    }
+
+    /** @brief invalidate marks the newest value of `match` as unreadable */
+    void invalidate(std::size_t match) {
+        valid_[match] = static_cast<std::uint8_t>(valid_[match] & ~(1u << head_));
+    }
+
+    /**
+     * @brief get reads a value zero-extended to 64 bits
+     * @param age 0 for the newest column, 1 for the one before it etc.
+     * @return false if there is no such column or the value wasn't readable
+     */
+    bool get(std::size_t match, std::size_t age, std::uint64_t &value) const {
+        if (age >= filled_ || match >= count_) {
+            return false;
+        }
+        const std::size_t column = (head_ + columns_.size() - age) % columns_.size();
+        if (!(valid_[match] & (1u << column))) {
+            return false;
+        }
+        value = 0;
+        std::memcpy(&value, &columns_[column][match * width_], width_);
+        return true;
+    }
+
+    /**
+     * @brief move copies the history of match `from` to `to`, used while
+     * compacting the matches in place
+     */
+    void move(std::size_t from, std::size_t to) {
+        for (std::vector<std::uint8_t> &column : columns_) {
+            if (!column.empty()) {
+                std::memmove(&column[to * width_], &column[from * width_], width_);
+            }
+        }
+        if (!valid_.empty()) {
+            valid_[to] = valid_[from];
+        }
+    }
+
+    /** @brief resize truncates to `count` matches after compacting */
+    void resize(std::size_t count);
+
+private:
+    std::vector<std::vector<std::uint8_t>>  columns_{};
+    std::vector<std::uint8_t>               valid_{};
+    std::size_t                             count_{};
+    std::size_t                             width_{};
+    std::size_t                             head_{};
+    std::size_t                             filled_{};
+};
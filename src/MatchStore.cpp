@@ -0,0 +1,66 @@
+#include "MatchStore.h"
+
+#include <algorithm>
+#include <sys/mman.h>
+
+MatchStore::~MatchStore() {
+    unmap();
+}
+
+void MatchStore::unmap() {
+    if (map_ != nullptr) {
+        munmap(map_, map_size_);
+        map_ = nullptr;
+        map_size_ = 0;
+        data_ = owned_.data();
+        size_ = owned_.size();
+    }
+}
+
+/**
+ * @brief detach copies a mapped list to the heap so it can grow
+ */
+void MatchStore::detach() {
+    if (map_ == nullptr) {
+        return;
+    }
+    std::vector<void *> copy(data_, data_ + size_);
+    unmap();
+    *this = std::move(copy);
+}
+
+void MatchStore::map(void *mapping, std::size_t mapping_size, std::size_t offset,
+                     std::size_t count) {
+    clear();
+    owned_.shrink_to_fit();
+    map_ = mapping;
+    map_size_ = mapping_size;
+    data_ = reinterpret_cast<void **>(static_cast<char *>(mapping) + offset);
+    size_ = count;
+    // Matches are walked front to back by every scan
+    madvise(map_, map_size_, MADV_SEQUENTIAL);
+}
+
+void MatchStore::resize(std::size_t count) {
+    if (count > size_) {
+        detach();
+        owned_.resize(count);
+        data_ = owned_.data();
+    } else if (map_ == nullptr) {
+        owned_.resize(count);
+    }
+    size_ = count;
+}
+
+void MatchStore::push_back(void *match) {
+    detach();
+    owned_.push_back(match);
+    data_ = owned_.data();
+    size_ = owned_.size();
+}
+
+MatchStore::iterator MatchStore::erase(iterator first, iterator last) {
+    iterator tail = std::move(last, end(), first);
+    resize(static_cast<std::size_t>(tail - begin()));
+    return first;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+/**
+ * The scanner's match list. Matches either live in an ordinary vector or
+ * are a view into a mapped session file, so reopening a session doesn't
+ * copy them. The mapping is MAP_PRIVATE: next scan compacts it in place
+ * without touching the file, only the pages it writes get copied.
+ *
+ * Anything that grows the list moves a mapped list to the heap first.
+ */
+class MatchStore {
+    std::vector<void *> owned_{};
+    void                **data_{};
+    std::size_t         size_{};
+
+    /** Mapping backing data_, nullptr when owned_ is used */
+    void                *map_{};
+    std::size_t         map_size_{};
+
+    void unmap();
+    void detach();
+
+public:
+    using iterator = void **;
+    using const_iterator = void *const *;
+
+    MatchStore() = default;
+    ~MatchStore();
+    MatchStore(const MatchStore &) = delete;
+    MatchStore &operator=(const MatchStore &) = delete;
+
+    /**
+     * @brief map takes ownership of a mapping made with mmap, the matches
+     * are `count` pointers at `offset` into it
+     */
+    void map(void *mapping, std::size_t mapping_size, std::size_t offset, std::size_t count);
+
+    bool mapped() const {
+        return map_ != nullptr;
+    }
+
+    MatchStore &operator=(std::vector<void *> &&matches) {
+        unmap();
+        owned_ = std::move(matches);
+        data_ = owned_.data();
+        size_ = owned_.size();
+        return *this;
+    }
+
+    std::size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    void *&operator[](std::size_t i) {
+        return data_[i];
+    }
+
+    void *operator[](std::size_t i) const {
+        return data_[i];
+    }
+
+    iterator begin() {
+        return data_;
+    }
+
+    iterator end() {
+        return data_ + size_;
+    }
+
+    const_iterator begin() const {
+        return data_;
+    }
+
+    const_iterator end() const {
+        return data_ + size_;
+    }
+
+    std::span<void *const> span() const {
+        return {data_, size_};
+    }
+
+    void clear() {
+        unmap();
+        owned_.clear();
+        data_ = owned_.data();
+        size_ = 0;
+    }
+
+    void swap(MatchStore &other) {
+        std::swap(owned_, other.owned_);
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        std::swap(map_, other.map_);
+        std::swap(map_size_, other.map_size_);
+    }
+
+    void resize(std::size_t count);
+    void push_back(void *match);
+
+    /** @brief erase removes [first, last), like std::vector::erase */
+    iterator erase(iterator first, iterator last);
+};
@@ -0,0 +1,452 @@
+#include "MemorySampler.h"
+#include "perf.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <optional>
+#include <poll.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+/** Soft-dirty bit in a /proc/pid/pagemap entry */
+constexpr std::uint64_t pagemap_soft_dirty = 1ull << 55;
+
+std::size_t page_size() {
+    static const auto size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+struct pmu_event {
+    std::uint32_t   type;
+    std::uint64_t   config[3];
+};
+
+std::string read_line(const std::string &path) {
+    char buf[256] = {};
+    FILE *f = fopen(path.c_str(), "r");
+    if (f == nullptr) {
+        return {};
+    }
+    if (fgets(buf, sizeof(buf), f) == nullptr) {
+        buf[0] = '\0';
+    }
+    fclose(f);
+    std::string line = buf;
+    while (!line.empty() && (line.back() == '\n' || line.back() == ' ')) {
+        line.pop_back();
+    }
+    return line;
+}
+
+/**
+ * @brief place_bits stores `value` into the config fields described by a
+ * pmu format string such as "config:0-7" or "config1:0-15"
+ */
+bool place_bits(pmu_event &event, const std::string &format, std::uint64_t value) {
+    std::size_t colon = format.find(':');
+    if (colon == std::string::npos) {
+        return false;
+    }
+    const std::string field = format.substr(0, colon);
+    std::uint64_t *config = field == "config"    ? &event.config[0]
+                          : field == "config1"   ? &event.config[1]
+                          : field == "config2"   ? &event.config[2]
+                                                 : nullptr;
+    if (config == nullptr) {
+        return false;
+    }
+    // The bits may be split over several ranges, fill them low to high
+    const char *p = format.c_str() + colon + 1;
+    while (*p != '\0') {
+        char *end = nullptr;
+        unsigned lo = static_cast<unsigned>(strtoul(p, &end, 10));
+        unsigned hi = lo;
+        if (*end == '-') {
+            hi = static_cast<unsigned>(strtoul(end + 1, &end, 10));
+        }
+        for (unsigned bit = lo; bit <= hi && bit < 64; ++bit) {
+            *config |= (value & 1) << bit;
+            value >>= 1;
+        }
+        p = *end == ',' ? end + 1 : end;
+        if (end == p && *p != '\0') {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief find_pmu_event resolves a named event like "mem-stores" through
+ * the pmu description in sysfs
+ */
+std::optional<pmu_event> find_pmu_event(const char *name) {
+    for (const char *pmu : {"cpu", "cpu_core"}) {
+        const std::string dir = std::string("/sys/bus/event_source/devices/") + pmu;
+        const std::string terms = read_line(dir + "/events/" + name);
+        const std::string type = read_line(dir + "/type");
+        if (terms.empty() || type.empty()) {
+            continue;
+        }
+
+        pmu_event event{static_cast<std::uint32_t>(strtoul(type.c_str(), nullptr, 10)), {}};
+        bool ok = true;
+        std::size_t start = 0;
+        while (ok && start < terms.size()) {
+            std::size_t comma = terms.find(',', start);
+            std::string term = terms.substr(start, comma == std::string::npos ? comma : comma - start);
+            start = comma == std::string::npos ? terms.size() : comma + 1;
+
+            std::size_t eq = term.find('=');
+            std::string key = term.substr(0, eq);
+            std::uint64_t value = eq == std::string::npos ? 1 : strtoull(term.c_str() + eq + 1, nullptr, 0);
+            ok = place_bits(event, read_line(dir + "/format/" + key), value);
+        }
+        if (ok) {
+            return event;
+        }
+    }
+    return std::nullopt;
+}
+
+/**
+ * @brief soft_dirty_supported checks whether the kernel tracks soft-dirty
+ * bits, freshly faulted pages are always soft-dirty when it does
+ */
+bool soft_dirty_supported() {
+    const std::size_t page = page_size();
+    void *mem = mmap(nullptr, page, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        return false;
+    }
+    *static_cast<volatile char *>(mem) = 1;
+
+    std::uint64_t entry = 0;
+    int fd = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        if (pread(fd, &entry, sizeof(entry),
+                  static_cast<off_t>(reinterpret_cast<std::uintptr_t>(mem) / page * sizeof(entry))) !=
+            sizeof(entry)) {
+            entry = 0;
+        }
+        close(fd);
+    }
+    munmap(mem, page);
+    return (entry & pagemap_soft_dirty) != 0;
+}
+
+bool clear_soft_dirty(pid_t pid) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/clear_refs", pid);
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = write(fd, "4", 1) == 1;
+    close(fd);
+    return ok;
+}
+}
+
+MemorySampler::MemorySampler() : thread_(&MemorySampler::run, this) {}
+
+MemorySampler::~MemorySampler() {
+    quit_ = true;
+    wakeup_.wake();
+    thread_.join();
+    std::lock_guard lock{lock_};
+    events_.clear();
+    retired_.clear();
+}
+
+const char *MemorySampler::source_name(source s) {
+    switch (s) {
+    case SOURCE_MEM_STORES:
+        return "mem-stores";
+    case SOURCE_MEM_LOADS:
+        return "mem-loads";
+    case SOURCE_SOFT_DIRTY:
+        return "soft-dirty pages";
+    case SOURCE_PAGE_FAULTS:
+        return "page faults";
+    case SOURCE_NONE:
+    default:
+        return "none";
+    }
+}
+
+std::size_t MemorySampler::granularity() const {
+    return source_.load() == SOURCE_SOFT_DIRTY ? page_size() : 1;
+}
+
+/**
+ * @brief MemorySampler::open_event samples thread `tid` with attr_
+ * @return 0 or the errno of the last attempt
+ */
+int MemorySampler::open_event(pid_t tid) {
+    perf_event_attr pe = attr_;
+    // Data addresses from the pmu need PEBS or the like, ask for the most
+    // precise sampling it accepts
+    int error = EINVAL;
+    for (unsigned precise = pe.type == PERF_TYPE_SOFTWARE ? 1 : 3; precise > 0 && error != 0; --precise) {
+        pe.precise_ip = pe.type == PERF_TYPE_SOFTWARE ? 0 : precise & 3;
+        error = events_.open(pe, tid);
+    }
+    return error;
+}
+
+bool MemorySampler::open_all(pid_t pid) {
+    int error = ESRCH;
+    for (pid_t tid : get_threads(pid)) {
+        if (int e = open_event(tid); e != 0) {
+            error = e;
+        }
+    }
+    if (events_.empty()) {
+        fprintf(stderr, "MemorySampler: perf_event_open: %s\n", strerror(error));
+        return false;
+    }
+    return true;
+}
+
+void MemorySampler::close_events() {
+    // The sampler thread may be polling them
+    if (!events_.empty()) {
+        retired_.push_back(std::move(events_));
+        events_ = PerfRings(ring_pages);
+    }
+    wakeup_.wake();
+}
+
+MemorySampler::source MemorySampler::start(pid_t pid, bool loads, std::uint64_t period,
+                                            std::vector<address_range> ranges) {
+    std::lock_guard lock{lock_};
+    running_ = false;
+    close_events();
+    samples_.clear();
+    total_ = 0;
+    lost_ = 0;
+    pid_ = pid;
+    ++session_;
+    soft_dirty_ranges_ = std::move(ranges);
+
+    attr_ = {};
+    attr_.size = sizeof(attr_);
+    attr_.sample_period = std::max<std::uint64_t>(period, 1);
+    attr_.sample_type = PERF_SAMPLE_IP | PERF_SAMPLE_ADDR;
+    attr_.exclude_kernel = 1;
+    attr_.exclude_hv = 1;
+    attr_.wakeup_events = 64;
+
+    if (std::optional<pmu_event> event = find_pmu_event(loads ? "mem-loads" : "mem-stores")) {
+        attr_.type = event->type;
+        attr_.config = event->config[0];
+        attr_.config1 = event->config[1];
+        attr_.config2 = event->config[2];
+        if (open_all(pid)) {
+            source_ = loads ? SOURCE_MEM_LOADS : SOURCE_MEM_STORES;
+            running_ = true;
+            return source_.load();
+        }
+    }
+
+    if (soft_dirty_supported() && clear_soft_dirty(pid)) {
+        fprintf(stderr, "MemorySampler: no memory sampling events, using soft-dirty pages\n");
+        source_ = SOURCE_SOFT_DIRTY;
+        running_ = true;
+        return source_.load();
+    }
+
+    fprintf(stderr, "MemorySampler: no soft-dirty tracking, sampling page faults\n");
+    attr_.type = PERF_TYPE_SOFTWARE;
+    attr_.config = PERF_COUNT_SW_PAGE_FAULTS;
+    attr_.sample_period = 1;
+    attr_.wakeup_events = 1;
+    source_ = open_all(pid) ? SOURCE_PAGE_FAULTS : SOURCE_NONE;
+    running_ = source_.load() != SOURCE_NONE;
+    return source_.load();
+}
+
+void MemorySampler::stop() {
+    std::lock_guard lock{lock_};
+    running_ = false;
+    close_events();
+}
+
+void MemorySampler::count_sample(const std::uint8_t *body, std::size_t size) {
+    // struct { u64 ip; u64 addr; }
+    std::uint64_t addr = 0;
+    if (size < 2 * sizeof(std::uint64_t)) {
+        return;
+    }
+    std::memcpy(&addr, body + sizeof(std::uint64_t), sizeof(addr));
+    if (addr != 0) {
+        ++samples_[addr];
+        total_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief MemorySampler::sample_soft_dirty counts the pages written since the
+ * previous call and clears the soft-dirty bits again. The pagemap is read
+ * without holding the lock, only the counts are merged under it.
+ */
+bool MemorySampler::sample_soft_dirty() {
+    pid_t pid = -1;
+    std::uint64_t session = 0;
+    std::vector<address_range> ranges;
+    {
+        std::lock_guard lock{lock_};
+        pid = pid_;
+        session = session_;
+        ranges = soft_dirty_ranges_;
+    }
+    if (ranges.empty()) {
+        ranges = get_memory_ranges(pid, false);
+    }
+    range_filter filter{};
+    filter.writable_only = true;
+    ranges = apply_range_filter(ranges, filter);
+
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/pagemap", pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    const std::size_t page = page_size();
+    std::vector<std::uint64_t> entries;
+    std::vector<std::uintptr_t> dirty;
+    for (const address_range &range : ranges) {
+        // Ranges given by the caller may be clipped to an address window
+        const auto start = reinterpret_cast<std::uintptr_t>(range.start) / page * page;
+        const auto end = reinterpret_cast<std::uintptr_t>(range.start) + range.length;
+        entries.resize((end - start + page - 1) / page);
+        const auto bytes = static_cast<ssize_t>(entries.size() * sizeof(std::uint64_t));
+        if (pread(fd, entries.data(), static_cast<std::size_t>(bytes),
+                  static_cast<off_t>(start / page * sizeof(std::uint64_t))) != bytes) {
+            continue;
+        }
+        for (std::size_t i = 0; i < entries.size(); ++i) {
+            if (entries[i] & pagemap_soft_dirty) {
+                dirty.push_back(start + i * page);
+            }
+        }
+    }
+    close(fd);
+    const bool cleared = clear_soft_dirty(pid);
+
+    std::lock_guard lock{lock_};
+    if (session != session_ || !running_) {
+        return true;
+    }
+    for (std::uintptr_t address : dirty) {
+        ++samples_[address];
+    }
+    total_.fetch_add(dirty.size(), std::memory_order_relaxed);
+    return cleared;
+}
+
+void MemorySampler::run() {
+    using namespace std::chrono_literals;
+    auto last_rescan = std::chrono::steady_clock::now();
+    auto last_soft_dirty = last_rescan;
+    std::vector<pollfd> fds;
+
+    while (!quit_) {
+        {
+            // Nothing polls the events of ended sessions between two polls
+            std::lock_guard lock{lock_};
+            retired_.clear();
+        }
+        if (!running_) {
+            std::this_thread::sleep_for(50ms);
+            continue;
+        }
+        if (source_.load() == SOURCE_SOFT_DIRTY) {
+            // Short sleeps keep stop() and quitting responsive with long
+            // intervals
+            std::this_thread::sleep_for(10ms);
+            auto now = std::chrono::steady_clock::now();
+            if (now - last_soft_dirty < soft_dirty_interval()) {
+                continue;
+            }
+            last_soft_dirty = now;
+            if (!sample_soft_dirty()) {
+                running_ = false;
+            }
+            continue;
+        }
+
+        fds.assign(1, wakeup_.entry());
+        {
+            std::lock_guard lock{lock_};
+            events_.add_fds(fds);
+        }
+        poll(fds.data(), fds.size(), 100);
+        wakeup_.reset();
+
+        auto now = std::chrono::steady_clock::now();
+        std::lock_guard lock{lock_};
+        auto sample = [this](const std::uint8_t *body, std::size_t size) {
+            count_sample(body, size);
+        };
+        if (now - last_rescan > 500ms) {
+            last_rescan = now;
+            lost_.fetch_add(events_.sync_threads(
+                pid_, [this](pid_t tid) { return open_event(tid); }, sample));
+        }
+        lost_.fetch_add(events_.drain(sample));
+    }
+}
+
+std::vector<MemorySampler::hot_address> MemorySampler::hottest(std::size_t count) const {
+    std::vector<hot_address> hot;
+    {
+        std::lock_guard lock{lock_};
+        hot.reserve(samples_.size());
+        for (auto [address, samples] : samples_) {
+            hot.push_back({address, samples});
+        }
+    }
+    count = std::min(count, hot.size());
+    std::partial_sort(hot.begin(), hot.begin() + static_cast<std::ptrdiff_t>(count), hot.end(),
+                      [](const hot_address &a, const hot_address &b) {
+                          return a.samples > b.samples ||
+                                 (a.samples == b.samples && a.address < b.address);
+                      });
+    hot.resize(count);
+    return hot;
+}
+
+std::vector<MemorySampler::range_heat> MemorySampler::heat(const maps_snapshot &maps) const {
+    std::unordered_map<std::size_t, range_heat> ranges;
+    {
+        std::lock_guard lock{lock_};
+        for (auto [address, samples] : samples_) {
+            std::ptrdiff_t index = maps.index.find(address);
+            if (index == address_range_index::npos) {
+                continue;
+            }
+            range_heat &heat = ranges[std::size_t(index)];
+            heat.range = std::size_t(index);
+            heat.samples += samples;
+            ++heat.addresses;
+        }
+    }
+    std::vector<range_heat> heat;
+    heat.reserve(ranges.size());
+    for (auto &[index, h] : ranges) {
+        heat.push_back(h);
+    }
+    std::sort(heat.begin(), heat.end(), [](const range_heat &a, const range_heat &b) {
+        return a.samples > b.samples;
+    });
+    return heat;
+}
@@ -0,0 +1,150 @@
+#pragma once
+#include "PerfRings.h"
+#include "maps.h"
+#include "perf.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/types.h>
+
+/**
+ * Samples which addresses the target touches instead of scanning for them.
+ *
+ * Where the cpu pmu exposes precise memory events (mem-stores, mem-loads)
+ * every thread of the target gets a sampling event recording the data
+ * address, samples are drained from the perf ring buffers by a background
+ * thread. Elsewhere, e.g. in VMs without a virtual pmu, it falls back to
+ * the kernel's soft-dirty page tracking which reports written pages instead
+ * of exact addresses, and without that to sampling page faults which only
+ * sees the first touch of a page.
+ *
+ * Soft-dirty bits are per process: clearing them every interval also resets
+ * them for anything else tracking the target, e.g. CRIU.
+ */
+class MemorySampler {
+public:
+    enum source {
+        SOURCE_NONE = 0,
+        SOURCE_MEM_STORES,
+        SOURCE_MEM_LOADS,
+        SOURCE_SOFT_DIRTY,
+        SOURCE_PAGE_FAULTS
+    };
+
+    struct hot_address {
+        std::uintptr_t  address;
+        std::uint64_t   samples;
+    };
+
+    /** Samples falling into one range of the snapshot given to heat() */
+    struct range_heat {
+        std::size_t     range;
+        std::uint64_t   samples;
+        std::size_t     addresses;
+    };
+
+    MemorySampler();
+    ~MemorySampler();
+    MemorySampler(const MemorySampler &) = delete;
+    MemorySampler &operator=(const MemorySampler &) = delete;
+
+    static constexpr std::chrono::milliseconds default_soft_dirty_interval{250};
+
+    /**
+     * @brief start begins sampling `pid`, replacing the previous session and
+     * its samples
+     * @param loads sample loads instead of stores where the pmu can
+     * @param period take a sample every `period` events, not used with
+     * soft-dirty tracking
+     * @param ranges what soft-dirty tracking reads the pagemap of, the
+     * writable parts of these. Every writable range if empty.
+     * @return the source used, SOURCE_NONE on error
+     */
+    source start(pid_t pid, bool loads = false, std::uint64_t period = 1000,
+                 std::vector<address_range> ranges = {});
+    /** @brief stop ends the session, its samples are kept */
+    void stop();
+
+    /** The source of the current or last session */
+    source current_source() const {
+        return source_.load();
+    }
+
+    bool running() const {
+        return running_.load();
+    }
+
+    /**
+     * @brief soft_dirty_interval sets how often soft-dirty bits are read and
+     * cleared. Every clear makes the target fault on its next write to each
+     * page, so shorter intervals cost it more.
+     */
+    void soft_dirty_interval(std::chrono::milliseconds interval) {
+        soft_dirty_interval_.store(std::max(interval, std::chrono::milliseconds{10}).count());
+    }
+
+    std::chrono::milliseconds soft_dirty_interval() const {
+        return std::chrono::milliseconds{soft_dirty_interval_.load()};
+    }
+
+    /**
+     * @brief granularity is how many bytes one sampled address stands for,
+     * 1 for exact addresses and the page size for soft-dirty tracking
+     */
+    std::size_t granularity() const;
+
+    /** @brief hottest returns the `count` most sampled addresses */
+    std::vector<hot_address> hottest(std::size_t count) const;
+
+    /** @brief heat sums the samples per range, hottest first */
+    std::vector<range_heat> heat(const maps_snapshot &maps) const;
+
+    std::uint64_t total_samples() const {
+        return total_.load();
+    }
+
+    std::uint64_t lost() const {
+        return lost_.load();
+    }
+
+    static const char *source_name(source s);
+
+private:
+    /** Data pages of each ring buffer, must be a power of two */
+    static constexpr std::size_t ring_pages = 16;
+
+    mutable std::mutex                                  lock_{};
+    std::unordered_map<std::uintptr_t, std::uint64_t>   samples_{};
+    PerfRings                                           events_{ring_pages};
+    /** Events of ended sessions, closed by the sampler thread after its poll */
+    std::vector<PerfRings>                              retired_{};
+    PollWakeup                                          wakeup_{};
+    pid_t                                               pid_{-1};
+    /** Counts sessions so a soft-dirty pass of an old one is dropped */
+    std::uint64_t                                       session_{};
+    std::vector<address_range>                          soft_dirty_ranges_{};
+    std::atomic<std::chrono::milliseconds::rep>         soft_dirty_interval_{
+        default_soft_dirty_interval.count()};
+    perf_event_attr                                     attr_{};
+    std::atomic<source>                                 source_{SOURCE_NONE};
+    std::atomic<bool>                                   running_{};
+    std::atomic<bool>                                   quit_{};
+    std::atomic<std::uint64_t>                          total_{};
+    std::atomic<std::uint64_t>                          lost_{};
+    std::thread                                         thread_{};
+
+    int open_event(pid_t tid);
+    bool open_all(pid_t pid);
+    void close_events();
+    void count_sample(const std::uint8_t *body, std::size_t size);
+    bool sample_soft_dirty();
+    void run();
+};
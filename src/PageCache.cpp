@@ -0,0 +1,75 @@
+#include "PageCache.h"
+#include "ProcessMemory.h"
+
+#include <algorithm>
+#include <vector>
+
+std::size_t PageCache::refresh(std::uintptr_t first, std::uintptr_t last) {
+    if (last <= first || pid_ <= 0) {
+        return 0;
+    }
+    ++generation_;
+    first &= ~(page_size - 1);
+    const std::size_t count = (last - first + page_size - 1) / page_size;
+
+    // Read into scratch buffers so the old contents can be compared
+    auto scratch = std::make_unique<std::uint8_t[]>(count * page_size);
+    std::vector<ReadRequest> requests(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        requests[i] = {reinterpret_cast<void *>(first + i * page_size),
+                       &scratch[i * page_size], page_size};
+    }
+    const std::size_t read = ProcessMemory::read_many(pid_, requests);
+
+    for (std::size_t i = 0; i < count; ++i) {
+        std::unique_ptr<page> &p = pages_[first + i * page_size];
+        const std::uint8_t *data = &scratch[i * page_size];
+        const bool valid = requests[i].result == static_cast<ssize_t>(page_size);
+        if (!p) {
+            p = std::make_unique<page>();
+            p->valid = false;
+        }
+        p->used = generation_;
+        if (!valid) {
+            p->valid = false;
+            continue;
+        }
+        if (!p->valid) {
+            // Nothing to compare to, a page coming back isn't a change
+            std::copy_n(data, page_size, p->data.begin());
+            p->age.fill(age_unchanged);
+            p->valid = true;
+            continue;
+        }
+        for (std::size_t b = 0; b < page_size; ++b) {
+            if (p->data[b] != data[b]) {
+                p->data[b] = data[b];
+                p->age[b] = 0;
+            } else if (p->age[b] < age_unchanged - 1) {
+                ++p->age[b];
+            }
+        }
+    }
+
+    if (pages_.size() > capacity_) {
+        evict();
+    }
+    return read;
+}
+
+void PageCache::evict() {
+    // Drop the oldest pages, never the ones of the current refresh
+    std::vector<std::pair<std::uint64_t, std::uintptr_t>> by_use;
+    by_use.reserve(pages_.size());
+    for (const auto &[address, p] : pages_) {
+        if (p->used != generation_) {
+            by_use.emplace_back(p->used, address);
+        }
+    }
+    const std::size_t excess = std::min(pages_.size() - capacity_, by_use.size());
+    std::nth_element(by_use.begin(), by_use.begin() + static_cast<std::ptrdiff_t>(excess),
+                     by_use.end());
+    for (std::size_t i = 0; i < excess; ++i) {
+        pages_.erase(by_use[i].second);
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <sys/types.h>
+
+/**
+ * Copies of the target's pages for viewers that show raw memory. Only the
+ * pages asked for are read, all of them with one read_many batch, and every
+ * byte remembers how many refreshes ago it last changed.
+ */
+class PageCache {
+public:
+    static constexpr std::size_t page_size = 4096;
+
+    /** Pages kept before the least recently refreshed are dropped */
+    static constexpr std::size_t default_capacity = 256;
+
+    /** Age of a byte that hasn't changed since it was first read */
+    static constexpr std::uint8_t age_unchanged = 0xff;
+
+    struct page {
+        std::array<std::uint8_t, page_size> data;
+        /** Refreshes since each byte last changed, saturating */
+        std::array<std::uint8_t, page_size> age;
+        /** The last read of the page succeeded */
+        bool                                valid;
+        /** Refresh the page was last part of, for eviction */
+        std::uint64_t                       used;
+    };
+
+    explicit PageCache(std::size_t capacity = default_capacity)
+        : capacity_(capacity) {}
+
+    /** @brief pid switches the process, dropping every page */
+    void pid(pid_t pid) {
+        pid_ = pid;
+        clear();
+    }
+
+    pid_t pid() const {
+        return pid_;
+    }
+
+    void clear() {
+        pages_.clear();
+    }
+
+    /**
+     * @brief refresh reads every page overlapping [first, last)
+     * @return the amount of pages that could be read
+     */
+    std::size_t refresh(std::uintptr_t first, std::uintptr_t last);
+
+    /** @brief find returns the cached page at `page_address` or null */
+    const page *find(std::uintptr_t page_address) const {
+        auto it = pages_.find(page_address);
+        return it != pages_.end() ? it->second.get() : nullptr;
+    }
+
+    /**
+     * @brief byte looks up a cached byte
+     * @return false if the page wasn't read or couldn't be read
+     */
+    bool byte(std::uintptr_t address, std::uint8_t &value, std::uint8_t &age) const {
+        const page *p = find(address & ~(page_size - 1));
+        if (p == nullptr || !p->valid) {
+            return false;
+        }
+        value = p->data[address & (page_size - 1)];
+        age = p->age[address & (page_size - 1)];
+        return true;
+    }
+
+    std::size_t size() const {
+        return pages_.size();
+    }
+
+private:
+    std::unordered_map<std::uintptr_t, std::unique_ptr<page>>  pages_{};
+    std::size_t                                                 capacity_;
+    std::uint64_t                                               generation_{};
+    pid_t                                                       pid_{-1};
+
+    void evict();
+};
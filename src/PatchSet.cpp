@@ -0,0 +1,113 @@
+#include "PatchSet.h"
+#include "ProcessMemory.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+
+bool PatchSet::add(void *address, const void *bytes, std::size_t size) {
+    if (applied_) {
+        return false;
+    }
+    // Writes that fail in the batch are retried after the rest, two
+    // patches touching the same bytes could land in either order. Patches
+    // are kept sorted by address, only the neighbours can overlap.
+    const auto start = reinterpret_cast<std::uintptr_t>(address);
+    auto next = std::lower_bound(patches_.begin(), patches_.end(), start,
+        [](const patch &p, std::uintptr_t value) {
+            return reinterpret_cast<std::uintptr_t>(p.address) < value;
+        });
+    if (next != patches_.end() &&
+        reinterpret_cast<std::uintptr_t>(next->address) < start + size) {
+        fprintf(stderr, "PatchSet: patch at %p overlaps the one at %p\n", address, next->address);
+        return false;
+    }
+    if (next != patches_.begin()) {
+        const patch &previous = *std::prev(next);
+        if (reinterpret_cast<std::uintptr_t>(previous.address) + previous.bytes.size() > start) {
+            fprintf(stderr, "PatchSet: patch at %p overlaps the one at %p\n", address,
+                    previous.address);
+            return false;
+        }
+    }
+    const auto *begin = static_cast<const std::uint8_t *>(bytes);
+    patches_.insert(next, {address, {begin, begin + size}, {}});
+    return true;
+}
+
+/**
+ * @brief PatchSet::write writes `field` of every patch in order
+ * @param written if given, set to which patches were written
+ * @return true if all of them were
+ */
+bool PatchSet::write(const std::vector<std::uint8_t> patch::*field,
+                     std::vector<bool> *written) {
+    std::vector<WriteRequest> requests(patches_.size());
+    for (std::size_t i = 0; i < patches_.size(); ++i) {
+        const std::vector<std::uint8_t> &bytes = patches_[i].*field;
+        requests[i] = {patches_[i].address, bytes.data(), bytes.size()};
+    }
+
+    std::size_t done = ProcessMemory::write_many(pid_, requests);
+    if (done < requests.size()) {
+        done += ProcessMemory::write_proc_mem(pid_, requests);
+    }
+    if (written != nullptr) {
+        written->resize(requests.size());
+        for (std::size_t i = 0; i < requests.size(); ++i) {
+            (*written)[i] = requests[i].result >= 0;
+        }
+    }
+    return done == requests.size();
+}
+
+bool PatchSet::apply() {
+    if (applied_) {
+        return true;
+    }
+
+    // Read every original before writing anything, a failed write rolls
+    // back the ones before it
+    std::vector<ReadRequest> reads(patches_.size());
+    for (std::size_t i = 0; i < patches_.size(); ++i) {
+        patch &p = patches_[i];
+        p.original.resize(p.bytes.size());
+        reads[i] = {p.address, p.original.data(), p.original.size()};
+    }
+    if (ProcessMemory::read_many(pid_, reads) != reads.size()) {
+        fprintf(stderr, "PatchSet: could not read the original bytes, nothing was written\n");
+        return false;
+    }
+
+    std::vector<bool> written;
+    if (!write(&patch::bytes, &written)) {
+        fprintf(stderr, "PatchSet: could not write every patch, rolling back\n");
+        std::vector<WriteRequest> rollback;
+        for (std::size_t i = 0; i < patches_.size(); ++i) {
+            if (written[i]) {
+                const patch &p = patches_[i];
+                rollback.push_back({p.address, p.original.data(), p.original.size()});
+            }
+        }
+        std::size_t done = ProcessMemory::write_many(pid_, rollback);
+        if (done < rollback.size() &&
+            done + ProcessMemory::write_proc_mem(pid_, rollback) < rollback.size()) {
+            fprintf(stderr, "PatchSet: rollback failed, the target is partially patched\n");
+        }
+        return false;
+    }
+    applied_ = true;
+    return true;
+}
+
+bool PatchSet::revert() {
+    if (!applied_) {
+        return true;
+    }
+    if (!write(&patch::original)) {
+        fprintf(stderr, "PatchSet: could not restore every patch\n");
+        return false;
+    }
+    applied_ = false;
+    return true;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <sys/types.h>
+
+/**
+ * One replacement of bytes in the target, `original` is filled in when the
+ * patch is applied
+ */
+struct patch {
+    void                        *address;
+    std::vector<std::uint8_t>   bytes;
+    std::vector<std::uint8_t>   original;
+};
+
+/**
+ * A set of patches that is applied and reverted as a whole.
+ *
+ * Applying reads the original bytes of every patch first and then writes
+ * all of them with vectored writes, anything process_vm_writev refuses
+ * (read-only pages like the text segment) is retried through /proc/pid/mem.
+ * If any patch can't be written the ones that were are restored, so the
+ * target ends up either fully patched or untouched. Since patches don't
+ * overlap, neither the fallback writes nor the rollback depend on order. The target is not
+ * stopped meanwhile, a thread may observe the set half applied.
+ */
+class PatchSet {
+    pid_t               pid_;
+    std::vector<patch>  patches_{};
+    bool                applied_{};
+
+    bool write(const std::vector<std::uint8_t> patch::*field,
+               std::vector<bool> *written = nullptr);
+
+public:
+    explicit PatchSet(pid_t pid) : pid_(pid) {}
+
+    /**
+     * @brief add queues a patch, the set must not be applied. Patches of a
+     * set must not overlap and are kept ordered by address.
+     * @return false if the set is currently applied or the patch overlaps
+     * one already in the set
+     */
+    bool add(void *address, const void *bytes, std::size_t size);
+
+    /**
+     * @brief apply writes every patch
+     * @return false if anything failed, the target is left unchanged then
+     */
+    bool apply();
+
+    /**
+     * @brief revert writes back the original bytes of every patch
+     * @return false if some patch could not be restored
+     */
+    bool revert();
+
+    /** @brief clear forgets all patches, does not revert them */
+    void clear() {
+        patches_.clear();
+        applied_ = false;
+    }
+
+    bool applied() const {
+        return applied_;
+    }
+
+    bool empty() const {
+        return patches_.empty();
+    }
+
+    /** Patches ordered by address */
+    const std::vector<patch> &patches() const {
+        return patches_;
+    }
+
+    pid_t pid() const {
+        return pid_;
+    }
+};
@@ -0,0 +1,85 @@
+#include "PerfRings.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+
+PerfRings::PerfRings(PerfRings &&other) noexcept
+    : pages_(other.pages_), rings_(std::move(other.rings_)) {
+    other.rings_.clear();
+}
+
+PerfRings &PerfRings::operator=(PerfRings &&other) noexcept {
+    if (this != &other) {
+        clear();
+        pages_ = other.pages_;
+        rings_ = std::move(other.rings_);
+        other.rings_.clear();
+    }
+    return *this;
+}
+
+std::size_t PerfRings::map_size() const {
+    static const auto page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    return (pages_ + 1) * page;
+}
+
+int PerfRings::open(perf_event_attr attr, pid_t tid) {
+    int fd = static_cast<int>(perf_event_open(&attr, tid, -1, -1, PERF_FLAG_FD_CLOEXEC));
+    if (fd < 0) {
+        return errno;
+    }
+    void *data = mmap(nullptr, map_size(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        const int error = errno;
+        ::close(fd);
+        return error;
+    }
+    rings_.push_back({tid, fd, data});
+    return 0;
+}
+
+void PerfRings::close(ring &r) const {
+    munmap(r.data, map_size());
+    ::close(r.fd);
+}
+
+void PerfRings::add_fds(std::vector<pollfd> &fds) const {
+    for (const ring &r : rings_) {
+        fds.push_back({r.fd, POLLIN, 0});
+    }
+}
+
+void PerfRings::clear() {
+    for (ring &r : rings_) {
+        close(r);
+    }
+    rings_.clear();
+}
+
+PollWakeup::PollWakeup() : fd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {
+    if (fd_ < 0) {
+        perror("PollWakeup: eventfd");
+    }
+}
+
+PollWakeup::~PollWakeup() {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+void PollWakeup::wake() {
+    const std::uint64_t one = 1;
+    if (fd_ >= 0 && write(fd_, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        perror("PollWakeup: write");
+    }
+}
+
+void PollWakeup::reset() {
+    std::uint64_t count = 0;
+    if (fd_ >= 0 && read(fd_, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+        perror("PollWakeup: read");
+    }
+}
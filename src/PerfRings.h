@@ -0,0 +1,182 @@
+#pragma once
+#include "maps.h"
+#include "perf.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <vector>
+#include <poll.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+/**
+ * One sampling perf event per thread of a process, each with its ring
+ * buffer mapped. Shared by the tools that sample the target through perf,
+ * they only differ in the event and in what they take from a sample.
+ *
+ * Not thread safe, and a ring must not be closed while another thread
+ * polls its fd: move the set into a retired one and close it from the
+ * polling thread instead.
+ */
+class PerfRings {
+public:
+    struct ring {
+        pid_t   tid;
+        int     fd;
+        void    *data;
+    };
+
+    /** @param pages data pages of each ring buffer, a power of two */
+    explicit PerfRings(std::size_t pages) : pages_(pages) {}
+    ~PerfRings() {
+        clear();
+    }
+    PerfRings(const PerfRings &) = delete;
+    PerfRings &operator=(const PerfRings &) = delete;
+    PerfRings(PerfRings &&other) noexcept;
+    PerfRings &operator=(PerfRings &&other) noexcept;
+
+    /**
+     * @brief open opens `attr` on thread `tid` and maps its ring buffer
+     * @return 0 or the errno of the call that failed, taken before cleaning
+     * up so callers can tell a thread that exited (ESRCH) from a real error
+     */
+    int open(perf_event_attr attr, pid_t tid);
+
+    /**
+     * @brief sync_threads follows the threads of `pid`: rings of threads
+     * that exited are drained into `on_sample` and closed, threads not seen
+     * before are opened with `open_thread`
+     * @return records the kernel dropped in the rings that were closed
+     */
+    template<typename F>
+    std::uint64_t sync_threads(pid_t pid, const std::function<int(pid_t)> &open_thread,
+                               F &&on_sample);
+
+    /**
+     * @brief drain hands every PERF_RECORD_SAMPLE waiting in the rings to
+     * `on_sample(const std::uint8_t *body, std::size_t size)`, body being the
+     * record after its header
+     * @return records the kernel dropped because a ring was full
+     */
+    template<typename F>
+    std::uint64_t drain(F &&on_sample) {
+        std::uint64_t lost = 0;
+        for (ring &r : rings_) {
+            lost += drain(r, on_sample);
+        }
+        return lost;
+    }
+
+    /** @brief add_fds appends a POLLIN entry for every ring to `fds` */
+    void add_fds(std::vector<pollfd> &fds) const;
+
+    void clear();
+
+    bool empty() const {
+        return rings_.empty();
+    }
+
+    std::size_t size() const {
+        return rings_.size();
+    }
+
+private:
+    std::size_t         pages_;
+    std::vector<ring>   rings_{};
+
+    std::size_t map_size() const;
+    void close(ring &r) const;
+
+    template<typename F>
+    std::uint64_t drain(ring &r, F &&on_sample);
+};
+
+/**
+ * An eventfd to add to a poll set, so another thread can end the poll
+ * without closing any of the polled fds
+ */
+class PollWakeup {
+    int fd_;
+
+public:
+    PollWakeup();
+    ~PollWakeup();
+    PollWakeup(const PollWakeup &) = delete;
+    PollWakeup &operator=(const PollWakeup &) = delete;
+
+    pollfd entry() const {
+        return {fd_, POLLIN, 0};
+    }
+
+    void wake();
+
+    /** @brief reset consumes pending wakeups after the poll returned */
+    void reset();
+};
+
+template<typename F>
+std::uint64_t PerfRings::drain(ring &r, F &&on_sample) {
+    static const std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    const std::size_t data_size = pages_ * page;
+    auto *meta = static_cast<perf_event_mmap_page *>(r.data);
+    auto *data = static_cast<const std::uint8_t *>(r.data) + page;
+    const std::uint64_t head = __atomic_load_n(&meta->data_head, __ATOMIC_ACQUIRE);
+    std::uint64_t tail = meta->data_tail;
+    std::uint64_t lost = 0;
+
+    // Records may wrap around the end of the buffer
+    auto copy = [data, data_size](void *dst, std::uint64_t at, std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i) {
+            static_cast<std::uint8_t *>(dst)[i] = data[(at + i) % data_size];
+        }
+    };
+    while (tail < head) {
+        perf_event_header header{};
+        std::uint8_t record[64];
+        copy(&header, tail, sizeof(header));
+        if (header.size < sizeof(header)) {
+            tail = head;
+            break;
+        }
+        if (header.type == PERF_RECORD_SAMPLE && header.size <= sizeof(record)) {
+            copy(record, tail, header.size);
+            on_sample(record + sizeof(header), header.size - sizeof(header));
+        } else if (header.type == PERF_RECORD_LOST && header.size <= sizeof(record)) {
+            // struct { header; u64 id; u64 lost; }
+            copy(record, tail, header.size);
+            std::uint64_t count = 0;
+            std::memcpy(&count, record + sizeof(header) + sizeof(std::uint64_t), sizeof(count));
+            lost += count;
+        }
+        tail += header.size;
+    }
+    __atomic_store_n(&meta->data_tail, tail, __ATOMIC_RELEASE);
+    return lost;
+}
+
+template<typename F>
+std::uint64_t PerfRings::sync_threads(pid_t pid, const std::function<int(pid_t)> &open_thread,
+                                      F &&on_sample) {
+    std::vector<pid_t> tids = get_threads(pid);
+    std::uint64_t lost = 0;
+    std::erase_if(rings_, [&](ring &r) {
+        if (std::binary_search(tids.begin(), tids.end(), r.tid)) {
+            return false;
+        }
+        lost += drain(r, on_sample);
+        close(r);
+        return true;
+    });
+    for (pid_t tid : tids) {
+        auto known = std::any_of(rings_.begin(), rings_.end(),
+                                 [tid](const ring &r) { return r.tid == tid; });
+        if (!known) {
+            open_thread(tid);
+        }
+    }
+    return lost;
+}
@@ -0,0 +1,203 @@
+#include "PointerMapFile.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+static void write_varint(std::vector<std::uint8_t> &out, std::uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<std::uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(v));
+}
+
+static std::uint64_t align8(std::uint64_t v) {
+    return (v + 7) & ~std::uint64_t{7};
+}
+
+bool save_pointer_map(const std::string &path, const pointer_map &map,
+                      const maps_snapshot &maps) {
+    constexpr std::uint32_t block_entries = 256;
+
+    std::vector<pointer_map_range> ranges(maps.ranges.size());
+    std::string names;
+    for (std::size_t i = 0; i < maps.ranges.size(); ++i) {
+        const address_range &r = maps.ranges[i];
+        pointer_map_range &out = ranges[i];
+        out = {};
+        out.start = reinterpret_cast<std::uintptr_t>(r.start);
+        out.length = r.length;
+        out.offset = r.offset;
+        out.inode = r.inode;
+        out.device = r.device;
+        out.perms = r.perms;
+        out.name_offset = static_cast<std::uint32_t>(names.size());
+        out.name_length = static_cast<std::uint32_t>(std::strlen(r.name));
+        names.append(r.name, out.name_length);
+    }
+
+    std::vector<pointer_map_block> blocks;
+    std::vector<std::uint8_t> data;
+    std::uint64_t entry_count = 0;
+    std::uint64_t previous = 0;
+    for (const pointer_entry &entry : map.entries()) {
+        std::ptrdiff_t range = maps.index.find(entry.location);
+        if (range == address_range_index::npos) {
+            continue;
+        }
+        if (entry_count % block_entries == 0) {
+            blocks.push_back({entry.value, data.size()});
+            previous = entry.value;
+        }
+        write_varint(data, entry.value - previous);
+        write_varint(data, static_cast<std::uint64_t>(range));
+        write_varint(data, entry.location - ranges[std::size_t(range)].start);
+        previous = entry.value;
+        ++entry_count;
+    }
+
+    pointer_map_header header{};
+    std::memcpy(header.magic, pointer_map_file::magic, sizeof(header.magic));
+    header.version = pointer_map_file::version;
+    header.block_entries = block_entries;
+    header.range_count = ranges.size();
+    header.entry_count = entry_count;
+    header.block_count = blocks.size();
+    header.ranges_offset = sizeof(header);
+    header.names_offset = header.ranges_offset + ranges.size() * sizeof(pointer_map_range);
+    header.blocks_offset = align8(header.names_offset + names.size());
+    header.data_offset = header.blocks_offset + blocks.size() * sizeof(pointer_map_block);
+    header.file_size = header.data_offset + data.size();
+
+    // Written next to the target and renamed over it, an interrupted save
+    // leaves the old map intact
+    const std::string temporary = path + ".tmp";
+    FILE *f = fopen(temporary.c_str(), "wb");
+    if (f == nullptr) {
+        fprintf(stderr, "Error opening file %s: %s\n", temporary.c_str(), strerror(errno));
+        return false;
+    }
+    const char padding[8] = {};
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+              fwrite(ranges.data(), sizeof(pointer_map_range), ranges.size(), f) == ranges.size() &&
+              fwrite(names.data(), 1, names.size(), f) == names.size() &&
+              fwrite(padding, 1, header.blocks_offset - header.names_offset - names.size(), f) ==
+                  header.blocks_offset - header.names_offset - names.size() &&
+              fwrite(blocks.data(), sizeof(pointer_map_block), blocks.size(), f) == blocks.size() &&
+              fwrite(data.data(), 1, data.size(), f) == data.size();
+    if (fclose(f) != 0) {
+        ok = false;
+    }
+    if (ok && rename(temporary.c_str(), path.c_str()) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        fprintf(stderr, "Error writing pointer map %s: %s\n", path.c_str(), strerror(errno));
+        unlink(temporary.c_str());
+    }
+    return ok;
+}
+
+std::unique_ptr<pointer_map_file> pointer_map_file::open(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "Error opening file %s: %s\n", path.c_str(), strerror(errno));
+        return nullptr;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || std::size_t(st.st_size) < sizeof(pointer_map_header)) {
+        fprintf(stderr, "Error: %s is not a pointer map\n", path.c_str());
+        close(fd);
+        return nullptr;
+    }
+    const auto size = static_cast<std::size_t>(st.st_size);
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "Error mapping %s: %s\n", path.c_str(), strerror(errno));
+        return nullptr;
+    }
+
+    std::unique_ptr<pointer_map_file> file{new pointer_map_file()};
+    file->data_ = static_cast<const std::uint8_t *>(data);
+    file->size_ = size;
+    file->header_ = reinterpret_cast<const pointer_map_header *>(data);
+
+    if (!file->valid()) {
+        fprintf(stderr, "Error: %s is not a valid pointer map\n", path.c_str());
+        return nullptr;
+    }
+    const pointer_map_header &h = *file->header_;
+
+    std::vector<address_range> ranges(h.range_count);
+    for (std::size_t i = 0; i < ranges.size(); ++i) {
+        const pointer_map_range &in = file->ranges_[i];
+        address_range &out = ranges[i];
+        out.start = reinterpret_cast<void *>(in.start);
+        out.length = in.length;
+        out.offset = in.offset;
+        out.inode = in.inode;
+        out.device = in.device;
+        out.perms = in.perms;
+        std::size_t len = std::min<std::size_t>(in.name_length, sizeof(out.name) - 1);
+        std::memcpy(out.name, file->data_ + h.names_offset + in.name_offset, len);
+        out.name[len] = '\0';
+    }
+    file->maps_ = std::make_shared<const maps_snapshot>(std::move(ranges));
+    return file;
+}
+
+/**
+ * @brief pointer_map_file::valid checks that every section of the header and
+ * every block lies within the file, so queries can decode without bounds
+ * checks beyond the end of each block. Counts come from the file and are
+ * checked against the file size before being multiplied.
+ */
+bool pointer_map_file::valid() {
+    const pointer_map_header &h = *header_;
+    if (std::memcmp(h.magic, magic, sizeof(magic)) != 0 || h.version != version ||
+        h.file_size != size_ || h.block_entries == 0 ||
+        h.ranges_offset != sizeof(pointer_map_header) ||
+        h.range_count > (size_ - h.ranges_offset) / sizeof(pointer_map_range) ||
+        h.names_offset != h.ranges_offset + h.range_count * sizeof(pointer_map_range) ||
+        h.blocks_offset < h.names_offset || h.blocks_offset > size_ ||
+        h.blocks_offset % alignof(pointer_map_block) != 0 ||
+        h.block_count > (size_ - h.blocks_offset) / sizeof(pointer_map_block) ||
+        h.data_offset != h.blocks_offset + h.block_count * sizeof(pointer_map_block) ||
+        h.block_count != h.entry_count / h.block_entries +
+                             (h.entry_count % h.block_entries != 0 ? 1 : 0)) {
+        return false;
+    }
+    ranges_ = reinterpret_cast<const pointer_map_range *>(data_ + h.ranges_offset);
+    blocks_ = reinterpret_cast<const pointer_map_block *>(data_ + h.blocks_offset);
+
+    // for_each reads a block up to where the next one starts, and finds the
+    // blocks by binary search over their first value
+    const std::uint64_t data_size = size_ - h.data_offset;
+    for (std::size_t b = 0; b < h.block_count; ++b) {
+        if (blocks_[b].data_offset >= data_size ||
+            (b > 0 && (blocks_[b].data_offset < blocks_[b - 1].data_offset ||
+                       blocks_[b].first_value < blocks_[b - 1].first_value))) {
+            return false;
+        }
+    }
+    for (std::size_t i = 0; i < h.range_count; ++i) {
+        const pointer_map_range &r = ranges_[i];
+        if (std::uint64_t{r.name_offset} + r.name_length > h.blocks_offset - h.names_offset) {
+            return false;
+        }
+    }
+    return true;
+}
+
+pointer_map_file::~pointer_map_file() {
+    if (data_ != nullptr) {
+        munmap(const_cast<std::uint8_t *>(data_), size_);
+    }
+}
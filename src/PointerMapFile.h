@@ -0,0 +1,175 @@
+#pragma once
+#include "PointerScanner.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/*
+ * On-disk reverse pointer map, laid out so it can be queried straight from
+ * mmap without parsing:
+ *
+ *   pointer_map_header
+ *   pointer_map_range[range_count]     the maps snapshot the map was built from
+ *   char names[]                       range names, referenced by offset
+ *   pointer_map_block[block_count]     first value of every block, for bsearch
+ *   uint8_t data[]                     varint encoded entries
+ *
+ * Entries are sorted by value and stored in blocks of `block_entries`. Each
+ * entry is the delta from the previous value followed by the location as
+ * (range index, offset into range), so the file is independent of where the
+ * modules were loaded and two runs can be compared.
+ */
+
+struct pointer_map_header {
+    char            magic[8];
+    std::uint32_t   version;
+    std::uint32_t   block_entries;
+    std::uint64_t   range_count;
+    std::uint64_t   entry_count;
+    std::uint64_t   block_count;
+    std::uint64_t   ranges_offset;
+    std::uint64_t   names_offset;
+    std::uint64_t   blocks_offset;
+    std::uint64_t   data_offset;
+    std::uint64_t   file_size;
+};
+
+struct pointer_map_range {
+    std::uint64_t   start;
+    std::uint64_t   length;
+    std::uint64_t   offset;
+    std::uint64_t   inode;
+    std::uint64_t   device;
+    std::uint32_t   name_offset;
+    std::uint32_t   name_length;
+    std::uint8_t    perms;
+    std::uint8_t    reserved[7];
+};
+
+struct pointer_map_block {
+    std::uint64_t   first_value;
+    std::uint64_t   data_offset;
+};
+
+static_assert(sizeof(pointer_map_header) % 8 == 0);
+static_assert(sizeof(pointer_map_range) == 56);
+static_assert(sizeof(pointer_map_block) == 16);
+
+/**
+ * @brief save_pointer_map writes `map` and the snapshot it was built from
+ * @return false on error, errors are reported on stderr
+ */
+bool save_pointer_map(const std::string &path, const pointer_map &map,
+                      const maps_snapshot &maps);
+
+/**
+ * A pointer map file mapped into memory, usable everywhere a pointer_map is
+ */
+class pointer_map_file {
+    const std::uint8_t                      *data_{};
+    std::size_t                             size_{};
+    const pointer_map_header                *header_{};
+    const pointer_map_range                 *ranges_{};
+    const pointer_map_block                 *blocks_{};
+    std::shared_ptr<const maps_snapshot>    maps_{};
+
+    pointer_map_file() = default;
+    bool valid();
+
+    /**
+     * @brief read_varint decodes one value at `p` without reading past `end`
+     * @return false if the value runs past `end` or is longer than 64 bits
+     */
+    static bool read_varint(const std::uint8_t *&p, const std::uint8_t *end, std::uint64_t &v) {
+        v = 0;
+        for (unsigned shift = 0; shift < 64 && p < end; shift += 7) {
+            const std::uint8_t byte = *p++;
+            v |= std::uint64_t(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+public:
+    static constexpr char magic[8] = {'M', 'E', 'M', 'S', 'C', 'P', 'M', '\0'};
+    static constexpr std::uint32_t version = 1;
+
+    ~pointer_map_file();
+    pointer_map_file(const pointer_map_file &) = delete;
+    pointer_map_file &operator=(const pointer_map_file &) = delete;
+
+    /**
+     * @brief open maps a file written by save_pointer_map
+     * @return nullptr on error, errors are reported on stderr
+     */
+    static std::unique_ptr<pointer_map_file> open(const std::string &path);
+
+    /** The maps of the process at the time the map was built */
+    const maps_snapshot &maps() const {
+        return *maps_;
+    }
+
+    std::shared_ptr<const maps_snapshot> maps_ptr() const {
+        return maps_;
+    }
+
+    std::size_t size() const {
+        return header_->entry_count;
+    }
+
+    /**
+     * @brief for_each calls `f` for every entry whose value is in [lo, hi],
+     * only the blocks overlapping the interval are decoded
+     */
+    template<typename F>
+    void for_each(std::uintptr_t lo, std::uintptr_t hi, F &&f) const {
+        const std::size_t block_count = header_->block_count;
+        if (block_count == 0) {
+            return;
+        }
+        // Last block starting at or before lo, duplicates of lo may spill
+        // over from the previous one so step back while equal
+        std::size_t first = std::upper_bound(blocks_, blocks_ + block_count, lo,
+                                             [](std::uintptr_t v, const pointer_map_block &b) {
+                                                 return v < b.first_value;
+                                             }) - blocks_;
+        first = first > 0 ? first - 1 : 0;
+        while (first > 0 && blocks_[first].first_value == lo) {
+            --first;
+        }
+
+        const std::uint64_t entries = header_->entry_count;
+        const std::uint32_t per_block = header_->block_entries;
+        const std::uint8_t *data = data_ + header_->data_offset;
+        for (std::size_t b = first; b < block_count; ++b) {
+            if (blocks_[b].first_value > hi) {
+                return;
+            }
+            // Offsets were checked by open() to be ascending and in the file
+            const std::uint8_t *p = data + blocks_[b].data_offset;
+            const std::uint8_t *end = b + 1 < block_count ? data + blocks_[b + 1].data_offset
+                                                          : data_ + size_;
+            std::uint64_t value = blocks_[b].first_value;
+            const std::uint64_t count = std::min<std::uint64_t>(per_block, entries - b * per_block);
+            for (std::uint64_t i = 0; i < count; ++i) {
+                std::uint64_t delta = 0, range = 0, offset = 0;
+                if (!read_varint(p, end, delta) || !read_varint(p, end, range) ||
+                    !read_varint(p, end, offset)) {
+                    // Corrupt block, nothing after it can be trusted either
+                    return;
+                }
+                value += delta;
+                if (value > hi || range >= header_->range_count) {
+                    return;
+                }
+                if (value >= lo) {
+                    f(pointer_entry{value, ranges_[range].start + offset});
+                }
+            }
+        }
+    }
+};
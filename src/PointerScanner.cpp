@@ -0,0 +1,163 @@
+#include "PointerScanner.h"
+#include "ProcessMemory.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <tuple>
+#include <parallel/algorithm>
+
+pointer_map pointer_map::build(pid_t pid, const maps_snapshot &maps,
+                               std::size_t block_size,
+                               const std::function<void(size_t, size_t)> &progress) {
+    range_filter filter{};
+    filter.writable_only = true;
+    filter.perms_excluded = 0;
+    std::vector<address_range> list = apply_range_filter(maps.ranges, filter);
+
+    block_size = std::max<std::size_t>(block_size & ~std::size_t{7}, 4096);
+    const std::size_t total_size = get_address_range_list_size(list, true);
+    const std::uintptr_t lowest = maps.index.lowest();
+    const std::uintptr_t highest = maps.index.highest();
+    std::atomic<std::size_t> scanned_size = 0;
+    std::vector<pointer_entry> entries;
+
+    #pragma omp parallel
+    {
+        std::vector<pointer_entry> local;
+        auto buf = std::make_unique<std::uintptr_t[]>(block_size / sizeof(std::uintptr_t));
+        #pragma omp for schedule(dynamic, 1)
+        for (std::size_t r = 0; r < list.size(); ++r) {
+            const address_range &range = list[r];
+            auto start = reinterpret_cast<std::uintptr_t>(range.start);
+            const std::uintptr_t end = start + range.length;
+
+            for (std::uintptr_t cur = start; cur < end; cur += block_size) {
+                const std::size_t size = std::min<std::uintptr_t>(block_size, end - cur);
+                ssize_t nread = ProcessMemory::read_process_memory_nosplit(
+                    pid, reinterpret_cast<void *>(cur), buf.get(), size);
+                if (nread <= 0) {
+                    break;
+                }
+                const std::size_t count = static_cast<std::size_t>(nread) / sizeof(std::uintptr_t);
+                for (std::size_t i = 0; i < count; ++i) {
+                    const std::uintptr_t value = buf[i];
+                    // Cheap bounds check before the index lookup, most
+                    // values aren't anywhere near mapped memory
+                    if (value < lowest || value >= highest ||
+                        !maps.index.is_valid_pointer(value)) {
+                        continue;
+                    }
+                    local.push_back({value, cur + i * sizeof(std::uintptr_t)});
+                }
+            }
+
+            scanned_size.fetch_add(range.length);
+            if (progress) {
+                progress(scanned_size.load(), total_size);
+            }
+        }
+        #pragma omp critical
+        entries.insert(entries.end(), local.begin(), local.end());
+    }
+
+    __gnu_parallel::sort(entries.begin(), entries.end(),
+                         [](const pointer_entry &a, const pointer_entry &b) {
+                             return a.value < b.value ||
+                                    (a.value == b.value && a.location < b.location);
+                         });
+    return pointer_map{std::move(entries)};
+}
+
+
+std::string pointer_path::to_string() const {
+    char buf[64];
+    std::string text = basename_of(module);
+    snprintf(buf, sizeof(buf), "+0x%" PRIxPTR, offset);
+    text += buf;
+    for (std::uintptr_t off : offsets) {
+        snprintf(buf, sizeof(buf), " -> 0x%" PRIxPTR, off);
+        text += buf;
+    }
+    return text;
+}
+
+std::optional<pointer_path> pointer_path::parse(const std::string &text) {
+    pointer_path path{};
+    std::size_t arrow = text.find(" -> ");
+    std::string head = text.substr(0, arrow);
+    std::size_t plus = head.rfind('+');
+    if (plus == std::string::npos || plus == 0) {
+        return std::nullopt;
+    }
+    path.module = head.substr(0, plus);
+
+    auto parse_hex = [](const std::string &s, std::uintptr_t &out) {
+        char *end = nullptr;
+        out = std::strtoull(s.c_str(), &end, 16);
+        return end != s.c_str() && *end == '\0';
+    };
+    if (!parse_hex(head.substr(plus + 1), path.offset)) {
+        return std::nullopt;
+    }
+
+    while (arrow != std::string::npos) {
+        std::size_t start = arrow + 4;
+        arrow = text.find(" -> ", start);
+        std::uintptr_t off = 0;
+        if (!parse_hex(text.substr(start, arrow == std::string::npos ? arrow : arrow - start), off)) {
+            return std::nullopt;
+        }
+        path.offsets.push_back(off);
+    }
+    return path;
+}
+
+std::optional<std::uintptr_t> pointer_path::resolve(pid_t pid, const maps_snapshot &maps) const {
+    std::uintptr_t base = maps.index.base_of(module);
+    if (base == 0) {
+        return std::nullopt;
+    }
+    std::uintptr_t addr = base + offset;
+    for (std::uintptr_t off : offsets) {
+        std::uintptr_t ptr = 0;
+        if (!maps.index.is_valid_pointer(addr) ||
+            ProcessMemory::read_process_memory_nosplit(pid, reinterpret_cast<void *>(addr),
+                                                       &ptr, sizeof(ptr)) != sizeof(ptr)) {
+            return std::nullopt;
+        }
+        addr = ptr + off;
+    }
+    return addr;
+}
+
+std::vector<pointer_path> intersect_pointer_paths(const std::vector<pointer_path> &a,
+                                                  const std::vector<pointer_path> &b) {
+    auto key = [](const pointer_path &p) {
+        return std::tie(p.offset, p.offsets);
+    };
+    std::vector<const pointer_path *> sorted;
+    sorted.reserve(b.size());
+    for (const pointer_path &p : b) {
+        sorted.push_back(&p);
+    }
+    std::sort(sorted.begin(), sorted.end(), [&key](auto *x, auto *y) {
+        return key(*x) < key(*y);
+    });
+
+    std::vector<pointer_path> both;
+    for (const pointer_path &p : a) {
+        auto [first, last] = std::equal_range(sorted.begin(), sorted.end(), &p,
+                                              [&key](auto *x, auto *y) {
+                                                  return key(*x) < key(*y);
+                                              });
+        const std::string module = basename_of(p.module);
+        if (std::any_of(first, last, [&module](auto *q) {
+                return basename_of(q->module) == module;
+            })) {
+            both.push_back(p);
+        }
+    }
+    return both;
+}
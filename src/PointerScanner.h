@@ -0,0 +1,265 @@
+#pragma once
+#include "maps.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+/**
+ * A location in the target holding a pointer, `value` is what it points to
+ */
+struct pointer_entry {
+    std::uintptr_t  value;
+    std::uintptr_t  location;
+};
+
+/**
+ * A chain of dereferences starting from a module, e.g.
+ * "libfoo.so+0x1234 -> 0x10 -> 0x8" reads the pointer at libfoo.so+0x1234,
+ * adds 0x10, reads the pointer there and adds 0x8 to get the address.
+ */
+struct pointer_path {
+    /** Name of the module as it appears in the maps */
+    std::string                 module;
+
+    /** Offset of the first pointer from the module base */
+    std::uintptr_t              offset;
+
+    /** Offsets added after each dereference, in order */
+    std::vector<std::uintptr_t> offsets;
+
+    std::string to_string() const;
+    static std::optional<pointer_path> parse(const std::string &text);
+
+    /**
+     * @brief resolve follows the path in the current process image
+     * @return the final address or nullopt if a link could not be read
+     */
+    std::optional<std::uintptr_t> resolve(pid_t pid, const maps_snapshot &maps) const;
+
+    bool operator==(const pointer_path &) const = default;
+};
+
+struct pointer_scan_options {
+    /** Maximum amount of dereferences in a path */
+    unsigned                    max_depth = 4;
+
+    /** Maximum offset added after a dereference */
+    std::uintptr_t              max_offset = 0x1000;
+
+    /** Stop after this many paths have been found */
+    std::size_t                 max_results = 100000;
+
+    /**
+     * Stop after following this many pointers. The amount of candidate
+     * paths grows exponentially with depth and offset, this bounds how long
+     * a wide search can take.
+     */
+    std::size_t                 max_visits = 50000000;
+
+    /** Checked while searching, once set the paths found so far are returned */
+    const std::atomic<bool>     *cancel = nullptr;
+};
+
+/**
+ * How a pointer search ended
+ */
+struct pointer_scan_stats {
+    /** Pointers followed */
+    std::size_t                 visits = 0;
+
+    /** False if the search was cut short by a limit or cancelled */
+    bool                        complete = true;
+};
+
+/**
+ * Reverse pointer map of a process: every aligned pointer-sized value in a
+ * writable range that points into a mapped range, sorted by value so that
+ * "who points near X" is a binary search.
+ */
+class pointer_map {
+    std::vector<pointer_entry> entries_{};
+
+public:
+    pointer_map() = default;
+    explicit pointer_map(std::vector<pointer_entry> entries)
+        : entries_(std::move(entries)) {}
+
+    /**
+     * @brief build reads all writable ranges of the process once and
+     * collects the pointers in them
+     * @param block_size how much to read from the process at once
+     * @param progress called with (bytes done, bytes total), may be empty
+     */
+    static pointer_map build(pid_t pid, const maps_snapshot &maps,
+                             std::size_t block_size,
+                             const std::function<void(size_t, size_t)> &progress = {});
+
+    std::span<const pointer_entry> entries() const {
+        return entries_;
+    }
+
+    std::size_t size() const {
+        return entries_.size();
+    }
+
+    /**
+     * @brief for_each calls `f` for every entry whose value is in [lo, hi]
+     */
+    template<typename F>
+    void for_each(std::uintptr_t lo, std::uintptr_t hi, F &&f) const {
+        auto it = std::lower_bound(entries_.begin(), entries_.end(), lo,
+                                   [](const pointer_entry &e, std::uintptr_t v) {
+                                       return e.value < v;
+                                   });
+        for (; it != entries_.end() && it->value <= hi; ++it) {
+            f(*it);
+        }
+    }
+};
+
+namespace detail {
+/**
+ * Counters shared by the threads of one search. Visits are counted per
+ * thread and added in batches so the threads don't fight over one line.
+ */
+struct pointer_search_state {
+    static constexpr std::size_t visit_batch = 4096;
+
+    const pointer_scan_options  &options;
+    std::atomic<std::size_t>    found{};
+    std::atomic<std::size_t>    visits{};
+    std::atomic<bool>           stopped{};
+
+    explicit pointer_search_state(const pointer_scan_options &o) : options(o) {}
+
+    /** @brief visit counts one pointer followed, false once the search must stop */
+    bool visit(std::size_t &pending) {
+        if (++pending == visit_batch) {
+            flush(pending);
+        }
+        return !stopped.load(std::memory_order_relaxed);
+    }
+
+    void flush(std::size_t &pending) {
+        const std::size_t total = visits.fetch_add(pending, std::memory_order_relaxed) + pending;
+        pending = 0;
+        if (total >= options.max_visits ||
+            found.load(std::memory_order_relaxed) >= options.max_results ||
+            (options.cancel != nullptr && options.cancel->load(std::memory_order_relaxed))) {
+            stopped.store(true, std::memory_order_relaxed);
+        }
+    }
+};
+
+template<typename Map>
+void pointer_search(const Map &map, const maps_snapshot &maps, std::uintptr_t target,
+                    pointer_search_state &state, std::size_t &pending,
+                    std::vector<std::uintptr_t> &stack,
+                    std::vector<pointer_path> &found) {
+    const pointer_scan_options &options = state.options;
+    const std::uintptr_t lo = target > options.max_offset ? target - options.max_offset : 0;
+    map.for_each(lo, target, [&](const pointer_entry &entry) {
+        if (!state.visit(pending)) {
+            return;
+        }
+        stack.push_back(target - entry.value);
+        if (maps.index.is_static(entry.location)) {
+            // A path through a module is found, anything longer through the
+            // same pointer only adds links that may break
+            const std::uintptr_t base = maps.index.module_base(entry.location);
+            found.push_back({*maps.index.name(entry.location),
+                             entry.location - base,
+                             {stack.rbegin(), stack.rend()}});
+            if (state.found.fetch_add(1, std::memory_order_relaxed) + 1 >= options.max_results) {
+                state.stopped.store(true, std::memory_order_relaxed);
+            }
+        } else if (stack.size() < options.max_depth) {
+            pointer_search(map, maps, entry.location, state, pending, stack, found);
+        }
+        stack.pop_back();
+    });
+}
+}
+
+/**
+ * @brief find_pointer_paths walks the reverse pointer map backwards from
+ * `target` until it reaches static memory, which ends a path. The first
+ * level is split across all cores.
+ *
+ * @tparam Map anything with for_each(lo, hi, f) like pointer_map
+ * @param stats filled in with how the search ended, may be null
+ */
+template<typename Map>
+std::vector<pointer_path> find_pointer_paths(const Map &map,
+                                             const maps_snapshot &maps,
+                                             std::uintptr_t target,
+                                             const pointer_scan_options &options,
+                                             pointer_scan_stats *stats = nullptr) {
+    std::vector<pointer_entry> first_level;
+    const std::uintptr_t lo = target > options.max_offset ? target - options.max_offset : 0;
+    map.for_each(lo, target, [&first_level](const pointer_entry &entry) {
+        first_level.push_back(entry);
+    });
+
+    std::vector<pointer_path> found;
+    detail::pointer_search_state state{options};
+    #pragma omp parallel
+    {
+        std::vector<pointer_path> local;
+        std::vector<std::uintptr_t> stack;
+        std::size_t pending = 0;
+        #pragma omp for schedule(dynamic, 1)
+        for (std::size_t i = 0; i < first_level.size(); ++i) {
+            if (!state.visit(pending)) {
+                continue;
+            }
+            const pointer_entry &entry = first_level[i];
+            stack.assign(1, target - entry.value);
+            if (maps.index.is_static(entry.location)) {
+                const std::uintptr_t base = maps.index.module_base(entry.location);
+                local.push_back({*maps.index.name(entry.location),
+                                 entry.location - base, stack});
+                state.found.fetch_add(1, std::memory_order_relaxed);
+            } else if (options.max_depth > 1) {
+                detail::pointer_search(map, maps, entry.location, state, pending, stack, local);
+            }
+        }
+        state.flush(pending);
+        #pragma omp critical
+        found.insert(found.end(), std::make_move_iterator(local.begin()),
+                     std::make_move_iterator(local.end()));
+    }
+    if (stats != nullptr) {
+        stats->visits = state.visits.load();
+        stats->complete = !state.stopped.load();
+    }
+
+    // Shortest paths first, they tend to be the stable ones
+    std::sort(found.begin(), found.end(), [](const auto &a, const auto &b) {
+        if (a.offsets.size() != b.offsets.size()) {
+            return a.offsets.size() < b.offsets.size();
+        }
+        return a.offset < b.offset;
+    });
+    if (found.size() > options.max_results) {
+        found.resize(options.max_results);
+    }
+    return found;
+}
+
+/**
+ * @brief intersect_pointer_paths keeps the paths of `a` that also appear in
+ * `b`, comparing modules by basename. Running a scan against maps saved from
+ * two runs of the program and intersecting the results leaves the paths that
+ * survive a restart.
+ */
+std::vector<pointer_path> intersect_pointer_paths(const std::vector<pointer_path> &a,
+                                                  const std::vector<pointer_path> &b);
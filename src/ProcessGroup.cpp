@@ -0,0 +1,107 @@
+#include "ProcessGroup.h"
+
+bool ProcessGroup::add(pid_t pid) {
+    if (find(pid) != npos) {
+        return false;
+    }
+    auto member = std::make_unique<ProcessMemory>();
+    if (!member->pid(pid)) {
+        return false;
+    }
+    member->epsilon(epsilon_);
+    member->max_read_size(max_read_size_);
+    member->scan_filter(scan_filter_);
+    members_.push_back(std::move(member));
+    update_offsets();
+    return true;
+}
+
+bool ProcessGroup::remove(pid_t pid) {
+    std::size_t i = find(pid);
+    if (i == npos) {
+        return false;
+    }
+    members_.erase(members_.begin() + static_cast<std::ptrdiff_t>(i));
+    update_offsets();
+    return true;
+}
+
+std::size_t ProcessGroup::find(pid_t pid) const {
+    for (std::size_t i = 0; i < members_.size(); ++i) {
+        if (members_[i]->pid() == pid) {
+            return i;
+        }
+    }
+    return npos;
+}
+
+std::vector<pid_t> ProcessGroup::pids() const {
+    std::vector<pid_t> pids;
+    pids.reserve(members_.size());
+    for (const auto &member : members_) {
+        pids.push_back(member->pid());
+    }
+    return pids;
+}
+
+void ProcessGroup::update_offsets() {
+    offsets_.resize(members_.size() + 1);
+    offsets_[0] = 0;
+    for (std::size_t i = 0; i < members_.size(); ++i) {
+        offsets_[i + 1] = offsets_[i] + members_[i]->get_matches().size();
+    }
+}
+
+group_match ProcessGroup::match(std::size_t index) const {
+    // The last offset not above index, empty members share their offset
+    // with the next one so upper_bound skips them
+    auto it = std::upper_bound(offsets_.begin(), offsets_.end(), index) - 1;
+    const std::size_t i = static_cast<std::size_t>(it - offsets_.begin());
+    return {members_[i]->pid(), members_[i]->get_matches()[index - *it]};
+}
+
+std::vector<group_match> ProcessGroup::matches(std::size_t first, std::size_t count) const {
+    std::vector<group_match> result;
+    if (first >= match_count()) {
+        return result;
+    }
+    count = std::min(count, match_count() - first);
+    result.reserve(count);
+    std::size_t i = static_cast<std::size_t>(
+        std::upper_bound(offsets_.begin(), offsets_.end(), first) - offsets_.begin() - 1);
+    for (std::size_t index = first; index < first + count; ++index) {
+        while (index >= offsets_[i + 1]) {
+            ++i;
+        }
+        result.push_back({members_[i]->pid(), members_[i]->get_matches()[index - offsets_[i]]});
+    }
+    return result;
+}
+
+void ProcessGroup::clear_matches() {
+    for (auto &member : members_) {
+        member->clear_matches();
+    }
+    update_offsets();
+}
+
+void ProcessGroup::epsilon(double e) {
+    epsilon_ = e;
+    for (auto &member : members_) {
+        member->epsilon(e);
+    }
+}
+
+void ProcessGroup::max_read_size(std::size_t size) {
+    max_read_size_ = size;
+    for (auto &member : members_) {
+        member->max_read_size(size);
+    }
+}
+
+void ProcessGroup::scan_filter(const range_filter &filter) {
+    scan_filter_ = filter;
+    for (auto &member : members_) {
+        member->scan_filter(filter);
+    }
+}
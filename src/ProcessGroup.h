@@ -0,0 +1,272 @@
+#pragma once
+#include "ProcessMemory.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <sys/types.h>
+
+/**
+ * A match of a ProcessGroup scan, tagged with the process it was found in
+ */
+struct group_match {
+    pid_t   pid;
+    void    *address;
+};
+
+/**
+ * Result of ProcessGroup::compare, the same initial scan done as a group and
+ * as separate scanners
+ */
+struct group_comparison {
+    double          group_seconds;
+    std::size_t     group_matches;
+    double          separate_seconds;
+    std::size_t     separate_matches;
+};
+
+/**
+ * Scans several processes, such as the workers of one binary, with a single
+ * query. Every member keeps its own maps, matches and history in a
+ * ProcessMemory, the group only decides how the work is spread.
+ *
+ * An initial scan flattens the (process, range) pairs of all members into one
+ * list, largest range first, that one OpenMP team works through. A process
+ * with a huge heap doesn't leave the other threads idle at the end, and N
+ * processes don't each start a thread pool fighting over the same cores.
+ * Next scans refine one member at a time, each spreading its batched reads
+ * over the whole team, so a group with one huge member and a few idle ones
+ * still uses every thread.
+ *
+ * Matches are numbered across the group in member order, so a match index
+ * can be turned back into a pid and an address without storing the pid
+ * next to every match.
+ */
+class ProcessGroup {
+public:
+    static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+private:
+    std::vector<std::unique_ptr<ProcessMemory>> members_{};
+
+    /** Group index of the first match of each member, plus the total */
+    std::vector<std::size_t> offsets_{0};
+
+    range_filter scan_filter_{};
+    double epsilon_ = 0.000000001;
+    std::size_t max_read_size_ = ProcessMemory::default_max_read_size;
+    std::function<void(size_t, size_t)> progressCallback_{};
+    std::atomic<bool> scanning_{};
+
+    void update_offsets();
+
+public:
+    /**
+     * @brief add attaches to another process, its matches start out empty
+     * @return false if it doesn't exist or is already a member
+     */
+    bool add(pid_t pid);
+
+    /** @brief remove drops a member together with its matches */
+    bool remove(pid_t pid);
+
+    /** @brief find returns the member index of `pid` or npos */
+    std::size_t find(pid_t pid) const;
+
+    std::size_t size() const {
+        return members_.size();
+    }
+
+    ProcessMemory &member(std::size_t i) {
+        return *members_[i];
+    }
+
+    const ProcessMemory &member(std::size_t i) const {
+        return *members_[i];
+    }
+
+    std::vector<pid_t> pids() const;
+
+    /** @brief match_count is the amount of matches of all members together */
+    std::size_t match_count() const {
+        return offsets_.back();
+    }
+
+    /** @brief match_count is the amount of matches found in member `i` */
+    std::size_t match_count(std::size_t i) const {
+        return offsets_[i + 1] - offsets_[i];
+    }
+
+    /**
+     * @brief match looks up a match by its index across the group
+     * @param index below match_count()
+     */
+    group_match match(std::size_t index) const;
+
+    /**
+     * @brief matches lists `count` matches starting at `first` with their
+     * pid, for views that only show part of the list
+     */
+    std::vector<group_match> matches(std::size_t first, std::size_t count) const;
+
+    void clear_matches();
+
+    bool scanning() const {
+        return scanning_.load();
+    }
+
+    /** @brief setProgressCallback reports bytes scanned over all members */
+    void setProgressCallback(std::function<void(size_t, size_t)> cb) {
+        progressCallback_ = cb;
+    }
+
+    void epsilon(double e);
+    void max_read_size(std::size_t size);
+    void scan_filter(const range_filter &filter);
+
+    const range_filter &scan_filter() const {
+        return scan_filter_;
+    }
+
+    /**
+     * @brief scan looks for `value` in every member, like
+     * ProcessMemory::scan. Without any matches in the group this is an
+     * initial scan, otherwise each member's matches are filtered with `mode`.
+     */
+    template<typename T>
+    void scan(T value, scan_mode mode = SCAN_EXACT) {
+        if (members_.empty()) {
+            return;
+        }
+        const bool initial = match_count() == 0;
+        if (!initial) {
+            for (const auto &member : members_) {
+                if (!member->can_refine<T>(mode)) {
+                    std::fprintf(stderr, "ProcessGroup: no previous values to compare to in %d\n",
+                                 member->pid());
+                    return;
+                }
+            }
+        }
+        scanning_ = true;
+        using Clock = std::chrono::high_resolution_clock;
+        auto t0 = Clock::now();
+
+        if (initial) {
+            initial_scan<T>(value);
+        } else {
+            for (const auto &member : members_) {
+                member->refine<T>(value, mode);
+            }
+        }
+        update_offsets();
+
+        std::chrono::duration<double> elapsed = Clock::now() - t0;
+        fprintf(stdout, "Group scan of %zu processes: %.3f s, matches: %zu\n",
+                members_.size(), elapsed.count(), match_count());
+        scanning_ = false;
+    }
+
+    /**
+     * @brief compare times an initial scan for `value` in `pids` as a group
+     * against one ProcessMemory per process scanning at the same time, each
+     * with its own thread pool, which is what running a scanner per process
+     * amounts to
+     */
+    template<typename T>
+    static group_comparison compare(const std::vector<pid_t> &pids, T value,
+                                    const range_filter &filter) {
+        using Clock = std::chrono::high_resolution_clock;
+        group_comparison result{};
+
+        ProcessGroup group;
+        group.scan_filter(filter);
+        for (pid_t pid : pids) {
+            group.add(pid);
+        }
+        auto t0 = Clock::now();
+        group.scan(value);
+        result.group_seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+        result.group_matches = group.match_count();
+        group.clear_matches();
+
+        std::vector<std::unique_ptr<ProcessMemory>> separate;
+        for (pid_t pid : pids) {
+            auto scanner = std::make_unique<ProcessMemory>();
+            if (scanner->pid(pid)) {
+                scanner->scan_filter(filter);
+                separate.push_back(std::move(scanner));
+            }
+        }
+        t0 = Clock::now();
+        std::vector<std::thread> threads;
+        for (auto &scanner : separate) {
+            threads.emplace_back([&scanner, value] {
+                scanner->scan(value);
+            });
+        }
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+        result.separate_seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+        for (const auto &scanner : separate) {
+            result.separate_matches += scanner->get_matches().size();
+        }
+        return result;
+    }
+
+private:
+    template<typename T>
+    void initial_scan(T value) {
+        struct work {
+            std::size_t     member;
+            address_range   range;
+        };
+        std::vector<work> list;
+        std::size_t total_size = 0;
+        for (std::size_t i = 0; i < members_.size(); ++i) {
+            auto snapshot = members_[i]->refresh_maps();
+            for (const address_range &range : apply_range_filter(snapshot->ranges, scan_filter_)) {
+                list.push_back({i, range});
+                total_size += range.length;
+            }
+        }
+        // Largest first, what is left at the end is small enough to even out
+        std::sort(list.begin(), list.end(), [](const work &a, const work &b) {
+            return a.range.length > b.range.length;
+        });
+
+        std::vector<std::vector<void *>> found(members_.size());
+        std::atomic<size_t> scanned_size = 0;
+        #pragma omp parallel
+        {
+            std::vector<std::vector<void *>> local(members_.size());
+            #pragma omp for schedule(dynamic, 1)
+            for (std::size_t i = 0; i < list.size(); ++i) {
+                const work &current = list[i];
+                members_[current.member]->scan_range(local[current.member], current.range, value);
+
+                scanned_size.fetch_add(current.range.length);
+                if (progressCallback_) {
+                    progressCallback_(scanned_size.load(), total_size);
+                }
+            }
+            #pragma omp critical
+            for (std::size_t m = 0; m < local.size(); ++m) {
+                found[m].insert(found[m].end(), local[m].begin(), local[m].end());
+            }
+        }
+        for (std::size_t m = 0; m < members_.size(); ++m) {
+            members_[m]->adopt_matches<T>(std::move(found[m]), value);
+        }
+        printf("Scanned %'lu bytes (%.02f GB) in %zu processes\n", total_size,
+               double(total_size) / 1e9, members_.size());
+    }
+};
@@ -0,0 +1,204 @@
+#include "ProcessList.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+#include <dirent.h>
+#include <fcntl.h>
+#include <pwd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+struct linux_dirent64 {
+    ino64_t         d_ino;
+    off64_t         d_off;
+    unsigned short  d_reclen;
+    unsigned char   d_type;
+    char            d_name[];
+};
+
+/** @brief read_file reads up to `size` bytes of a small /proc file */
+ssize_t read_file(int dir_fd, const char *name, char *buffer, std::size_t size) {
+    int fd = openat(dir_fd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    std::size_t total = 0;
+    while (total < size) {
+        ssize_t n = read(fd, buffer + total, size - total);
+        if (n <= 0) {
+            break;
+        }
+        total += static_cast<std::size_t>(n);
+    }
+    close(fd);
+    return static_cast<ssize_t>(total);
+}
+
+std::string user_name(uid_t uid) {
+    // Looked up once per uid, nss may be a network round trip
+    static thread_local std::unordered_map<uid_t, std::string> names;
+    auto it = names.find(uid);
+    if (it != names.end()) {
+        return it->second;
+    }
+    char buffer[1024];
+    passwd pw{};
+    passwd *result = nullptr;
+    std::string name;
+    if (getpwuid_r(uid, &pw, buffer, sizeof(buffer), &result) == 0 && result != nullptr) {
+        name = result->pw_name;
+    } else {
+        name = std::to_string(uid);
+    }
+    return names.emplace(uid, std::move(name)).first->second;
+}
+
+bool word_start(std::string_view text, std::size_t i) {
+    return i == 0 || !std::isalnum(static_cast<unsigned char>(text[i - 1]));
+}
+}
+
+std::vector<pid_t> list_pids() {
+    std::vector<pid_t> pids;
+    int fd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        perror("open /proc");
+        return pids;
+    }
+    alignas(linux_dirent64) char buffer[32768];
+    for (;;) {
+        long n = syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+        if (n <= 0) {
+            if (n < 0) {
+                perror("getdents64");
+            }
+            break;
+        }
+        for (long offset = 0; offset < n;) {
+            auto *entry = reinterpret_cast<linux_dirent64 *>(buffer + offset);
+            offset += entry->d_reclen;
+            const char *name = entry->d_name;
+            if (entry->d_type != DT_DIR || *name < '1' || *name > '9') {
+                continue;
+            }
+            char *end = nullptr;
+            long pid = std::strtol(name, &end, 10);
+            if (*end == '\0') {
+                pids.push_back(static_cast<pid_t>(pid));
+            }
+        }
+    }
+    close(fd);
+    return pids;
+}
+
+bool read_process_info(int proc_fd, pid_t pid, process_info &info) {
+    const bool own_fd = proc_fd < 0;
+    if (own_fd) {
+        proc_fd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (proc_fd < 0) {
+            return false;
+        }
+    }
+    char name[16];
+    snprintf(name, sizeof(name), "%d", pid);
+    int dir_fd = openat(proc_fd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (own_fd) {
+        close(proc_fd);
+    }
+    if (dir_fd < 0) {
+        return false;
+    }
+
+    info.pid = pid;
+    struct stat st{};
+    info.uid = fstat(dir_fd, &st) == 0 ? st.st_uid : static_cast<uid_t>(-1);
+    info.user = user_name(info.uid);
+
+    char buffer[4096];
+    ssize_t n = read_file(dir_fd, "comm", buffer, sizeof(buffer));
+    if (n < 0) {
+        close(dir_fd);
+        return false;
+    }
+    info.comm.assign(buffer, static_cast<std::size_t>(n));
+    while (!info.comm.empty() && info.comm.back() == '\n') {
+        info.comm.pop_back();
+    }
+
+    // Arguments are NUL separated, only the start is interesting for a list
+    n = read_file(dir_fd, "cmdline", buffer, sizeof(buffer));
+    info.cmdline.assign(buffer, static_cast<std::size_t>(std::max<ssize_t>(n, 0)));
+    while (!info.cmdline.empty() && info.cmdline.back() == '\0') {
+        info.cmdline.pop_back();
+    }
+    std::replace(info.cmdline.begin(), info.cmdline.end(), '\0', ' ');
+
+    info.rss = 0;
+    n = read_file(dir_fd, "statm", buffer, sizeof(buffer) - 1);
+    if (n > 0) {
+        buffer[n] = '\0';
+        unsigned long long size = 0, resident = 0;
+        if (sscanf(buffer, "%llu %llu", &size, &resident) == 2) {
+            info.rss = resident * static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+        }
+    }
+    close(dir_fd);
+    return true;
+}
+
+std::size_t enumerate_processes(const std::function<void(std::vector<process_info> &&)> &batch,
+                                const std::atomic<bool> &cancel, std::size_t batch_size) {
+    int proc_fd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (proc_fd < 0) {
+        perror("open /proc");
+        return 0;
+    }
+    std::size_t count = 0;
+    std::vector<process_info> pending;
+    pending.reserve(batch_size);
+    for (pid_t pid : list_pids()) {
+        if (cancel.load(std::memory_order_relaxed)) {
+            break;
+        }
+        process_info info{};
+        if (!read_process_info(proc_fd, pid, info)) {
+            continue;
+        }
+        pending.push_back(std::move(info));
+        ++count;
+        if (pending.size() >= batch_size) {
+            batch(std::move(pending));
+            pending.clear();
+            pending.reserve(batch_size);
+        }
+    }
+    if (!pending.empty()) {
+        batch(std::move(pending));
+    }
+    close(proc_fd);
+    return count;
+}
+
+int fuzzy_score(std::string_view pattern, std::string_view text) {
+    int score = 0;
+    int run = 0;
+    std::size_t p = 0;
+    for (std::size_t i = 0; i < text.size() && p < pattern.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(text[i])) !=
+            std::tolower(static_cast<unsigned char>(pattern[p]))) {
+            run = 0;
+            continue;
+        }
+        ++run;
+        score += run * 2 + (word_start(text, i) ? 3 : 0);
+        ++p;
+    }
+    return p == pattern.size() ? score : -1;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/types.h>
+
+struct process_info {
+    pid_t           pid;
+    uid_t           uid;
+    /** Resident set size in bytes */
+    std::uint64_t   rss;
+    std::string     comm;
+    std::string     user;
+    /** Arguments joined with spaces, empty for kernel threads */
+    std::string     cmdline;
+};
+
+/**
+ * @brief list_pids lists the numeric entries of /proc with raw getdents64
+ * calls, which is a lot cheaper than readdir + stat on hosts with many pids
+ */
+std::vector<pid_t> list_pids();
+
+/**
+ * @brief read_process_info reads comm, cmdline, statm and the owner of `pid`
+ * relative to one directory fd
+ * @param proc_fd fd of /proc, -1 to open it
+ * @return false if the process is gone
+ */
+bool read_process_info(int proc_fd, pid_t pid, process_info &info);
+
+/**
+ * @brief enumerate_processes reads every process of the system and hands
+ * them out in batches as they are read, so a list can fill in before the
+ * whole of /proc has been walked
+ * @param batch called with up to `batch_size` processes at a time
+ * @param cancel checked between processes, stops the walk when set
+ * @return the amount of processes read, less than listed if any exited
+ */
+std::size_t enumerate_processes(const std::function<void(std::vector<process_info> &&)> &batch,
+                                const std::atomic<bool> &cancel,
+                                std::size_t batch_size = 256);
+
+/**
+ * @brief fuzzy_score matches `pattern` as a case insensitive subsequence of
+ * `text`
+ * @return -1 if it doesn't match, otherwise higher for better matches:
+ * consecutive characters and matches at word starts score more
+ */
+int fuzzy_score(std::string_view pattern, std::string_view text);
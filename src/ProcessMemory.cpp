@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <climits>
+#include <fcntl.h>
 #include <stdlib.h>
 #include <sys/mman.h>
 #include <sys/uio.h>
@@ -7,6 +8,28 @@
 #include <sys/types.h>
 #include "ProcessMemory.h"
 
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+std::shared_ptr<const maps_snapshot> ProcessMemory::refresh_maps() {
+    auto snapshot =
+        std::make_shared<const maps_snapshot>(get_memory_ranges(pid_, true));
+    std::lock_guard lock{maps_lock_};
+    maps_ = snapshot;
+    return snapshot;
+}
+
+std::shared_ptr<const maps_snapshot> ProcessMemory::maps() const {
+    std::lock_guard lock{maps_lock_};
+    if (!maps_) {
+        static const auto empty =
+            std::make_shared<const maps_snapshot>(std::vector<address_range>{});
+        return empty;
+    }
+    return maps_;
+}
+
 void ProcessMemory::prefetch_area(pid_t pid, void *address, size_t size) {
     iovec remote{.iov_base = address, .iov_len=size};
     process_madvise(pid, &remote, 1, MADV_WILLNEED, 0);
@@ -38,57 +61,346 @@ ssize_t ProcessMemory::read_process_memory_nosplit(pid_t pid, void *address, voi
  * @return bytes read
  */
 ssize_t ProcessMemory::read_process_memory(void *address, void *buffer, size_t n) const {
-    const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
-    size_t num_vecs = (n + page_size - 1) / page_size;
-    auto max_iov = static_cast<unsigned long>(sysconf(_SC_IOV_MAX));
-    if (num_vecs > max_iov) {
-        fprintf(stderr, "ProcessMemory: Error could not read process memory, too many iovecs %zu > %lu\n",
-                num_vecs, max_iov);
-        return 0;
+    return read_process_memory_nosplit(pid_, address, buffer, n);
+}
+
+namespace {
+/** A contiguous remote range covering one or more sorted requests */
+struct read_span {
+    std::uintptr_t  start;
+    std::uintptr_t  end;
+    std::size_t     first;
+    std::size_t     last;
+    /** Offset into the scratch buffer, or SIZE_MAX when read in place */
+    std::size_t     scratch;
+};
+}
+
+std::size_t ProcessMemory::read_many(pid_t pid, std::span<ReadRequest> requests) {
+    static const auto page_size = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+    static const auto max_iov = static_cast<std::size_t>(sysconf(_SC_IOV_MAX));
+
+    std::vector<std::uint32_t> order;
+    order.reserve(requests.size());
+    for (std::size_t i = 0; i < requests.size(); ++i) {
+        requests[i].result = -1;
+        if (requests[i].size == 0) {
+            requests[i].result = 0;
+            continue;
+        }
+        order.push_back(static_cast<std::uint32_t>(i));
     }
+    std::sort(order.begin(), order.end(), [&requests](auto a, auto b) {
+        return requests[a].address < requests[b].address;
+    });
 
-    std::unique_ptr<iovec[]> remote = std::make_unique<iovec[]>(num_vecs);
-    size_t remaining = n;
-    size_t offset = 0;
-    for (size_t i = 0; i < num_vecs; ++i) {
-        size_t chunk = remaining < page_size ? remaining : page_size;
-        remote[i].iov_base = static_cast<char *>(address) + offset;
-        remote[i].iov_len  = chunk;
-        offset    += chunk;
-        remaining -= chunk;
+    // Coalesce overlapping requests and requests sharing a page, reading the
+    // gap between two values on the same page can't fault if either can't
+    std::vector<read_span> spans;
+    std::size_t scratch_size = 0;
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        const ReadRequest &req = requests[order[i]];
+        auto start = reinterpret_cast<std::uintptr_t>(req.address);
+        auto end = start + req.size;
+        if (!spans.empty()) {
+            read_span &cur = spans.back();
+            if (start <= cur.end || (cur.end - 1) / page_size == start / page_size) {
+                cur.end = std::max(cur.end, end);
+                cur.last = i;
+                continue;
+            }
+        }
+        spans.push_back({start, end, i, i, SIZE_MAX});
+    }
+    for (read_span &span : spans) {
+        if (span.first != span.last) {
+            span.scratch = scratch_size;
+            scratch_size += span.end - span.start;
+        }
     }
+    std::unique_ptr<char[]> scratch = std::make_unique<char[]>(scratch_size);
 
-    iovec local { .iov_base = buffer, .iov_len = n };
-    ssize_t amount_read = process_vm_readv(pid_, &local, 1,
-        remote.get(), num_vecs, 0);
+    std::vector<iovec> local(std::min(spans.size(), max_iov));
+    std::vector<iovec> remote(local.size());
+    std::vector<std::size_t> failed;
 
-    if (amount_read == -1) {
-        char error[512] = {};
-        snprintf(error, sizeof(error),
-                 "ProcessMemory: process_vm_readv error %p - %p",
-                 address, static_cast<char *>(address) + n);
+    // Spans past this one weren't attempted, the process is gone or can't
+    // be read at all
+    std::size_t readable = spans.size();
+    std::size_t done = 0;
+    while (done < spans.size()) {
+        const std::size_t batch = std::min(spans.size() - done, max_iov);
+        for (std::size_t i = 0; i < batch; ++i) {
+            const read_span &span = spans[done + i];
+            const std::size_t len = span.end - span.start;
+            remote[i] = {.iov_base = reinterpret_cast<void *>(span.start),
+                         .iov_len = len};
+            local[i] = {.iov_base = span.scratch == SIZE_MAX
+                                        ? requests[order[span.first]].buffer
+                                        : scratch.get() + span.scratch,
+                        .iov_len = len};
+        }
+        ssize_t n = process_vm_readv(pid, local.data(), batch, remote.data(),
+                                     batch, 0);
+        if (n < 0 && errno != EFAULT) {
+            readable = done;
+            break;
+        }
+
+        // The kernel stops at the first remote iovec it can't read
+        std::size_t bytes = n > 0 ? static_cast<std::size_t>(n) : 0;
+        std::size_t ok = 0;
+        while (ok < batch && bytes >= remote[ok].iov_len) {
+            bytes -= remote[ok].iov_len;
+            ++ok;
+        }
+        if (ok < batch) {
+            failed.push_back(done + ok);
+        }
+        done += ok + (ok < batch ? 1 : 0);
+    }
+
+    std::size_t succeeded = 0;
+    std::size_t next_failed = 0;
+    for (std::size_t s = 0; s < readable; ++s) {
+        const read_span &span = spans[s];
+        const bool span_failed = next_failed < failed.size() && failed[next_failed] == s;
+        if (span_failed) {
+            ++next_failed;
+        }
+        for (std::size_t i = span.first; i <= span.last; ++i) {
+            ReadRequest &req = requests[order[i]];
+            if (span_failed) {
+                // Only retry separately if other requests shared the span,
+                // one of them might still be readable
+                if (span.first == span.last) {
+                    continue;
+                }
+                iovec l{.iov_base = req.buffer, .iov_len = req.size};
+                iovec r{.iov_base = req.address, .iov_len = req.size};
+                ssize_t n = process_vm_readv(pid, &l, 1, &r, 1, 0);
+                if (n < 0 && errno != EFAULT) {
+                    return succeeded;
+                }
+                if (n != static_cast<ssize_t>(req.size)) {
+                    continue;
+                }
+            } else if (span.scratch != SIZE_MAX) {
+                std::memcpy(req.buffer,
+                            scratch.get() + span.scratch +
+                                (reinterpret_cast<std::uintptr_t>(req.address) - span.start),
+                            req.size);
+            }
+            req.result = static_cast<ssize_t>(req.size);
+            ++succeeded;
+        }
+    }
+    return succeeded;
+}
+
+std::size_t ProcessMemory::write_many(pid_t pid, std::span<WriteRequest> requests) {
+    static const auto max_iov = static_cast<std::size_t>(sysconf(_SC_IOV_MAX));
+
+    std::vector<iovec> local(std::min(requests.size(), max_iov));
+    std::vector<iovec> remote(local.size());
+    std::size_t succeeded = 0;
+    for (WriteRequest &req : requests) {
+        req.result = -1;
+    }
+
+    std::size_t done = 0;
+    while (done < requests.size()) {
+        const std::size_t batch = std::min(requests.size() - done, max_iov);
+        for (std::size_t i = 0; i < batch; ++i) {
+            const WriteRequest &req = requests[done + i];
+            remote[i] = {.iov_base = req.address, .iov_len = req.size};
+            local[i] = {.iov_base = const_cast<void *>(req.buffer),
+                        .iov_len = req.size};
+        }
+        ssize_t n = process_vm_writev(pid, local.data(), batch, remote.data(),
+                                      batch, 0);
+        if (n < 0 && errno != EFAULT) {
+            break;
+        }
+
+        // Same as reading, the kernel stops at the first remote iovec it
+        // can't write. Skip it and carry on with the rest.
+        std::size_t bytes = n > 0 ? static_cast<std::size_t>(n) : 0;
+        std::size_t ok = 0;
+        while (ok < batch && bytes >= remote[ok].iov_len) {
+            bytes -= remote[ok].iov_len;
+            requests[done + ok].result = static_cast<ssize_t>(remote[ok].iov_len);
+            ++ok;
+        }
+        succeeded += ok;
+        done += ok + (ok < batch ? 1 : 0);
+    }
+    return succeeded;
+}
+
+std::size_t ProcessMemory::write_proc_mem(pid_t pid, std::span<WriteRequest> requests) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/mem", pid);
+    int fd = open(path, O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        char error[128];
+        snprintf(error, sizeof(error), "ProcessMemory: could not open %s", path);
         perror(error);
+        return 0;
     }
 
-    return amount_read;
+    std::size_t succeeded = 0;
+    for (WriteRequest &req : requests) {
+        if (req.result >= 0) {
+            continue;
+        }
+        ssize_t n = pwrite(fd, req.buffer, req.size,
+                           static_cast<off_t>(reinterpret_cast<std::uintptr_t>(req.address)));
+        if (n == static_cast<ssize_t>(req.size)) {
+            req.result = n;
+            ++succeeded;
+        } else {
+            char error[128];
+            snprintf(error, sizeof(error),
+                     "ProcessMemory: /proc/%d/mem write error %p - %p", pid,
+                     req.address, static_cast<char *>(req.address) + req.size);
+            perror(error);
+        }
+    }
+    close(fd);
+    return succeeded;
 }
+
 /**
- * @brief write_process_memory Writes to the memory of a given process
- * @param pid                  Program pid
+ * @brief write_process_memory Writes to the memory of the attached process,
+ * read-only pages are written through /proc/pid/mem
  * @param address              The base memory address
  * @param buffer               Buffer to write
  * @param n                    How many bytes to write
- * @return                     Returns bytes written
+ * @return                     Returns bytes written, -1 on error
  */
-ssize_t ProcessMemory::write_process_memory(void *address, void *buffer, const ssize_t n) const {
-    iovec local, remote;
-    /* this might have to be made so that if n > _SC_PAGESIZE
-     * local would be split into multiple locals, similar to how
-     * read_process_memory works, no fucking clue though if it's necessary */
-    remote.iov_base = address;
-    remote.iov_len = n;
-    local.iov_base = buffer;
-    local.iov_len = n;
-    ssize_t amount_read = process_vm_writev(pid_, &local, 1, &remote, 1, 0);
-    return amount_read;
+ssize_t ProcessMemory::write_process_memory(void *address, const void *buffer, size_t n) const {
+    iovec local{.iov_base = const_cast<void *>(buffer), .iov_len = n};
+    iovec remote{.iov_base = address, .iov_len = n};
+    ssize_t written = process_vm_writev(pid_, &local, 1, &remote, 1, 0);
+    if (written == static_cast<ssize_t>(n)) {
+        return written;
+    }
+
+    // EFAULT is what a read-only mapping looks like as well
+    if (written >= 0 || errno == EFAULT) {
+        WriteRequest request{address, buffer, n};
+        return write_proc_mem(pid_, std::span{&request, 1}) == 1 ? request.result : -1;
+    }
+
+    char error[512] = {};
+    snprintf(error, sizeof(error),
+             "ProcessMemory: process_vm_writev error %p - %p",
+             address, static_cast<char *>(address) + n);
+    perror(error);
+    return -1;
+}
+
+std::size_t ProcessMemory::snapshot_values(std::size_t width) {
+    if (width == 0 || width > sizeof(std::uint64_t)) {
+        return 0;
+    }
+    scanning_ = true;
+    if (history_.size() != matches.size() || history_.width() != width) {
+        history_.reset(matches.size(), width);
+    }
+    history_.begin_column();
+
+    constexpr std::size_t batch = 4096;
+    std::vector<std::uint64_t> values(batch);
+    std::vector<ReadRequest> requests(batch);
+    std::size_t read = 0;
+    for (std::size_t first = 0; first < matches.size(); first += batch) {
+        const std::size_t count = std::min(batch, matches.size() - first);
+        for (std::size_t i = 0; i < count; ++i) {
+            requests[i] = {matches[first + i], &values[i], width};
+        }
+        read_many(std::span{requests.data(), count});
+
+        for (std::size_t i = 0; i < count; ++i) {
+            if (requests[i].result == static_cast<ssize_t>(width)) {
+                history_.set(first + i, &values[i]);
+                ++read;
+            } else {
+                history_.invalidate(first + i);
+            }
+        }
+    }
+    scanning_ = false;
+    return read;
+}
+
+std::size_t ProcessMemory::benchmark_read_size(pid_t pid, const maps_snapshot &maps,
+                                               std::chrono::milliseconds budget) {
+    using Clock = std::chrono::steady_clock;
+    constexpr std::size_t candidates[] = {
+        0x10000, 0x40000, 0x100000, 0x400000, 0x1000000, 0x4000000,
+    };
+
+    // Benchmark on what a default scan reads, biggest ranges first so the
+    // large sizes have something to read
+    std::vector<address_range> list = apply_range_filter(maps.ranges, range_filter{});
+    std::sort(list.begin(), list.end(), [](const address_range &a, const address_range &b) {
+        return a.length > b.length;
+    });
+    if (list.empty()) {
+        return default_max_read_size;
+    }
+
+    const auto slice = budget / std::size(candidates);
+    std::size_t best = default_max_read_size;
+    double best_rate = 0;
+    for (std::size_t size : candidates) {
+        if (size > list.front().length && size != candidates[0]) {
+            break;
+        }
+        // Blocks of at most `size` bytes across the ranges, every thread
+        // takes the next one and wraps around until the slice is used up
+        std::vector<iovec> blocks;
+        for (const address_range &range : list) {
+            for (std::size_t offset = 0; offset < range.length && blocks.size() < 4096;
+                 offset += size) {
+                blocks.push_back({static_cast<char *>(range.start) + offset,
+                                  std::min(size, range.length - offset)});
+            }
+        }
+        std::atomic<std::size_t> total = 0;
+        std::atomic<std::size_t> cursor = 0;
+        const auto t0 = Clock::now();
+        #pragma omp parallel
+        {
+            auto buf = std::make_unique<std::uint64_t[]>(size / sizeof(std::uint64_t));
+            std::uint64_t sink = 0;
+            while (Clock::now() - t0 < slice) {
+                iovec remote = blocks[cursor.fetch_add(1) % blocks.size()];
+                iovec local{buf.get(), remote.iov_len};
+                ssize_t nread = process_vm_readv(pid, &local, 1, &remote, 1, 0);
+                if (nread <= 0) {
+                    continue;
+                }
+                // Touch the data the way the comparison loop would
+                for (std::size_t i = 0; i < std::size_t(nread) / sizeof(std::uint64_t); ++i) {
+                    sink += buf[i];
+                }
+                total.fetch_add(std::size_t(nread));
+            }
+            asm volatile("" :: "r"(sink));
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+        const double rate = double(total.load()) / seconds;
+        // Prefer the smaller size unless the larger one is clearly faster
+        if (rate > best_rate * 1.05) {
+            best_rate = rate;
+            best = size;
+        }
+    }
+    if (best_rate > 0) {
+        fprintf(stdout, "Calibrated read size 0x%zx (%.0f MB/s)\n", best, best_rate / 1e6);
+    }
+    return best_rate > 0 ? best : default_max_read_size;
 }
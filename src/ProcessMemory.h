@@ -1,4 +1,6 @@
 #pragma once
+#include "MatchHistory.h"
+#include "MatchStore.h"
 #include "maps.h"
 #include "perf.h"
 
@@ -21,36 +23,178 @@
 #include <chrono>
 #include <functional>
 #include <iostream>
+#include <mutex>
+#include <span>
 
 
 using Match = std::variant<std::uint8_t *, std::uint16_t *, std::uint32_t *, std::uint64_t *, float *, double *>;
 
+/**
+ * One read in a ProcessMemory::read_many batch
+ */
+struct ReadRequest {
+    /** Address in the target process */
+    void            *address;
+
+    /** Where to store the bytes read */
+    void            *buffer;
+
+    /** Amount of bytes to read */
+    std::size_t     size;
+
+    /** Filled in by read_many, `size` on success otherwise -1 */
+    ssize_t         result = -1;
+};
+
+/**
+ * One write in a ProcessMemory::write_many batch
+ */
+struct WriteRequest {
+    /** Address in the target process */
+    void            *address;
+
+    /** Bytes to write */
+    const void      *buffer;
+
+    /** Amount of bytes to write */
+    std::size_t     size;
+
+    /** Filled in by write_many, `size` on success otherwise -1 */
+    ssize_t         result = -1;
+};
+
+/**
+ * How a scan decides which matches to keep, in the order of the scan type
+ * combo box. Only exact scans can start a new scan, the change based ones
+ * compare against the newest value in the match history.
+ */
+enum scan_mode {
+    SCAN_EXACT = 0,
+    SCAN_BIGGER,
+    SCAN_SMALLER,
+    SCAN_BETWEEN,
+    SCAN_UNKNOWN,
+    SCAN_CHANGED,
+    SCAN_UNCHANGED,
+    SCAN_INCREASED,
+    SCAN_DECREASED,
+};
+
+/** @brief needs_history tells whether a scan mode compares to older values */
+constexpr bool needs_history(scan_mode mode) {
+    return mode >= SCAN_CHANGED;
+}
+
 /*
  * maybe make this into a class? you could place the pid into
  * it which would be nice so you don't have a global variable
  */
 class ProcessMemory {
-    std::size_t max_read_size_ = 0x10000000;
+public:
+    /** Read size used until calibrate_read_size or the settings say otherwise */
+    static constexpr std::size_t default_max_read_size = 0x1000000;
+
+private:
+    /** Read once per range by the scan threads, may change at any time */
+    std::atomic<std::size_t> max_read_size_{default_max_read_size};
     double epsilon_ = 0.000000001;
-    std::vector<void *> matches{};
+    MatchStore matches{};
+    MatchHistory history_{};
     std::function<void(size_t, size_t)> progressCallback_{};
+    range_filter scan_filter_{};
     std::atomic<bool> scanning_{};
 
+    mutable std::mutex maps_lock_{};
+    std::shared_ptr<const maps_snapshot> maps_{};
+
     pid_t pid_{-1};
 
 public:
-    ssize_t write_process_memory(void *address, void *buffer,
-                                 const ssize_t n) const;
+    ssize_t write_process_memory(void *address, const void *buffer,
+                                 size_t n) const;
+
+    /**
+     * @brief write_proc_mem writes the failed requests of a batch through
+     * /proc/pid/mem, which unlike process_vm_writev can write to read-only
+     * mappings such as the text segment
+     *
+     * Only requests whose result is negative are attempted.
+     *
+     * @return the amount of requests that were written successfully
+     */
+    static std::size_t write_proc_mem(pid_t pid, std::span<WriteRequest> requests);
 
     static void prefetch_area(pid_t pid, void *address, size_t size);
     ssize_t read_process_memory(void *address, void *buffer, size_t n) const;
 	static ssize_t read_process_memory_nosplit(pid_t pid, void *address,
                                             void *buffer, size_t n);
 
+    /**
+     * @brief read_many reads a batch of scattered addresses with as few
+     * process_vm_readv calls as possible
+     *
+     * Requests are sorted and requests that touch the same page are coalesced
+     * into one remote iovec, the rest is packed into IOV_MAX sized batches.
+     * An unreadable address only fails the requests it belongs to.
+     *
+     * @return the amount of requests that were read successfully
+     */
+    static std::size_t read_many(pid_t pid, std::span<ReadRequest> requests);
+    std::size_t read_many(std::span<ReadRequest> requests) const {
+        return read_many(pid_, requests);
+    }
+
+    /**
+     * @brief write_many writes a batch of scattered addresses with as few
+     * process_vm_writev calls as possible
+     *
+     * Requests are written in the order given, packed into IOV_MAX sized
+     * batches. Unlike read_many nothing is coalesced since the bytes between
+     * two requests must not be touched. An unwritable address only fails its
+     * own request.
+     *
+     * @return the amount of requests that were written successfully
+     */
+    static std::size_t write_many(pid_t pid, std::span<WriteRequest> requests);
+    std::size_t write_many(std::span<WriteRequest> requests) const {
+        return write_many(pid_, requests);
+    }
+
     decltype(matches) &get_matches() {
         return matches;
     }
 
+    /**
+     * @brief history holds the values each match had in the last scans and
+     * value snapshots, indexed like get_matches()
+     */
+    const MatchHistory &history() const {
+        return history_;
+    }
+
+    /** @brief clear_matches drops the matches and their history */
+    void clear_matches() {
+        matches.clear();
+        history_.clear();
+    }
+
+    /**
+     * @brief seed_matches replaces the matches with addresses that weren't
+     * found by a scan, they start without history
+     */
+    void seed_matches(std::vector<void *> &&addresses) {
+        matches = std::move(addresses);
+        history_.clear();
+    }
+
+    /**
+     * @brief snapshot_values reads the current value of every match into a
+     * new history column without filtering anything
+     * @param width size of the scanned value type
+     * @return the amount of matches that could be read
+     */
+    std::size_t snapshot_values(std::size_t width);
+
     bool scanning() const {
         return scanning_.load();
     }
@@ -59,19 +203,59 @@ public:
         progressCallback_ = cb;
     }
 
+    /**
+     * @brief max_read_size sets how much a scan reads with one syscall, 0
+     * restores the default. Safe to call while scanning, a range already
+     * being scanned keeps the size it started with.
+     */
     void max_read_size(std::size_t size) {
-        // TODO: fix race condition
-        max_read_size_ = size;
+        max_read_size_.store(size != 0 ? size : default_max_read_size,
+                             std::memory_order_relaxed);
     }
 
     std::size_t max_read_size() const {
-        return max_read_size_;
+        return max_read_size_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief benchmark_read_size measures scan throughput, reading and
+     * touching the data like a scan does on all cores, for a set of read
+     * sizes and returns the fastest. Larger reads mean fewer syscalls but
+     * once the per-thread buffers stop fitting in cache every value is
+     * fetched from memory twice.
+     *
+     * @param budget roughly how long the whole benchmark may take
+     * @return the best read size, the default if nothing could be read
+     */
+    static std::size_t benchmark_read_size(pid_t pid, const maps_snapshot &maps,
+                                           std::chrono::milliseconds budget);
+
+    /**
+     * @brief calibrate_read_size benchmarks the attached process and
+     * applies the result
+     */
+    std::size_t calibrate_read_size(std::chrono::milliseconds budget = std::chrono::milliseconds{300}) {
+        std::size_t size = benchmark_read_size(pid_, *refresh_maps(), budget);
+        max_read_size(size);
+        return size;
     }
 
     void epsilon(double e) {
         epsilon_ = e;
     }
 
+    /**
+     * @brief scan_filter sets which ranges the initial scan reads, must not
+     * be called while a scan is running
+     */
+    void scan_filter(const range_filter &filter) {
+        scan_filter_ = filter;
+    }
+
+    const range_filter &scan_filter() const {
+        return scan_filter_;
+    }
+
     bool pid(const pid_t p) {
         if (!std::filesystem::exists("/proc/" + std::to_string(p))) {
             std::cout << "Could not attach to: " << p << "\n";
@@ -79,6 +263,7 @@ public:
         }
 
         pid_ = p;
+        refresh_maps();
         return true;
     }
 
@@ -86,6 +271,22 @@ public:
         return pid_;
     }
 
+    /** @brief detach forgets the process, reads fail until pid() is set */
+    void detach() {
+        pid_ = -1;
+    }
+
+    /**
+     * @brief refresh_maps re-reads the memory map of the process, including
+     * executable ranges, and publishes it as the current snapshot
+     */
+    std::shared_ptr<const maps_snapshot> refresh_maps();
+
+    /**
+     * @brief maps returns the most recent snapshot, never null
+     */
+    std::shared_ptr<const maps_snapshot> maps() const;
+
     /**
      * @brief ProcessMemory::scan_range scans a section of a process
      * @param range Memory range information
@@ -96,7 +297,8 @@ public:
     void scan_range(std::vector<void *>& found, const address_range &range,
                     const T value) {
         // We're largely dependent on how large the page size is on how much we can actually read.
-        const std::size_t count = max_read_size_ / sizeof(T);
+        const std::size_t read_size = max_read_size();
+        const std::size_t count = read_size / sizeof(T);
 
         size_t bufsize = std::min(range.length / sizeof(T), count);
         alignas(64) std::unique_ptr<T[]> buf = std::make_unique<T[]>(bufsize);
@@ -107,9 +309,9 @@ public:
 
         for (char *start = reinterpret_cast<char *>(range.start);
              start < end;
-             start += max_read_size_) {
+             start += read_size) {
             std::uintptr_t ptrdiff = end - start;
-            ssize_t size = std::min(max_read_size_, ptrdiff);
+            ssize_t size = std::min(read_size, ptrdiff);
 
             ssize_t nread = read_process_memory_nosplit(pid_, start, buf.get(), size);
             if (nread < 0 || nread != size) {
@@ -131,7 +333,11 @@ public:
      * @return returns the matches it finds
      */
     template<typename T>
-    void scan(T value) {
+    void scan(T value, scan_mode mode = SCAN_EXACT) {
+        if (!can_refine<T>(mode)) {
+            std::fprintf(stderr, "ProcessMemory: no previous values to compare to\n");
+            return;
+        }
         scanning_ = true;
         using Clock = std::chrono::high_resolution_clock;
         std::cout << "epsilon: " << epsilon_ << "\n";
@@ -153,9 +359,9 @@ public:
         auto overall_t0 = Clock::now();
 
         if (matches.size() == 0) {
-            matches = initial_scan<T>(value);
+            adopt_matches<T>(initial_scan<T>(value), value);
         } else {
-            scan_found<T>(value);
+            scan_found<T>(value, mode);
         }
 
         ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
@@ -171,34 +377,141 @@ public:
         scanning_ = false;
     }
 
+    /**
+     * @brief can_refine tells whether the matches can be filtered with `mode`,
+     * the change based modes need a history of the same value type
+     */
+    template<typename T>
+    bool can_refine(scan_mode mode) const {
+        return !needs_history(mode) ||
+               (history_.filled() != 0 && history_.size() == matches.size() &&
+                history_.width() == sizeof(T));
+    }
+
+    /**
+     * @brief adopt_matches replaces the matches with the result of an exact
+     * scan for `value` done with scan_range, e.g. by a ProcessGroup. The
+     * history starts with `value` for every match.
+     */
+    template<typename T>
+    void adopt_matches(std::vector<void *> &&found, T value) {
+        matches = std::move(found);
+        history_.reset(matches.size(), sizeof(T));
+        history_.begin_column();
+        for (std::size_t i = 0; i < matches.size(); ++i) {
+            history_.set(i, &value);
+        }
+    }
+
+    /**
+     * @brief refine filters the current matches like a next scan, without
+     * the timing and perf counters scan() reports
+     * @return false if `mode` has no previous values to compare to
+     */
+    template<typename T>
+    bool refine(T value, scan_mode mode) {
+        if (!can_refine<T>(mode)) {
+            return false;
+        }
+        scan_found<T>(value, mode);
+        return true;
+    }
+
 private:
+    /**
+     * Reads are spread over the threads a batch at a time straight into the
+     * new history column, then the matches are compacted in one serial pass
+     * that only touches memory
+     */
     template<typename T>
-    void scan_found(T value) {
+    void scan_found(T value, scan_mode mode) {
+        constexpr std::size_t batch = 4096;
+
+        // A history left over from another value type or a seeded match
+        // list is started over, it has nothing to compare to anyway
+        if (history_.size() != matches.size() || history_.width() != sizeof(T)) {
+            history_.reset(matches.size(), sizeof(T));
+        }
+        history_.begin_column();
+
+        const std::size_t batches = (matches.size() + batch - 1) / batch;
+        #pragma omp parallel
+        {
+            auto values = std::make_unique<T[]>(batch);
+            std::vector<ReadRequest> requests(batch);
+            #pragma omp for schedule(dynamic, 1)
+            for (std::size_t b = 0; b < batches; ++b) {
+                const std::size_t first = b * batch;
+                const std::size_t count = std::min(batch, matches.size() - first);
+                for (std::size_t i = 0; i < count; ++i) {
+                    requests[i] = {matches[first + i], &values[i], sizeof(T)};
+                }
+                read_many(std::span{requests.data(), count});
+                // Each thread writes its own rows of the column
+                for (std::size_t i = 0; i < count; ++i) {
+                    if (requests[i].result == static_cast<ssize_t>(sizeof(T))) {
+                        history_.set(first + i, &values[i]);
+                    } else {
+                        history_.invalidate(first + i);
+                    }
+                }
+            }
+        }
+
         std::size_t found = 0;
         for (std::size_t i = 0; i < matches.size(); ++i) {
-            void *addr = matches[i];
-            if (addr == nullptr) {
-                return;
+            // Age 0 is the column just read, 1 the last one
+            std::uint64_t raw = 0;
+            if (!history_.get(i, 0, raw)) {
+                continue;
             }
-            T new_value{};
-            [[maybe_unused]] ssize_t n =
-                read_process_memory_nosplit(pid_, addr, &new_value,
-                                            sizeof(new_value));
-            assert(n == sizeof(T));
-            if (new_value != value) {
-                matches[i] = static_cast<T *>(nullptr);
-            } else {
-                matches[found++] = addr;
+            T current{};
+            std::memcpy(&current, &raw, sizeof(T));
+            T previous{};
+            raw = 0;
+            bool has_previous = history_.get(i, 1, raw);
+            std::memcpy(&previous, &raw, sizeof(T));
+            if (keep(mode, current, value, previous, has_previous)) {
+                history_.move(i, found);
+                matches[found++] = matches[i];
             }
         }
         matches.resize(found);
+        history_.resize(found);
+    }
+
+    template<typename T>
+    bool keep(scan_mode mode, T current, T value, T previous, bool has_previous) const {
+        switch (mode) {
+        case SCAN_CHANGED:
+            return has_previous && !equals(current, previous);
+        case SCAN_UNCHANGED:
+            return has_previous && equals(current, previous);
+        case SCAN_INCREASED:
+            return has_previous && current > previous && !equals(current, previous);
+        case SCAN_DECREASED:
+            return has_previous && current < previous && !equals(current, previous);
+        default:
+            return equals(current, value);
+        }
+    }
+
+    template<typename T>
+    bool equals(T a, T b) const {
+        if constexpr (std::is_floating_point_v<T>) {
+            return std::abs(a - b) < epsilon_;
+        } else {
+            return a == b;
+        }
     }
 
     template<typename T>
     std::vector<void *> initial_scan(T value) {
-        std::vector<address_range> list = get_memory_ranges(pid_, false);
+        auto snapshot = refresh_maps();
+        std::vector<address_range> list =
+            apply_range_filter(snapshot->ranges, scan_filter_);
         std::vector<void *> found;
-        size_t total_size = get_address_range_list_size(list, false);
+        size_t total_size = get_address_range_list_size(list, true);
         std::atomic<size_t> scanned_size = 0;
         #pragma omp parallel
         {
@@ -206,10 +519,10 @@ private:
             #pragma omp for schedule(dynamic, 5)
             for (auto it = list.begin(); it < list.end(); ++it) {
                 auto& current = *it;
-                if (current.perms & PERM_READ) {
-                    scan_range<T>(local, current, value);
+                scan_range<T>(local, current, value);
 
-                    scanned_size.fetch_add(current.length);
+                scanned_size.fetch_add(current.length);
+                if (progressCallback_) {
                     progressCallback_(scanned_size.load(), total_size);
                 }
             }
@@ -0,0 +1,202 @@
+#include "SavedAddressStore.h"
+#include "PointerScanner.h"
+#include "ProcessMemory.h"
+#include "Signature.h"
+
+#include <algorithm>
+
+std::optional<std::uintptr_t> resolve_locator(const std::string &locator, pid_t pid,
+                                              const maps_snapshot &maps) {
+    constexpr std::size_t prefix = sizeof(signature_locator_prefix) - 1;
+    if (locator.compare(0, prefix, signature_locator_prefix) == 0) {
+        auto sig = signature::parse(locator.substr(prefix));
+        if (!sig) {
+            return std::nullopt;
+        }
+        auto matches = scan_signatures(pid, maps, std::span<const signature>(&*sig, 1));
+        // More than one match doesn't say which one was meant
+        if (matches.size() != 1) {
+            return std::nullopt;
+        }
+        return matches.front().resolved;
+    }
+    auto path = pointer_path::parse(locator);
+    if (!path) {
+        return std::nullopt;
+    }
+    return path->resolve(pid, maps);
+}
+
+long SavedAddressStore::find(std::uintptr_t address) const {
+    auto it = index_.find(address);
+    return it != index_.end() ? static_cast<long>(it->second) : -1;
+}
+
+long SavedAddressStore::add(std::uintptr_t address, value_type type, std::string description,
+                            std::string locator) {
+    if (index_.contains(address)) {
+        return -1;
+    }
+    const std::size_t row = entries_.size();
+    entries_.push_back({address, 0, 0, std::move(description), std::move(locator), type, false,
+                        false, false});
+    index_.emplace(address, row);
+    return static_cast<long>(row);
+}
+
+void SavedAddressStore::remove(std::size_t row) {
+    index_.erase(entries_[row].address);
+    entries_.erase(entries_.begin() + static_cast<std::ptrdiff_t>(row));
+    // Every row after it moved up by one
+    for (std::size_t i = row; i < entries_.size(); ++i) {
+        index_[entries_[i].address] = i;
+    }
+}
+
+void SavedAddressStore::clear() {
+    entries_.clear();
+    index_.clear();
+}
+
+void SavedAddressStore::set_type(std::size_t row, value_type type) {
+    saved_address &entry = entries_[row];
+    if (entry.type == type) {
+        return;
+    }
+    // The old value means nothing at the new width
+    entry.type = type;
+    entry.value = 0;
+    entry.previous = 0;
+    entry.valid = false;
+    entry.changed = false;
+}
+
+void SavedAddressStore::set_description(std::size_t row, std::string description) {
+    entries_[row].description = std::move(description);
+}
+
+void SavedAddressStore::set_frozen(std::size_t row, bool frozen) {
+    entries_[row].frozen = frozen;
+}
+
+std::size_t SavedAddressStore::relocate(pid_t pid, const maps_snapshot &maps,
+                                       std::vector<std::size_t> *unresolved) {
+    const std::vector<std::string> current = locators();
+    return apply_locations(current, resolve_locators(current, pid, maps), unresolved);
+}
+
+std::vector<std::string> SavedAddressStore::locators() const {
+    std::vector<std::string> result;
+    result.reserve(entries_.size());
+    for (const saved_address &entry : entries_) {
+        result.push_back(entry.locator);
+    }
+    return result;
+}
+
+std::vector<std::optional<std::uintptr_t>>
+SavedAddressStore::resolve_locators(const std::vector<std::string> &locators, pid_t pid,
+                                    const maps_snapshot &maps) {
+    constexpr std::size_t prefix = sizeof(signature_locator_prefix) - 1;
+    std::vector<std::optional<std::uintptr_t>> addresses(locators.size());
+
+    // All signatures are searched for in one pass over the modules
+    std::vector<signature> signatures;
+    std::vector<std::size_t> signature_rows;
+    for (std::size_t row = 0; row < locators.size(); ++row) {
+        const std::string &locator = locators[row];
+        if (locator.compare(0, prefix, signature_locator_prefix) == 0) {
+            if (auto sig = signature::parse(locator.substr(prefix))) {
+                signatures.push_back(std::move(*sig));
+                signature_rows.push_back(row);
+            }
+        } else if (!locator.empty()) {
+            addresses[row] = resolve_locator(locator, pid, maps);
+        }
+    }
+    if (!signatures.empty()) {
+        std::vector<std::size_t> counts(signatures.size());
+        std::vector<std::uintptr_t> resolved(signatures.size());
+        for (const signature_match &match : scan_signatures(pid, maps, signatures)) {
+            ++counts[match.signature];
+            resolved[match.signature] = match.resolved;
+        }
+        for (std::size_t i = 0; i < signatures.size(); ++i) {
+            if (counts[i] == 1) {
+                addresses[signature_rows[i]] = resolved[i];
+            }
+        }
+    }
+    return addresses;
+}
+
+std::size_t SavedAddressStore::apply_locations(
+    const std::vector<std::string> &locators,
+    const std::vector<std::optional<std::uintptr_t>> &addresses,
+    std::vector<std::size_t> *unresolved) {
+    std::size_t count = 0;
+    const std::size_t rows = std::min({entries_.size(), locators.size(), addresses.size()});
+    for (std::size_t row = 0; row < rows; ++row) {
+        saved_address &entry = entries_[row];
+        const std::optional<std::uintptr_t> &address = addresses[row];
+        if (entry.locator.empty() || entry.locator != locators[row]) {
+            continue;
+        }
+        if (!address || (*address != entry.address && index_.contains(*address))) {
+            entry.valid = false;
+            if (unresolved != nullptr) {
+                unresolved->push_back(row);
+            }
+            continue;
+        }
+        ++count;
+        if (*address == entry.address) {
+            continue;
+        }
+        index_.erase(entry.address);
+        index_.emplace(*address, row);
+        entry.address = *address;
+        // Whatever was read at the old address belongs to the old process
+        entry.valid = false;
+        entry.changed = false;
+    }
+    return count;
+}
+
+bool SavedAddressStore::set_value(std::size_t row, std::uint64_t value, bool valid) {
+    saved_address &entry = entries_[row];
+    const bool updated = valid != entry.valid || (valid && value != entry.value);
+    if (valid && entry.valid && value != entry.value) {
+        entry.previous = entry.value;
+        entry.changed = true;
+    }
+    if (valid) {
+        entry.value = value;
+    }
+    entry.valid = valid;
+    return updated;
+}
+
+std::size_t SavedAddressStore::refresh(pid_t pid, std::size_t first, std::size_t count,
+                                       std::vector<std::size_t> *changed) {
+    if (first >= entries_.size()) {
+        return 0;
+    }
+    count = std::min(count, entries_.size() - first);
+    std::vector<std::uint64_t> values(count);
+    std::vector<ReadRequest> requests(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const saved_address &entry = entries_[first + i];
+        requests[i] = {reinterpret_cast<void *>(entry.address), &values[i],
+                       value_type_size(entry.type)};
+    }
+    const std::size_t read = ProcessMemory::read_many(pid, requests);
+
+    for (std::size_t i = 0; i < count; ++i) {
+        const bool valid = requests[i].result == static_cast<ssize_t>(requests[i].size);
+        if (set_value(first + i, values[i], valid) && changed != nullptr) {
+            changed->push_back(first + i);
+        }
+    }
+    return read;
+}
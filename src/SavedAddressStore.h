@@ -0,0 +1,158 @@
+#pragma once
+#include "value_type.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sys/types.h>
+
+/**
+ * One saved address, values are the raw bytes zero-extended to 64 bits
+ */
+struct saved_address {
+    std::uintptr_t  address;
+
+    /** Last value read */
+    std::uint64_t   value;
+
+    /** Value before the last change */
+    std::uint64_t   previous;
+
+    std::string     description;
+
+    /**
+     * Pointer path or signature the address is found with, empty for a
+     * fixed address. See resolve_locator.
+     */
+    std::string     locator;
+
+    value_type      type;
+
+    bool            frozen;
+
+    /** The last read succeeded */
+    bool            valid;
+
+    /** The value changed at least once since the address was saved */
+    bool            changed;
+};
+
+struct maps_snapshot;
+
+/** Prefix of locators holding a signature database line instead of a pointer path */
+constexpr char signature_locator_prefix[] = "sig:";
+
+/**
+ * @brief resolve_locator finds the address a locator stands for in the
+ * current process image. A locator is either a pointer path as written by
+ * pointer_path::to_string or signature_locator_prefix followed by a
+ * signature database line, which must match exactly once.
+ * @return nullopt if the locator is invalid or doesn't resolve
+ */
+std::optional<std::uintptr_t> resolve_locator(const std::string &locator, pid_t pid,
+                                              const maps_snapshot &maps);
+
+/**
+ * The saved addresses, stored contiguously in the order they are shown with
+ * an index by address. All of them are refreshed with a single batched read.
+ */
+class SavedAddressStore {
+public:
+    std::size_t size() const {
+        return entries_.size();
+    }
+
+    bool empty() const {
+        return entries_.empty();
+    }
+
+    const saved_address &operator[](std::size_t row) const {
+        return entries_[row];
+    }
+
+    auto begin() const {
+        return entries_.begin();
+    }
+
+    auto end() const {
+        return entries_.end();
+    }
+
+    /** @return the row of `address`, -1 if it isn't saved */
+    long find(std::uintptr_t address) const;
+
+    /**
+     * @brief add appends an address, its value is unknown until refreshed
+     * or given with set_value
+     * @return the new row, -1 if the address was already saved
+     */
+    long add(std::uintptr_t address, value_type type, std::string description = {},
+             std::string locator = {});
+
+    void remove(std::size_t row);
+    void clear();
+
+    void set_type(std::size_t row, value_type type);
+    void set_description(std::size_t row, std::string description);
+    void set_frozen(std::size_t row, bool frozen);
+
+    /**
+     * @brief relocate resolves the locator of every row that has one again,
+     * e.g. after the target restarted. Rows that don't resolve, or would
+     * land on an address saved in another row, keep their address and are
+     * marked invalid.
+     * @param unresolved filled with the rows that have a locator which
+     * didn't resolve, may be null
+     * @return the amount of rows that resolved
+     */
+    std::size_t relocate(pid_t pid, const maps_snapshot &maps,
+                         std::vector<std::size_t> *unresolved = nullptr);
+
+    /** @brief locators lists the locator of every row, in row order */
+    std::vector<std::string> locators() const;
+
+    /**
+     * @brief resolve_locators does the slow part of relocate without
+     * touching a store, so it can run on another thread. All signatures are
+     * searched for in one pass over the modules.
+     * @return the address of each locator, nullopt where it didn't resolve
+     */
+    static std::vector<std::optional<std::uintptr_t>>
+    resolve_locators(const std::vector<std::string> &locators, pid_t pid,
+                     const maps_snapshot &maps);
+
+    /**
+     * @brief apply_locations finishes a relocate with the result of
+     * resolve_locators for `locators`. Rows whose locator changed since are
+     * left alone.
+     */
+    std::size_t apply_locations(const std::vector<std::string> &locators,
+                                const std::vector<std::optional<std::uintptr_t>> &addresses,
+                                std::vector<std::size_t> *unresolved = nullptr);
+
+    /**
+     * @brief set_value stores a value read elsewhere, e.g. by the memory
+     * monitor
+     * @return true if the value or its validity differs from the last one
+     */
+    bool set_value(std::size_t row, std::uint64_t value, bool valid);
+
+    /**
+     * @brief refresh reads `count` rows starting at `first` with one
+     * read_many batch
+     * @param changed filled with the rows set_value reported as updated,
+     * may be null
+     * @return the amount of rows that could be read
+     */
+    std::size_t refresh(pid_t pid, std::size_t first = 0,
+                        std::size_t count = std::numeric_limits<std::size_t>::max(),
+                        std::vector<std::size_t> *changed = nullptr);
+
+private:
+    std::vector<saved_address>                          entries_{};
+    std::unordered_map<std::uintptr_t, std::size_t>     index_{};
+};
@@ -0,0 +1,238 @@
+#include "Session.h"
+#include "PointerMapFile.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <tuple>
+#include <unistd.h>
+
+namespace {
+constexpr std::uint64_t page_size = 4096;
+
+std::uint64_t align(std::uint64_t v, std::uint64_t to) {
+    return (v + to - 1) & ~(to - 1);
+}
+
+/**
+ * Strings are appended to one blob and referred to by offset and length
+ */
+struct string_table {
+    std::string data;
+
+    std::pair<std::uint32_t, std::uint32_t> add(const std::string &s) {
+        auto offset = static_cast<std::uint32_t>(data.size());
+        data += s;
+        return {offset, static_cast<std::uint32_t>(s.size())};
+    }
+};
+
+bool write_all(FILE *f, const void *data, std::size_t size) {
+    return size == 0 || fwrite(data, 1, size, f) == size;
+}
+}
+
+bool save_session(const std::string &path, const session &s, std::span<void *const> matches) {
+    string_table strings;
+    session_header header{};
+    std::memcpy(header.magic, session_magic, sizeof(header.magic));
+    header.version = session_version;
+    header.pid = s.pid;
+    header.type = s.type;
+    std::tie(header.name_offset, header.name_length) = strings.add(s.process);
+
+    std::vector<pointer_map_range> ranges;
+    if (s.maps) {
+        for (const address_range &r : s.maps->ranges) {
+            pointer_map_range out{};
+            out.start = reinterpret_cast<std::uintptr_t>(r.start);
+            out.length = r.length;
+            out.offset = r.offset;
+            out.inode = r.inode;
+            out.device = r.device;
+            out.perms = r.perms;
+            std::tie(out.name_offset, out.name_length) = strings.add(r.name);
+            ranges.push_back(out);
+        }
+    }
+
+    std::vector<session_scan> history;
+    for (const scan_record &scan : s.history) {
+        session_scan out{};
+        out.match_count = scan.matches;
+        out.time = scan.time;
+        out.type = scan.type;
+        std::tie(out.text_offset, out.text_length) = strings.add(scan.text);
+        history.push_back(out);
+    }
+
+    std::vector<session_saved> saved;
+    for (const saved_address_record &entry : s.saved) {
+        session_saved out{};
+        out.address = entry.address;
+        out.value = entry.value;
+        out.size = entry.size;
+        out.type = entry.type;
+        out.frozen = entry.frozen;
+        std::tie(out.description_offset, out.description_length) = strings.add(entry.description);
+        std::tie(out.locator_offset, out.locator_length) = strings.add(entry.locator);
+        saved.push_back(out);
+    }
+
+    header.range_count = ranges.size();
+    header.history_count = history.size();
+    header.saved_count = saved.size();
+    header.match_count = matches.size();
+    header.ranges_offset = sizeof(header);
+    header.history_offset = header.ranges_offset + ranges.size() * sizeof(pointer_map_range);
+    header.saved_offset = header.history_offset + history.size() * sizeof(session_scan);
+    header.strings_offset = header.saved_offset + saved.size() * sizeof(session_saved);
+    header.matches_offset = align(header.strings_offset + strings.data.size(), page_size);
+    header.file_size = header.matches_offset + matches.size() * sizeof(std::uint64_t);
+
+    const std::string temporary = path + ".tmp";
+    FILE *f = fopen(temporary.c_str(), "wb");
+    if (f == nullptr) {
+        fprintf(stderr, "Error opening file %s: %s\n", temporary.c_str(), strerror(errno));
+        return false;
+    }
+    const std::vector<char> padding(header.matches_offset - header.strings_offset -
+                                    strings.data.size());
+    static_assert(sizeof(void *) == sizeof(std::uint64_t));
+    bool ok = write_all(f, &header, sizeof(header)) &&
+              write_all(f, ranges.data(), ranges.size() * sizeof(pointer_map_range)) &&
+              write_all(f, history.data(), history.size() * sizeof(session_scan)) &&
+              write_all(f, saved.data(), saved.size() * sizeof(session_saved)) &&
+              write_all(f, strings.data.data(), strings.data.size()) &&
+              write_all(f, padding.data(), padding.size()) &&
+              write_all(f, matches.data(), matches.size() * sizeof(void *));
+    if (fclose(f) != 0) {
+        ok = false;
+    }
+    if (ok && rename(temporary.c_str(), path.c_str()) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        fprintf(stderr, "Error writing session %s: %s\n", path.c_str(), strerror(errno));
+        unlink(temporary.c_str());
+    }
+    return ok;
+}
+
+bool load_session(const std::string &path, session &s, MatchStore &matches) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "Error opening file %s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || std::size_t(st.st_size) < sizeof(session_header)) {
+        fprintf(stderr, "Error: %s is not a session\n", path.c_str());
+        close(fd);
+        return false;
+    }
+    const auto size = static_cast<std::size_t>(st.st_size);
+    // Writable private mapping, scans compact the matches in place
+    void *map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "Error mapping %s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    const auto *data = static_cast<const std::uint8_t *>(map);
+    const auto &h = *reinterpret_cast<const session_header *>(data);
+    auto invalid = [&] {
+        fprintf(stderr, "Error: %s is not a valid session\n", path.c_str());
+        munmap(map, size);
+        return false;
+    };
+    // Counts are checked against the file before they are multiplied, a
+    // corrupt count must neither wrap the offsets around nor size a vector
+    auto fits = [size](std::uint64_t offset, std::uint64_t count, std::uint64_t record) {
+        return offset <= size && count <= (size - offset) / record;
+    };
+    if (std::memcmp(h.magic, session_magic, sizeof(session_magic)) != 0 ||
+        h.version != session_version || h.file_size != size ||
+        h.type >= VALUE_TYPE_COUNT ||
+        h.ranges_offset != sizeof(session_header) ||
+        !fits(h.ranges_offset, h.range_count, sizeof(pointer_map_range)) ||
+        h.history_offset != h.ranges_offset + h.range_count * sizeof(pointer_map_range) ||
+        !fits(h.history_offset, h.history_count, sizeof(session_scan)) ||
+        h.saved_offset != h.history_offset + h.history_count * sizeof(session_scan) ||
+        !fits(h.saved_offset, h.saved_count, sizeof(session_saved)) ||
+        h.strings_offset != h.saved_offset + h.saved_count * sizeof(session_saved) ||
+        h.matches_offset < h.strings_offset || h.matches_offset % page_size != 0 ||
+        !fits(h.matches_offset, h.match_count, sizeof(std::uint64_t)) ||
+        h.matches_offset + h.match_count * sizeof(std::uint64_t) != size) {
+        return invalid();
+    }
+    const char *strings = reinterpret_cast<const char *>(data + h.strings_offset);
+    const std::uint64_t strings_size = h.matches_offset - h.strings_offset;
+    auto string_at = [&](std::uint32_t offset, std::uint32_t length, std::string &out) {
+        if (std::uint64_t(offset) + length > strings_size) {
+            return false;
+        }
+        out.assign(strings + offset, length);
+        return true;
+    };
+
+    session loaded{};
+    loaded.pid = h.pid;
+    loaded.type = static_cast<value_type>(h.type);
+    if (!string_at(h.name_offset, h.name_length, loaded.process)) {
+        return invalid();
+    }
+
+    const auto *ranges = reinterpret_cast<const pointer_map_range *>(data + h.ranges_offset);
+    std::vector<address_range> list(h.range_count);
+    for (std::size_t i = 0; i < list.size(); ++i) {
+        const pointer_map_range &in = ranges[i];
+        address_range &out = list[i];
+        std::string name;
+        if (!string_at(in.name_offset, in.name_length, name)) {
+            return invalid();
+        }
+        out.start = reinterpret_cast<void *>(in.start);
+        out.length = in.length;
+        out.offset = in.offset;
+        out.inode = in.inode;
+        out.device = in.device;
+        out.perms = in.perms;
+        std::size_t len = std::min(name.size(), sizeof(out.name) - 1);
+        std::memcpy(out.name, name.data(), len);
+        out.name[len] = '\0';
+    }
+    loaded.maps = std::make_shared<const maps_snapshot>(std::move(list));
+
+    const auto *history = reinterpret_cast<const session_scan *>(data + h.history_offset);
+    for (std::size_t i = 0; i < h.history_count; ++i) {
+        scan_record scan{static_cast<value_type>(history[i].type), {},
+                         history[i].match_count, history[i].time};
+        if (scan.type >= VALUE_TYPE_COUNT ||
+            !string_at(history[i].text_offset, history[i].text_length, scan.text)) {
+            return invalid();
+        }
+        loaded.history.push_back(std::move(scan));
+    }
+
+    const auto *saved = reinterpret_cast<const session_saved *>(data + h.saved_offset);
+    for (std::size_t i = 0; i < h.saved_count; ++i) {
+        const session_saved &in = saved[i];
+        saved_address_record entry{in.address, in.size, in.type, in.frozen != 0, {}, in.value, {}};
+        if (entry.size > sizeof(entry.value) ||
+            !string_at(in.description_offset, in.description_length, entry.description) ||
+            !string_at(in.locator_offset, in.locator_length, entry.locator)) {
+            return invalid();
+        }
+        loaded.saved.push_back(std::move(entry));
+    }
+
+    s = std::move(loaded);
+    matches.map(map, size, h.matches_offset, h.match_count);
+    return true;
+}
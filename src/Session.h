@@ -0,0 +1,124 @@
+#pragma once
+#include "MatchStore.h"
+#include "maps.h"
+#include "value_type.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+/*
+ * On-disk scan session, laid out so the match list can be used straight
+ * from mmap:
+ *
+ *   session_header
+ *   pointer_map_range[range_count]     maps snapshot, same records as a pointer map
+ *   session_scan[history_count]        every scan in order
+ *   session_saved[saved_count]         saved address list
+ *   char strings[]                     names and texts, referenced by offset
+ *   uint64_t matches[match_count]      page aligned
+ */
+
+struct session_header {
+    char            magic[8];
+    std::uint32_t   version;
+    std::int32_t    pid;
+    std::uint8_t    type;
+    std::uint8_t    reserved[7];
+    std::uint32_t   name_offset;
+    std::uint32_t   name_length;
+    std::uint64_t   range_count;
+    std::uint64_t   history_count;
+    std::uint64_t   saved_count;
+    std::uint64_t   match_count;
+    std::uint64_t   ranges_offset;
+    std::uint64_t   history_offset;
+    std::uint64_t   saved_offset;
+    std::uint64_t   strings_offset;
+    std::uint64_t   matches_offset;
+    std::uint64_t   file_size;
+};
+
+struct session_scan {
+    std::uint64_t   match_count;
+    std::int64_t    time;
+    std::uint32_t   text_offset;
+    std::uint32_t   text_length;
+    std::uint8_t    type;
+    std::uint8_t    reserved[7];
+};
+
+struct session_saved {
+    std::uint64_t   address;
+    std::uint64_t   value;
+    std::uint32_t   size;
+    std::uint32_t   type;
+    std::uint32_t   description_offset;
+    std::uint32_t   description_length;
+    std::uint32_t   locator_offset;
+    std::uint32_t   locator_length;
+    std::uint8_t    frozen;
+    std::uint8_t    reserved[7];
+};
+
+static_assert(sizeof(session_header) % 8 == 0);
+static_assert(sizeof(session_scan) == 32);
+static_assert(sizeof(session_saved) == 48);
+
+/** One first or next scan */
+struct scan_record {
+    value_type      type;
+    std::string     text;
+    std::uint64_t   matches;
+    /** Unix time the scan finished */
+    std::int64_t    time;
+};
+
+/** A row of the saved address list */
+struct saved_address_record {
+    std::uintptr_t  address;
+    std::uint32_t   size;
+    /** A value_type */
+    std::uint32_t   type;
+    bool            frozen;
+    std::string     description;
+    /** Last known value, little endian in the low `size` bytes */
+    std::uint64_t   value;
+    /** See saved_address::locator */
+    std::string     locator;
+};
+
+/**
+ * Everything of a session except the matches, which go straight between
+ * the scanner and the file
+ */
+struct session {
+    pid_t                                   pid{-1};
+    std::string                             process{};
+    value_type                              type{VALUE_U32};
+    std::vector<scan_record>                history{};
+    std::vector<saved_address_record>       saved{};
+    std::shared_ptr<const maps_snapshot>    maps{};
+};
+
+constexpr char session_magic[8] = {'M', 'E', 'M', 'S', 'C', 'S', 'S', '\0'};
+constexpr std::uint32_t session_version = 1;
+
+/**
+ * @brief save_session writes `s` and `matches` to a temporary file that
+ * replaces `path` once complete, so a crash while saving keeps the old one
+ * @return false on error, errors are reported on stderr
+ */
+bool save_session(const std::string &path, const session &s, std::span<void *const> matches);
+
+/**
+ * @brief load_session reads a session file, the matches are mapped into
+ * `matches` instead of being read
+ * @return false on error, errors are reported on stderr. Nothing is changed
+ * on error.
+ */
+bool load_session(const std::string &path, session &s, MatchStore &matches);
@@ -0,0 +1,343 @@
+#include "Signature.h"
+#include "ProcessMemory.h"
+#include "X86Code.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <immintrin.h>
+#include <memory>
+#include <sstream>
+#include <tuple>
+
+namespace {
+/**
+ * Bytes that are everywhere in x86 code make poor anchors, everything else
+ * is treated as equally rare
+ */
+bool is_common(std::uint8_t b) {
+    switch (b) {
+    case 0x00: case 0xff: case 0xcc: case 0x90: case 0x48: case 0x89:
+    case 0x8b: case 0x0f: case 0x24: case 0x44: case 0x4c: case 0xe8:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * A signature prepared for matching, the prefilter looks for the two anchor
+ * bytes at their distance before comparing the whole pattern
+ */
+struct compiled_signature {
+    const signature *sig;
+    std::size_t     first;
+    std::size_t     second;
+};
+
+compiled_signature compile(const signature &sig) {
+    compiled_signature c{&sig, 0, 0};
+    std::vector<std::size_t> exact;
+    for (std::size_t i = 0; i < sig.bytes.size(); ++i) {
+        if (sig.mask[i] == 0xff) {
+            exact.push_back(i);
+        }
+    }
+    if (exact.empty()) {
+        return c;
+    }
+    auto rare = std::find_if(exact.begin(), exact.end(),
+                             [&sig](std::size_t i) { return !is_common(sig.bytes[i]); });
+    c.first = rare != exact.end() ? *rare : exact.front();
+    // The furthest exact byte from the first, so they're unlikely to be
+    // matched by the same common instruction
+    c.second = std::abs(std::ptrdiff_t(exact.back()) - std::ptrdiff_t(c.first)) >
+               std::abs(std::ptrdiff_t(exact.front()) - std::ptrdiff_t(c.first)) ? exact.back()
+                                                                               : exact.front();
+    return c;
+}
+
+bool matches_at(const signature &sig, const std::uint8_t *p) {
+    for (std::size_t i = 0; i < sig.bytes.size(); ++i) {
+        if ((p[i] & sig.mask[i]) != sig.bytes[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief find_all calls `f` with every offset in [0, count) where the
+ * signature matches, `buf` must have `count + pattern size - 1` bytes
+ */
+template<typename F>
+void find_all(const compiled_signature &c, const std::uint8_t *buf, std::size_t count, F &&f) {
+    const signature &sig = *c.sig;
+    const std::uint8_t *first = buf + c.first;
+    const std::uint8_t *second = buf + c.second;
+    std::size_t i = 0;
+
+#ifdef __AVX2__
+    constexpr std::size_t lanes = 32;
+    const __m256i a = _mm256_set1_epi8(static_cast<char>(sig.bytes[c.first]));
+    const __m256i b = _mm256_set1_epi8(static_cast<char>(sig.bytes[c.second]));
+    for (; i + lanes <= count; i += lanes) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(first + i));
+        __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(second + i));
+        auto mask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(x, a), _mm256_cmpeq_epi8(y, b))));
+        while (mask) {
+            unsigned lane = __builtin_ctz(mask);
+            mask &= mask - 1;
+            if (matches_at(sig, buf + i + lane)) {
+                f(i + lane);
+            }
+        }
+    }
+#endif // __AVX2__
+
+    for (; i < count; ++i) {
+        if (first[i] == sig.bytes[c.first] && second[i] == sig.bytes[c.second] &&
+            matches_at(sig, buf + i)) {
+            f(i);
+        }
+    }
+}
+}
+
+bool signature::parse_pattern(const std::string &pattern, std::vector<std::uint8_t> &bytes,
+                              std::vector<std::uint8_t> &mask) {
+    bytes.clear();
+    mask.clear();
+    std::istringstream in{pattern};
+    std::string token;
+    while (in >> token) {
+        if (token == "?" || token == "??") {
+            bytes.push_back(0);
+            mask.push_back(0);
+            continue;
+        }
+        char *end = nullptr;
+        unsigned long value = std::strtoul(token.c_str(), &end, 16);
+        if (token.size() != 2 || *end != '\0' || value > 0xff) {
+            return false;
+        }
+        bytes.push_back(static_cast<std::uint8_t>(value));
+        mask.push_back(0xff);
+    }
+    // Wildcards at the ends match anything, the prefilter needs an exact byte
+    return std::find(mask.begin(), mask.end(), 0xff) != mask.end();
+}
+
+std::optional<signature> signature::parse(const std::string &line) {
+    std::istringstream in{line};
+    signature sig{};
+    if (!(in >> sig.name >> sig.module)) {
+        return std::nullopt;
+    }
+    if (sig.module == "*") {
+        sig.module.clear();
+    }
+
+    std::string pattern;
+    std::string token;
+    while (in >> token) {
+        char *end = nullptr;
+        if (token.starts_with("rel=")) {
+            sig.rel32_offset = std::strtoull(token.c_str() + 4, &end, 0);
+            sig.instruction_length = *sig.rel32_offset + 4;
+            if (*end == ':') {
+                sig.instruction_length = std::strtoull(end + 1, &end, 0);
+            }
+        } else if (token.starts_with("off=")) {
+            sig.offset = std::strtoll(token.c_str() + 4, &end, 0);
+        } else {
+            pattern += token;
+            pattern += ' ';
+            continue;
+        }
+        if (*end != '\0') {
+            return std::nullopt;
+        }
+    }
+    if (!parse_pattern(pattern, sig.bytes, sig.mask)) {
+        return std::nullopt;
+    }
+    if (sig.rel32_offset && *sig.rel32_offset + 4 > sig.bytes.size()) {
+        return std::nullopt;
+    }
+    return sig;
+}
+
+std::string signature::pattern_string() const {
+    std::string text;
+    char buf[4];
+    for (std::size_t i = 0; i < bytes.size(); ++i) {
+        if (i > 0) {
+            text += ' ';
+        }
+        if (mask[i] == 0) {
+            text += "??";
+        } else {
+            snprintf(buf, sizeof(buf), "%02X", bytes[i]);
+            text += buf;
+        }
+    }
+    return text;
+}
+
+std::string signature::to_string() const {
+    std::string text = name + ' ' + (module.empty() ? "*" : module) + ' ' + pattern_string();
+    char buf[64];
+    if (rel32_offset) {
+        snprintf(buf, sizeof(buf), " rel=%zu:%zu", *rel32_offset, instruction_length);
+        text += buf;
+    }
+    if (offset != 0) {
+        snprintf(buf, sizeof(buf), " off=%s0x%tx", offset < 0 ? "-" : "",
+                 offset < 0 ? -offset : offset);
+        text += buf;
+    }
+    return text;
+}
+
+std::vector<signature_match> scan_signatures(pid_t pid, const maps_snapshot &maps,
+                                             std::span<const signature> signatures,
+                                             const std::function<void(size_t, size_t)> &progress) {
+    std::vector<compiled_signature> compiled;
+    std::size_t longest = 0;
+    for (const signature &sig : signatures) {
+        compiled.push_back(compile(sig));
+        longest = std::max(longest, sig.bytes.size());
+    }
+
+    struct chunk {
+        std::uintptr_t  start;
+        std::uintptr_t  end;
+        std::uintptr_t  range_end;
+        /** Indices into compiled of the signatures for this module */
+        std::shared_ptr<const std::vector<std::size_t>> wanted;
+    };
+    std::vector<chunk> chunks;
+    std::size_t total = 0;
+    for (const address_range &range : maps.ranges) {
+        if (!(range.perms & PERM_EXECUTE) || !(range.perms & PERM_READ) || range.name[0] != '/') {
+            continue;
+        }
+        const std::string module = basename_of(range.name);
+        auto wanted = std::make_shared<std::vector<std::size_t>>();
+        for (std::size_t s = 0; s < signatures.size(); ++s) {
+            if (signatures[s].module.empty() || signatures[s].module == module) {
+                wanted->push_back(s);
+            }
+        }
+        if (wanted->empty()) {
+            continue;
+        }
+        const auto start = reinterpret_cast<std::uintptr_t>(range.start);
+        const std::uintptr_t end = start + range.length;
+        for (std::uintptr_t cur = start; cur < end; cur += code_chunk_size) {
+            chunks.push_back({cur, std::min(cur + code_chunk_size, end), end, wanted});
+        }
+        total += range.length;
+    }
+
+    std::vector<signature_match> found;
+    std::atomic<std::size_t> done = 0;
+    #pragma omp parallel
+    {
+        std::vector<signature_match> local;
+        std::vector<std::uint8_t> buf;
+        #pragma omp for schedule(dynamic, 1)
+        for (std::size_t c = 0; c < chunks.size(); ++c) {
+            const chunk &ch = chunks[c];
+            done.fetch_add(ch.end - ch.start);
+            if (progress) {
+                progress(done.load(), total);
+            }
+            // Overlap the next chunk so matches crossing the boundary are
+            // found, they are only reported by the chunk they start in
+            const std::size_t size = std::min<std::uintptr_t>(ch.end + longest, ch.range_end) - ch.start;
+            buf.resize(size);
+            if (ProcessMemory::read_process_memory_nosplit(pid, reinterpret_cast<void *>(ch.start),
+                                                           buf.data(), size) !=
+                static_cast<ssize_t>(size)) {
+                continue;
+            }
+            for (std::size_t s : *ch.wanted) {
+                const signature &sig = signatures[s];
+                if (sig.bytes.size() > size) {
+                    continue;
+                }
+                const std::size_t count = std::min(ch.end - ch.start, size - sig.bytes.size() + 1);
+                find_all(compiled[s], buf.data(), count, [&](std::size_t i) {
+                    std::uintptr_t address = ch.start + i;
+                    std::uintptr_t resolved = address;
+                    if (sig.rel32_offset) {
+                        std::int32_t rel;
+                        std::memcpy(&rel, &buf[i + *sig.rel32_offset], sizeof(rel));
+                        resolved = address + sig.instruction_length +
+                                   static_cast<std::uintptr_t>(static_cast<std::intptr_t>(rel));
+                    }
+                    resolved += static_cast<std::uintptr_t>(sig.offset);
+                    local.push_back({s, address, resolved});
+                });
+            }
+        }
+        #pragma omp critical
+        found.insert(found.end(), local.begin(), local.end());
+    }
+
+    std::sort(found.begin(), found.end(), [](const signature_match &a, const signature_match &b) {
+        return std::tie(a.signature, a.address) < std::tie(b.signature, b.address);
+    });
+    return found;
+}
+
+bool load_signatures(const std::string &path, std::vector<signature> &signatures) {
+    std::ifstream in{path};
+    if (!in) {
+        fprintf(stderr, "Error opening file %s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    std::string line;
+    std::size_t number = 0;
+    while (std::getline(in, line)) {
+        ++number;
+        std::size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+        std::optional<signature> sig = signature::parse(line);
+        if (!sig) {
+            fprintf(stderr, "Error: %s:%zu is not a valid signature\n", path.c_str(), number);
+            return false;
+        }
+        signatures.push_back(std::move(*sig));
+    }
+    return true;
+}
+
+bool save_signatures(const std::string &path, std::span<const signature> signatures) {
+    FILE *f = fopen(path.c_str(), "w");
+    if (f == nullptr) {
+        fprintf(stderr, "Error opening file %s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    bool ok = fputs("# name module pattern [rel=offset[:length]] [off=offset]\n", f) >= 0;
+    for (const signature &sig : signatures) {
+        ok = ok && fprintf(f, "%s\n", sig.to_string().c_str()) >= 0;
+    }
+    if (fclose(f) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        fprintf(stderr, "Error writing signatures %s: %s\n", path.c_str(), strerror(errno));
+    }
+    return ok;
+}
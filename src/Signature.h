@@ -0,0 +1,87 @@
+#pragma once
+#include "maps.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+/**
+ * A byte pattern locating code that survives rebuilds of the target, e.g.
+ * "48 8B 05 ?? ?? ?? ?? 89 C3" with the wildcards covering the
+ * displacement that changes between versions.
+ */
+struct signature {
+    std::string                 name;
+
+    /** Basename of the module to search, empty searches every module */
+    std::string                 module;
+
+    std::vector<std::uint8_t>   bytes;
+
+    /** 0xff where the byte must match, 0 for wildcards */
+    std::vector<std::uint8_t>   mask;
+
+    /**
+     * If set, the result is the target of the rel32 at this offset into the
+     * match instead of the match itself, `instruction_length` is the offset
+     * of the end of the instruction the displacement is relative to
+     */
+    std::optional<std::size_t>  rel32_offset{};
+    std::size_t                 instruction_length{};
+
+    /** Added to the result, e.g. the offset of a field */
+    std::ptrdiff_t              offset{};
+
+    /**
+     * @brief parse reads a signature database line:
+     *
+     *   name module 48 8B 05 ?? ?? ?? ?? [rel=3[:7]] [off=0x10]
+     *
+     * module is a basename or * for every module, without an instruction
+     * length rel assumes the rel32 ends the instruction
+     */
+    static std::optional<signature> parse(const std::string &line);
+
+    /** @brief parse_pattern parses "48 8B ?? 05" into bytes and mask */
+    static bool parse_pattern(const std::string &pattern, std::vector<std::uint8_t> &bytes,
+                              std::vector<std::uint8_t> &mask);
+
+    std::string pattern_string() const;
+    std::string to_string() const;
+};
+
+struct signature_match {
+    /** Index of the signature in the list given to scan_signatures */
+    std::size_t     signature;
+    std::uintptr_t  address;
+
+    /** address after the rel32 and offset were applied */
+    std::uintptr_t  resolved;
+};
+
+/**
+ * @brief scan_signatures searches the executable ranges of every named
+ * module for all `signatures` in one pass, each chunk is read once and
+ * matched against every signature of its module
+ *
+ * @param progress called with (bytes done, bytes total), may be empty
+ * @return every match sorted by signature and address, a signature matching
+ * more than once needs more context to be useful
+ */
+std::vector<signature_match> scan_signatures(pid_t pid, const maps_snapshot &maps,
+                                             std::span<const signature> signatures,
+                                             const std::function<void(size_t, size_t)> &progress = {});
+
+/**
+ * @brief load_signatures reads a signature database, one signature per line
+ * and # for comments
+ * @return false if the file could not be read or a line is invalid, errors
+ * are reported on stderr
+ */
+bool load_signatures(const std::string &path, std::vector<signature> &signatures);
+bool save_signatures(const std::string &path, std::span<const signature> signatures);
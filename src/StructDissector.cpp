@@ -0,0 +1,249 @@
+#include "StructDissector.h"
+#include "ProcessMemory.h"
+#include "maps.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstring>
+
+namespace {
+/** Integers this small are more likely counters or ids than anything else */
+constexpr std::int64_t small_int = 1 << 24;
+
+/** Shortest run of printable characters taken for a string */
+constexpr std::size_t min_string = 4;
+
+bool printable(std::uint8_t c) {
+    return (c >= 0x20 && c < 0x7f) || c == '\t' || c == '\n';
+}
+
+/** @brief string_length counts the printable characters before a NUL, 0 if not a string */
+std::size_t string_length(const std::uint8_t *bytes, std::size_t size, bool need_nul) {
+    std::size_t n = 0;
+    while (n < size && printable(bytes[n])) {
+        ++n;
+    }
+    if (n < min_string || (need_nul && n == size)) {
+        return 0;
+    }
+    // Inline strings may be followed by padding but nothing else
+    for (std::size_t i = n; i < size && !need_nul; ++i) {
+        if (bytes[i] != 0) {
+            return 0;
+        }
+    }
+    return n;
+}
+
+bool sane_double(double value) {
+    const double magnitude = std::fabs(value);
+    return std::isnormal(value) && magnitude >= 1e-6 && magnitude <= 1e12;
+}
+
+bool sane_float(float value) {
+    const float magnitude = std::fabs(value);
+    return value == 0.0f || (std::isnormal(value) && magnitude >= 1e-6f && magnitude <= 1e9f);
+}
+
+bool small(std::int64_t value) {
+    return value > -small_int && value < small_int;
+}
+}
+
+const char *field_kind_name(field_kind kind) {
+    switch (kind) {
+    case FIELD_UNREADABLE:
+        return "unreadable";
+    case FIELD_ZERO:
+        return "zero";
+    case FIELD_CODE_POINTER:
+        return "code pointer";
+    case FIELD_STRING_POINTER:
+        return "char *";
+    case FIELD_POINTER:
+        return "pointer";
+    case FIELD_STRING:
+        return "char[8]";
+    case FIELD_INT:
+        return "int64";
+    case FIELD_INT_PAIR:
+        return "int32, int32";
+    case FIELD_DOUBLE:
+        return "double";
+    case FIELD_FLOAT_PAIR:
+        return "float, float";
+    case FIELD_UNKNOWN:
+        return "?";
+    }
+    return "?";
+}
+
+value_type field_value_type(field_kind kind) {
+    switch (kind) {
+    case FIELD_INT_PAIR:
+        return VALUE_U32;
+    case FIELD_DOUBLE:
+        return VALUE_DOUBLE;
+    case FIELD_FLOAT_PAIR:
+        return VALUE_FLOAT;
+    default:
+        return VALUE_U64;
+    }
+}
+
+field_kind classify_slot(std::uint64_t raw, const address_range_index &index) {
+    if (raw == 0) {
+        return FIELD_ZERO;
+    }
+    if (index.is_valid_pointer(raw, PERM_READ | PERM_EXECUTE)) {
+        return FIELD_CODE_POINTER;
+    }
+    if (index.is_valid_pointer(raw, PERM_READ)) {
+        return FIELD_POINTER;
+    }
+
+    const auto value = static_cast<std::int64_t>(raw);
+    if (small(value)) {
+        return FIELD_INT;
+    }
+    const auto low = static_cast<std::int32_t>(raw);
+    const auto high = static_cast<std::int32_t>(raw >> 32);
+    if (small(low) && small(high)) {
+        return FIELD_INT_PAIR;
+    }
+
+    std::uint8_t bytes[8];
+    std::memcpy(bytes, &raw, sizeof(bytes));
+    if (string_length(bytes, sizeof(bytes), false) != 0) {
+        return FIELD_STRING;
+    }
+
+    // Two floats also make a plausible double, the low half of a double
+    // however is mostly zero or noise, not another float
+    float f[2];
+    std::memcpy(f, &raw, sizeof(f));
+    const bool floats = sane_float(f[0]) && sane_float(f[1]);
+    if (floats && f[0] != 0.0f && f[1] != 0.0f) {
+        return FIELD_FLOAT_PAIR;
+    }
+    double d;
+    std::memcpy(&d, &raw, sizeof(d));
+    if (sane_double(d)) {
+        return FIELD_DOUBLE;
+    }
+    return floats ? FIELD_FLOAT_PAIR : FIELD_UNKNOWN;
+}
+
+std::string format_field(const dissected_field &field, const address_range_index &index) {
+    char buf[64];
+    switch (field.kind) {
+    case FIELD_UNREADABLE:
+        return "??";
+    case FIELD_ZERO:
+        return "0";
+    case FIELD_CODE_POINTER:
+    case FIELD_POINTER:
+        return index.label(field.raw);
+    case FIELD_STRING_POINTER:
+        return index.label(field.raw) + " \"" + field.text + "\"";
+    case FIELD_STRING: {
+        char text[9] = {};
+        std::memcpy(text, &field.raw, 8);
+        return std::string("\"") + text + "\"";
+    }
+    case FIELD_INT:
+        snprintf(buf, sizeof(buf), "%" PRId64, static_cast<std::int64_t>(field.raw));
+        return buf;
+    case FIELD_INT_PAIR:
+        snprintf(buf, sizeof(buf), "%" PRId32 ", %" PRId32, static_cast<std::int32_t>(field.raw),
+                 static_cast<std::int32_t>(field.raw >> 32));
+        return buf;
+    case FIELD_DOUBLE: {
+        double d;
+        std::memcpy(&d, &field.raw, sizeof(d));
+        snprintf(buf, sizeof(buf), "%g", d);
+        return buf;
+    }
+    case FIELD_FLOAT_PAIR: {
+        float f[2];
+        std::memcpy(f, &field.raw, sizeof(f));
+        snprintf(buf, sizeof(buf), "%g, %g", static_cast<double>(f[0]), static_cast<double>(f[1]));
+        return buf;
+    }
+    case FIELD_UNKNOWN:
+        break;
+    }
+    snprintf(buf, sizeof(buf), "0x%016" PRIx64, field.raw);
+    return buf;
+}
+
+const std::vector<dissected_field> &StructDissector::refresh(std::uintptr_t base, std::size_t size,
+                                                             const maps_snapshot &maps) {
+    base &= ~static_cast<std::uintptr_t>(7);
+    const std::size_t count = (size + 7) / 8;
+    cache_.refresh(base, base + count * 8);
+
+    fields_.resize(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        dissected_field &field = fields_[i];
+        field.offset = i * 8;
+        field.age = PageCache::age_unchanged;
+        field.raw = 0;
+        field.text.clear();
+        bool readable = true;
+        for (std::size_t b = 0; b < 8 && readable; ++b) {
+            std::uint8_t value, age;
+            readable = cache_.byte(base + field.offset + b, value, age);
+            field.raw |= static_cast<std::uint64_t>(value) << (b * 8);
+            field.age = std::min(field.age, age);
+        }
+        field.kind = readable ? classify_slot(field.raw, maps.index) : FIELD_UNREADABLE;
+    }
+
+    read_strings(maps);
+    return fields_;
+}
+
+void StructDissector::read_strings(const maps_snapshot &maps) {
+    // One batch for every pointer, the targets are all over the place
+    std::vector<std::size_t> pointers;
+    for (std::size_t i = 0; i < fields_.size(); ++i) {
+        if (fields_[i].kind == FIELD_POINTER) {
+            pointers.push_back(i);
+        }
+    }
+    if (pointers.empty()) {
+        return;
+    }
+
+    auto buffer = std::make_unique<std::uint8_t[]>(pointers.size() * max_string);
+    std::vector<ReadRequest> requests(pointers.size());
+    for (std::size_t i = 0; i < pointers.size(); ++i) {
+        const std::uintptr_t target = fields_[pointers[i]].raw;
+        // A read past the end of the mapping would fail as a whole
+        const address_range &range =
+            maps.ranges[static_cast<std::size_t>(maps.index.find(target))];
+        const std::uintptr_t end = reinterpret_cast<std::uintptr_t>(range.start) + range.length;
+        requests[i] = {reinterpret_cast<void *>(target), &buffer[i * max_string],
+                       std::min<std::size_t>(max_string, end - target)};
+    }
+    ProcessMemory::read_many(cache_.pid(), requests);
+
+    for (std::size_t i = 0; i < pointers.size(); ++i) {
+        // A short read leaves the rest of the slot unwritten, only what was
+        // read may hold the string and its NUL
+        if (requests[i].result <= 0) {
+            continue;
+        }
+        const std::uint8_t *bytes = &buffer[i * max_string];
+        const auto read = std::min(static_cast<std::size_t>(requests[i].result), requests[i].size);
+        const std::size_t length = string_length(bytes, read, true);
+        if (length == 0) {
+            continue;
+        }
+        dissected_field &field = fields_[pointers[i]];
+        field.kind = FIELD_STRING_POINTER;
+        field.text.assign(reinterpret_cast<const char *>(bytes), length);
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+#include "PageCache.h"
+#include "value_type.h"
+
+class address_range_index;
+struct maps_snapshot;
+
+/** What an 8 byte slot most likely holds, in the order they are tried */
+enum field_kind : std::uint8_t {
+    FIELD_UNREADABLE = 0,
+    FIELD_ZERO,
+    /** Points into an executable mapping */
+    FIELD_CODE_POINTER,
+    /** Points at a NUL terminated printable string */
+    FIELD_STRING_POINTER,
+    /** Points into any other readable mapping */
+    FIELD_POINTER,
+    /** Inline printable characters */
+    FIELD_STRING,
+    FIELD_INT,
+    /** Two 32 bit integers, e.g. a pair of int fields */
+    FIELD_INT_PAIR,
+    FIELD_DOUBLE,
+    FIELD_FLOAT_PAIR,
+    FIELD_UNKNOWN,
+};
+
+const char *field_kind_name(field_kind kind);
+
+/**
+ * @brief field_value_type returns the saved address type matching `kind`,
+ * VALUE_U64 when there is no better fit
+ */
+value_type field_value_type(field_kind kind);
+
+struct dissected_field {
+    /** Offset from the start of the window */
+    std::size_t     offset;
+    std::uint64_t   raw;
+    field_kind      kind;
+    /** Refreshes since any of the 8 bytes last changed, see PageCache */
+    std::uint8_t    age;
+    /** Start of a string a FIELD_STRING_POINTER points at */
+    std::string     text;
+};
+
+/**
+ * @brief classify_slot guesses the type of an 8 byte slot without reading
+ * anything, FIELD_STRING_POINTER is left to the caller as it needs a read
+ */
+field_kind classify_slot(std::uint64_t raw, const address_range_index &index);
+
+/**
+ * @brief format_field formats the value of a field according to its kind,
+ * pointers are labelled relative to their module
+ */
+std::string format_field(const dissected_field &field, const address_range_index &index);
+
+/**
+ * Types the 8 byte slots of a window of the target's memory with the same
+ * guesses one makes by hand in gdb: whatever lands in a mapping is a
+ * pointer, printable bytes are a string, and a value that is a sane double
+ * or a pair of sane floats probably is one. Reads go through a PageCache so
+ * refreshing a window that is already on screen is a single batched read and
+ * the fields know which of them just changed.
+ */
+class StructDissector {
+public:
+    /** Longest string read through a pointer */
+    static constexpr std::size_t max_string = 64;
+
+    /** @brief pid switches the process */
+    void pid(pid_t pid) {
+        cache_.pid(pid);
+    }
+
+    /**
+     * @brief refresh re-reads [base, base + size) and re-types every slot
+     * @param base start of the window, rounded down to 8 bytes
+     * @param maps the mappings pointers are resolved against
+     * @return the fields, one per 8 bytes
+     */
+    const std::vector<dissected_field> &refresh(std::uintptr_t base, std::size_t size,
+                                                const maps_snapshot &maps);
+
+    const std::vector<dissected_field> &fields() const {
+        return fields_;
+    }
+
+private:
+    PageCache                       cache_{};
+    std::vector<dissected_field>    fields_{};
+
+    void read_strings(const maps_snapshot &maps);
+};
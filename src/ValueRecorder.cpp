@@ -0,0 +1,323 @@
+#include "ValueRecorder.h"
+#include "ProcessMemory.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+namespace {
+std::uint64_t clock_ns(clockid_t clock) {
+    timespec ts{};
+    clock_gettime(clock, &ts);
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000ull +
+           static_cast<std::uint64_t>(ts.tv_nsec);
+}
+
+std::uint64_t zigzag(std::int64_t v) {
+    return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+}
+
+std::int64_t unzigzag(std::uint64_t v) {
+    return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+}
+
+void put_varint(std::vector<std::uint8_t> &out, std::uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<std::uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(v));
+}
+
+bool get_varint(std::span<const std::uint8_t> in, std::size_t &pos, std::uint64_t &v) {
+    v = 0;
+    for (unsigned shift = 0; shift < 64 && pos < in.size(); shift += 7) {
+        const std::uint8_t byte = in[pos++];
+        v |= std::uint64_t{byte & 0x7fu} << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool write_all(FILE *f, const void *data, std::size_t size) {
+    return size == 0 || fwrite(data, 1, size, f) == size;
+}
+
+/**
+ * @brief write_csv_field quotes `s` if it would otherwise break the row
+ */
+bool write_csv_field(FILE *f, const std::string &s) {
+    if (s.find_first_of(",\"\n") == std::string::npos) {
+        return fputs(s.c_str(), f) >= 0;
+    }
+    std::string quoted = "\"";
+    for (char c : s) {
+        quoted += c;
+        if (c == '"') {
+            quoted += '"';
+        }
+    }
+    quoted += '"';
+    return fputs(quoted.c_str(), f) >= 0;
+}
+
+bool write_csv_value(FILE *f, value_type type, std::uint64_t raw) {
+    return visit_value_type(type, [f, raw](auto value) {
+        using T = decltype(value);
+        std::memcpy(&value, &raw, sizeof(value));
+        if constexpr (std::is_same_v<T, float>) {
+            return fprintf(f, ",%.9g", static_cast<double>(value)) >= 0;
+        } else if constexpr (std::is_same_v<T, double>) {
+            return fprintf(f, ",%.17g", value) >= 0;
+        } else {
+            return fprintf(f, ",%" PRIu64, static_cast<std::uint64_t>(value)) >= 0;
+        }
+    });
+}
+}
+
+ValueRecorder::~ValueRecorder() {
+    stop();
+}
+
+bool ValueRecorder::start(pid_t pid, std::vector<recorder_channel> channels,
+                          std::chrono::microseconds period, std::size_t max_bytes) {
+    stop();
+    std::lock_guard lock{lock_};
+    data_.clear();
+    data_.shrink_to_fit();
+    ticks_ = 0;
+    changes_ = 0;
+    late_ = 0;
+    bytes_ = 0;
+    for (recorder_channel &channel : channels) {
+        channel.size = std::clamp<std::uint8_t>(channel.size, 1, sizeof(std::uint64_t));
+    }
+    channels_ = std::move(channels);
+    if (channels_.empty() || pid <= 0) {
+        return false;
+    }
+    pid_ = pid;
+    period_us_ = static_cast<std::uint64_t>(std::max<std::int64_t>(period.count(), 1));
+    max_bytes_ = max_bytes;
+    start_ns_ = clock_ns(CLOCK_REALTIME);
+    running_ = true;
+    thread_ = std::thread(&ValueRecorder::run, this);
+    return true;
+}
+
+void ValueRecorder::stop() {
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void ValueRecorder::run() {
+    const std::size_t count = channels_.size();
+    const std::size_t bitmap_size = (count + 7) / 8;
+    std::vector<std::uint64_t> previous(count);
+    std::vector<std::uint64_t> current(count);
+    std::vector<ReadRequest> requests(count);
+    std::vector<std::uint8_t> tick;
+    std::vector<std::uint8_t> bitmap(bitmap_size);
+
+    const std::uint64_t period_ns = period_us_ * 1000;
+    std::uint64_t last_us = clock_ns(CLOCK_MONOTONIC) / 1000;
+    std::uint64_t next_ns = last_us * 1000;
+
+    while (running_) {
+        const std::uint64_t now_us = clock_ns(CLOCK_MONOTONIC) / 1000;
+
+        // Values are zero-extended to 64 bits like everywhere else
+        std::fill(current.begin(), current.end(), 0);
+        for (std::size_t i = 0; i < count; ++i) {
+            requests[i] = {reinterpret_cast<void *>(channels_[i].address), &current[i],
+                           channels_[i].size};
+        }
+        ProcessMemory::read_many(pid_, requests);
+
+        std::fill(bitmap.begin(), bitmap.end(), 0);
+        std::uint64_t changed = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            if (requests[i].result != static_cast<ssize_t>(channels_[i].size)) {
+                current[i] = previous[i];
+            } else if (current[i] != previous[i]) {
+                bitmap[i / 8] = static_cast<std::uint8_t>(bitmap[i / 8] | (1u << (i % 8)));
+                ++changed;
+            }
+        }
+
+        tick.clear();
+        const auto jitter = static_cast<std::int64_t>(now_us - last_us) -
+                            static_cast<std::int64_t>(period_us_);
+        put_varint(tick, zigzag(jitter) << 1 | (changed > 0 ? 1 : 0));
+        if (changed > 0) {
+            tick.insert(tick.end(), bitmap.begin(), bitmap.end());
+            for (std::size_t i = 0; i < count; ++i) {
+                if (bitmap[i / 8] & (1u << (i % 8))) {
+                    put_varint(tick, zigzag(static_cast<std::int64_t>(current[i] - previous[i])));
+                }
+            }
+        }
+
+        {
+            std::lock_guard lock{lock_};
+            if (data_.size() + tick.size() > max_bytes_) {
+                fprintf(stderr, "ValueRecorder: buffer full after %zu bytes, stopping\n",
+                        data_.size());
+                running_ = false;
+                break;
+            }
+            data_.insert(data_.end(), tick.begin(), tick.end());
+            bytes_ = data_.size();
+            // Under the lock so an export sees a matching count
+            ++ticks_;
+        }
+        previous.swap(current);
+        last_us = now_us;
+        changes_ += changed;
+
+        // Fixed rate, a tick that overran the period doesn't cause a burst
+        next_ns += period_ns;
+        const std::uint64_t after = clock_ns(CLOCK_MONOTONIC);
+        if (next_ns < after) {
+            ++late_;
+            next_ns = after;
+            continue;
+        }
+        timespec deadline{static_cast<time_t>(next_ns / 1000000000ull),
+                          static_cast<long>(next_ns % 1000000000ull)};
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {
+        }
+    }
+}
+
+std::vector<std::uint8_t> ValueRecorder::snapshot() const {
+    std::lock_guard lock{lock_};
+    return data_;
+}
+
+bool ValueRecorder::replay(const std::function<void(std::uint64_t, std::span<const std::uint64_t>)> &f) const {
+    const std::vector<std::uint8_t> data = snapshot();
+    const std::size_t count = channels_.size();
+    const std::size_t bitmap_size = (count + 7) / 8;
+    std::vector<std::uint64_t> values(count);
+    std::uint64_t time = 0;
+
+    std::size_t pos = 0;
+    while (pos < data.size()) {
+        std::uint64_t head = 0;
+        if (!get_varint(data, pos, head)) {
+            return false;
+        }
+        time += static_cast<std::uint64_t>(static_cast<std::int64_t>(period_us_) +
+                                           unzigzag(head >> 1));
+        if (head & 1) {
+            if (data.size() - pos < bitmap_size) {
+                return false;
+            }
+            const std::uint8_t *bitmap = &data[pos];
+            pos += bitmap_size;
+            for (std::size_t i = 0; i < count; ++i) {
+                if (!(bitmap[i / 8] & (1u << (i % 8)))) {
+                    continue;
+                }
+                std::uint64_t delta = 0;
+                if (!get_varint(data, pos, delta)) {
+                    return false;
+                }
+                values[i] += static_cast<std::uint64_t>(unzigzag(delta));
+            }
+        }
+        f(time, values);
+    }
+    return true;
+}
+
+bool ValueRecorder::export_csv(const std::string &path) const {
+    FILE *f = fopen(path.c_str(), "w");
+    if (f == nullptr) {
+        fprintf(stderr, "Error opening file %s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    bool ok = fputs("time_us", f) >= 0;
+    for (const recorder_channel &channel : channels_) {
+        ok = ok && fputc(',', f) != EOF;
+        if (channel.name.empty()) {
+            ok = ok && fprintf(f, "0x%" PRIxPTR, channel.address) >= 0;
+        } else {
+            ok = ok && write_csv_field(f, channel.name);
+        }
+    }
+    ok = ok && fputc('\n', f) != EOF;
+    ok = ok && replay([this, f, &ok](std::uint64_t time, std::span<const std::uint64_t> values) {
+        ok = ok && fprintf(f, "%" PRIu64, time) >= 0;
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            ok = ok && write_csv_value(f, channels_[i].type, values[i]);
+        }
+        ok = ok && fputc('\n', f) != EOF;
+    });
+    if (fclose(f) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        fprintf(stderr, "Error writing timeline %s: %s\n", path.c_str(), strerror(errno));
+    }
+    return ok;
+}
+
+bool ValueRecorder::export_binary(const std::string &path) const {
+    std::vector<std::uint8_t> data;
+    std::uint64_t ticks = 0;
+    {
+        std::lock_guard lock{lock_};
+        data = data_;
+        ticks = ticks_.load();
+    }
+
+    std::string names;
+    std::vector<timeline_channel> channels;
+    for (const recorder_channel &channel : channels_) {
+        timeline_channel out{};
+        out.address = channel.address;
+        out.name_offset = static_cast<std::uint32_t>(names.size());
+        out.name_length = static_cast<std::uint32_t>(channel.name.size());
+        out.size = channel.size;
+        out.type = channel.type;
+        names += channel.name;
+        channels.push_back(out);
+    }
+
+    timeline_header header{};
+    std::memcpy(header.magic, timeline_magic, sizeof(header.magic));
+    header.version = timeline_version;
+    header.channel_count = static_cast<std::uint32_t>(channels.size());
+    header.period_us = period_us_;
+    header.start_ns = start_ns_;
+    header.tick_count = ticks;
+    header.names_size = names.size();
+    header.data_size = data.size();
+
+    FILE *f = fopen(path.c_str(), "wb");
+    if (f == nullptr) {
+        fprintf(stderr, "Error opening file %s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    bool ok = write_all(f, &header, sizeof(header)) &&
+              write_all(f, channels.data(), channels.size() * sizeof(timeline_channel)) &&
+              write_all(f, names.data(), names.size()) &&
+              write_all(f, data.data(), data.size());
+    if (fclose(f) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        fprintf(stderr, "Error writing timeline %s: %s\n", path.c_str(), strerror(errno));
+    }
+    return ok;
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include "value_type.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/types.h>
+
+/**
+ * One address the recorder samples
+ */
+struct recorder_channel {
+    std::uintptr_t  address;
+
+    /** Bytes read, at most 8 */
+    std::uint8_t    size;
+
+    /** Only used to format the exported values */
+    value_type      type;
+
+    std::string     name;
+};
+
+/**
+ * Header of an exported timeline, followed by `channel_count`
+ * timeline_channel records, the names and `data_size` bytes of samples.
+ *
+ * The samples are stored as they are recorded, one tick after another:
+ *  - varint((zigzag(interval - period_us) << 1) | changed), the interval is
+ *    the microseconds since the previous tick (since `start_ns` for the first)
+ *  - if changed, a bitmap of ceil(channel_count / 8) bytes with a bit set for
+ *    every channel whose value changed, followed by varint(zigzag(new - old))
+ *    for each of them, the difference taken on the raw 64-bit values
+ *
+ * Every channel starts at 0 and a value that can't be read keeps the last one.
+ */
+struct timeline_header {
+    char            magic[8];
+    std::uint32_t   version;
+    std::uint32_t   channel_count;
+    std::uint64_t   period_us;
+    /** CLOCK_REALTIME when recording started */
+    std::uint64_t   start_ns;
+    std::uint64_t   tick_count;
+    std::uint64_t   names_size;
+    std::uint64_t   data_size;
+};
+
+struct timeline_channel {
+    std::uint64_t   address;
+    std::uint32_t   name_offset;
+    std::uint32_t   name_length;
+    std::uint8_t    size;
+    std::uint8_t    type;
+    std::uint8_t    reserved[6];
+};
+
+inline constexpr char timeline_magic[8] = {'M', 'S', 'C', 'T', 'L', 'I', 'N', 'E'};
+inline constexpr std::uint32_t timeline_version = 1;
+
+/**
+ * Samples a set of addresses at a fixed rate on its own thread and keeps
+ * every tick in a delta encoded buffer, see timeline_header for the format.
+ * Values that stay put cost two bytes per tick, so a minute at 1 kHz is in
+ * the order of a hundred kilobytes.
+ */
+class ValueRecorder {
+public:
+    /** Recording stops once the samples take this much memory */
+    static constexpr std::size_t default_max_bytes = std::size_t{256} << 20;
+
+    ValueRecorder() = default;
+    ~ValueRecorder();
+    ValueRecorder(const ValueRecorder &) = delete;
+    ValueRecorder &operator=(const ValueRecorder &) = delete;
+
+    /**
+     * @brief start begins recording, replacing the previous recording
+     * @param period time between two ticks
+     * @return false if there is nothing to record
+     */
+    bool start(pid_t pid, std::vector<recorder_channel> channels,
+               std::chrono::microseconds period,
+               std::size_t max_bytes = default_max_bytes);
+
+    /** @brief stop ends the recording, the samples are kept */
+    void stop();
+
+    bool running() const {
+        return running_.load();
+    }
+
+    /** Channels of the current or last recording, fixed while running */
+    const std::vector<recorder_channel> &channels() const {
+        return channels_;
+    }
+
+    std::uint64_t ticks() const {
+        return ticks_.load();
+    }
+
+    /** Amount of values that differed from the tick before */
+    std::uint64_t changes() const {
+        return changes_.load();
+    }
+
+    /** Ticks that started more than a period late */
+    std::uint64_t late() const {
+        return late_.load();
+    }
+
+    std::size_t bytes() const {
+        return bytes_.load();
+    }
+
+    /**
+     * @brief replay decodes the recording, calling `f` with the time since
+     * the start in microseconds and the value of every channel for each tick
+     * @return false if the data is corrupt
+     */
+    bool replay(const std::function<void(std::uint64_t, std::span<const std::uint64_t>)> &f) const;
+
+    /** @brief export_csv writes one row per tick, time in microseconds */
+    bool export_csv(const std::string &path) const;
+
+    /** @brief export_binary writes the samples as recorded, see timeline_header */
+    bool export_binary(const std::string &path) const;
+
+private:
+    mutable std::mutex              lock_{};
+    std::vector<std::uint8_t>       data_{};
+    std::vector<recorder_channel>   channels_{};
+    pid_t                           pid_{-1};
+    std::uint64_t                   period_us_{};
+    std::uint64_t                   start_ns_{};
+    std::size_t                     max_bytes_{};
+    std::atomic<bool>               running_{};
+    std::atomic<std::uint64_t>      ticks_{};
+    std::atomic<std::uint64_t>      changes_{};
+    std::atomic<std::uint64_t>      late_{};
+    std::atomic<std::size_t>        bytes_{};
+    std::thread                     thread_{};
+
+    void run();
+    std::vector<std::uint8_t> snapshot() const;
+};
@@ -0,0 +1,160 @@
+#include "WriteTracer.h"
+#include "maps.h"
+#include "perf.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <linux/hw_breakpoint.h>
+#include <poll.h>
+#include <unistd.h>
+
+WriteTracer::WriteTracer() : thread_(&WriteTracer::run, this) {}
+
+WriteTracer::~WriteTracer() {
+    quit_ = true;
+    wakeup_.wake();
+    thread_.join();
+    std::lock_guard lock{lock_};
+    watches_.clear();
+    retired_.clear();
+}
+
+/**
+ * @brief WriteTracer::open_event watches the address of `watch` in thread `tid`
+ * @return 0 or the errno of the failed call
+ */
+int WriteTracer::open_event(watch_entry &watch, pid_t tid) {
+    perf_event_attr pe{};
+    pe.type = PERF_TYPE_BREAKPOINT;
+    pe.size = sizeof(pe);
+    pe.bp_type = HW_BREAKPOINT_W;
+    pe.bp_addr = reinterpret_cast<std::uintptr_t>(watch.address);
+    pe.bp_len = watch.size;
+    pe.sample_period = 1;
+    pe.sample_type = PERF_SAMPLE_IP;
+    pe.exclude_kernel = 1;
+    pe.exclude_hv = 1;
+    pe.wakeup_events = 1;
+    return watch.events.open(pe, tid);
+}
+
+void WriteTracer::count_sample(watch_entry &watch, const std::uint8_t *body, std::size_t size) {
+    // struct { u64 ip; }
+    std::uint64_t ip = 0;
+    if (size >= sizeof(ip)) {
+        std::memcpy(&ip, body, sizeof(ip));
+        ++watch.hits[ip];
+    }
+}
+
+bool WriteTracer::watch(pid_t pid, void *address, std::size_t size) {
+    const auto addr = reinterpret_cast<std::uintptr_t>(address);
+    if ((size != 1 && size != 2 && size != 4 && size != 8) || addr % size != 0) {
+        fprintf(stderr, "WriteTracer: %p/%zu can't be watched, size must be "
+                        "1, 2, 4 or 8 and the address aligned to it\n", address, size);
+        return false;
+    }
+    unwatch(address);
+
+    watch_entry watch{pid, address, size};
+    for (pid_t tid : get_threads(pid)) {
+        // A thread exiting meanwhile isn't an error, running out of debug
+        // registers or permissions is and hits the first thread as well
+        const int error = open_event(watch, tid);
+        if (error != 0 && error != ESRCH) {
+            fprintf(stderr, "WriteTracer: perf_event_open on thread %d: %s\n", tid,
+                    strerror(error));
+            return false;
+        }
+    }
+    if (watch.events.empty()) {
+        fprintf(stderr, "WriteTracer: no threads found in %d\n", pid);
+        return false;
+    }
+
+    std::lock_guard lock{lock_};
+    watches_.push_back(std::move(watch));
+    wakeup_.wake();
+    return true;
+}
+
+void WriteTracer::unwatch(void *address) {
+    std::lock_guard lock{lock_};
+    std::erase_if(watches_, [this, address](watch_entry &watch) {
+        if (watch.address != address) {
+            return false;
+        }
+        retired_.push_back(std::move(watch.events));
+        return true;
+    });
+    wakeup_.wake();
+}
+
+void WriteTracer::clear() {
+    std::lock_guard lock{lock_};
+    for (watch_entry &watch : watches_) {
+        retired_.push_back(std::move(watch.events));
+    }
+    watches_.clear();
+    wakeup_.wake();
+}
+
+std::vector<write_hit> WriteTracer::hits(void *address) const {
+    std::vector<write_hit> hits;
+    {
+        std::lock_guard lock{lock_};
+        for (const watch_entry &watch : watches_) {
+            if (watch.address == address) {
+                for (auto [ip, count] : watch.hits) {
+                    hits.push_back({ip, count});
+                }
+            }
+        }
+    }
+    std::sort(hits.begin(), hits.end(), [](const write_hit &a, const write_hit &b) {
+        return a.count > b.count || (a.count == b.count && a.ip < b.ip);
+    });
+    return hits;
+}
+
+void WriteTracer::run() {
+    using namespace std::chrono_literals;
+    auto last_rescan = std::chrono::steady_clock::now();
+    std::vector<pollfd> fds;
+
+    while (!quit_) {
+        fds.assign(1, wakeup_.entry());
+        {
+            std::lock_guard lock{lock_};
+            for (const watch_entry &watch : watches_) {
+                watch.events.add_fds(fds);
+            }
+        }
+        // Changes to the watches wake the poll, the timeout only paces the
+        // rescans for new threads
+        poll(fds.data(), fds.size(), 100);
+        wakeup_.reset();
+
+        auto now = std::chrono::steady_clock::now();
+        const bool rescan = now - last_rescan > 500ms;
+        if (rescan) {
+            last_rescan = now;
+        }
+        std::lock_guard lock{lock_};
+        // Nothing polls the removed events anymore
+        retired_.clear();
+        for (watch_entry &watch : watches_) {
+            auto sample = [&watch](const std::uint8_t *body, std::size_t size) {
+                count_sample(watch, body, size);
+            };
+            if (rescan) {
+                lost_.fetch_add(watch.events.sync_threads(
+                    watch.pid, [&watch](pid_t tid) { return open_event(watch, tid); }, sample));
+            }
+            lost_.fetch_add(watch.events.drain(sample));
+        }
+    }
+}
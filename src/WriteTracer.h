@@ -0,0 +1,83 @@
+#pragma once
+#include "PerfRings.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/types.h>
+
+/**
+ * An instruction that wrote to a watched address. On x86 data breakpoints
+ * trap after the instruction has run, so `ip` is the address of the
+ * instruction following the writer.
+ */
+struct write_hit {
+    std::uintptr_t  ip;
+    std::uint64_t   count;
+};
+
+/**
+ * Finds the code writing to an address with hardware watchpoints.
+ *
+ * Every thread of the target gets a PERF_TYPE_BREAKPOINT event sampling the
+ * instruction pointer on each write, the samples are drained from the perf
+ * ring buffers by a background thread and counted per instruction. Threads
+ * started later are picked up on the next drain. The cpu has four debug
+ * registers so at most four addresses can be watched in a thread at once.
+ */
+class WriteTracer {
+public:
+    WriteTracer();
+    ~WriteTracer();
+    WriteTracer(const WriteTracer &) = delete;
+    WriteTracer &operator=(const WriteTracer &) = delete;
+
+    /**
+     * @brief watch starts tracing writes to `size` bytes at `address`
+     * @param size 1, 2, 4 or 8 and `address` aligned to it
+     * @return false on error, errors are reported on stderr
+     */
+    bool watch(pid_t pid, void *address, std::size_t size);
+
+    void unwatch(void *address);
+    void clear();
+
+    /**
+     * @brief hits returns the writers seen so far, most frequent first
+     */
+    std::vector<write_hit> hits(void *address) const;
+
+    /** Samples the kernel dropped because a ring buffer was full */
+    std::uint64_t lost() const {
+        return lost_.load();
+    }
+
+private:
+    /** Data pages of each ring buffer, must be a power of two */
+    static constexpr std::size_t ring_pages = 8;
+
+    struct watch_entry {
+        pid_t                                           pid;
+        void                                            *address;
+        std::size_t                                     size;
+        PerfRings                                       events{ring_pages};
+        std::unordered_map<std::uintptr_t, std::uint64_t> hits{};
+    };
+
+    mutable std::mutex          lock_{};
+    std::vector<watch_entry>    watches_{};
+    /** Events of removed watches, closed by the tracer thread after its poll */
+    std::vector<PerfRings>      retired_{};
+    PollWakeup                  wakeup_{};
+    std::atomic<bool>           quit_{};
+    std::atomic<std::uint64_t>  lost_{};
+    std::thread                 thread_{};
+
+    static int open_event(watch_entry &watch, pid_t tid);
+    static void count_sample(watch_entry &watch, const std::uint8_t *body, std::size_t size);
+    void run();
+};
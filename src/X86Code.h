@@ -0,0 +1,42 @@
+#pragma once
+
+#include <capstone/capstone.h>
+#include <cstddef>
+
+/** The longest x86 instruction */
+constexpr std::size_t max_instruction = 15;
+
+/**
+ * Bytes of code each thread reads and searches or decodes at a time by the
+ * tools that sweep the executable mappings
+ */
+constexpr std::size_t code_chunk_size = 256 * 1024;
+
+/**
+ * A 64 bit x86 capstone handle with operand details on and one reusable
+ * instruction for cs_disasm_iter, one per thread. `ok` is false if capstone
+ * couldn't be opened.
+ */
+struct capstone {
+    csh         handle{};
+    cs_insn     *insn{};
+    bool        ok{};
+
+    capstone() {
+        ok = cs_open(CS_ARCH_X86, CS_MODE_64, &handle) == CS_ERR_OK;
+        if (ok) {
+            cs_option(handle, CS_OPT_DETAIL, CS_OPT_ON);
+            insn = cs_malloc(handle);
+        }
+    }
+
+    ~capstone() {
+        if (ok) {
+            cs_free(insn, 1);
+            cs_close(&handle);
+        }
+    }
+
+    capstone(const capstone &) = delete;
+    capstone &operator=(const capstone &) = delete;
+};
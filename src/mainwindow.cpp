@@ -1,14 +1,33 @@
 #include "mainwindow.h"
+#include "AttachWatcher.h"
+#include "FreezeService.h"
 #include "ProcessMemory.h"
 #include "ui/Disassembly.h"
+#include "ui/GroupScanDialog.h"
+#include "ui/HeatMapDialog.h"
 #include "ui/MapsDialog.h"
 #include "ui/PidDialog.h"
-#include "ui/MatchTableItem.h"
+#include "ui/PointerScanDialog.h"
+#include "ui/RecorderDialog.h"
+#include "ui/MemoryViewer.h"
+#include "ui/StructDissectorDialog.h"
+#include "ui/SavedAddressModel.h"
+#include "ui/MatchTableModel.h"
+#include "ui/MemoryMonitor.h"
 #include "ui/Settings.h"
+#include "ui/WriteTracerDialog.h"
+#include "ui/CodeReferencesDialog.h"
+#include "ui/SignatureDialog.h"
+#include "ui/ValueFormat.h"
 #include "ui_mainwindow.h"
 
 #include <QAction>
 #include <QComboBox>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileDialog>
+#include <QInputDialog>
 #include <QListWidget>
 #include <QMenuBar>
 #include <QMessageBox>
@@ -16,68 +35,44 @@
 #include <QRegularExpressionValidator>
 #include <QScrollBar>
 #include <QShortcut>
-#include <QTableWidgetItem>
+#include <QStandardItemModel>
+#include <QStandardPaths>
+#include <QThread>
 #include <QTimer>
 #include <QtConcurrent/QtConcurrent>
 #include <QtDebug>
 
-#include <assert.h>
+#include <algorithm>
+#include <cstring>
 #include <QDebug>
 #include <QSettings>
 #include <unistd.h>
 
-template<typename T>
-void populate_table_after_scan(ProcessMemory &scanner,
-                               QTableWidget *memory_addresses,
-                               const QString &searchText,
-                               QLabel *amount_found_label,
-                               QPushButton *next_scan_button)
-{
-    constexpr int max_rows = 10000;
-    auto &matches = scanner.get_matches();
-    memory_addresses->clearContents();
-    memory_addresses->setRowCount(0);
-    int row = 0;
-    for (size_t i = 0; i < matches.size(); ++i) {
-        void *match = matches[i];
-        if (!match) continue;
-        if (row >= max_rows) { row++; continue; }
-        char str_address[64];
-        snprintf(str_address, sizeof(str_address), "%p", match);
-
-        T val{};
-        [[maybe_unused]]
-        ssize_t n = scanner.read_process_memory(match, &val, sizeof(val));
-        assert(n == sizeof(val));
-
-        memory_addresses->insertRow(row);
-        memory_addresses->setItem(row, 0, new MatchTableItem(str_address, reinterpret_cast<T*>(match)));
-        memory_addresses->setItem(row, 1, new QTableWidgetItem(QString::number(val)));
-        memory_addresses->setItem(row, 2, new QTableWidgetItem(searchText));
-
-        row++;
-    }
-    matches.resize(row);
-    amount_found_label->setText(QString("Found: %1").arg(row));
-    next_scan_button->setEnabled(true);
-}
+// A snapshot of this many matches reads in a few milliseconds
+static constexpr std::size_t tick_history_limit = 1 << 16;
 
 template<typename T>
 void start_scan_and_populate(MainWindow *self, ProcessMemory *scanner,
-                             QTableWidget *memory_addresses,
+                             MatchTableModel *match_model,
                              const QString &searchText,
                              QLabel *amount_found_label,
                              QPushButton *next_scan_button,
-                             T parsedValue)
+                             T parsedValue,
+                             scan_mode mode)
 {
-    auto future = QtConcurrent::run([scanner, parsedValue] {
-        scanner->scan(parsedValue);
+    // The scan compacts the match list in place, stop the view reading it
+    match_model->begin_scan();
+    auto future = QtConcurrent::run([scanner, parsedValue, mode] {
+        scanner->scan(parsedValue, mode);
     });
 
     auto *watcher = new QFutureWatcher<void>(self);
-    QObject::connect(watcher, &QFutureWatcher<void>::finished, self, [self, scanner, memory_addresses, searchText, amount_found_label, next_scan_button, watcher]() {
-            populate_table_after_scan<T>(*scanner, memory_addresses, searchText,
-                                         amount_found_label, next_scan_button);
+    QObject::connect(watcher, &QFutureWatcher<void>::finished, self, [self, scanner, match_model, searchText, amount_found_label, next_scan_button, watcher]() {
+            match_model->end_scan(value_type_of<T>());
+            self->record_scan(value_type_of<T>(), searchText);
+            amount_found_label->setText(
+                QString("Found: %1").arg(scanner->get_matches().size()));
+            next_scan_button->setEnabled(true);
             watcher->deleteLater();
         });
     watcher->setFuture(future);
@@ -94,62 +89,39 @@ static void toggleLayoutItems(QLayout *layout, bool enable) {
     }
 }
 
-/**
- * @brief parse_cstr places the value correctly from the table into dest, cuts off necessary bits
- * @param dest
- * @param src
- * @param size
- * @param type
- */
-static void parse_cstr(void *dest, const char *src, size_t size, int type) {
-    if(dest == nullptr || src == nullptr) {
-        return;
-    }
-    /* it's simply the largest possible; so that everything will fit */
-    uint64_t num = 0;
-    /* to reduce code repetitions */
-    size_t max_values[] = {
-        0,
-        UINT8_MAX,
-        UINT16_MAX,
-        UINT32_MAX,
-        UINT64_MAX,
-    };
-
-    switch(type) {
-        case 0: /* binary */
-            break;
-        case 1: /* uint8 */
-        case 2: /* uint16 */
-        case 3: /* uint32 */
-        case 4: /* uint64 */
-            num = atoll(src) & max_values[type];
-            memcpy(dest, &num, size);
-            break;
-        default:
-            break;
-    }
-}
-
 /*
  * PLAN:
  * 1. create a function to automatically update the value in the variables DONE!!
- * 2. create ability to freeze a memory range(value in memory more likely) (mmap)
+ * 2. create ability to freeze a memory range(value in memory more likely) DONE (FreezeService)
  * 3. create more types to read
  * 4. create more types to write
- * 5. add pointer dereferencing
+ * 5. add pointer dereferencing DONE (pointer scan)
  * 6. a better ui for pointers, like cheat engine
  * */
 MainWindow::MainWindow(QWidget *parent)
     : QWidget(parent), ui(new Ui::MainWindow),
-      value_update_timer(new QTimer(this)),
+      monitor_thread(new QThread(this)),
+      monitor(new MemoryMonitor()),
       pos_only{new QRegularExpressionValidator(QRegularExpression("\\d*"), this)},
       pos_neg{new QRegularExpressionValidator(QRegularExpression("[+-]?\\d*"),
                                               this)},
     floating_point(new QRegularExpressionValidator(QRegularExpression("\\d+([,.]+\\d*)?"), this)),
-    scanner(new ProcessMemory())
+    scanner(new ProcessMemory()),
+    freezer(new FreezeService()),
+    attach_watcher(new AttachWatcher()),
+    freeze_stats_timer(new QTimer(this)),
+    history_timer(new QTimer(this)),
+    match_model(new MatchTableModel(*scanner, this)),
+    saved_model(new SavedAddressModel(this))
 {
     ui->setupUi(this);
+    ui->memory_addresses->setModel(match_model);
+    ui->saved_addresses->setModel(saved_model);
+    ui->saved_addresses->setItemDelegateForColumn(SavedAddressModel::COLUMN_TYPE,
+                                                  new SavedAddressTypeDelegate(this));
+    ui->saved_addresses->setSelectionBehavior(QAbstractItemView::SelectRows);
+    ui->saved_addresses->setEditTriggers(QAbstractItemView::DoubleClicked |
+                                         QAbstractItemView::EditKeyPressed);
 
     ui->progressBar->setRange(0, 100);
     scanner->setProgressCallback(
@@ -160,13 +132,20 @@ MainWindow::MainWindow(QWidget *parent)
     });
     ui->next_scan->setEnabled(false);
     ui->value_type->setEnabled(false);
+    // The scanner has no string or byte array type yet, keep those listed
+    // but unselectable
+    if (auto *types = qobject_cast<QStandardItemModel *>(ui->value_type->model())) {
+        for (int i = VALUE_TYPE_COUNT; i < ui->value_type->count(); ++i) {
+            types->item(i)->setEnabled(false);
+        }
+    }
     //MemoryWidget *memory_addresses = new MemoryWidget(this);
     ui->memory_addresses->setSelectionBehavior(QAbstractItemView::SelectRows);
     ui->memory_addresses->setSelectionMode(QAbstractItemView::SingleSelection);
     ui->memory_addresses->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
     ui->memory_addresses->setEditTriggers(QAbstractItemView::NoEditTriggers);
 	ui->memory_addresses->setContextMenuPolicy(Qt::CustomContextMenu);
-    connect(ui->memory_addresses, &QTableWidget::customContextMenuRequested, this,
+    connect(ui->memory_addresses, &QTableView::customContextMenuRequested, this,
         [this](const QPoint &pos) {
         // figure out which row was clicked
         QModelIndex idx = ui->memory_addresses->indexAt(pos);
@@ -179,27 +158,105 @@ MainWindow::MainWindow(QWidget *parent)
         QMenu menu(this);
         QAction *showInMaps = menu.addAction(tr("Show in maps"));
         connect(showInMaps, &QAction::triggered, this, [this, row]() {
-            // grab the address string from column 0
-            auto *item = ui->memory_addresses->item(row, 0);
-            if (!item) return;
-            QString addr = item->text();
-            // do your mapping logic here, e.g. emit a signal:
-            locate_in_maps(addr.toULongLong(nullptr, 16));
+            void *addr = match_model->address(row);
+            if (!addr) return;
+            locate_in_maps(reinterpret_cast<uintptr_t>(addr));
+        });
+        QAction *pointerScan = menu.addAction(tr("Pointer scan for this address"));
+        connect(pointerScan, &QAction::triggered, this, [this, row]() {
+            show_pointer_scan(reinterpret_cast<uintptr_t>(match_model->address(row)));
+        });
+        QAction *codeReferences = menu.addAction(tr("Find code accessing this address"));
+        connect(codeReferences, &QAction::triggered, this, [this, row]() {
+            show_code_references(reinterpret_cast<uintptr_t>(match_model->address(row)));
         });
+        QAction *browse = menu.addAction(tr("Browse memory"));
+        connect(browse, &QAction::triggered, this, [this, row]() {
+            show_memory_viewer(reinterpret_cast<uintptr_t>(match_model->address(row)));
+        });
+        QAction *dissect = menu.addAction(tr("Dissect structure"));
+        connect(dissect, &QAction::triggered, this, [this, row]() {
+            show_struct_dissector(reinterpret_cast<uintptr_t>(match_model->address(row)));
+        });
+        menu.addSeparator();
+        QAction *snapshot = menu.addAction(tr("Snapshot values"));
+        snapshot->setToolTip(tr("Remember the current value of every match so "
+                                "change scans compare against it"));
+        connect(snapshot, &QAction::triggered, this, &MainWindow::snapshot_values);
 
         menu.exec(ui->memory_addresses->viewport()->mapToGlobal(pos));
     });
+    ui->saved_addresses->setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(ui->saved_addresses, &QTableView::customContextMenuRequested, this,
+        [this](const QPoint &pos) {
+        QModelIndex index = ui->saved_addresses->indexAt(pos);
+        if (!index.isValid()) {
+            return;
+        }
+        const int row = index.row();
+        const saved_address &entry = saved_model->store()[static_cast<std::size_t>(row)];
+        void *address = reinterpret_cast<void *>(entry.address);
+        std::size_t size = value_type_size(entry.type);
+
+        QMenu menu(this);
+        QAction *writes = menu.addAction(tr("Find out what writes to this address"));
+        connect(writes, &QAction::triggered, this, [this, address, size]() {
+            auto *dialog = new WriteTracerDialog(*scanner, address, size, this);
+            dialog->setAttribute(Qt::WA_DeleteOnClose);
+            dialog->show();
+        });
+        QAction *pointerScan = menu.addAction(tr("Pointer scan for this address"));
+        connect(pointerScan, &QAction::triggered, this, [this, address]() {
+            show_pointer_scan(reinterpret_cast<uintptr_t>(address));
+        });
+        QAction *codeReferences = menu.addAction(tr("Find code accessing this address"));
+        connect(codeReferences, &QAction::triggered, this, [this, address]() {
+            show_code_references(reinterpret_cast<uintptr_t>(address));
+        });
+        QAction *browse = menu.addAction(tr("Browse memory"));
+        connect(browse, &QAction::triggered, this, [this, address]() {
+            show_memory_viewer(reinterpret_cast<uintptr_t>(address));
+        });
+        QAction *dissect = menu.addAction(tr("Dissect structure"));
+        connect(dissect, &QAction::triggered, this, [this, address]() {
+            show_struct_dissector(reinterpret_cast<uintptr_t>(address));
+        });
+        menu.addSeparator();
+        QAction *remove = menu.addAction(tr("Remove"));
+        connect(remove, &QAction::triggered, this, [this, address]() {
+            const long current = saved_model->store().find(reinterpret_cast<uintptr_t>(address));
+            if (current < 0) {
+                return;
+            }
+            freezer->unfreeze(address);
+            saved_model->remove(static_cast<int>(current));
+            update_monitor_targets();
+            update_freeze_stats();
+        });
+        menu.exec(ui->saved_addresses->viewport()->mapToGlobal(pos));
+    });
     create_menu();
     create_connections();
     ui->search_bar->setValidator(this->pos_only);
     ui->saved_addresses->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    ui->saved_addresses->horizontalHeader()->setSectionResizeMode(
+        SavedAddressModel::COLUMN_ACTIVE, QHeaderView::ResizeToContents);
     toggleLayoutItems(ui->memorySearchLayout, false);
     ui->memory_addresses->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
     ui->memory_addresses->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
 
-    load_settings();
+    monitor->moveToThread(monitor_thread);
+    connect(monitor_thread, &QThread::finished, monitor, &QObject::deleteLater);
+    connect(monitor, &MemoryMonitor::values_changed, this,
+            &MainWindow::apply_monitor_updates);
+    monitor_thread->start();
+
+    connect(freeze_stats_timer, &QTimer::timeout, this,
+            &MainWindow::update_freeze_stats);
+    freeze_stats_timer->start(1000);
+    connect(history_timer, &QTimer::timeout, this, &MainWindow::record_history_tick);
 
-    value_update_timer->start();
+    load_settings();
 }
 
 void MainWindow::load_settings() {
@@ -207,11 +264,27 @@ void MainWindow::load_settings() {
     QSettings settings{"Memory Scanner", "Memsc"};
     bool ok = false;
     qDebug() << "Updating settings\n";
-    value_update_timer->setInterval(
-        settings.value("General/update-interval", 100).toInt());
-    std::size_t size =
-        settings.value("General/scan-block-size").toULongLong(&ok);
-    scanner->max_read_size(size);
+    int interval = settings.value("General/update-interval", 100).toInt();
+    QMetaObject::invokeMethod(monitor, [this, interval] {
+        monitor->start(interval);
+    }, Qt::QueuedConnection);
+    int history_ticks = settings.value("General/history-ticks", 50).toInt();
+    if (history_ticks > 0) {
+        history_timer->start(interval * history_ticks);
+    } else {
+        history_timer->stop();
+    }
+    freeze_interval = settings.value("General/freeze-interval", 1000).toInt();
+    freezer->set_interval(std::chrono::microseconds{freeze_interval});
+    auto_read_size = settings.value("General/scan-block-size-auto", true).toBool();
+    if (!auto_read_size) {
+        std::size_t size = settings.value("General/scan-block-size",
+                                          qulonglong(ProcessMemory::default_max_read_size))
+                               .toULongLong(&ok);
+        scanner->max_read_size(ok ? size : 0);
+    } else {
+        calibrate_read_size();
+    }
     double epsilon = settings.value("General/epsilon").toDouble(&ok);
     scanner->epsilon(epsilon);
 
@@ -227,20 +300,164 @@ void MainWindow::load_settings() {
 
         attach_to_process(pid, QString("%1: %2").arg(pid).arg(procName));
     }
+
+    // Rules follow the program across restarts where the pid above can't
+    attach_watcher->stop();
+    reattach = settings.value("General/attach-reattach", true).toBool();
+    const QString rule = settings.value("General/attach-rule").toString();
+    if (!rule.isEmpty()) {
+        auto compiled = attach_rule::make(rule.toStdString(),
+                                          settings.value("General/attach-cmdline", false).toBool());
+        if (compiled) {
+            std::vector<attach_rule> rules;
+            rules.push_back(std::move(*compiled));
+            attach_watcher->start(std::move(rules), [this](const process_info &info) {
+                QMetaObject::invokeMethod(this, [this, pid = info.pid,
+                                                 comm = QString::fromStdString(info.comm)] {
+                    attach_by_rule(pid, comm);
+                }, Qt::QueuedConnection);
+            });
+        }
+    }
+}
+
+/**
+ * @brief MainWindow::attach_by_rule attaches to a process found by the attach
+ * rule unless the attached process is still running. A new instance of the
+ * program attached last is a restart, its saved addresses are kept and their
+ * pointer paths and signatures resolved again.
+ */
+void MainWindow::attach_by_rule(pid_t pid, const QString &comm) {
+    const pid_t current = scanner->pid();
+    if (current == pid || (current > 0 && QFile::exists(QString("/proc/%1").arg(current)))) {
+        return;
+    }
+    const bool restart = !process_name.isEmpty();
+    if (restart && !reattach) {
+        return;
+    }
+    attach(pid, QString("%1: %2").arg(pid).arg(comm), restart && comm == process_name);
 }
 
 void MainWindow::attach_to_process(pid_t pid, const QString name) {
+    attach(pid, name, false);
+}
+
+void MainWindow::attach(pid_t pid, const QString &name, bool keep_saved) {
     if (!scanner->pid(pid)) {
         return;
     }
     qDebug() << "Attaching to: " << pid << "\n";
     setWindowTitle(QString("MemSC - ") + name);
+    // Sessions match the process by comm, `name` is only for display
+    QFile comm(QString("/proc/%1/comm").arg(pid));
+    process_name = comm.open(QIODevice::ReadOnly)
+                       ? QString::fromLocal8Bit(comm.readAll()).trimmed()
+                       : QString();
     toggleLayoutItems(ui->memorySearchLayout, true);
     ui->next_scan->setEnabled(false);
     ui->search_bar->setFocus();
-    ui->memory_addresses->clearContents();
-    ui->saved_addresses->clearContents();
-    scanner->get_matches().clear();
+    freezer->pid(pid);
+    freezer->clear();
+    match_model->clear();
+    if (keep_saved) {
+        restore_saved(pid);
+    } else {
+        saved_model->clear();
+    }
+    autosave.waitForFinished();
+    scanner->clear_matches();
+    scan_history.clear();
+    calibrate_read_size();
+}
+
+/**
+ * @brief MainWindow::restore_saved carries the saved addresses over to a new
+ * instance of the same program. Entries with a locator are resolved again in
+ * the background, frozen ones are frozen at their old value once they have
+ * been found.
+ */
+void MainWindow::restore_saved(pid_t pid) {
+    auto maps = scanner->maps();
+    if (!maps) {
+        return;
+    }
+    const SavedAddressStore &store = saved_model->store();
+    std::vector<std::string> locators = store.locators();
+    std::vector<std::pair<int, std::uint64_t>> frozen;
+    for (std::size_t row = 0; row < store.size(); ++row) {
+        if (store[row].frozen) {
+            frozen.emplace_back(static_cast<int>(row), store[row].value);
+        }
+    }
+
+    using locations = std::vector<std::optional<std::uintptr_t>>;
+    auto future = QtConcurrent::run([pid, maps = std::move(maps), locators] {
+        return SavedAddressStore::resolve_locators(locators, pid, *maps);
+    });
+    auto *watcher = new QFutureWatcher<locations>(this);
+    connect(watcher, &QFutureWatcher<locations>::finished, this,
+            [this, watcher, pid, locators = std::move(locators), frozen = std::move(frozen)] {
+        watcher->deleteLater();
+        // Attached elsewhere meanwhile, the addresses belong to another image
+        if (scanner->pid() != pid) {
+            return;
+        }
+        const SavedAddressStore &store = saved_model->store();
+        std::vector<std::size_t> unresolved;
+        saved_model->apply_locations(locators, watcher->result(), &unresolved);
+        saved_model->refresh(pid);
+        for (const auto &[row, value] : frozen) {
+            const auto r = static_cast<std::size_t>(row);
+            // Rows edited while resolving are left as they are
+            if (r >= store.size() || store[r].locator != locators[r] || !store[r].frozen) {
+                continue;
+            }
+            // The old address of an entry that wasn't found may well be readable
+            if (!store[r].valid ||
+                std::find(unresolved.begin(), unresolved.end(), r) != unresolved.end()) {
+                saved_model->set_frozen(row, false);
+                continue;
+            }
+            saved_model->set_value(row, value);
+            toggle_freeze(row, true);
+        }
+        update_monitor_targets();
+    });
+    watcher->setFuture(future);
+}
+
+/**
+ * @brief MainWindow::calibrate_read_size benchmarks the attached process in
+ * the background when the scan block size is automatic. The result is
+ * applied once it finishes, a scan started meanwhile picks it up per range.
+ * A calibration of the previous process is left to finish and ignored.
+ */
+void MainWindow::calibrate_read_size() {
+    auto maps = scanner->maps();
+    if (!auto_read_size || scanner->pid() <= 0 || !maps) {
+        return;
+    }
+    if (calibration.isRunning()) {
+        recalibrate = true;
+        return;
+    }
+    const pid_t pid = scanner->pid();
+    calibration = QtConcurrent::run([pid, maps = std::move(maps)] {
+        return ProcessMemory::benchmark_read_size(pid, *maps, std::chrono::milliseconds{300});
+    });
+    auto *watcher = new QFutureWatcher<std::size_t>(this);
+    connect(watcher, &QFutureWatcher<std::size_t>::finished, this, [this, watcher, pid] {
+        if (auto_read_size && scanner->pid() == pid) {
+            scanner->max_read_size(watcher->result());
+        }
+        watcher->deleteLater();
+        if (recalibrate) {
+            recalibrate = false;
+            calibrate_read_size();
+        }
+    });
+    watcher->setFuture(calibration);
 }
 
 void MainWindow::show_pid_window() {
@@ -251,8 +468,19 @@ void MainWindow::show_pid_window() {
 }
 
 MainWindow::~MainWindow() {
+    autosave.waitForFinished();
+    if (!scanner->scanning() &&
+        (!scanner->get_matches().empty() || saved_model->rowCount() > 0)) {
+        write_session(autosave_path());
+    }
+    calibration.waitForFinished();
+    // Matches are posted to this window, stop before it goes away
+    delete attach_watcher;
     this->quit = true;
+    monitor_thread->quit();
+    monitor_thread->wait();
     delete ui;
+    delete freezer;
     delete scanner;
 }
 
@@ -310,27 +538,210 @@ void MainWindow::create_menu() {
         window->show();
     });
 
+    QAction *pointers = new QAction("Pointer scan", tools);
+    pointers->setShortcut(QKeySequence(Qt::Key_F10));
+    connect(pointers, &QAction::triggered, [this] {
+        show_pointer_scan(0);
+    });
+
+    QAction *references = new QAction("Code references", tools);
+    connect(references, &QAction::triggered, [this] {
+        show_code_references(0);
+    });
+
+    QAction *signatures = new QAction("Signature scan", tools);
+    connect(signatures, &QAction::triggered, [this] {
+        if (scanner->pid() <= 0) {
+            QMessageBox::warning(
+                this,
+                tr("Invalid PID"),
+                tr("Please attach to a process")
+            );
+            return;
+        }
+        SignatureDialog *dialog = new SignatureDialog(*scanner, this);
+        dialog->setAttribute(Qt::WA_DeleteOnClose);
+        connect(dialog, &SignatureDialog::saveAddress, this,
+                [this](std::uintptr_t address, const QString &locator) {
+            add_saved_address(address, match_model->type(), QString(), locator);
+        });
+        dialog->show();
+    });
+
+    QAction *hot = new QAction("Hot addresses", tools);
+    hot->setShortcut(QKeySequence(Qt::Key_F9));
+    connect(hot, &QAction::triggered, [this] {
+        if (scanner->pid() <= 0) {
+            QMessageBox::warning(
+                this,
+                tr("Invalid PID"),
+                tr("Please attach to a process")
+            );
+            return;
+        }
+        HeatMapDialog *dialog = new HeatMapDialog(*scanner, this);
+        dialog->setAttribute(Qt::WA_DeleteOnClose);
+        connect(dialog, &HeatMapDialog::seedMatches, this, &MainWindow::seed_matches);
+        dialog->show();
+    });
+
+    QAction *recorder = new QAction("Value recorder", tools);
+    connect(recorder, &QAction::triggered, [this] {
+        if (scanner->pid() <= 0) {
+            QMessageBox::warning(
+                this,
+                tr("Invalid PID"),
+                tr("Please attach to a process")
+            );
+            return;
+        }
+        RecorderDialog *dialog = new RecorderDialog(*scanner, [this] {
+            return recorder_channels();
+        }, this);
+        dialog->setAttribute(Qt::WA_DeleteOnClose);
+        dialog->show();
+    });
+
+    // Needs no attached process, the group picks its own
+    QAction *group = new QAction("Group scan", tools);
+    connect(group, &QAction::triggered, [this] {
+        GroupScanDialog *dialog = new GroupScanDialog(scan_scope(), this);
+        dialog->setAttribute(Qt::WA_DeleteOnClose);
+        dialog->show();
+    });
+
+    QAction *memory = new QAction("Memory viewer", tools);
+    memory->setShortcut(QKeySequence(Qt::Key_F7));
+    connect(memory, &QAction::triggered, [this] {
+        show_memory_viewer(0);
+    });
+
+    QAction *dissector = new QAction("Dissect structure", tools);
+    connect(dissector, &QAction::triggered, [this] {
+        show_struct_dissector(0);
+    });
+
+    QAction *openSession = new QAction("Open session...", filemenu);
+    openSession->setShortcut(QKeySequence::Open);
+    connect(openSession, &QAction::triggered, this, &MainWindow::open_session);
+    QAction *saveSession = new QAction("Save session...", filemenu);
+    saveSession->setShortcut(QKeySequence::Save);
+    connect(saveSession, &QAction::triggered, this, &MainWindow::save_session_as);
+    QAction *restoreSession = new QAction("Restore last session", filemenu);
+    connect(restoreSession, &QAction::triggered, [this] {
+        if (!QFile::exists(autosave_path())) {
+            QMessageBox::information(this, tr("No session"),
+                                     tr("No session was saved on exit yet."));
+            return;
+        }
+        read_session(autosave_path());
+    });
+
     QAction *settings = new QAction("Settings", filemenu);
     connect(settings, &QAction::triggered, [this] {
         SettingsDialog *diag = new SettingsDialog(this);
         connect(diag, &SettingsDialog::settings_changed, this, &MainWindow::load_settings);
         diag->exec();
     });
+    filemenu->addAction(openSession);
+    filemenu->addAction(saveSession);
+    filemenu->addAction(restoreSession);
+    filemenu->addSeparator();
     filemenu->addAction(settings);
     tools->addAction(disasm);
     tools->addAction(maps);
+    tools->addAction(memory);
+    tools->addAction(dissector);
+    tools->addAction(pointers);
+    tools->addAction(references);
+    tools->addAction(signatures);
+    tools->addAction(hot);
+    tools->addAction(recorder);
+    tools->addAction(group);
     menubar->addMenu(filemenu);
     menubar->addMenu(tools);
     this->layout()->setMenuBar(menubar);
 }
 
+void MainWindow::show_pointer_scan(uintptr_t target) {
+    if (scanner->pid() <= 0) {
+        QMessageBox::warning(
+            this,
+            tr("Invalid PID"),
+            tr("Please attach to a process")
+        );
+        return;
+    }
+    PointerScanDialog *dialog = new PointerScanDialog(*scanner, target, this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    connect(dialog, &PointerScanDialog::saveAddress, this,
+            [this](std::uintptr_t address, const QString &locator) {
+        add_saved_address(address, match_model->type(), QString(), locator);
+    });
+    dialog->show();
+}
+
+void MainWindow::show_code_references(uintptr_t target) {
+    if (scanner->pid() <= 0) {
+        QMessageBox::warning(
+            this,
+            tr("Invalid PID"),
+            tr("Please attach to a process")
+        );
+        return;
+    }
+    CodeReferencesDialog *dialog = new CodeReferencesDialog(*scanner, target, this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    dialog->show();
+}
+
+void MainWindow::show_memory_viewer(uintptr_t address) {
+    if (scanner->pid() <= 0) {
+        QMessageBox::warning(
+            this,
+            tr("Invalid PID"),
+            tr("Please attach to a process")
+        );
+        return;
+    }
+    MemoryViewer *dialog = new MemoryViewer(*scanner, this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    if (address != 0) {
+        dialog->gotoAddress(address);
+    }
+    dialog->show();
+}
+
+void MainWindow::show_struct_dissector(uintptr_t address) {
+    if (scanner->pid() <= 0) {
+        QMessageBox::warning(
+            this,
+            tr("Invalid PID"),
+            tr("Please attach to a process")
+        );
+        return;
+    }
+    StructDissectorDialog *dialog = new StructDissectorDialog(*scanner, this);
+    dialog->setAttribute(Qt::WA_DeleteOnClose);
+    connect(dialog, &StructDissectorDialog::saveAddress, this,
+            [this](std::uintptr_t address, value_type type, const QString &description) {
+        add_saved_address(address, type, description);
+    });
+    if (address != 0) {
+        dialog->dissect(address);
+    }
+    dialog->show();
+}
+
 void MainWindow::create_connections() {
     QSettings settings{"Memsc"};
     ui->attachButton->setShortcut(QKeySequence(Qt::Key_F2));
     connect(ui->attachButton, &QPushButton::clicked, this,
                           &MainWindow::show_pid_window);
-    connect(ui->memory_addresses, &QTableWidget::cellDoubleClicked,
-                     this, &MainWindow::save_row);
+    connect(ui->memory_addresses, &QTableView::doubleClicked, this,
+            [this](const QModelIndex &index) {
+                save_row(index.row(), index.column());
+            });
     connect(ui->value_type,
                      QOverload<int>::of(&QComboBox::currentIndexChanged),
                      this, &MainWindow::change_validator);
@@ -338,13 +749,25 @@ void MainWindow::create_connections() {
                      this, &MainWindow::handle_new_scan);
     connect(ui->next_scan, &QPushButton::pressed,
                      this, &MainWindow::handle_next_scan);
-    connect(ui->saved_addresses, &QTableWidget::cellDoubleClicked, this, &MainWindow::handle_double_click_saved);
-    connect(this, &MainWindow::value_changed, this, &MainWindow::saved_address_change);
-    // TODO integrate settings
-    connect(value_update_timer, &QTimer::timeout, [this] {
-        update_table(ui->saved_addresses, 0, 1);
-        update_table(ui->memory_addresses, 0, 1);
+    connect(ui->saved_addresses, &QTableView::doubleClicked, this, &MainWindow::handle_double_click_saved);
+    connect(saved_model, &SavedAddressModel::freezeToggled, this, &MainWindow::toggle_freeze);
+    connect(saved_model, &SavedAddressModel::typeChanged, this, [this](int row) {
+        // Read it at the new size and keep a frozen entry frozen
+        saved_model->refresh(scanner->pid());
+        const saved_address &entry = saved_model->store()[static_cast<std::size_t>(row)];
+        if (entry.frozen) {
+            toggle_freeze(row, entry.valid);
+            saved_model->set_frozen(row, entry.valid);
+        }
+        update_monitor_targets();
     });
+    QScrollBar *scroll = ui->memory_addresses->verticalScrollBar();
+    connect(scroll, &QScrollBar::valueChanged, this,
+            &MainWindow::update_monitor_targets);
+    connect(scroll, &QScrollBar::rangeChanged, this,
+            &MainWindow::update_monitor_targets);
+    connect(match_model, &QAbstractItemModel::modelReset, this,
+            &MainWindow::update_monitor_targets);
 
 
     connect(ui->search_bar, &QLineEdit::returnPressed, this, [this]() {
@@ -356,66 +779,31 @@ void MainWindow::create_connections() {
 }
 
 /**
- * @brief MainWindow::save_row saves the row to saved_addresses, memory monitoring is currently only
- * supported for the "basic" types
- * @param row
- * @param column
+ * @brief MainWindow::save_row saves the match on `row` to the saved
+ * addresses
  */
-void MainWindow::save_row(int row, int column) {
-    /* sizes for the specified type */
-    static const ssize_t size_array[] = {
-        -1,
-        1,
-        2,
-        4,
-        8,
-        sizeof(float),
-        sizeof(double),
-        -1,
-        -1,
-        -1
-    };
-    QTableWidgetItem *address = ui->memory_addresses->item(row, 0)->clone();
-    QString value = ui->memory_addresses->item(row, 2)->text();
-    int type = ui->value_type->currentIndex();
-
-    int current_rows = ui->saved_addresses->rowCount();
-    ui->saved_addresses->setRowCount(current_rows + 1);
-    QTableWidgetItem *checkbox = new QTableWidgetItem();
-    checkbox->setCheckState(Qt::Unchecked);
-    ui->saved_addresses->setItem(current_rows, 0, checkbox); /* checkbox */
-    /*description inserted automatically; when saving is added will probably be included here as well or something */
-    ui->saved_addresses->setItem(current_rows, 2, address); /* address */
-    QComboBox *type_combobox = new QComboBox(this);
-    type_combobox->addItems({"Byte", "2 Bytes", "4 Bytes", "8 Bytes", "Float", "Double", "String", "Array of Bytes"});
-    type_combobox->setCurrentIndex(type);
-    ui->saved_addresses->setCellWidget(current_rows, 3, type_combobox);
-    QTableWidgetItem *value_cell = new QTableWidgetItem(value);
-    std::string str = value_cell->text().toStdString();
-    value_cell->setFlags(value_cell->flags() & (~Qt::ItemFlag::ItemIsEditable));
-    /* TODO change this to get from the column that contains the actual value when done */
-    ssize_t size = size_array[type];
-    if (size > 0) {
-        void *_address = nullptr;
-        sscanf(address->text().toStdString().c_str(), "%p", &_address);
-        if(saved_address_values.find(_address) == saved_address_values.end()) {
-            address_t *entry = new address_t;
-            entry->size=size;
-            if(size != -1) {
-                entry->value = new char[size];
-                parse_cstr((void *)entry->value, value.toStdString().c_str(), entry->size, type);
-                ui->saved_addresses->setItem(current_rows, 4, value_cell); /* value */
-
-            } else {
-                /* TODO add an allocation system for byte arrays etc,
-                 * will probably include asking user how large it is
-                 */
-            }
-            saved_address_values[_address] = entry;
-            printf("saving: %p\n", _address);
+void MainWindow::save_row(int row, [[maybe_unused]] int column) {
+    void *match = match_model->address(row);
+    if (match == nullptr) {
+        return;
+    }
+    add_saved_address(reinterpret_cast<uintptr_t>(match), match_model->type(), QString());
+}
 
-        }
+/**
+ * @brief MainWindow::add_saved_address appends an address to the saved
+ * addresses, reads it and starts monitoring it
+ * @return the row, or -1 if the address was already saved
+ */
+int MainWindow::add_saved_address(std::uintptr_t address, value_type type,
+                                  const QString &description, const QString &locator) {
+    int row = saved_model->add(address, type, description, locator);
+    if (row < 0) {
+        return -1;
     }
+    saved_model->refresh(scanner->pid());
+    update_monitor_targets();
+    return row;
 }
 
 void MainWindow::change_validator(int index) {
@@ -434,14 +822,21 @@ void MainWindow::change_validator(int index) {
 }
 
 void MainWindow::handle_new_scan() {
+    // Disabled while detached or while a snapshot rewrites the history
+    if (!ui->new_scan->isEnabled()) {
+        return;
+    }
     if(ui->next_scan->isEnabled()) {
-        scanner->get_matches().clear();
-        ui->memory_addresses->clearContents();
+        autosave.waitForFinished();
+        match_model->clear();
+        scanner->clear_matches();
+        scan_history.clear();
         ui->amount_found->setText("Found: 0");
         ui->next_scan->setEnabled(false);
         ui->value_type->setEnabled(true);
     } else {
-        if(ui->search_bar->text().isEmpty() || scanner->scanning()) {
+        if(ui->search_bar->text().isEmpty() || scanner->scanning() ||
+           needs_history(static_cast<scan_mode>(ui->scan_type->currentIndex()))) {
             return;
         }
         ui->value_type->setEnabled(false);
@@ -450,160 +845,474 @@ void MainWindow::handle_new_scan() {
 }
 
 void MainWindow::handle_next_scan() {
-    if(ui->search_bar->text().isEmpty()) {
+    const auto mode = static_cast<scan_mode>(ui->scan_type->currentIndex());
+    // Change scans compare against the previous values, they need no input
+    // but can't start a new scan
+    const bool by_value = !needs_history(mode);
+    if (by_value && ui->search_bar->text().isEmpty()) {
         return;
     }
+    if (!by_value && (scanner->get_matches().empty() || scanner->history().filled() == 0)) {
+        return;
+    }
+
+    if (scanner->get_matches().empty()) {
+        scanner->scan_filter(scan_scope());
+    }
+    // Scans compact the matches the autosave is writing
+    autosave.waitForFinished();
 
     int idx = ui->value_type->currentIndex();
     const QString searchText = ui->search_bar->text();
+    const QString label = by_value ? searchText : ui->scan_type->currentText();
     switch (idx) {
         case 0: { // Byte -> uint8_t
             bool ok = false;
             uint8_t v = static_cast<uint8_t>(searchText.toUInt(&ok));
-            if (!ok) return;
+            if (!ok && by_value) return;
             start_scan_and_populate<uint8_t>(this, scanner,
-                                             ui->memory_addresses, searchText,
-                                             ui->amount_found, ui->next_scan, v
-                                             );
+                                             match_model, label,
+                                             ui->amount_found, ui->next_scan, v, mode);
             break;
         }
         case 1: { // 2 Bytes -> uint16_t
             bool ok = false;
             uint16_t v = static_cast<uint16_t>(searchText.toUInt(&ok));
-            if (!ok) return;
+            if (!ok && by_value) return;
             start_scan_and_populate<uint16_t>(this, scanner,
-                                              ui->memory_addresses, searchText,
-                                              ui->amount_found, ui->next_scan, v);
+                                              match_model, label,
+                                              ui->amount_found, ui->next_scan, v, mode);
             break;
         }
         case 2: { // 4 Bytes -> uint32_t
             bool ok = false;
             uint32_t v = searchText.toUInt(&ok);
-            if (!ok) return;
+            if (!ok && by_value) return;
             start_scan_and_populate<uint32_t>(this, scanner,
-                                              ui->memory_addresses, searchText,
-                                              ui->amount_found, ui->next_scan, v);
+                                              match_model, label,
+                                              ui->amount_found, ui->next_scan, v, mode);
             break;
         }
         case 3: { // 8 Bytes -> uint64_t
             bool ok = false;
             uint64_t v = searchText.toULongLong(&ok);
-            if (!ok) return;
+            if (!ok && by_value) return;
             start_scan_and_populate<uint64_t>(this, scanner,
-                                              ui->memory_addresses, searchText,
-                                              ui->amount_found, ui->next_scan, v);
+                                              match_model, label,
+                                              ui->amount_found, ui->next_scan, v, mode);
             break;
         }
 
         case 4: { // Float
             bool ok = false;
             float v = searchText.toFloat(&ok);
-            if (!ok) return;
+            if (!ok && by_value) return;
             start_scan_and_populate<float>(this, scanner,
-                                              ui->memory_addresses, searchText,
-                                              ui->amount_found, ui->next_scan, v);
+                                              match_model, label,
+                                              ui->amount_found, ui->next_scan, v, mode);
             break;
         }
 
         case 5: { // Double
             bool ok = false;
             double v = searchText.toDouble(&ok);
-            if (!ok) return;
+            if (!ok && by_value) return;
             start_scan_and_populate<double>(this, scanner,
-                                              ui->memory_addresses, searchText,
-                                              ui->amount_found, ui->next_scan, v);
+                                              match_model, label,
+                                              ui->amount_found, ui->next_scan, v, mode);
             break;
         }
         default:
-            /* should never get here... */
-            assert(false);
+            // String and Array of byte are disabled in the combo box
             return;
     }
 }
 
-void MainWindow::handle_double_click_saved(int row,int column) {
-    switch (column) {
-    case 0: /* freeze value, probably somehow with mmap to change region to read only*/
-        break;
-    case 1: /* change description */
-        break;
-    case 2: /* change address */
-        break;
-    case 3: /* change type */
-        break;
-    case 4: /* change value */
-        //uint32_t value =(uint32_t) QInputDialog::getInt(this, tr("QInputDialog::getInt()"), tr("Set Value"));
-        QString str_addr = ui->saved_addresses->item(row, 2)->text();
-        void *address = nullptr;
-        sscanf(str_addr.toStdString().c_str(), "%p", &address);
-        // TODO: scanner->write(address, &value, sizeof(value));
-        break;
+/**
+ * @brief MainWindow::scan_scope builds the range filter for the initial scan
+ * from the scope controls
+ */
+range_filter MainWindow::scan_scope() const {
+    range_filter filter{};
+    filter.writable_only = ui->scope_writable->isChecked();
+    filter.anonymous_only = ui->scope_anonymous->isChecked();
+    filter.exclude_shared = ui->scope_skip_shared->isChecked();
+    if (ui->scope_exec->isChecked()) {
+        filter.perms_excluded &= static_cast<unsigned char>(~PERM_EXECUTE);
+    }
+    filter.name_glob = ui->scope_module->text().trimmed().toStdString();
+
+    bool ok = false;
+    uintptr_t start = ui->scope_start->text().trimmed().toULongLong(&ok, 16);
+    if (ok) {
+        filter.min_address = start;
+    }
+    uintptr_t end = ui->scope_end->text().trimmed().toULongLong(&ok, 16);
+    if (ok && end > filter.min_address) {
+        filter.max_address = end;
     }
+    return filter;
 }
 
-void MainWindow::delete_window() {
+/**
+ * @brief MainWindow::handle_double_click_saved asks for a new value when the
+ * value of a saved address is double clicked, the other columns are edited
+ * in place
+ */
+void MainWindow::handle_double_click_saved(const QModelIndex &index) {
+    if (!index.isValid() || index.column() != SavedAddressModel::COLUMN_VALUE) {
+        return;
+    }
+    const saved_address &entry = saved_model->store()[static_cast<std::size_t>(index.row())];
+    void *address = reinterpret_cast<void *>(entry.address);
+    const value_type type = entry.type;
 
+    bool ok = false;
+    QString text = QInputDialog::getText(this, tr("Set value"), tr("New value:"),
+                                         QLineEdit::Normal, index.data().toString(), &ok);
+    std::uint64_t raw = 0;
+    if (!ok || !parse_value(type, text.trimmed(), raw)) {
+        return;
+    }
+    if (scanner->write_process_memory(address, &raw, value_type_size(type)) < 0) {
+        QMessageBox::warning(this, tr("Write failed"),
+                             tr("Could not write to %1").arg(
+                                 index.siblingAtColumn(SavedAddressModel::COLUMN_ADDRESS)
+                                     .data().toString()));
+        return;
+    }
+    // Keep a frozen value frozen at the new value
+    if (freezer->frozen(address)) {
+        freezer->freeze(address, &raw, value_type_size(type),
+                        std::chrono::microseconds{freeze_interval});
+    }
+    saved_model->refresh(scanner->pid());
 }
 
-void MainWindow::update_table(QTableWidget *widget, int addr_col, int value_col) {
-    // Scans forward this many rows, unnecessary to go further down
-    constexpr int scan_forward = 50;
-    int row = std::max(widget->verticalScrollBar()->value() - scan_forward, 0);
-    int end = std::min(widget->verticalScrollBar()->value() + scan_forward,
-                       widget->rowCount());
-    // Look around "current row", i.e. highest one
-    for (; row < end; row++) {
-        QTableWidgetItem *addr_item = widget->item(row, addr_col);
-        if (addr_item == nullptr) {
-            continue;
+/**
+ * @brief MainWindow::toggle_freeze freezes the saved address to its last
+ * value when its checkbox is checked and releases it when unchecked
+ */
+void MainWindow::toggle_freeze(int row, bool frozen) {
+    const saved_address &entry = saved_model->store()[static_cast<std::size_t>(row)];
+    void *address = reinterpret_cast<void *>(entry.address);
+    if (frozen && entry.valid) {
+        freezer->freeze(address, &entry.value, value_type_size(entry.type),
+                        std::chrono::microseconds{freeze_interval});
+    } else {
+        freezer->unfreeze(address);
+        if (frozen) {
+            // Nothing to freeze it to yet
+            saved_model->set_frozen(row, false);
         }
-        QTableWidgetItem *current_value = widget->item(row, value_col);
-        if (current_value == nullptr) {
-            continue;
+    }
+    update_freeze_stats();
+}
+
+/**
+ * @brief MainWindow::update_freeze_stats shows what freezing currently costs,
+ * the counters are reset every time so the rates cover the last interval
+ */
+void MainWindow::update_freeze_stats() {
+    FreezeService::stats stats = freezer->statistics();
+    freezer->reset_statistics();
+    if (stats.entries == 0) {
+        ui->freeze_stats->clear();
+        return;
+    }
+    const double seconds = std::chrono::duration<double>(stats.elapsed).count();
+    if (seconds <= 0) {
+        return;
+    }
+    QString text = QString("Frozen: %1, %2 writes/s in %3 syscalls/s, %4% CPU, lag %5/%6 us")
+                       .arg(stats.entries)
+                       .arg(double(stats.writes) / seconds, 0, 'f', 0)
+                       .arg(double(stats.syscalls) / seconds, 0, 'f', 0)
+                       .arg(std::chrono::duration<double>(stats.cpu_time).count() / seconds * 100, 0, 'f', 1)
+                       .arg(stats.average_lag.count() / 1000)
+                       .arg(stats.max_lag.count() / 1000);
+    if (stats.failing > 0) {
+        text += QString(", %1 failing").arg(stats.failing);
+    }
+    ui->freeze_stats->setText(text);
+}
+
+/**
+ * @brief MainWindow::seed_matches replaces the matches with sampled
+ * addresses so next scan can narrow them down without an initial scan
+ * @param addresses sampled addresses
+ * @param granularity bytes each address stands for, every aligned value of
+ * the selected type in that span becomes a match
+ */
+void MainWindow::seed_matches(std::vector<std::uintptr_t> addresses, std::size_t granularity) {
+    if (scanner->scanning()) {
+        return;
+    }
+    auto type = static_cast<value_type>(ui->value_type->currentIndex());
+    const std::uintptr_t size = value_type_size(type);
+    if (size == 0) {
+        return;
+    }
+
+    std::vector<void *> matches;
+    autosave.waitForFinished();
+    match_model->begin_scan();
+    for (std::uintptr_t address : addresses) {
+        const std::uintptr_t first = address & ~(size - 1);
+        const std::uintptr_t last = granularity > 1 ? address + granularity : first + size;
+        for (std::uintptr_t slot = first; slot < last; slot += size) {
+            matches.push_back(reinterpret_cast<void *>(slot));
         }
-        if (auto *mti = dynamic_cast<MatchTableItem*>(addr_item)) {
-            const Match &storedMatch = mti->match();
-            std::visit([&](auto *ptr) {
-                using U = std::remove_pointer_t<decltype(ptr)>;
-                if (!ptr) return;
-
-                U newVal{};
-                [[maybe_unused]] ssize_t n = scanner->read_process_memory(ptr, &newVal, sizeof(newVal));
-                assert(n == sizeof(newVal));
-
-                current_value->setText(QString::number(newVal));
-            }, storedMatch);
+    }
+    std::sort(matches.begin(), matches.end());
+    matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+    const std::size_t found = matches.size();
+    scanner->seed_matches(std::move(matches));
+    match_model->end_scan(type);
+    record_scan(type, tr("sampled"));
+
+    ui->amount_found->setText(QString("Found: %1").arg(found));
+    ui->next_scan->setEnabled(true);
+    ui->value_type->setEnabled(false);
+}
+
+/**
+ * @brief MainWindow::snapshot_values reads every match into a new history
+ * column, the Previous column and change scans use it from then on
+ */
+void MainWindow::snapshot_values() {
+    if (scanner->scanning() || scanner->get_matches().empty()) {
+        return;
+    }
+    const auto type = match_model->type();
+    const std::size_t width = value_type_size(type);
+    match_model->begin_scan();
+    ui->new_scan->setEnabled(false);
+    ui->next_scan->setEnabled(false);
+    auto future = QtConcurrent::run([this, width] {
+        scanner->snapshot_values(width);
+    });
+    auto *watcher = new QFutureWatcher<void>(this);
+    connect(watcher, &QFutureWatcher<void>::finished, this, [this, type, watcher] {
+        match_model->end_scan(type);
+        ui->new_scan->setEnabled(true);
+        ui->next_scan->setEnabled(true);
+        watcher->deleteLater();
+    });
+    watcher->setFuture(future);
+}
+
+/**
+ * @brief MainWindow::record_history_tick adds the current values as a
+ * history column every few monitor ticks. It reads on the ui thread so the
+ * Previous column can keep reading the history, match lists above
+ * tick_history_limit are left to scans and manual snapshots.
+ */
+void MainWindow::record_history_tick() {
+    const std::size_t count = scanner->get_matches().size();
+    if (count == 0 || count > tick_history_limit || scanner->scanning() ||
+        !ui->new_scan->isEnabled()) {
+        return;
+    }
+    scanner->snapshot_values(value_type_size(match_model->type()));
+    match_model->history_changed();
+}
+
+void MainWindow::delete_window() {
+
+}
+
+/**
+ * @brief MainWindow::update_monitor_targets hands the on-screen match rows
+ * and all saved addresses to the memory monitor
+ */
+void MainWindow::update_monitor_targets() {
+    std::vector<monitor_target> targets;
+
+    QTableView *view = ui->memory_addresses;
+    int first = view->rowAt(0);
+    if (first >= 0) {
+        int last = view->rowAt(view->viewport()->height());
+        if (last < 0) {
+            last = match_model->rowCount() - 1;
         }
-        else {
-            // Not a MatchTableItem
+        auto size = static_cast<std::uint8_t>(value_type_size(match_model->type()));
+        for (int row = first; row <= last; ++row) {
+            targets.push_back({match_model->address(row), size,
+                               MemoryMonitor::TABLE_MATCHES, row});
         }
     }
+
+    const SavedAddressStore &saved = saved_model->store();
+    for (std::size_t row = 0; row < saved.size(); ++row) {
+        targets.push_back({reinterpret_cast<void *>(saved[row].address),
+                           static_cast<std::uint8_t>(value_type_size(saved[row].type)),
+                           MemoryMonitor::TABLE_SAVED, static_cast<int>(row)});
+    }
+
+    monitor->set_targets(scanner->pid(), std::move(targets));
+}
+
+void MainWindow::apply_monitor_updates(const std::vector<monitor_update> &updates) {
+    match_model->apply_updates(updates);
+    saved_model->apply_updates(updates);
+}
+
+void MainWindow::record_scan(value_type type, const QString &search_text) {
+    scan_history.push_back({type, search_text.toStdString(), scanner->get_matches().size(),
+                            QDateTime::currentSecsSinceEpoch()});
+    autosave_session();
 }
 
 /**
- * @brief MainWindow::handle_value_changed
- * @param segment the piece in memory that has changed value, it should also
- * have been updated so you don't need to re-read the memory
- * @param row which row it's on
+ * @brief MainWindow::current_session collects everything but the matches
+ * for a session file
  */
-void MainWindow::saved_address_change(address_t *segment, int row) {
-    QTableWidgetItem *value_cell = this->ui->saved_addresses->item(row, SAVED_ADDRESS_VALUE);
-
-    value_cell->setForeground(QColor::fromRgb(200, 0, 0));
-    QComboBox *combo = qobject_cast<QComboBox *>(this->ui->saved_addresses->cellWidget(row, SAVED_ADDRESS_TYPE));
-
-    uint64_t num = 0;
-    switch(combo->currentIndex()) {
-    case 0:
-        break;
-    case 1:
-    case 2:
-    case 3:
-    case 4:
-        for (size_t i = 0; i < segment->size; i++) {
-            num |= ((char *)segment->value)[i] << i;
+session MainWindow::current_session() const {
+    session s{};
+    s.pid = scanner->pid();
+    s.process = process_name.toStdString();
+    s.type = match_model->type();
+    s.history = scan_history;
+    s.maps = scanner->maps();
+    for (const saved_address &entry : saved_model->store()) {
+        s.saved.push_back({entry.address, static_cast<std::uint32_t>(value_type_size(entry.type)),
+                           entry.type, entry.frozen, entry.description, entry.value,
+                           entry.locator});
+    }
+    return s;
+}
+
+/**
+ * @brief MainWindow::recorder_channels lists the saved addresses the value
+ * recorder can sample, strings and byte arrays are left out
+ */
+std::vector<recorder_channel> MainWindow::recorder_channels() const {
+    std::vector<recorder_channel> channels;
+    for (const saved_address &entry : saved_model->store()) {
+        channels.push_back({entry.address, static_cast<std::uint8_t>(value_type_size(entry.type)),
+                            entry.type, entry.description});
+    }
+    return channels;
+}
+
+QString MainWindow::autosave_path() {
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dir);
+    return dir + "/last.memsc-session";
+}
+
+bool MainWindow::write_session(const QString &path) {
+    return save_session(path.toStdString(), current_session(), scanner->get_matches().span());
+}
+
+/**
+ * @brief MainWindow::autosave_session writes the last session in the
+ * background after every scan, so a crash loses at most the scan that was
+ * running. The matches are written in place, anything changing them waits
+ * for the save first.
+ */
+void MainWindow::autosave_session() {
+    autosave.waitForFinished();
+    if (scanner->get_matches().empty() && saved_model->rowCount() == 0) {
+        return;
+    }
+    autosave = QtConcurrent::run([path = autosave_path().toStdString(), s = current_session(),
+                                  matches = scanner->get_matches().span()] {
+        return save_session(path, s, matches);
+    });
+}
+
+/**
+ * @brief MainWindow::read_session replaces the current state with a saved
+ * session, attaching again if the process is still running. The matches are
+ * mapped from the file, not read.
+ */
+bool MainWindow::read_session(const QString &path) {
+    if (scanner->scanning()) {
+        return false;
+    }
+    session s{};
+    MatchStore matches;
+    if (!load_session(path.toStdString(), s, matches)) {
+        QMessageBox::warning(this, tr("Open failed"),
+                             tr("%1 is not a valid session, see stderr").arg(path));
+        return false;
+    }
+
+    // Only reattach to the same program, the pid may have been reused
+    QFile comm(QString("/proc/%1/comm").arg(s.pid));
+    const QString name = QString::fromStdString(s.process);
+    const bool running = s.pid > 0 && comm.open(QIODevice::ReadOnly) &&
+                         QString::fromLocal8Bit(comm.readAll()).trimmed() == name;
+    if (running) {
+        attach_to_process(s.pid, QString("%1: %2").arg(s.pid).arg(name));
+    } else {
+        // Keep the values from being read from whatever is attached now
+        scanner->detach();
+        freezer->clear();
+        match_model->clear();
+        setWindowTitle(QString("MemSC - %1: %2").arg(s.pid).arg(name) + tr(" (not running)"));
+        process_name = name;
+    }
+    saved_model->clear();
+
+    autosave.waitForFinished();
+    match_model->begin_scan();
+    MatchStore &current = scanner->get_matches();
+    // Hand the mapping over without copying it, values from the last run
+    // aren't saved so change scans start over
+    scanner->clear_matches();
+    current.swap(matches);
+    scan_history = std::move(s.history);
+    match_model->end_scan(s.type);
+    ui->value_type->setCurrentIndex(s.type);
+    ui->value_type->setEnabled(current.empty());
+    ui->next_scan->setEnabled(running && !current.empty());
+    ui->amount_found->setText(QString("Found: %1").arg(current.size()));
+
+    for (const saved_address_record &entry : s.saved) {
+        if (entry.type >= VALUE_TYPE_COUNT) {
+            continue;
         }
-        value_cell->setText(QString::number(num));
-        break;
+        int row = saved_model->add(entry.address, static_cast<value_type>(entry.type),
+                                   QString::fromStdString(entry.description),
+                                   QString::fromStdString(entry.locator));
+        if (row < 0) {
+            continue;
+        }
+        // Frozen entries are frozen at the saved value, the rest shows it
+        // until the monitor reads them
+        saved_model->set_value(row, entry.value);
+        if (entry.frozen && running) {
+            saved_model->set_frozen(row, true);
+            toggle_freeze(row, true);
+        }
+    }
+    update_monitor_targets();
+    return true;
+}
+
+void MainWindow::save_session_as() {
+    QString path = QFileDialog::getSaveFileName(this, tr("Save session"), QString(),
+                                                tr("Sessions (*.memsc-session)"));
+    if (path.isEmpty()) {
+        return;
+    }
+    if (scanner->scanning()) {
+        QMessageBox::warning(this, tr("Scan running"),
+                             tr("Wait for the scan to finish before saving."));
+        return;
+    }
+    if (!write_session(path)) {
+        QMessageBox::warning(this, tr("Save failed"), tr("Could not write %1").arg(path));
+    }
+}
+
+void MainWindow::open_session() {
+    QString path = QFileDialog::getOpenFileName(this, tr("Open session"), QString(),
+                                                tr("Sessions (*.memsc-session)"));
+    if (!path.isEmpty()) {
+        read_session(path);
     }
 }
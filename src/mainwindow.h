@@ -1,31 +1,34 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include <QFuture>
 #include <QMainWindow>
-#include <QTableWidget>
+#include <QModelIndex>
 
-#include <unordered_map>
-#include <thread>
-
-struct address_t {
-    /* fuck this shit, the ui can get to decide what the data is currently..
-     * I give up trying to do some bullshit with variants etc */
-    /* TODO: change to std::variant */
-    void *value;
-    /* size to read */
-    size_t size;
-};
+#include <cstdint>
+#include <string>
+#include <vector>
 
+#include "Session.h"
+#include "ValueRecorder.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
 QT_END_NAMESPACE
 
 class ProcessMemory;
+class FreezeService;
+class AttachWatcher;
+class QTimer;
+class MatchTableModel;
+class SavedAddressModel;
+class MemoryMonitor;
+struct monitor_update;
 class QRegularExpressionValidator;
 class MapsDialog;
 class QMenuBar;
 class QMenu;
+struct range_filter;
 
 class MainWindow : public QWidget
 {
@@ -34,47 +37,79 @@ class MainWindow : public QWidget
 public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow() override;
-signals:
-    void value_changed(address_t *segment, int row);
 
+    /** @brief record_scan adds a finished scan to the session history */
+    void record_scan(value_type type, const QString &search_text);
 public slots:
     void handle_next_scan();
     void handle_new_scan();
     void change_validator(int index);
     void save_row(int row, int column);
-    void handle_double_click_saved(int row, int column);
+    void handle_double_click_saved(const QModelIndex &index);
     void delete_window();
-    void saved_address_change(address_t *segment, int row);
+    void toggle_freeze(int row, bool frozen);
+    void seed_matches(std::vector<std::uintptr_t> addresses, std::size_t granularity);
+    void snapshot_values();
     void load_settings();
     void attach_to_process(pid_t pid, const QString name);
+    void save_session_as();
+    void open_session();
 private:
-    enum saved_address_cells {
-        SAVED_ADDRESS_CHECKBOX = 0,
-        SAVED_ADDRESS_DESCRIPTION,
-        SAVED_ADDRESS_ADDRESS,
-        SAVED_ADDRESS_TYPE,
-        SAVED_ADDRESS_VALUE
-    };
-
     Ui::MainWindow *ui;
     QMenuBar    *menubar{};
     QMenu       *filemenu{};
-	QTimer      *value_update_timer{};
+	QThread     *monitor_thread{};
+	MemoryMonitor *monitor{};
 	MapsDialog  *mapsDialog{};
     QRegularExpressionValidator *pos_only;
     QRegularExpressionValidator *pos_neg;
     QRegularExpressionValidator *floating_point;
 
     bool quit = false;
-    std::unordered_map<void *, address_t*> saved_address_values;
-    std::thread saved_address_scanner;
     ProcessMemory *scanner;
+    FreezeService *freezer;
+    AttachWatcher *attach_watcher;
+    bool reattach = true;
+    QTimer *freeze_stats_timer;
+    /** Records a history column every few monitor ticks, see record_history_tick */
+    QTimer *history_timer;
+    int freeze_interval = 1000;
+    bool auto_read_size = true;
+    QFuture<std::size_t> calibration{};
+    /** Attached to another process while calibrating, run again once done */
+    bool recalibrate = false;
+    /** Background save of the last session, see autosave_session */
+    QFuture<bool> autosave{};
+    MatchTableModel *match_model;
+    SavedAddressModel *saved_model;
+    QString process_name{};
+    std::vector<scan_record> scan_history{};
 
     void create_menu();
     void create_connections();
     void show_pid_window();
-    void update_table(QTableWidget *widget, int addr_row, int value_row);
+    void update_monitor_targets();
+    void apply_monitor_updates(const std::vector<monitor_update> &updates);
     void createMapsDialog(pid_t pid);
     void locate_in_maps(uintptr_t ptr);
+    range_filter scan_scope() const;
+    void show_pointer_scan(uintptr_t target);
+    void show_code_references(uintptr_t target);
+    void show_memory_viewer(uintptr_t address);
+    void show_struct_dissector(uintptr_t address);
+    void update_freeze_stats();
+    void record_history_tick();
+    void calibrate_read_size();
+    int add_saved_address(std::uintptr_t address, value_type type, const QString &description,
+                          const QString &locator = QString());
+    void attach(pid_t pid, const QString &name, bool keep_saved);
+    void attach_by_rule(pid_t pid, const QString &comm);
+    void restore_saved(pid_t pid);
+    session current_session() const;
+    std::vector<recorder_channel> recorder_channels() const;
+    bool write_session(const QString &path);
+    void autosave_session();
+    bool read_session(const QString &path);
+    static QString autosave_path();
 };
 #endif // MAINWINDOW_H
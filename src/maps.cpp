@@ -3,13 +3,20 @@
 #include <errno.h>
 #include <string.h>
 
+#include <dirent.h>
+#include <fnmatch.h>
 #include <sys/sysmacros.h>
 
 #include "maps.h"
 
+#include <algorithm>
+#include <cinttypes>
 #include <cstdint>
 #include <cstring>
 #include <memory>
+#include <numeric>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 std::vector<address_range> get_memory_ranges(pid_t pid, bool include_exec) {
@@ -85,6 +92,27 @@ std::vector<address_range> get_memory_ranges(pid_t pid, bool include_exec) {
     return ranges;
 }
 
+std::vector<pid_t> get_threads(pid_t pid) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/task", pid);
+    DIR *dir = opendir(path);
+    if (dir == nullptr) {
+        fprintf(stderr, "Error opening directory %s: %s\n", path, strerror(errno));
+        return {};
+    }
+    std::vector<pid_t> tids;
+    while (dirent *entry = readdir(dir)) {
+        char *end = nullptr;
+        long tid = strtol(entry->d_name, &end, 10);
+        if (end != entry->d_name && *end == '\0') {
+            tids.push_back(static_cast<pid_t>(tid));
+        }
+    }
+    closedir(dir);
+    std::sort(tids.begin(), tids.end());
+    return tids;
+}
+
 size_t get_address_range_list_size(std::vector<address_range> &ranges, bool include_exec) {
     size_t n = 0;
     for(address_range& current : ranges) {
@@ -95,3 +123,210 @@ size_t get_address_range_list_size(std::vector<address_range> &ranges, bool incl
     return n;
 }
 
+
+bool range_filter::matches(const address_range &range) const {
+    unsigned char required = perms_required;
+    if (writable_only) {
+        required |= PERM_WRITE;
+    }
+    if ((range.perms & required) != required || (range.perms & perms_excluded)) {
+        return false;
+    }
+    if (exclude_shared && (range.perms & PERM_SHARED)) {
+        return false;
+    }
+    if (anonymous_only && range.inode != 0) {
+        return false;
+    }
+    if (exclude_device && std::strncmp(range.name, "/dev/", 5) == 0 &&
+        std::strncmp(range.name, "/dev/zero", 9) != 0 &&
+        std::strncmp(range.name, "/dev/shm/", 9) != 0) {
+        return false;
+    }
+
+    auto start = reinterpret_cast<std::uintptr_t>(range.start);
+    if (start >= max_address || start + range.length <= min_address) {
+        return false;
+    }
+
+    if (!name_glob.empty()) {
+        const char *base = std::strrchr(range.name, '/');
+        base = base ? base + 1 : range.name;
+        if (fnmatch(name_glob.c_str(), range.name, 0) != 0 &&
+            fnmatch(name_glob.c_str(), base, 0) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<address_range> apply_range_filter(const std::vector<address_range> &ranges,
+                                              const range_filter &filter) {
+    std::vector<address_range> selected;
+    for (const address_range &range : ranges) {
+        if (!filter.matches(range)) {
+            continue;
+        }
+        address_range clipped = range;
+        auto start = reinterpret_cast<std::uintptr_t>(range.start);
+        auto end = start + range.length;
+        start = std::max(start, filter.min_address);
+        end = std::min(end, filter.max_address);
+        clipped.start = reinterpret_cast<void *>(start);
+        clipped.length = end - start;
+        selected.push_back(clipped);
+    }
+    return selected;
+}
+
+static void eytzinger_fill(const std::vector<std::uintptr_t> &sorted,
+                           std::vector<std::uintptr_t> &eyt,
+                           std::vector<std::uint32_t> &rank,
+                           std::size_t &i, std::size_t k) {
+    if (k >= eyt.size()) {
+        return;
+    }
+    eytzinger_fill(sorted, eyt, rank, i, 2 * k);
+    eyt[k] = sorted[i];
+    rank[k] = static_cast<std::uint32_t>(i++);
+    eytzinger_fill(sorted, eyt, rank, i, 2 * k + 1);
+}
+
+void address_range_index::build(const std::vector<address_range> &ranges) {
+    std::vector<std::uint32_t> order(ranges.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&ranges](auto a, auto b) {
+        return ranges[a].start < ranges[b].start;
+    });
+
+    const std::size_t n = ranges.size();
+    starts_.resize(n);
+    ends_.resize(n);
+    module_base_.resize(n);
+    source_.resize(n);
+    perms_.resize(n);
+    names_.resize(n);
+
+    std::unordered_map<std::string_view, std::uintptr_t> bases;
+    for (std::size_t i = 0; i < n; ++i) {
+        const address_range &cur = ranges[order[i]];
+        starts_[i] = reinterpret_cast<std::uintptr_t>(cur.start);
+        ends_[i] = starts_[i] + cur.length;
+        source_[i] = order[i];
+        perms_[i] = cur.perms;
+        names_[i] = cur.name;
+        // sorted by start, so the first one seen is the lowest
+        if (cur.name[0] != '\0') {
+            bases.try_emplace(cur.name, starts_[i]);
+        }
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+        auto it = bases.find(ranges[order[i]].name);
+        module_base_[i] = it != bases.end() ? it->second : 0;
+        // The .bss past the end of the file is an anonymous rw mapping
+        // right after the module's last one, it goes by the module's name
+        if (i > 0 && names_[i].empty() && starts_[i] == ends_[i - 1] &&
+            (perms_[i] & (PERM_READ | PERM_WRITE)) == (PERM_READ | PERM_WRITE) &&
+            names_[i - 1].starts_with('/')) {
+            names_[i] = names_[i - 1];
+            module_base_[i] = module_base_[i - 1];
+        }
+    }
+
+    eyt_.assign(n + 1, 0);
+    eyt_rank_.assign(n + 1, 0);
+    std::size_t i = 0;
+    eytzinger_fill(starts_, eyt_, eyt_rank_, i, 1);
+}
+
+/**
+ * @brief address_range_index::lookup finds the last range starting at or
+ * before `addr`
+ * @return sorted position of the range or SIZE_MAX
+ */
+std::size_t address_range_index::lookup(std::uintptr_t addr) const {
+    const std::size_t n = starts_.size();
+    const std::uintptr_t *eyt = eyt_.data();
+    std::size_t k = 1;
+    while (k <= n) {
+        // 16 slots ahead is 4 levels down, i.e. one cache line of children
+        __builtin_prefetch(eyt + std::min(16 * k, n));
+        k = 2 * k + (eyt[k] <= addr);
+    }
+    // Strip the trailing right turns to get the first start > addr
+    k >>= __builtin_ffsll(static_cast<long long>(~k));
+    std::size_t upper = k ? eyt_rank_[k] : n;
+    if (upper == 0) {
+        return SIZE_MAX;
+    }
+    return upper - 1;
+}
+
+std::ptrdiff_t address_range_index::find(std::uintptr_t addr) const {
+    std::size_t pos = lookup(addr);
+    if (pos == SIZE_MAX || addr >= ends_[pos]) {
+        return npos;
+    }
+    return source_[pos];
+}
+
+bool address_range_index::is_valid_pointer(std::uintptr_t addr,
+                                           unsigned char perms) const {
+    std::size_t pos = lookup(addr);
+    return pos != SIZE_MAX && addr < ends_[pos] &&
+           (perms_[pos] & perms) == perms;
+}
+
+std::uintptr_t address_range_index::module_base(std::uintptr_t addr) const {
+    std::size_t pos = lookup(addr);
+    if (pos == SIZE_MAX || addr >= ends_[pos]) {
+        return 0;
+    }
+    return module_base_[pos];
+}
+
+bool address_range_index::is_static(std::uintptr_t addr) const {
+    std::size_t pos = lookup(addr);
+    return pos != SIZE_MAX && addr < ends_[pos] && names_[pos].starts_with('/');
+}
+
+const std::string *address_range_index::name(std::uintptr_t addr) const {
+    std::size_t pos = lookup(addr);
+    if (pos == SIZE_MAX || addr >= ends_[pos]) {
+        return nullptr;
+    }
+    return &names_[pos];
+}
+
+std::uintptr_t address_range_index::base_of(const std::string &name) const {
+    for (std::size_t i = 0; i < names_.size(); ++i) {
+        const std::string &cur = names_[i];
+        if (cur == name) {
+            return module_base_[i];
+        }
+        std::size_t slash = cur.find_last_of('/');
+        if (slash != std::string::npos &&
+            cur.compare(slash + 1, std::string::npos, name) == 0) {
+            return module_base_[i];
+        }
+    }
+    return 0;
+}
+
+std::string address_range_index::label(std::uintptr_t addr) const {
+    char buf[64];
+    std::size_t pos = lookup(addr);
+    if (pos == SIZE_MAX || addr >= ends_[pos] || module_base_[pos] == 0) {
+        snprintf(buf, sizeof(buf), "0x%" PRIxPTR, addr);
+        return buf;
+    }
+
+    std::string label = basename_of(names_[pos]);
+    snprintf(buf, sizeof(buf), "+0x%" PRIxPTR, addr - module_base_[pos]);
+    return label + buf;
+}
+
+std::string basename_of(const std::string &name) {
+    std::size_t slash = name.find_last_of('/');
+    return slash == std::string::npos ? name : name.substr(slash + 1);
+}
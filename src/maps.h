@@ -1,6 +1,10 @@
 #ifndef MAPS_H
 #define MAPS_H
 
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
 #include <vector>
 #include <linux/limits.h>
 #include <sys/types.h>
@@ -57,4 +61,180 @@ struct address_range {
 std::vector<address_range> get_memory_ranges(pid_t pid, bool include_exec);
 size_t get_address_range_list_size(std::vector<address_range> &ranges, bool include_exec);
 
+/** @brief basename_of strips the directories off a mapping name */
+std::string basename_of(const std::string &name);
+
+/**
+ * @brief get_threads lists the thread ids in /proc/<pid>/task, sorted
+ */
+std::vector<pid_t> get_threads(pid_t pid);
+
+/**
+ * Describes which parts of the address space a scan should touch. The
+ * defaults scan every readable non-exec range except device mappings, which
+ * the scanner used to read as well.
+ */
+struct range_filter {
+    /** Permission bits a range must have */
+    unsigned char                   perms_required = PERM_READ;
+
+    /** Permission bits a range must not have */
+    unsigned char                   perms_excluded = PERM_EXECUTE;
+
+    /** Shorthand for requiring PERM_WRITE */
+    bool                            writable_only = false;
+
+    /** Only ranges not backed by a file, e.g. [heap] or malloc arenas */
+    bool                            anonymous_only = false;
+
+    /** Skip MAP_SHARED ranges, writes to these are usually not ours */
+    bool                            exclude_shared = false;
+
+    /**
+     * Skip ranges mapped from /dev, reading those may have side effects.
+     * /dev/zero and /dev/shm are plain memory and always scanned.
+     */
+    bool                            exclude_device = true;
+
+    /**
+     * fnmatch(3) pattern matched against both the full name and the basename
+     * of the range, empty matches everything
+     */
+    std::string                     name_glob{};
+
+    /** Address window [min_address, max_address), ranges are clipped to it */
+    std::uintptr_t                  min_address = 0;
+    std::uintptr_t                  max_address = UINTPTR_MAX;
+
+    bool matches(const address_range &range) const;
+};
+
+/**
+ * @brief apply_range_filter selects the ranges matching `filter`, clipping
+ * them to its address window
+ */
+std::vector<address_range> apply_range_filter(const std::vector<address_range> &ranges,
+                                              const range_filter &filter);
+
+/**
+ * Sorted interval index over a snapshot of address ranges.
+ *
+ * Range starts are stored in Eytzinger (BFS) order so that the binary search
+ * walks the array front to back and every level can be prefetched, which is
+ * noticeably faster than std::upper_bound once the maps no longer fit in L1.
+ * Lookups return the position of the range in the vector the index was built
+ * from, so callers can keep using their own row numbering.
+ */
+class address_range_index {
+    /** Sorted range starts in Eytzinger order, 1-based, eyt_[0] unused */
+    std::vector<std::uintptr_t> eyt_{};
+    /** Sorted position of each Eytzinger slot */
+    std::vector<std::uint32_t>  eyt_rank_{};
+
+    /** The following are indexed by sorted position */
+    std::vector<std::uintptr_t> starts_{};
+    std::vector<std::uintptr_t> ends_{};
+    std::vector<std::uintptr_t> module_base_{};
+    std::vector<std::uint32_t>  source_{};
+    std::vector<unsigned char>  perms_{};
+    std::vector<std::string>    names_{};
+
+    std::size_t lookup(std::uintptr_t addr) const;
+
+public:
+    static constexpr std::ptrdiff_t npos = -1;
+
+    address_range_index() = default;
+    explicit address_range_index(const std::vector<address_range> &ranges) {
+        build(ranges);
+    }
+
+    /**
+     * @brief build (re)creates the index from a maps snapshot
+     * @param ranges snapshot, may be unsorted but must not overlap
+     */
+    void build(const std::vector<address_range> &ranges);
+
+    std::size_t size() const {
+        return starts_.size();
+    }
+
+    bool empty() const {
+        return starts_.empty();
+    }
+
+    /**
+     * @brief find looks up the range containing `addr`
+     * @return index into the vector given to build() or npos
+     */
+    std::ptrdiff_t find(std::uintptr_t addr) const;
+
+    std::ptrdiff_t find(const void *addr) const {
+        return find(reinterpret_cast<std::uintptr_t>(addr));
+    }
+
+    /**
+     * @brief is_valid_pointer checks if `addr` points into a mapping that has
+     * all of the permission bits in `perms` set
+     */
+    bool is_valid_pointer(std::uintptr_t addr,
+                          unsigned char perms = PERM_READ) const;
+
+    /**
+     * @brief module_base returns the lowest start address of all the ranges
+     * mapped from the same file as the range containing `addr`, or 0 if the
+     * address is not in a named mapping. An anonymous rw range directly
+     * after a file mapping is that module's .bss and belongs to it.
+     */
+    std::uintptr_t module_base(std::uintptr_t addr) const;
+
+    /**
+     * @brief is_static checks if `addr` is inside a mapping backed by a file
+     * or its .bss, these are the same on every run of the program relative to
+     * their base
+     */
+    bool is_static(std::uintptr_t addr) const;
+
+    /**
+     * @brief name returns the name of the mapping containing `addr`, the
+     * module's for its .bss, or nullptr if there is none
+     */
+    const std::string *name(std::uintptr_t addr) const;
+
+    /**
+     * @brief base_of returns the lowest start address of the mappings named
+     * `name`, either the full path or the basename, or 0 if not mapped
+     */
+    std::uintptr_t base_of(const std::string &name) const;
+
+    /** Lowest mapped address, 0 if empty */
+    std::uintptr_t lowest() const {
+        return starts_.empty() ? 0 : starts_.front();
+    }
+
+    /** One past the highest mapped address, 0 if empty */
+    std::uintptr_t highest() const {
+        return ends_.empty() ? 0 : *std::max_element(ends_.begin(), ends_.end());
+    }
+
+    /**
+     * @brief label formats `addr` relative to the module it is in, for
+     * example "libfoo.so+0x1234" or "[heap]+0x10". Anonymous mappings and
+     * unmapped addresses are formatted as plain hex.
+     */
+    std::string label(std::uintptr_t addr) const;
+};
+
+/**
+ * A /proc/<pid>/maps snapshot together with its lookup index, shared between
+ * the scanner and the ui so that both agree on what a match belongs to.
+ */
+struct maps_snapshot {
+    std::vector<address_range>  ranges;
+    address_range_index         index;
+
+    explicit maps_snapshot(std::vector<address_range> r)
+        : ranges(std::move(r)), index(ranges) {}
+};
+
 #endif /* MAPS_H */
@@ -0,0 +1,51 @@
+#include "ui/AddressListModel.h"
+
+#include <algorithm>
+#include <climits>
+
+AddressListModel::AddressListModel(QObject *parent) : QAbstractListModel(parent) {}
+
+int AddressListModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : rows_;
+}
+
+QVariant AddressListModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= rows_) {
+        return {};
+    }
+    const std::uintptr_t address = addresses_[static_cast<std::size_t>(index.row())];
+    switch (role) {
+    case Qt::DisplayRole:
+        return QString("0x%1").arg(address, 0, 16);
+    case Qt::UserRole:
+        return qulonglong(address);
+    default:
+        return {};
+    }
+}
+
+bool AddressListModel::canFetchMore(const QModelIndex &parent) const {
+    // A QModelIndex row is an int, anything past that is never shown
+    return !parent.isValid() &&
+           static_cast<std::size_t>(rows_) < std::min<std::size_t>(addresses_.size(), INT_MAX);
+}
+
+void AddressListModel::fetchMore(const QModelIndex &parent) {
+    if (!canFetchMore(parent)) {
+        return;
+    }
+    const std::size_t limit = std::min<std::size_t>(addresses_.size(), INT_MAX);
+    const int count = static_cast<int>(
+        std::min<std::size_t>(fetch_rows, limit - static_cast<std::size_t>(rows_)));
+    beginInsertRows(QModelIndex(), rows_, rows_ + count - 1);
+    rows_ += count;
+    endInsertRows();
+}
+
+void AddressListModel::setAddresses(std::vector<std::uintptr_t> addresses) {
+    beginResetModel();
+    addresses_ = std::move(addresses);
+    rows_ = 0;
+    endResetModel();
+    fetchMore(QModelIndex());
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QAbstractListModel>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * List model over a vector of addresses, such as search results that can
+ * run into millions. Rows are handed to the view one batch at a time as it
+ * scrolls, so nothing is created per address up front.
+ */
+class AddressListModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    /** Rows added by one fetchMore */
+    static constexpr int fetch_rows = 1024;
+
+    explicit AddressListModel(QObject *parent = nullptr);
+    ~AddressListModel() override = default;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    /** Qt::UserRole holds the address as a qulonglong */
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    void setAddresses(std::vector<std::uintptr_t> addresses);
+
+    std::size_t size() const {
+        return addresses_.size();
+    }
+
+private:
+    std::vector<std::uintptr_t> addresses_{};
+    /** Rows the view knows about so far */
+    int rows_ = 0;
+};
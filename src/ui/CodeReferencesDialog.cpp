@@ -0,0 +1,157 @@
+#include "ui/CodeReferencesDialog.h"
+#include "ProcessMemory.h"
+#include "ui/Disassembly.h"
+
+#include <QFormLayout>
+#include <QFutureWatcher>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMessageBox>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+#include <QtConcurrent/QtConcurrent>
+
+CodeReferencesDialog::CodeReferencesDialog(ProcessMemory &scanner, uintptr_t target,
+                                           QWidget *parent)
+    : QDialog(parent),
+      scanner_(scanner),
+      targetEdit_(new QLineEdit(this)),
+      sizeEdit_(new QLineEdit(this)),
+      scanButton_(new QPushButton(tr("Scan"), this)),
+      progress_(new QProgressBar(this)),
+      status_(new QLabel(this)),
+      tree_(new QTreeWidget(this))
+{
+    setWindowTitle(tr("Code references"));
+    resize(800, 500);
+
+    if (target != 0) {
+        targetEdit_->setText(QString("0x%1").arg(target, 0, 16));
+    }
+    targetEdit_->setPlaceholderText("e.g. 0x55d1c2a04010");
+    sizeEdit_->setText("1");
+    sizeEdit_->setToolTip(tr("Size of the window starting at the address, "
+                             "e.g. the size of a struct to find all of its fields"));
+    progress_->setRange(0, 100);
+
+    auto *form = new QFormLayout();
+    form->addRow(tr("Address:"), targetEdit_);
+    form->addRow(tr("Size:"), sizeEdit_);
+
+    auto *buttons = new QHBoxLayout();
+    buttons->addWidget(scanButton_);
+    buttons->addWidget(progress_);
+
+    QFont monoFont("Courier New");
+    monoFont.setStyleHint(QFont::Monospace);
+    tree_->setFont(monoFont);
+    tree_->setColumnCount(3);
+    tree_->setHeaderLabels({tr("Location"), tr("Instruction"), tr("Target")});
+    tree_->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    tree_->header()->setStretchLastSection(true);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addLayout(form);
+    layout->addLayout(buttons);
+    layout->addWidget(status_);
+    layout->addWidget(tree_);
+    setLayout(layout);
+
+    connect(scanButton_, &QPushButton::clicked, this, &CodeReferencesDialog::startScan);
+    connect(tree_, &QTreeWidget::itemDoubleClicked, this,
+            [this](QTreeWidgetItem *item, int) { showInDisassembler(item); });
+
+    if (target != 0) {
+        startScan();
+    }
+}
+
+CodeReferencesDialog::~CodeReferencesDialog() {
+    // The scan refers to the dialog for progress updates
+    future_.waitForFinished();
+}
+
+void CodeReferencesDialog::startScan() {
+    bool ok = false;
+    uintptr_t target = targetEdit_->text().trimmed().toULongLong(&ok, 16);
+    if (!ok) {
+        QMessageBox::warning(this, tr("Invalid Address"),
+                             tr("Could not parse the given address."));
+        return;
+    }
+    uintptr_t size = sizeEdit_->text().trimmed().toULongLong(&ok, 0);
+    if (!ok || size == 0) {
+        QMessageBox::warning(this, tr("Invalid Size"),
+                             tr("Could not parse the given size."));
+        return;
+    }
+
+    scanButton_->setEnabled(false);
+    progress_->setValue(0);
+    status_->setText(tr("Scanning executable mappings..."));
+    future_ = QtConcurrent::run([this, target, size] {
+        auto maps = scanner_.refresh_maps();
+        return find_code_references(scanner_.pid(), *maps, target, target + size - 1,
+                                    [this](size_t current, size_t total) {
+            QMetaObject::invokeMethod(progress_, [this, current, total] {
+                progress_->setValue(int(double(current) / double(total) * 100));
+            }, Qt::QueuedConnection);
+        });
+    });
+
+    auto *watcher = new QFutureWatcher<std::vector<code_reference>>(this);
+    connect(watcher, &QFutureWatcher<std::vector<code_reference>>::finished, this,
+            [this, watcher] {
+        showResults(watcher->result());
+        scanButton_->setEnabled(true);
+        watcher->deleteLater();
+    });
+    watcher->setFuture(future_);
+}
+
+void CodeReferencesDialog::showResults(const std::vector<code_reference> &refs) {
+    tree_->clear();
+    QTreeWidgetItem *module = nullptr;
+    QTreeWidgetItem *function = nullptr;
+    for (const code_reference &ref : refs) {
+        const QString moduleName = ref.module.empty() ? tr("[anonymous]")
+                                                      : QString::fromStdString(ref.module);
+        if (module == nullptr || module->text(0) != moduleName) {
+            module = new QTreeWidgetItem(tree_, {moduleName});
+            function = nullptr;
+        }
+        // Only the name, not the offset into the function
+        QString functionName = QString::fromStdString(ref.function);
+        if (qsizetype plus = functionName.lastIndexOf("+0x"); plus >= 0) {
+            functionName.truncate(plus);
+        }
+        if (functionName.isEmpty()) {
+            functionName = tr("[unknown]");
+        }
+        if (function == nullptr || function->text(0) != functionName) {
+            function = new QTreeWidgetItem(module, {functionName});
+        }
+        auto *item = new QTreeWidgetItem(function, {
+            QString("0x%1").arg(ref.from, 0, 16),
+            QString::fromStdString(ref.text),
+            QString("0x%1").arg(ref.target, 0, 16),
+        });
+        item->setData(0, Qt::UserRole, qulonglong(ref.from));
+    }
+    tree_->expandAll();
+    status_->setText(tr("%n reference(s)", nullptr, int(refs.size())));
+}
+
+void CodeReferencesDialog::showInDisassembler(QTreeWidgetItem *item) {
+    QVariant from = item->data(0, Qt::UserRole);
+    if (!from.isValid()) {
+        return;
+    }
+    auto *disassembler = new Disassembly(scanner_.pid(), from.value<qulonglong>());
+    disassembler->setAttribute(Qt::WA_DeleteOnClose);
+    disassembler->show();
+}
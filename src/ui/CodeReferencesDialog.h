@@ -0,0 +1,47 @@
+#pragma once
+
+#include <QDialog>
+#include <QFuture>
+#include <cstdint>
+#include <vector>
+
+#include "CodeReferences.h"
+
+class ProcessMemory;
+class QLineEdit;
+class QPushButton;
+class QProgressBar;
+class QTreeWidget;
+class QTreeWidgetItem;
+class QLabel;
+
+/**
+ * Finds the code accessing an address or address window through rip
+ * relative operands, grouped by module and function. Double clicking an
+ * instruction opens the disassembler at it.
+ */
+class CodeReferencesDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    CodeReferencesDialog(ProcessMemory &scanner, uintptr_t target,
+                         QWidget *parent = nullptr);
+    ~CodeReferencesDialog() override;
+
+private slots:
+    void startScan();
+    void showInDisassembler(QTreeWidgetItem *item);
+
+private:
+    ProcessMemory                       &scanner_;
+    QLineEdit                           *targetEdit_;
+    QLineEdit                           *sizeEdit_;
+    QPushButton                         *scanButton_;
+    QProgressBar                        *progress_;
+    QLabel                              *status_;
+    QTreeWidget                         *tree_;
+    QFuture<std::vector<code_reference>> future_{};
+
+    void showResults(const std::vector<code_reference> &refs);
+};
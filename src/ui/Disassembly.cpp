@@ -1,75 +1,251 @@
 #include "ui/Disassembly.h"
-#include "ProcessMemory.h"
-#include "capstone/capstone.h"
-#include "maps.h"
+#include "ui/AddressListModel.h"
+#include "ui/DisassemblyModel.h"
 
 #include <algorithm>
 
-#include <QTableWidget>
-#include <QVBoxLayout>
-#include <QWidget>
+#include <QDockWidget>
+#include <QFutureWatcher>
 #include <QHeaderView>
-#include <memory>
+#include <QInputDialog>
+#include <QListView>
+#include <QMenu>
+#include <QMessageBox>
+#include <QScrollBar>
+#include <QStatusBar>
+#include <QTableView>
+#include <QWidget>
+#include <QtConcurrent/QtConcurrent>
+#include <vector>
 
-Disassembly::Disassembly(pid_t pid, QWidget *parent) : QMainWindow(parent),
-    disassembly(new QTableWidget(this)),
+Disassembly::Disassembly(pid_t pid, uintptr_t address, QWidget *parent) : QMainWindow(parent),
+    disassembly(new QTableView(this)),
+    model(new DisassemblyModel(pid, this)),
     pid(pid)
 {
-    if (cs_open(CS_ARCH_X86, CS_MODE_64, &handle) != CS_ERR_OK) {
-        close();
-    }
     QFont monoFont("Courier New");  // Or use "Monospace", "Courier", etc.
     monoFont.setStyleHint(QFont::Monospace);
     disassembly->setFont(monoFont);
 
     setWindowTitle("Disassembler");
-    disassembly->setColumnCount(3);
-    disassembly->setHorizontalHeaderLabels(
-        {"Address", "Disassembly", "Comments"});
+    disassembly->setModel(model);
     disassembly->horizontalHeader()->
         setSectionResizeMode(QHeaderView::Stretch);
     disassembly->horizontalHeader()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
     disassembly->verticalHeader()->setVisible(false);
+    // Fixed row heights so the view never asks for every row to measure it
+    disassembly->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    disassembly->verticalHeader()->setDefaultSectionSize(
+        disassembly->fontMetrics().height() + 4);
     disassembly->setShowGrid(false);
+    disassembly->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    disassembly->setSelectionBehavior(QAbstractItemView::SelectRows);
+    disassembly->setContextMenuPolicy(Qt::CustomContextMenu);
+    connect(disassembly, &QTableView::customContextMenuRequested, this,
+            [this](const QPoint &pos) {
+        QMenu menu(this);
+        QAction *nop = menu.addAction(tr("Replace with NOPs"));
+        QAction *undo = menu.addAction(tr("Undo last patch"));
+        QAction *revert = menu.addAction(tr("Revert all patches"));
+        menu.addSeparator();
+        QAction *references = menu.addAction(tr("Find references to address..."));
+        QAction *instructions = menu.addAction(tr("Find instruction..."));
+        undo->setEnabled(!patches.empty());
+        revert->setEnabled(!patches.empty());
+        connect(nop, &QAction::triggered, this, &Disassembly::nop_selection);
+        connect(undo, &QAction::triggered, this, &Disassembly::undo_patch);
+        connect(revert, &QAction::triggered, this, &Disassembly::revert_patches);
+        connect(references, &QAction::triggered, this, &Disassembly::find_references);
+        connect(instructions, &QAction::triggered, this, &Disassembly::find_instructions);
+        menu.exec(disassembly->viewport()->mapToGlobal(pos));
+    });
+
+    // The view fetches more rows at the bottom by itself, the pages above
+    // the window are loaded when scrolling hits the top
+    QScrollBar *scroll = disassembly->verticalScrollBar();
+    connect(scroll, &QScrollBar::valueChanged, this, [this, scroll](int value) {
+        if (value != scroll->minimum()) {
+            return;
+        }
+        int added = model->fetchPrevious();
+        if (added > 0) {
+            scroll->setValue(value + added);
+        }
+    });
+
+    resultsModel = new AddressListModel(this);
+    results = new QListView(this);
+    results->setFont(monoFont);
+    results->setUniformItemSizes(true);
+    results->setModel(resultsModel);
+    connect(results, &QListView::doubleClicked, this, [this](const QModelIndex &item) {
+        gotoAddress(item.data(Qt::UserRole).value<qulonglong>());
+    });
+    resultsDock = new QDockWidget(tr("Results"), this);
+    resultsDock->setWidget(results);
+    addDockWidget(Qt::RightDockWidgetArea, resultsDock);
+    resultsDock->hide();
 
     setCentralWidget(disassembly);
     resize(1024, 800);
-    disassemble(0);
+    disassemble(address);
+}
+
+Disassembly::~Disassembly() = default;
+
+void Disassembly::disassemble(uintptr_t address) {
+    int row = model->seek(address);
+    if (row >= 0) {
+        disassembly->selectRow(row);
+        disassembly->scrollTo(model->index(row, 0), QAbstractItemView::PositionAtCenter);
+    }
 }
 
-Disassembly::~Disassembly() {
-    cs_close(&handle);
+void Disassembly::gotoAddress(uintptr_t addr) {
+    int row = model->rowOf(addr);
+    if (row < 0) {
+        disassemble(addr);
+        return;
+    }
+    disassembly->selectRow(row);
+    disassembly->scrollTo(model->index(row, 0), QAbstractItemView::PositionAtCenter);
 }
 
-void Disassembly::disassemble(std::size_t offset) {
-    auto maps = get_memory_ranges(pid, true);
-    // Remove non-executable sections
-    maps.erase(std::remove_if(maps.begin(), maps.end(), [](auto &entry)
-                   { return !(entry.perms & PERM_EXECUTE); }));
-
-    std::uint64_t row = 0;
-    for (auto &map : maps) {
-        std::unique_ptr<std::uint8_t[]> buf =
-            std::make_unique<std::uint8_t[]>(map.length);
-        ProcessMemory::read_process_memory_nosplit(pid, map.start,
-                                                   buf.get(), map.length);
-        cs_insn *ins;
-        std::size_t count =
-            cs_disasm(handle, buf.get(), map.length, (uint64_t)map.start, 0, &ins);
-
-        disassembly->setRowCount(count + row);
-        if (count > 0) {
-            for (std::size_t i = 0; i < count; i++) {
-                QTableWidgetItem *addr = new QTableWidgetItem(
-                    "0x" + QString::number(ins[i].address, 16));
-                QString str = QString(ins[i].mnemonic) % QString(" ") %
-                    QString(ins[i].op_str);
-                QTableWidgetItem *op = new QTableWidgetItem(str);
-                disassembly->setItem(row, 0, addr);
-                disassembly->setItem(row, 1, op);
-                row++;
-            }
-            free(ins);
-        };
+/**
+ * @brief Disassembly::nop_selection overwrites every selected instruction
+ * with NOPs, the selection is applied as one patch set
+ */
+void Disassembly::nop_selection() {
+    PatchSet set{pid};
+    for (const QModelIndex &index : disassembly->selectionModel()->selectedRows()) {
+        DisassemblyModel::instruction ins = model->at(index.row());
+        if (ins.size == 0) {
+            continue;
+        }
+        std::vector<std::uint8_t> nops(ins.size, 0x90);
+        set.add(reinterpret_cast<void *>(ins.address), nops.data(), nops.size());
+    }
+    if (set.empty()) {
+        return;
+    }
+    if (!set.apply()) {
+        QMessageBox::warning(this, tr("Patch failed"),
+                             tr("Could not write to the process, nothing was changed"));
+        return;
+    }
+    for (const patch &p : set.patches()) {
+        auto address = reinterpret_cast<std::uintptr_t>(p.address);
+        model->invalidate(address, p.bytes.size());
+        model->setComment(address, tr("patched: nop"));
+    }
+    patches.push_back(std::move(set));
+}
+
+void Disassembly::undo_patch() {
+    if (patches.empty()) {
+        return;
+    }
+    if (!patches.back().revert()) {
+        QMessageBox::warning(this, tr("Revert failed"),
+                             tr("Could not restore the original bytes"));
+        return;
+    }
+    for (const patch &p : patches.back().patches()) {
+        auto address = reinterpret_cast<std::uintptr_t>(p.address);
+        model->invalidate(address, p.bytes.size());
+        model->clearComment(address);
     }
+    patches.pop_back();
+}
+
+void Disassembly::revert_patches() {
+    while (!patches.empty()) {
+        std::size_t count = patches.size();
+        undo_patch();
+        if (patches.size() == count) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Disassembly::with_index builds the instruction index in the
+ * background the first time, patches made afterwards aren't reflected in it
+ */
+void Disassembly::with_index(std::function<void()> then) {
+    if (index) {
+        then();
+        return;
+    }
+    pending.push_back(std::move(then));
+    if (indexing) {
+        return;
+    }
+    indexing = true;
+    statusBar()->showMessage(tr("Indexing executable mappings..."));
+    auto *watcher = new QFutureWatcher<std::shared_ptr<const instruction_index>>(this);
+    connect(watcher, &QFutureWatcher<std::shared_ptr<const instruction_index>>::finished, this,
+            [this, watcher] {
+        index = watcher->result();
+        indexing = false;
+        statusBar()->showMessage(tr("Indexed %1 instructions (%2 MiB)")
+                                     .arg(index->size())
+                                     .arg(double(index->memory_usage()) / (1024 * 1024), 0, 'f', 1));
+        auto callbacks = std::move(pending);
+        pending.clear();
+        for (auto &f : callbacks) {
+            f();
+        }
+        watcher->deleteLater();
+    });
+    watcher->setFuture(QtConcurrent::run([pid = pid] {
+        maps_snapshot maps{get_memory_ranges(pid, true)};
+        return std::make_shared<const instruction_index>(instruction_index::build(pid, maps));
+    }));
+}
+
+void Disassembly::find_references() {
+    bool ok = false;
+    QString text = QInputDialog::getText(this, tr("Find references"), tr("Address (hex):"),
+                                         QLineEdit::Normal, {}, &ok);
+    if (!ok) {
+        return;
+    }
+    uintptr_t target = text.trimmed().toULongLong(&ok, 16);
+    if (!ok) {
+        QMessageBox::warning(this, tr("Invalid Address"),
+                             tr("Could not parse the given address."));
+        return;
+    }
+    with_index([this, target] {
+        std::vector<uintptr_t> from;
+        for (const instruction_reference &ref : index->references_to(target)) {
+            from.push_back(ref.from);
+        }
+        show_results(tr("References to 0x%1").arg(target, 0, 16), std::move(from));
+    });
+}
+
+void Disassembly::find_instructions() {
+    bool ok = false;
+    QString text = QInputDialog::getText(this, tr("Find instruction"), tr("Mnemonic:"),
+                                         QLineEdit::Normal, {}, &ok);
+    if (!ok || text.trimmed().isEmpty()) {
+        return;
+    }
+    unsigned id = instruction_index::instruction_id(text.trimmed().toLower().toStdString());
+    if (id == 0) {
+        QMessageBox::warning(this, tr("Unknown Instruction"),
+                             tr("%1 is not an x86 mnemonic.").arg(text.trimmed()));
+        return;
+    }
+    with_index([this, id, text] {
+        show_results(text.trimmed(), index->find_instructions(id));
+    });
+}
+
+void Disassembly::show_results(const QString &title, std::vector<uintptr_t> addresses) {
+    resultsDock->setWindowTitle(tr("%1 (%2)").arg(title).arg(addresses.size()));
+    resultsModel->setAddresses(std::move(addresses));
+    resultsDock->show();
 }
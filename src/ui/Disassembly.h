@@ -3,19 +3,54 @@
 #include <QMainWindow>
 #include <QWidget>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <sys/types.h>
-#include <capstone/capstone.h>
+#include <vector>
+
+#include "InstructionIndex.h"
+#include "PatchSet.h"
+
+class QDockWidget;
+class QListView;
+class QTableView;
+class AddressListModel;
+class DisassemblyModel;
 
-class QTableWidget;
 class Disassembly : public QMainWindow {
-    QTableWidget *disassembly{};
+    QTableView *disassembly{};
+    DisassemblyModel *model{};
     pid_t pid{};
-    csh handle;
+    /** Applied patch sets, newest last */
+    std::vector<PatchSet> patches{};
+    /** Built the first time a search needs it */
+    std::shared_ptr<const instruction_index> index{};
+    bool indexing{};
+    std::vector<std::function<void()>> pending{};
+    QListView *results{};
+    AddressListModel *resultsModel{};
+    QDockWidget *resultsDock{};
 
 public:
-    Disassembly(pid_t pid, QWidget *parent = nullptr);
+    /**
+     * @param address where to start, 0 for the first executable mapping
+     */
+    Disassembly(pid_t pid, uintptr_t address = 0, QWidget *parent = nullptr);
     ~Disassembly();
 
+    /** Selects and scrolls to the instruction containing `addr` */
+    void gotoAddress(uintptr_t addr);
+
 protected:
-    void disassemble(std::size_t offset);
+    void disassemble(uintptr_t address);
+    void nop_selection();
+    void undo_patch();
+    void revert_patches();
+    void find_references();
+    void find_instructions();
+
+    /** Runs `then` once the instruction index is available */
+    void with_index(std::function<void()> then);
+    void show_results(const QString &title, std::vector<uintptr_t> addresses);
 };
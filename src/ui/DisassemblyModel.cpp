@@ -0,0 +1,347 @@
+#include "ui/DisassemblyModel.h"
+#include "ProcessMemory.h"
+
+#include <algorithm>
+#include <unistd.h>
+
+DisassemblyModel::DisassemblyModel(pid_t pid, QObject *parent)
+    : QAbstractTableModel(parent),
+      pid_(pid),
+      page_size_(static_cast<std::size_t>(sysconf(_SC_PAGESIZE)))
+{
+    ranges_ = get_memory_ranges(pid, true);
+    std::erase_if(ranges_, [](const address_range &range) {
+        return !(range.perms & PERM_EXECUTE);
+    });
+    seek(0);
+}
+
+int DisassemblyModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : rows_;
+}
+
+int DisassemblyModel::columnCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : COLUMN_COUNT;
+}
+
+QVariant DisassemblyModel::headerData(int section, Qt::Orientation orientation,
+                                      int role) const {
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal) {
+        return {};
+    }
+    switch (section) {
+    case COLUMN_ADDRESS:
+        return tr("Address");
+    case COLUMN_INSTRUCTION:
+        return tr("Disassembly");
+    case COLUMN_COMMENT:
+        return tr("Comments");
+    default:
+        return {};
+    }
+}
+
+QVariant DisassemblyModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= rows_ || role != Qt::DisplayRole) {
+        return {};
+    }
+    const window_page &wp = window_[std::size_t(window_index(index.row()))];
+    auto decoded = decode(wp.page, wp.entry);
+    const std::size_t i = std::size_t(index.row() - wp.first_row);
+    if (i >= decoded->offsets.size()) {
+        return {};
+    }
+    const std::uintptr_t address = wp.page + decoded->offsets[i];
+
+    switch (index.column()) {
+    case COLUMN_ADDRESS:
+        return "0x" + QString::number(address, 16);
+    case COLUMN_INSTRUCTION:
+        return decoded->text[i];
+    case COLUMN_COMMENT: {
+        auto it = comments_.find(address);
+        return it == comments_.end() ? QVariant{} : QVariant{it->second};
+    }
+    default:
+        return {};
+    }
+}
+
+/**
+ * @brief DisassemblyModel::decode disassembles one page starting `entry`
+ * bytes in, instructions running into the next page are completed from it
+ */
+std::shared_ptr<const DisassemblyModel::decoded_page>
+DisassemblyModel::decode(std::uintptr_t page, std::uint16_t entry) const {
+    auto it = cache_.find(page);
+    if (it != cache_.end() && (it->second->offsets.empty() ||
+                               it->second->offsets.front() == entry)) {
+        return it->second;
+    }
+    if (cache_.size() >= max_pages) {
+        cache_.clear();
+    }
+
+    // Read up to one instruction into the next page separately so an
+    // unmapped next page doesn't fail this one
+    constexpr std::size_t tail = max_instruction;
+    std::vector<std::uint8_t> buf(page_size_ + tail, 0);
+    ReadRequest requests[] = {
+        {reinterpret_cast<void *>(page), buf.data(), page_size_},
+        {reinterpret_cast<void *>(page + page_size_), buf.data() + page_size_, tail},
+    };
+    ProcessMemory::read_many(pid_, requests);
+    const std::size_t available = requests[1].result > 0 ? buf.size() : page_size_;
+
+    auto decoded = std::make_shared<decoded_page>();
+    decoded->overrun = 0;
+    if (requests[0].result < 0 || !capstone_.ok) {
+        decoded->offsets.push_back(entry);
+        decoded->sizes.push_back(0);
+        decoded->text.push_back(tr("(unreadable)"));
+        cache_[page] = decoded;
+        return decoded;
+    }
+
+    cs_insn *insn = capstone_.insn;
+    std::size_t offset = entry;
+    while (offset < page_size_) {
+        const std::uint8_t *code = buf.data() + offset;
+        std::size_t size = available - offset;
+        std::uint64_t address = page + offset;
+        std::size_t length = 1;
+        if (cs_disasm_iter(capstone_.handle, &code, &size, &address, insn)) {
+            length = insn->size;
+            decoded->text.push_back(QString(insn->mnemonic) + " " + QString(insn->op_str));
+        } else {
+            // Not an instruction, show the byte and resync on the next one
+            decoded->text.push_back(QString("db 0x%1").arg(uint(buf[offset]), 2, 16, QChar('0')));
+        }
+        decoded->offsets.push_back(static_cast<std::uint16_t>(offset));
+        decoded->sizes.push_back(static_cast<std::uint8_t>(length));
+        offset += length;
+    }
+    decoded->overrun = static_cast<std::uint16_t>(offset - page_size_);
+    cache_[page] = decoded;
+    return decoded;
+}
+
+std::uintptr_t DisassemblyModel::next_page(std::uintptr_t page) const {
+    const std::uintptr_t next = page + page_size_;
+    for (const address_range &range : ranges_) {
+        auto start = reinterpret_cast<std::uintptr_t>(range.start);
+        if (next < start + range.length) {
+            return std::max(next, start);
+        }
+    }
+    return 0;
+}
+
+std::uintptr_t DisassemblyModel::previous_page(std::uintptr_t page) const {
+    for (auto it = ranges_.rbegin(); it != ranges_.rend(); ++it) {
+        auto start = reinterpret_cast<std::uintptr_t>(it->start);
+        if (start < page) {
+            return std::min(page - page_size_, start + it->length - page_size_);
+        }
+    }
+    return 0;
+}
+
+DisassemblyModel::window_page DisassemblyModel::make_page(std::uintptr_t page,
+                                                          std::uint16_t entry,
+                                                          int first_row) const {
+    auto decoded = decode(page, entry);
+    return {page, entry, first_row, static_cast<int>(decoded->offsets.size())};
+}
+
+int DisassemblyModel::window_index(int row) const {
+    auto it = std::upper_bound(window_.begin(), window_.end(), row,
+                               [](int r, const window_page &wp) {
+                                   return r < wp.first_row;
+                               });
+    return static_cast<int>(it - window_.begin()) - 1;
+}
+
+bool DisassemblyModel::canFetchMore(const QModelIndex &parent) const {
+    return !parent.isValid() && !window_.empty() && next_page(window_.back().page) != 0;
+}
+
+void DisassemblyModel::fetchMore(const QModelIndex &parent) {
+    if (parent.isValid() || window_.empty()) {
+        return;
+    }
+    std::vector<window_page> pages;
+    std::uintptr_t page = window_.back().page;
+    // Carry the overrun of the last instruction into the next page, unless
+    // there's a gap between the mappings
+    std::uint16_t entry = decode(page, window_.back().entry)->overrun;
+    int first_row = rows_;
+    for (std::size_t i = 0; i < fetch_pages; ++i) {
+        std::uintptr_t next = next_page(page);
+        if (next == 0) {
+            break;
+        }
+        if (next != page + page_size_) {
+            entry = 0;
+        }
+        pages.push_back(make_page(next, entry, first_row));
+        first_row += pages.back().rows;
+        entry = decode(next, entry)->overrun;
+        page = next;
+    }
+    if (pages.empty()) {
+        return;
+    }
+    beginInsertRows(QModelIndex(), rows_, first_row - 1);
+    window_.insert(window_.end(), pages.begin(), pages.end());
+    rows_ = first_row;
+    endInsertRows();
+}
+
+int DisassemblyModel::fetchPrevious() {
+    if (window_.empty()) {
+        return 0;
+    }
+    // The instruction boundaries before the window are unknown, every page
+    // prepended starts decoding at its first byte
+    std::vector<window_page> pages;
+    std::uintptr_t page = window_.front().page;
+    int added = 0;
+    for (std::size_t i = 0; i < fetch_pages; ++i) {
+        std::uintptr_t previous = previous_page(page);
+        if (previous == 0) {
+            break;
+        }
+        pages.push_back(make_page(previous, 0, 0));
+        added += pages.back().rows;
+        page = previous;
+    }
+    if (added == 0) {
+        return 0;
+    }
+    std::reverse(pages.begin(), pages.end());
+    int first_row = 0;
+    for (window_page &wp : pages) {
+        wp.first_row = first_row;
+        first_row += wp.rows;
+    }
+    beginInsertRows(QModelIndex(), 0, added - 1);
+    for (window_page &wp : window_) {
+        wp.first_row += added;
+    }
+    window_.insert(window_.begin(), pages.begin(), pages.end());
+    rows_ += added;
+    endInsertRows();
+    return added;
+}
+
+int DisassemblyModel::seek(std::uintptr_t addr) {
+    std::uintptr_t page = addr & ~(page_size_ - 1);
+    std::uintptr_t first = 0;
+    for (const address_range &range : ranges_) {
+        auto start = reinterpret_cast<std::uintptr_t>(range.start);
+        if (page < start + range.length) {
+            first = std::max(page, start);
+            break;
+        }
+    }
+
+    beginResetModel();
+    window_.clear();
+    rows_ = 0;
+    if (first != 0) {
+        window_.push_back(make_page(first, 0, 0));
+        rows_ = window_.back().rows;
+    }
+    endResetModel();
+
+    if (first == 0) {
+        return -1;
+    }
+    // Have something to scroll into on both sides
+    fetchMore(QModelIndex());
+    fetchPrevious();
+    int row = rowOf(addr);
+    return row >= 0 ? row : rowOf(first);
+}
+
+int DisassemblyModel::rowOf(std::uintptr_t addr) const {
+    auto it = std::upper_bound(window_.begin(), window_.end(), addr,
+                               [](std::uintptr_t a, const window_page &wp) {
+                                   return a < wp.page;
+                               });
+    if (it == window_.begin()) {
+        return -1;
+    }
+    const window_page &wp = *--it;
+    if (addr >= wp.page + page_size_) {
+        return -1;
+    }
+    auto decoded = decode(wp.page, wp.entry);
+    const auto offset = static_cast<std::uint16_t>(addr - wp.page);
+    auto pos = std::upper_bound(decoded->offsets.begin(), decoded->offsets.end(), offset);
+    if (pos == decoded->offsets.begin()) {
+        // Inside an instruction that started on the previous page
+        return wp.first_row > 0 ? wp.first_row - 1 : wp.first_row;
+    }
+    return wp.first_row + static_cast<int>(pos - decoded->offsets.begin()) - 1;
+}
+
+DisassemblyModel::instruction DisassemblyModel::at(int row) const {
+    if (row < 0 || row >= rows_) {
+        return {0, 0};
+    }
+    const window_page &wp = window_[std::size_t(window_index(row))];
+    auto decoded = decode(wp.page, wp.entry);
+    const std::size_t i = std::size_t(row - wp.first_row);
+    if (i >= decoded->offsets.size()) {
+        return {0, 0};
+    }
+    return {wp.page + decoded->offsets[i], decoded->sizes[i]};
+}
+
+void DisassemblyModel::invalidate(std::uintptr_t address, std::size_t size) {
+    const std::uintptr_t first = address & ~(page_size_ - 1);
+    for (std::uintptr_t page = first; page < address + size; page += page_size_) {
+        cache_.erase(page);
+    }
+
+    // The amount of instructions may have changed, rebuild the affected
+    // pages in place and shift everything after them
+    bool changed = false;
+    int first_row = 0;
+    for (window_page &wp : window_) {
+        if (changed) {
+            wp.first_row = first_row;
+        }
+        if (wp.page >= first && wp.page < address + size) {
+            window_page rebuilt = make_page(wp.page, wp.entry, wp.first_row);
+            changed = changed || rebuilt.rows != wp.rows;
+            wp = rebuilt;
+        }
+        first_row = wp.first_row + wp.rows;
+    }
+    if (changed) {
+        beginResetModel();
+        rows_ = first_row;
+        endResetModel();
+    } else if (rows_ > 0) {
+        emit dataChanged(index(0, 0), index(rows_ - 1, COLUMN_COUNT - 1));
+    }
+}
+
+void DisassemblyModel::setComment(std::uintptr_t address, const QString &comment) {
+    comments_[address] = comment;
+    int row = rowOf(address);
+    if (row >= 0) {
+        emit dataChanged(index(row, COLUMN_COMMENT), index(row, COLUMN_COMMENT));
+    }
+}
+
+void DisassemblyModel::clearComment(std::uintptr_t address) {
+    comments_.erase(address);
+    int row = rowOf(address);
+    if (row >= 0) {
+        emit dataChanged(index(row, COLUMN_COMMENT), index(row, COLUMN_COMMENT));
+    }
+}
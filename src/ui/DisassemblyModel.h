@@ -0,0 +1,119 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QString>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <sys/types.h>
+
+#include "X86Code.h"
+#include "maps.h"
+
+/**
+ * Table model over the executable mappings of a process that only decodes
+ * what is looked at. The model holds a window of consecutive pages, for each
+ * only the amount of instructions is kept; the instructions themselves are
+ * decoded per page when a row is painted and cached. The window grows one
+ * batch of pages at a time as the view scrolls past either end.
+ */
+class DisassemblyModel : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    enum columns {
+        COLUMN_ADDRESS = 0,
+        COLUMN_INSTRUCTION,
+        COLUMN_COMMENT,
+        COLUMN_COUNT
+    };
+
+    struct instruction {
+        std::uintptr_t  address;
+        std::size_t     size;
+    };
+
+    /** Pages decoded by one fetchMore / fetchPrevious */
+    static constexpr std::size_t fetch_pages = 16;
+
+    explicit DisassemblyModel(pid_t pid, QObject *parent = nullptr);
+    ~DisassemblyModel() override = default;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    /**
+     * @brief fetchPrevious prepends the pages before the window
+     * @return the amount of rows inserted at the top
+     */
+    int fetchPrevious();
+
+    /**
+     * @brief seek moves the window to the page containing `addr`, or the
+     * first executable page after it
+     * @return the row of the instruction containing `addr`, -1 if the
+     * process has no executable memory after it
+     */
+    int seek(std::uintptr_t addr);
+
+    /** @brief rowOf finds the row of `addr` inside the window or -1 */
+    int rowOf(std::uintptr_t addr) const;
+
+    /** @brief at returns the instruction on `row`, size 0 if out of range */
+    instruction at(int row) const;
+
+    /**
+     * @brief invalidate drops the decoded pages overlapping the range, call
+     * after the bytes there were changed
+     */
+    void invalidate(std::uintptr_t address, std::size_t size);
+
+    void setComment(std::uintptr_t address, const QString &comment);
+    void clearComment(std::uintptr_t address);
+
+private:
+    /** A page of the window, `entry` is where its first instruction starts */
+    struct window_page {
+        std::uintptr_t page;
+        std::uint16_t   entry;
+        int             first_row;
+        int             rows;
+    };
+
+    struct decoded_page {
+        std::vector<std::uint16_t>  offsets;
+        std::vector<std::uint8_t>   sizes;
+        std::vector<QString>        text;
+        /** Bytes the last instruction runs into the next page */
+        std::uint16_t               overrun;
+    };
+
+    /** Upper bound of cached pages before the cache is dropped */
+    static constexpr std::size_t max_pages = 512;
+
+    pid_t pid_;
+    /** Only used from decode on the ui thread */
+    mutable capstone capstone_{};
+    std::size_t page_size_;
+    std::vector<address_range> ranges_{};
+    std::vector<window_page> window_{};
+    int rows_{};
+    std::unordered_map<std::uintptr_t, QString> comments_{};
+    mutable std::unordered_map<std::uintptr_t, std::shared_ptr<const decoded_page>> cache_{};
+
+    std::shared_ptr<const decoded_page> decode(std::uintptr_t page, std::uint16_t entry) const;
+    /** Next and previous executable page, 0 at either end */
+    std::uintptr_t next_page(std::uintptr_t page) const;
+    std::uintptr_t previous_page(std::uintptr_t page) const;
+    int window_index(int row) const;
+    window_page make_page(std::uintptr_t page, std::uint16_t entry, int first_row) const;
+};
@@ -0,0 +1,110 @@
+#include "ui/GroupMatchModel.h"
+#include "ui/ValueFormat.h"
+
+#include <algorithm>
+#include <climits>
+
+GroupMatchModel::GroupMatchModel(const ProcessGroup &group, QObject *parent)
+    : QAbstractTableModel(parent), group_(group) {}
+
+int GroupMatchModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : static_cast<int>(rows_.size());
+}
+
+int GroupMatchModel::columnCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : COLUMN_COUNT;
+}
+
+QVariant GroupMatchModel::headerData(int section, Qt::Orientation orientation,
+                                     int role) const {
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal) {
+        return {};
+    }
+    switch (section) {
+    case COLUMN_PID:
+        return tr("PID");
+    case COLUMN_ADDRESS:
+        return tr("Address");
+    case COLUMN_VALUE:
+        return tr("Value");
+    default:
+        return {};
+    }
+}
+
+QVariant GroupMatchModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || role != Qt::DisplayRole ||
+        static_cast<std::size_t>(index.row()) >= rows_.size()) {
+        return {};
+    }
+    const auto row = static_cast<std::size_t>(index.row());
+    switch (index.column()) {
+    case COLUMN_PID:
+        return QString::number(rows_[row].pid);
+    case COLUMN_ADDRESS:
+        return QString("0x%1").arg(reinterpret_cast<std::uintptr_t>(rows_[row].address), 0, 16);
+    case COLUMN_VALUE:
+        return readable_[row] ? format_value(type_, values_[row]) : QString("??");
+    default:
+        return {};
+    }
+}
+
+bool GroupMatchModel::canFetchMore(const QModelIndex &parent) const {
+    return !parent.isValid() && !scanning_ &&
+           rows_.size() < std::min<std::size_t>(group_.match_count(), INT_MAX);
+}
+
+void GroupMatchModel::fetchMore(const QModelIndex &parent) {
+    if (!canFetchMore(parent)) {
+        return;
+    }
+    const std::size_t first = rows_.size();
+    const std::size_t limit = std::min<std::size_t>(group_.match_count(), INT_MAX);
+    std::vector<group_match> batch =
+        group_.matches(first, std::min<std::size_t>(fetch_rows, limit - first));
+    std::vector<std::uint64_t> values(batch.size());
+    std::vector<ReadRequest> requests(batch.size());
+    const std::size_t size = value_type_size(type_);
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        requests[i] = {batch[i].address, &values[i], size};
+    }
+    // Matches are in member order, one batched read per run of a pid
+    for (std::size_t run = 0; run < batch.size();) {
+        std::size_t end = run;
+        while (end < batch.size() && batch[end].pid == batch[run].pid) {
+            ++end;
+        }
+        ProcessMemory::read_many(batch[run].pid, std::span{&requests[run], end - run});
+        run = end;
+    }
+
+    beginInsertRows(QModelIndex(), static_cast<int>(first),
+                    static_cast<int>(first + batch.size()) - 1);
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        rows_.push_back(batch[i]);
+        values_.push_back(values[i]);
+        readable_.push_back(requests[i].result == static_cast<ssize_t>(size));
+    }
+    endInsertRows();
+}
+
+void GroupMatchModel::begin_scan() {
+    beginResetModel();
+    scanning_ = true;
+    rows_.clear();
+    values_.clear();
+    readable_.clear();
+    endResetModel();
+}
+
+void GroupMatchModel::end_scan(value_type type) {
+    beginResetModel();
+    scanning_ = false;
+    type_ = type;
+    rows_.clear();
+    values_.clear();
+    readable_.clear();
+    endResetModel();
+    fetchMore(QModelIndex());
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QString>
+
+#include <cstdint>
+#include <vector>
+
+#include "ProcessGroup.h"
+#include "value_type.h"
+
+/**
+ * Table model over the matches of every ProcessGroup member, in group
+ * order. Rows are fetched in batches as the view scrolls, the values of a
+ * batch are read when it is fetched with one read_many per process.
+ */
+class GroupMatchModel : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    enum columns {
+        COLUMN_PID = 0,
+        COLUMN_ADDRESS,
+        COLUMN_VALUE,
+        COLUMN_COUNT
+    };
+
+    /** Rows added by one fetchMore */
+    static constexpr int fetch_rows = 1024;
+
+    explicit GroupMatchModel(const ProcessGroup &group, QObject *parent = nullptr);
+    ~GroupMatchModel() override = default;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    /** @brief begin_scan empties the view, a scan compacts the matches in place */
+    void begin_scan();
+
+    /** @brief end_scan shows the matches found, read as `type` */
+    void end_scan(value_type type);
+
+private:
+    const ProcessGroup          &group_;
+    value_type                  type_{VALUE_U32};
+    /** Rows fetched so far with their value at the time */
+    std::vector<group_match>    rows_{};
+    std::vector<std::uint64_t>  values_{};
+    std::vector<std::uint8_t>   readable_{};
+    bool                        scanning_{};
+};
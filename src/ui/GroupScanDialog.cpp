@@ -0,0 +1,273 @@
+#include "ui/GroupScanDialog.h"
+#include "ui/GroupMatchModel.h"
+#include "ui/ValueFormat.h"
+#include "ProcessList.h"
+
+#include <QComboBox>
+#include <QElapsedTimer>
+#include <QFormLayout>
+#include <QFutureWatcher>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QTableView>
+#include <QVBoxLayout>
+#include <QtConcurrent/QtConcurrent>
+
+#include <cstring>
+#include <memory>
+
+GroupScanDialog::GroupScanDialog(const range_filter &filter, QWidget *parent)
+    : QDialog(parent),
+      model_(new GroupMatchModel(group_, this)),
+      processEdit_(new QLineEdit(this)),
+      addButton_(new QPushButton(tr("Add"), this)),
+      removeButton_(new QPushButton(tr("Remove"), this)),
+      members_(new QListWidget(this)),
+      typeCombo_(new QComboBox(this)),
+      modeCombo_(new QComboBox(this)),
+      valueEdit_(new QLineEdit(this)),
+      scanButton_(new QPushButton(tr("First scan"), this)),
+      newButton_(new QPushButton(tr("New scan"), this)),
+      compareButton_(new QPushButton(tr("Compare"), this)),
+      progress_(new QProgressBar(this)),
+      status_(new QLabel(this)),
+      table_(new QTableView(this))
+{
+    setWindowTitle(tr("Group scan"));
+    resize(800, 600);
+
+    group_.scan_filter(filter);
+    group_.setProgressCallback([this](size_t current, size_t total) {
+        QMetaObject::invokeMethod(progress_, [this, current, total] {
+            progress_->setValue(int(double(current) / double(total) * 100));
+        }, Qt::QueuedConnection);
+    });
+
+    processEdit_->setPlaceholderText(tr("pid, or a name to add every process called so"));
+    for (int type = 0; type < VALUE_TYPE_COUNT; ++type) {
+        typeCombo_->addItem(value_type_name(static_cast<value_type>(type)));
+    }
+    typeCombo_->setCurrentIndex(VALUE_U32);
+    modeCombo_->addItem(tr("Exact value"), int(SCAN_EXACT));
+    modeCombo_->addItem(tr("Changed"), int(SCAN_CHANGED));
+    modeCombo_->addItem(tr("Unchanged"), int(SCAN_UNCHANGED));
+    modeCombo_->addItem(tr("Increased"), int(SCAN_INCREASED));
+    modeCombo_->addItem(tr("Decreased"), int(SCAN_DECREASED));
+    modeCombo_->setToolTip(tr("How the next scan filters the matches, a first scan "
+                              "always looks for the exact value"));
+    compareButton_->setToolTip(tr("Times a first scan for the value as a group against "
+                                  "one scanner per process running at the same time"));
+    members_->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    members_->setMaximumHeight(120);
+    progress_->setRange(0, 100);
+
+    auto *processes = new QHBoxLayout();
+    processes->addWidget(processEdit_);
+    processes->addWidget(addButton_);
+    processes->addWidget(removeButton_);
+
+    auto *form = new QFormLayout();
+    form->addRow(tr("Processes:"), processes);
+    form->addRow(QString(), members_);
+    form->addRow(tr("Value type:"), typeCombo_);
+    form->addRow(tr("Next scan:"), modeCombo_);
+    form->addRow(tr("Value:"), valueEdit_);
+
+    auto *buttons = new QHBoxLayout();
+    buttons->addWidget(scanButton_);
+    buttons->addWidget(newButton_);
+    buttons->addWidget(compareButton_);
+    buttons->addWidget(progress_);
+
+    QFont monoFont("Courier New");
+    monoFont.setStyleHint(QFont::Monospace);
+    table_->setFont(monoFont);
+    table_->setModel(model_);
+    table_->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    table_->horizontalHeader()->setStretchLastSection(true);
+    table_->verticalHeader()->setVisible(false);
+    table_->setSelectionBehavior(QAbstractItemView::SelectRows);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addLayout(form);
+    layout->addLayout(buttons);
+    layout->addWidget(status_);
+    layout->addWidget(table_);
+    setLayout(layout);
+
+    connect(addButton_, &QPushButton::clicked, this, &GroupScanDialog::addProcesses);
+    connect(processEdit_, &QLineEdit::returnPressed, this, &GroupScanDialog::addProcesses);
+    connect(removeButton_, &QPushButton::clicked, this, &GroupScanDialog::removeProcesses);
+    connect(scanButton_, &QPushButton::clicked, this, &GroupScanDialog::startScan);
+    connect(newButton_, &QPushButton::clicked, this, &GroupScanDialog::newScan);
+    connect(compareButton_, &QPushButton::clicked, this, &GroupScanDialog::compare);
+    resetMatches();
+}
+
+GroupScanDialog::~GroupScanDialog() {
+    // Both refer to the group, and the scan to the dialog for progress
+    future_.waitForFinished();
+    comparison_.waitForFinished();
+}
+
+void GroupScanDialog::setBusy(bool busy) {
+    addButton_->setEnabled(!busy);
+    removeButton_->setEnabled(!busy);
+    scanButton_->setEnabled(!busy);
+    newButton_->setEnabled(!busy);
+    compareButton_->setEnabled(!busy);
+    typeCombo_->setEnabled(!busy && group_.match_count() == 0);
+}
+
+void GroupScanDialog::showMembers() {
+    members_->clear();
+    for (pid_t pid : group_.pids()) {
+        process_info info{};
+        const QString comm = read_process_info(-1, pid, info)
+                                 ? QString::fromStdString(info.comm)
+                                 : tr("(exited)");
+        auto *item = new QListWidgetItem(QString("%1: %2").arg(pid).arg(comm), members_);
+        item->setData(Qt::UserRole, pid);
+    }
+}
+
+void GroupScanDialog::resetMatches() {
+    group_.clear_matches();
+    model_->end_scan(static_cast<value_type>(typeCombo_->currentIndex()));
+    scanButton_->setText(tr("First scan"));
+    typeCombo_->setEnabled(true);
+    status_->setText(tr("%n process(es)", nullptr, int(group_.size())));
+}
+
+void GroupScanDialog::addProcesses() {
+    const QString text = processEdit_->text().trimmed();
+    if (text.isEmpty()) {
+        return;
+    }
+    std::size_t added = 0;
+    bool ok = false;
+    const pid_t pid = text.toInt(&ok);
+    if (ok) {
+        if (group_.add(pid)) {
+            ++added;
+        }
+    } else {
+        const std::string name = text.toStdString();
+        for (pid_t candidate : list_pids()) {
+            process_info info{};
+            if (read_process_info(-1, candidate, info) && info.comm == name &&
+                group_.add(candidate)) {
+                ++added;
+            }
+        }
+    }
+    if (added == 0) {
+        status_->setText(tr("No new process matches %1").arg(text));
+        return;
+    }
+    processEdit_->clear();
+    // A member without matches would never get a first scan
+    showMembers();
+    resetMatches();
+}
+
+void GroupScanDialog::removeProcesses() {
+    const QList<QListWidgetItem *> selected = members_->selectedItems();
+    if (selected.isEmpty()) {
+        return;
+    }
+    for (QListWidgetItem *item : selected) {
+        group_.remove(item->data(Qt::UserRole).toInt());
+    }
+    showMembers();
+    resetMatches();
+}
+
+void GroupScanDialog::newScan() {
+    resetMatches();
+}
+
+void GroupScanDialog::startScan() {
+    if (group_.size() == 0) {
+        status_->setText(tr("Add the processes to scan first"));
+        return;
+    }
+    const auto type = static_cast<value_type>(typeCombo_->currentIndex());
+    const bool first = group_.match_count() == 0;
+    const auto mode = first ? SCAN_EXACT
+                            : static_cast<scan_mode>(modeCombo_->currentData().toInt());
+    std::uint64_t raw = 0;
+    if (!needs_history(mode) && !parse_value(type, valueEdit_->text().trimmed(), raw)) {
+        status_->setText(tr("Not a valid %1 value").arg(value_type_name(type)));
+        return;
+    }
+
+    setBusy(true);
+    progress_->setValue(0);
+    status_->setText(tr("Scanning..."));
+    // The scan compacts the matches in place, stop the view reading them
+    model_->begin_scan();
+    auto timer = std::make_shared<QElapsedTimer>();
+    timer->start();
+    future_ = QtConcurrent::run([this, type, mode, raw] {
+        visit_value_type(type, [this, mode, raw](auto value) {
+            std::memcpy(&value, &raw, sizeof(value));
+            group_.scan(value, mode);
+        });
+    });
+
+    auto *watcher = new QFutureWatcher<void>(this);
+    connect(watcher, &QFutureWatcher<void>::finished, this, [this, watcher, type, timer] {
+        model_->end_scan(type);
+        setBusy(false);
+        scanButton_->setText(group_.match_count() == 0 ? tr("First scan") : tr("Next scan"));
+        status_->setText(tr("%1 matches in %2 processes, %3 s")
+                             .arg(group_.match_count())
+                             .arg(group_.size())
+                             .arg(double(timer->elapsed()) / 1000.0, 0, 'f', 3));
+        watcher->deleteLater();
+    });
+    watcher->setFuture(future_);
+}
+
+void GroupScanDialog::compare() {
+    if (group_.size() == 0) {
+        status_->setText(tr("Add the processes to scan first"));
+        return;
+    }
+    const auto type = static_cast<value_type>(typeCombo_->currentIndex());
+    std::uint64_t raw = 0;
+    if (!parse_value(type, valueEdit_->text().trimmed(), raw)) {
+        status_->setText(tr("Not a valid %1 value").arg(value_type_name(type)));
+        return;
+    }
+
+    setBusy(true);
+    status_->setText(tr("Comparing..."));
+    comparison_ = QtConcurrent::run([pids = group_.pids(), filter = group_.scan_filter(),
+                                     type, raw] {
+        return visit_value_type(type, [&](auto value) {
+            std::memcpy(&value, &raw, sizeof(value));
+            return ProcessGroup::compare(pids, value, filter);
+        });
+    });
+
+    auto *watcher = new QFutureWatcher<group_comparison>(this);
+    connect(watcher, &QFutureWatcher<group_comparison>::finished, this, [this, watcher] {
+        const group_comparison result = watcher->result();
+        setBusy(false);
+        status_->setText(tr("Group: %1 s, %2 matches. One scanner per process: %3 s, "
+                            "%4 matches.")
+                             .arg(result.group_seconds, 0, 'f', 3)
+                             .arg(result.group_matches)
+                             .arg(result.separate_seconds, 0, 'f', 3)
+                             .arg(result.separate_matches));
+        watcher->deleteLater();
+    });
+    watcher->setFuture(comparison_);
+}
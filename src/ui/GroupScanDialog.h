@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QDialog>
+#include <QFuture>
+
+#include "ProcessGroup.h"
+#include "value_type.h"
+
+class GroupMatchModel;
+class QComboBox;
+class QLabel;
+class QLineEdit;
+class QListWidget;
+class QProgressBar;
+class QPushButton;
+class QTableView;
+
+/**
+ * Scans several processes, such as the workers of one binary, with one
+ * query through a ProcessGroup and lists the matches of all of them tagged
+ * with their pid. Compare runs the same first scan as a group and as one
+ * scanner per process so the two can be timed against each other.
+ */
+class GroupScanDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    /** @param filter scan scope of the first scan, see MainWindow::scan_scope */
+    GroupScanDialog(const range_filter &filter, QWidget *parent = nullptr);
+    ~GroupScanDialog() override;
+
+private slots:
+    void addProcesses();
+    void removeProcesses();
+    void startScan();
+    void newScan();
+    void compare();
+
+private:
+    ProcessGroup        group_{};
+    GroupMatchModel     *model_;
+    QLineEdit           *processEdit_;
+    QPushButton         *addButton_;
+    QPushButton         *removeButton_;
+    QListWidget         *members_;
+    QComboBox           *typeCombo_;
+    QComboBox           *modeCombo_;
+    QLineEdit           *valueEdit_;
+    QPushButton         *scanButton_;
+    QPushButton         *newButton_;
+    QPushButton         *compareButton_;
+    QProgressBar        *progress_;
+    QLabel              *status_;
+    QTableView          *table_;
+    QFuture<void>       future_{};
+    QFuture<group_comparison> comparison_{};
+
+    void setBusy(bool busy);
+    void showMembers();
+    /** @brief resetMatches drops the matches after the members changed */
+    void resetMatches();
+};
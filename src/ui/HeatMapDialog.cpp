@@ -0,0 +1,149 @@
+#include "ui/HeatMapDialog.h"
+#include "MemorySampler.h"
+#include "ProcessMemory.h"
+
+#include <QCheckBox>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <QTimer>
+#include <QVBoxLayout>
+
+HeatMapDialog::HeatMapDialog(ProcessMemory &scanner, QWidget *parent)
+    : QDialog(parent),
+      scanner_(scanner),
+      sampler_(std::make_unique<MemorySampler>()),
+      loadsCheck_(new QCheckBox(tr("Sample loads instead of stores"), this)),
+      periodSpin_(new QSpinBox(this)),
+      intervalSpin_(new QSpinBox(this)),
+      topSpin_(new QSpinBox(this)),
+      startButton_(new QPushButton(tr("Start"), this)),
+      seedButton_(new QPushButton(tr("Seed matches"), this)),
+      status_(new QLabel(this)),
+      table_(new QTableWidget(this)),
+      timer_(new QTimer(this))
+{
+    setWindowTitle(tr("Hot addresses"));
+    resize(800, 500);
+
+    periodSpin_->setRange(1, 1000000);
+    periodSpin_->setValue(1000);
+    periodSpin_->setToolTip(tr("Take a sample every n memory accesses"));
+    intervalSpin_->setRange(10, 60000);
+    intervalSpin_->setSuffix(tr(" ms"));
+    intervalSpin_->setValue(int(MemorySampler::default_soft_dirty_interval.count()));
+    intervalSpin_->setToolTip(tr("How often written pages are collected when the cpu "
+                                 "can't sample memory accesses. Every collection makes "
+                                 "the target fault on its next write to each page."));
+    topSpin_->setRange(1, 10000000);
+    topSpin_->setValue(1000);
+    seedButton_->setToolTip(tr("Replace the matches with the hottest addresses, "
+                               "then narrow them down with next scan"));
+
+    auto *form = new QFormLayout();
+    form->addRow(tr("Sample period:"), periodSpin_);
+    form->addRow(tr("Soft-dirty interval:"), intervalSpin_);
+    form->addRow(QString(), loadsCheck_);
+    form->addRow(tr("Seed from top:"), topSpin_);
+
+    auto *buttons = new QHBoxLayout();
+    buttons->addWidget(startButton_);
+    buttons->addWidget(seedButton_);
+    buttons->addStretch();
+
+    table_->setColumnCount(4);
+    table_->setHorizontalHeaderLabels({tr("Range"), tr("Name"), tr("Samples"), tr("Addresses")});
+    table_->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    table_->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
+    table_->verticalHeader()->setVisible(false);
+    table_->setEditTriggers(QTableWidget::NoEditTriggers);
+    table_->setSelectionBehavior(QTableWidget::SelectRows);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addLayout(form);
+    layout->addLayout(buttons);
+    layout->addWidget(status_);
+    layout->addWidget(table_);
+    setLayout(layout);
+
+    connect(startButton_, &QPushButton::clicked, this, &HeatMapDialog::toggleSampling);
+    connect(seedButton_, &QPushButton::clicked, this, &HeatMapDialog::seed);
+    connect(timer_, &QTimer::timeout, this, &HeatMapDialog::refresh);
+    connect(intervalSpin_, &QSpinBox::valueChanged, this, [this](int ms) {
+        sampler_->soft_dirty_interval(std::chrono::milliseconds{ms});
+    });
+}
+
+HeatMapDialog::~HeatMapDialog() = default;
+
+void HeatMapDialog::toggleSampling() {
+    if (sampler_->running()) {
+        sampler_->stop();
+        timer_->stop();
+        startButton_->setText(tr("Start"));
+        refresh();
+        return;
+    }
+
+    // Soft-dirty tracking only reads the pages a scan would cover
+    auto maps = scanner_.refresh_maps();
+    sampler_->soft_dirty_interval(std::chrono::milliseconds{intervalSpin_->value()});
+    MemorySampler::source source = sampler_->start(
+        scanner_.pid(), loadsCheck_->isChecked(),
+        static_cast<std::uint64_t>(periodSpin_->value()),
+        apply_range_filter(maps->ranges, scanner_.scan_filter()));
+    if (source == MemorySampler::SOURCE_NONE) {
+        status_->setText(tr("Could not sample the process, check perf_event_paranoid"));
+        return;
+    }
+    startButton_->setText(tr("Stop"));
+    timer_->start(500);
+}
+
+void HeatMapDialog::refresh() {
+    auto maps = scanner_.maps();
+    std::vector<MemorySampler::range_heat> heat = sampler_->heat(*maps);
+
+    table_->setRowCount(int(heat.size()));
+    for (int row = 0; row < int(heat.size()); ++row) {
+        const MemorySampler::range_heat &h = heat[std::size_t(row)];
+        const address_range &range = maps->ranges[h.range];
+        auto start = reinterpret_cast<std::uintptr_t>(range.start);
+        auto *samples = new QTableWidgetItem(QString::number(h.samples));
+        auto *addresses = new QTableWidgetItem(QString::number(h.addresses));
+        samples->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        addresses->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        table_->setItem(row, 0, new QTableWidgetItem(QString("%1-%2")
+                                                         .arg(start, 0, 16)
+                                                         .arg(start + range.length, 0, 16)));
+        table_->setItem(row, 1, new QTableWidgetItem(QString::fromUtf8(range.name)));
+        table_->setItem(row, 2, samples);
+        table_->setItem(row, 3, addresses);
+    }
+
+    QString status = tr("Source: %1, %2 samples")
+                         .arg(MemorySampler::source_name(sampler_->current_source()))
+                         .arg(sampler_->total_samples());
+    if (std::uint64_t lost = sampler_->lost(); lost > 0) {
+        status += tr(", %1 lost").arg(lost);
+    }
+    status_->setText(status);
+}
+
+void HeatMapDialog::seed() {
+    std::vector<MemorySampler::hot_address> hot =
+        sampler_->hottest(static_cast<std::size_t>(topSpin_->value()));
+    if (hot.empty()) {
+        return;
+    }
+    std::vector<std::uintptr_t> addresses;
+    addresses.reserve(hot.size());
+    for (const MemorySampler::hot_address &h : hot) {
+        addresses.push_back(h.address);
+    }
+    emit seedMatches(std::move(addresses), sampler_->granularity());
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QDialog>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class MemorySampler;
+class ProcessMemory;
+class QCheckBox;
+class QLabel;
+class QPushButton;
+class QSpinBox;
+class QTableWidget;
+class QTimer;
+
+/**
+ * Shows where the target is touching memory according to MemorySampler,
+ * summed per mapping, and can hand the hottest addresses to the main window
+ * as a starting match set.
+ */
+class HeatMapDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit HeatMapDialog(ProcessMemory &scanner, QWidget *parent = nullptr);
+    ~HeatMapDialog() override;
+
+signals:
+    /**
+     * @param addresses the hottest sampled addresses
+     * @param granularity bytes each address stands for, see
+     * MemorySampler::granularity
+     */
+    void seedMatches(std::vector<std::uintptr_t> addresses, std::size_t granularity);
+
+private slots:
+    void toggleSampling();
+    void refresh();
+    void seed();
+
+private:
+    ProcessMemory                   &scanner_;
+    std::unique_ptr<MemorySampler>  sampler_;
+    QCheckBox                       *loadsCheck_;
+    QSpinBox                        *periodSpin_;
+    QSpinBox                        *intervalSpin_;
+    QSpinBox                        *topSpin_;
+    QPushButton                     *startButton_;
+    QPushButton                     *seedButton_;
+    QLabel                          *status_;
+    QTableWidget                    *table_;
+    QTimer                          *timer_;
+};
@@ -0,0 +1,190 @@
+#include "ui/HexView.h"
+
+#include <QFontDatabase>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QScrollBar>
+#include <QTimer>
+
+#include <algorithm>
+#include <climits>
+
+namespace {
+/** Characters of the address column including the gap after it */
+constexpr int address_chars = 18;
+/** Characters of the hex column, "xx " per byte plus a gap after 8 bytes */
+constexpr int hex_chars = HexView::bytes_per_line * 3 + 2;
+}
+
+HexView::HexView(pid_t pid, QWidget *parent)
+    : QAbstractScrollArea(parent),
+      timer_(new QTimer(this))
+{
+    cache_.pid(pid);
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    lineHeight_ = fontMetrics().height();
+    charWidth_ = fontMetrics().horizontalAdvance(QLatin1Char('0'));
+    setMinimumWidth((address_chars + hex_chars + bytes_per_line + 2) * charWidth_);
+
+    connect(timer_, &QTimer::timeout, this, &HexView::refresh);
+    timer_->start(250);
+}
+
+void HexView::setRange(std::uintptr_t start, std::uintptr_t length) {
+    start_ = start;
+    length_ = length;
+    hasSelection_ = false;
+    cache_.clear();
+    updateScrollBar();
+    verticalScrollBar()->setValue(0);
+    refreshVisible();
+    viewport()->update();
+}
+
+void HexView::gotoAddress(std::uintptr_t address) {
+    if (address < start_ || address - start_ >= length_) {
+        return;
+    }
+    selected_ = address;
+    hasSelection_ = true;
+    // Put the line a few lines below the top so the context is visible
+    const std::uint64_t line = (address - start_) / bytes_per_line;
+    const std::uint64_t top = line > 4 ? line - 4 : 0;
+    verticalScrollBar()->setValue(static_cast<int>(top / scale_));
+    refreshVisible();
+    viewport()->update();
+}
+
+void HexView::setInterval(int ms) {
+    timer_->start(ms);
+}
+
+std::uint64_t HexView::lineCount() const {
+    return (length_ + bytes_per_line - 1) / bytes_per_line;
+}
+
+std::uint64_t HexView::firstLine() const {
+    return static_cast<std::uint64_t>(verticalScrollBar()->value()) * scale_;
+}
+
+int HexView::visibleLines() const {
+    return lineHeight_ > 0 ? viewport()->height() / lineHeight_ + 1 : 0;
+}
+
+void HexView::updateScrollBar() {
+    const std::uint64_t lines = lineCount();
+    const auto visible = static_cast<std::uint64_t>(std::max(visibleLines() - 1, 1));
+    // Scroll bars are int based, a 64 GiB range already has 4G lines
+    constexpr std::uint64_t max_steps = INT_MAX / 2;
+    scale_ = lines / max_steps + 1;
+    const std::uint64_t steps = lines > visible ? (lines - visible + scale_ - 1) / scale_ : 0;
+    verticalScrollBar()->setRange(0, static_cast<int>(steps));
+    verticalScrollBar()->setPageStep(static_cast<int>(std::max<std::uint64_t>(visible / scale_, 1)));
+    verticalScrollBar()->setSingleStep(1);
+}
+
+void HexView::refreshVisible() {
+    if (length_ == 0) {
+        return;
+    }
+    const std::uintptr_t first = start_ + firstLine() * bytes_per_line;
+    const std::uintptr_t end = std::min<std::uintptr_t>(
+        first + static_cast<std::uintptr_t>(visibleLines()) * bytes_per_line, start_ + length_);
+    cache_.refresh(first, end);
+}
+
+void HexView::refresh() {
+    if (!isVisible()) {
+        return;
+    }
+    refreshVisible();
+    viewport()->update();
+}
+
+void HexView::scrollContentsBy(int, int) {
+    // Only the pages now on screen are read, whatever was skipped over isn't
+    refreshVisible();
+    viewport()->update();
+}
+
+void HexView::resizeEvent(QResizeEvent *event) {
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBar();
+    refreshVisible();
+}
+
+void HexView::paintEvent(QPaintEvent *) {
+    QPainter painter(viewport());
+    painter.setFont(font());
+    const QPalette &pal = palette();
+    const QColor text = pal.color(QPalette::Text);
+    const QColor dim = pal.color(QPalette::Disabled, QPalette::Text);
+    const QColor changed = QColor::fromRgb(200, 0, 0);
+    const int ascent = fontMetrics().ascent();
+    const std::uintptr_t end = start_ + length_;
+
+    const std::uint64_t first_line = firstLine();
+    const int lines = visibleLines();
+    for (int row = 0; row < lines; ++row) {
+        const std::uintptr_t line = start_ + (first_line + static_cast<std::uint64_t>(row)) *
+                                                 bytes_per_line;
+        if (line >= end || line < start_) {
+            break;
+        }
+        const int y = row * lineHeight_;
+        painter.setPen(dim);
+        painter.drawText(0, y + ascent, QString("%1").arg(line, 16, 16, QLatin1Char('0')));
+
+        for (int b = 0; b < bytes_per_line && line + static_cast<std::uintptr_t>(b) < end; ++b) {
+            const std::uintptr_t address = line + static_cast<std::uintptr_t>(b);
+            const int hex_x = (address_chars + b * 3 + (b >= 8 ? 1 : 0)) * charWidth_;
+            const int ascii_x = (address_chars + hex_chars + b) * charWidth_;
+            if (hasSelection_ && address == selected_) {
+                painter.fillRect(hex_x, y, charWidth_ * 2, lineHeight_, pal.highlight());
+                painter.fillRect(ascii_x, y, charWidth_, lineHeight_, pal.highlight());
+            }
+
+            std::uint8_t value = 0;
+            std::uint8_t age = 0;
+            if (!cache_.byte(address, value, age)) {
+                painter.setPen(dim);
+                painter.drawText(hex_x, y + ascent, QStringLiteral("??"));
+                painter.drawText(ascii_x, y + ascent, QStringLiteral("?"));
+                continue;
+            }
+            painter.setPen(age < highlight_refreshes ? changed : text);
+            painter.drawText(hex_x, y + ascent,
+                             QString("%1").arg(static_cast<unsigned>(value), 2, 16, QLatin1Char('0')));
+            const char c = value >= 0x20 && value < 0x7f ? static_cast<char>(value) : '.';
+            painter.drawText(ascii_x, y + ascent, QString(QLatin1Char(c)));
+        }
+    }
+}
+
+void HexView::mousePressEvent(QMouseEvent *event) {
+    const int column = event->position().toPoint().x() / std::max(charWidth_, 1);
+    const int row = event->position().toPoint().y() / std::max(lineHeight_, 1);
+    int b = -1;
+    if (column >= address_chars && column < address_chars + hex_chars) {
+        int offset = column - address_chars;
+        if (offset >= 8 * 3) {
+            --offset;
+        }
+        b = offset / 3;
+    } else if (column >= address_chars + hex_chars &&
+               column < address_chars + hex_chars + bytes_per_line) {
+        b = column - address_chars - hex_chars;
+    }
+    if (b < 0 || b >= bytes_per_line) {
+        return;
+    }
+    const std::uintptr_t address = start_ + (firstLine() + static_cast<std::uint64_t>(row)) *
+                                                bytes_per_line + static_cast<std::uintptr_t>(b);
+    if (address >= start_ + length_) {
+        return;
+    }
+    selected_ = address;
+    hasSelection_ = true;
+    viewport()->update();
+    emit addressSelected(address);
+}
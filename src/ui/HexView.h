@@ -0,0 +1,76 @@
+#pragma once
+
+#include <QAbstractScrollArea>
+#include <cstdint>
+#include <sys/types.h>
+
+#include "PageCache.h"
+
+class QTimer;
+
+/**
+ * Hex dump of one range of the target's address space. Nothing is copied
+ * per line, every paint reads from a PageCache which is refreshed for the
+ * lines on screen only, so the size of the range doesn't matter. Bytes that
+ * changed in the last few refreshes are drawn in red.
+ */
+class HexView : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    static constexpr int bytes_per_line = 16;
+
+    /** Refreshes a changed byte stays highlighted for */
+    static constexpr std::uint8_t highlight_refreshes = 4;
+
+    explicit HexView(pid_t pid, QWidget *parent = nullptr);
+    ~HexView() override = default;
+
+    /** @brief setRange shows [start, start + length), clearing the selection */
+    void setRange(std::uintptr_t start, std::uintptr_t length);
+
+    std::uintptr_t rangeStart() const {
+        return start_;
+    }
+
+    std::uintptr_t rangeLength() const {
+        return length_;
+    }
+
+    /** @brief gotoAddress scrolls to `address` and selects it */
+    void gotoAddress(std::uintptr_t address);
+
+    /** @brief setInterval sets how often the visible pages are re-read */
+    void setInterval(int ms);
+
+signals:
+    void addressSelected(std::uintptr_t address);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+
+private slots:
+    void refresh();
+
+private:
+    PageCache       cache_{};
+    QTimer          *timer_;
+    std::uintptr_t  start_{};
+    std::uintptr_t  length_{};
+    std::uintptr_t  selected_{};
+    bool            hasSelection_{};
+    /** Lines per scroll bar step, above 1 only for ranges of tens of GiB */
+    std::uint64_t   scale_{1};
+    int             lineHeight_{};
+    int             charWidth_{};
+
+    std::uint64_t lineCount() const;
+    std::uint64_t firstLine() const;
+    int visibleLines() const;
+    void updateScrollBar();
+    void refreshVisible();
+};
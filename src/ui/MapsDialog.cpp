@@ -36,6 +36,7 @@ MapsDialog::MapsDialog(pid_t pid, QWidget *parent)
     resize(900, 500);
 
     ranges = get_memory_ranges(pid, true);
+    index_.build(ranges);
 
     auto *searchLayout = new QHBoxLayout();
     searchLayout->addWidget(new QLabel("Address:", this));
@@ -200,16 +201,7 @@ void MapsDialog::gotoAddress(uintptr_t addr) const {
 
 int MapsDialog::findRowForAddress(uintptr_t addr) const
 {
-    int row = 0;
-    for (const address_range &cur : ranges) {
-        uintptr_t startAddr = reinterpret_cast<uintptr_t>(cur.start);
-        uintptr_t endAddr = startAddr + cur.length;
-        if (addr >= startAddr && addr < endAddr) {
-            return row;
-        }
-        ++row;
-    }
-    return -1;
+    return int(index_.find(addr));
 }
 
 void MapsDialog::searchAddress()
@@ -41,6 +41,7 @@ private:
     QTableWidget                   *table_;
     QVBoxLayout                    *mainLayout_;
     std::vector<address_range>  ranges;  ///< keep the head pointer around
+    address_range_index         index_;  ///< lookup index over ranges
 
     /// Helper: Convert the perms bitmask into a human‐readable "rwxp" string.
     static QString permsToString(unsigned char perms);
@@ -49,8 +50,8 @@ private:
     void populateTable();
 
     /**
-     * Given a raw hex/decimal address, scan through rangesHead_ to find which
-     * address_range (if any) contains it. Returns the zero‐based row index or -1 if not found.
+     * Given a raw hex/decimal address, look up which address_range (if any)
+     * contains it. Returns the zero‐based row index or -1 if not found.
      */
     int findRowForAddress(uintptr_t addr) const;
 };
@@ -0,0 +1,198 @@
+#include "ui/MatchTableModel.h"
+#include "ui/MemoryMonitor.h"
+#include "ui/ValueFormat.h"
+#include "ProcessMemory.h"
+
+#include <QStringList>
+
+#include <climits>
+#include <cinttypes>
+
+MatchTableModel::MatchTableModel(ProcessMemory &scanner, QObject *parent)
+    : QAbstractTableModel(parent), scanner_(scanner) {}
+
+int MatchTableModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : rows_;
+}
+
+int MatchTableModel::columnCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : COLUMN_COUNT;
+}
+
+QVariant MatchTableModel::headerData(int section, Qt::Orientation orientation,
+                                     int role) const {
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal) {
+        return {};
+    }
+    switch (section) {
+    case COLUMN_ADDRESS:
+        return tr("Address");
+    case COLUMN_VALUE:
+        return tr("Value");
+    case COLUMN_PREVIOUS:
+        return tr("Previous");
+    default:
+        return {};
+    }
+}
+
+QVariant MatchTableModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || index.row() >= rows_) {
+        return {};
+    }
+    const int row = index.row();
+
+    if (role == Qt::ToolTipRole && index.column() == COLUMN_ADDRESS) {
+        auto maps = scanner_.maps();
+        return QString::fromStdString(
+            maps->index.label(reinterpret_cast<uintptr_t>(address(row))));
+    }
+    if (role == Qt::ToolTipRole && index.column() == COLUMN_PREVIOUS) {
+        return history_tooltip(row);
+    }
+    if (role != Qt::DisplayRole) {
+        return {};
+    }
+
+    switch (index.column()) {
+    case COLUMN_ADDRESS: {
+        char str_address[64];
+        snprintf(str_address, sizeof(str_address), "%p", address(row));
+        return QString::fromLatin1(str_address);
+    }
+    case COLUMN_VALUE: {
+        const block &b = fetch_block(row / block_rows);
+        const int i = row % block_rows;
+        if (!b.valid[i]) {
+            return QStringLiteral("??");
+        }
+        return format_value(type_, b.values[i]);
+    }
+    case COLUMN_PREVIOUS: {
+        // Value at the last scan or snapshot, kept by the scanner so
+        // nothing has to be read here
+        std::uint64_t value = 0;
+        if (!scanner_.history().get(static_cast<std::size_t>(row), 0, value)) {
+            return QString();
+        }
+        return format_value(type_, value);
+    }
+    default:
+        return {};
+    }
+}
+
+void MatchTableModel::begin_scan() {
+    beginResetModel();
+    rows_ = 0;
+    cache_.clear();
+    endResetModel();
+}
+
+void MatchTableModel::end_scan(value_type type) {
+    beginResetModel();
+    type_ = type;
+    rows_ = static_cast<int>(std::min<std::size_t>(scanner_.get_matches().size(),
+                                                   INT_MAX));
+    cache_.clear();
+    endResetModel();
+}
+
+/**
+ * @brief MatchTableModel::history_tooltip lists the older values of a row,
+ * newest first
+ */
+QString MatchTableModel::history_tooltip(int row) const {
+    const MatchHistory &history = scanner_.history();
+    QStringList values;
+    for (std::size_t age = 0; age < history.filled(); ++age) {
+        std::uint64_t value = 0;
+        values << (history.get(static_cast<std::size_t>(row), age, value)
+                       ? format_value(type_, value)
+                       : QStringLiteral("??"));
+    }
+    return values.join(QStringLiteral(", "));
+}
+
+void MatchTableModel::clear() {
+    begin_scan();
+}
+
+void *MatchTableModel::address(int row) const {
+    if (row < 0 || row >= rows_) {
+        return nullptr;
+    }
+    return scanner_.get_matches()[static_cast<std::size_t>(row)];
+}
+
+void MatchTableModel::apply_updates(const std::vector<monitor_update> &updates) {
+    int changed_first = -1, changed_last = -1;
+    for (const monitor_update &update : updates) {
+        if (update.table != MemoryMonitor::TABLE_MATCHES ||
+            address(update.row) != update.address) {
+            continue;
+        }
+        auto it = cache_.find(update.row / block_rows);
+        if (it == cache_.end()) {
+            continue;
+        }
+        const int i = update.row % block_rows;
+        it->second.valid[i] = update.valid;
+        it->second.values[i] = update.value;
+        changed_first = changed_first < 0 ? update.row
+                                          : std::min(changed_first, update.row);
+        changed_last = std::max(changed_last, update.row);
+    }
+
+    if (changed_first >= 0) {
+        emit dataChanged(index(changed_first, COLUMN_VALUE),
+                         index(changed_last, COLUMN_VALUE), {Qt::DisplayRole});
+    }
+}
+
+void MatchTableModel::history_changed() {
+    if (rows_ > 0) {
+        emit dataChanged(index(0, COLUMN_PREVIOUS), index(rows_ - 1, COLUMN_PREVIOUS),
+                         {Qt::DisplayRole, Qt::ToolTipRole});
+    }
+}
+
+const MatchTableModel::block &MatchTableModel::fetch_block(int block_index) const {
+    auto it = cache_.find(block_index);
+    if (it != cache_.end()) {
+        return it->second;
+    }
+
+    if (cache_.size() >= max_blocks) {
+        cache_.clear();
+    }
+
+    const int first = block_index * block_rows;
+    const int count = std::min(block_rows, rows_ - first);
+    block b{std::make_unique<std::uint64_t[]>(block_rows),
+            std::make_unique<bool[]>(block_rows)};
+    read_rows(first, count, b.values.get(), b.valid.get());
+    return cache_.emplace(block_index, std::move(b)).first->second;
+}
+
+/**
+ * @brief MatchTableModel::read_rows reads the values of `count` rows starting
+ * at `first` in one batch
+ */
+void MatchTableModel::read_rows(int first, int count, std::uint64_t *values,
+                                bool *valid) const {
+    const std::size_t size = value_type_size(type_);
+    const auto &matches = scanner_.get_matches();
+    std::vector<ReadRequest> requests(static_cast<std::size_t>(count));
+
+    // Values are zero-extended to 64 bits, so each one is read into the low
+    // bytes of its own slot
+    std::fill_n(values, count, 0);
+    for (std::size_t i = 0; i < requests.size(); ++i) {
+        requests[i] = {matches[static_cast<std::size_t>(first) + i], &values[i], size};
+    }
+    scanner_.read_many(requests);
+    for (std::size_t i = 0; i < requests.size(); ++i) {
+        valid[i] = requests[i].result > 0;
+    }
+}
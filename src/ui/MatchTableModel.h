@@ -0,0 +1,90 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QString>
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "value_type.h"
+
+class ProcessMemory;
+struct monitor_update;
+
+/**
+ * Table model sitting directly on the scanner's match list. Nothing is
+ * copied per row, values are read lazily in blocks of consecutive rows with
+ * a single vectored read the first time one of them is painted.
+ */
+class MatchTableModel : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    enum columns {
+        COLUMN_ADDRESS = 0,
+        COLUMN_VALUE,
+        COLUMN_PREVIOUS,
+        COLUMN_COUNT
+    };
+
+    /** Rows read together when a value is missing */
+    static constexpr int block_rows = 256;
+
+    explicit MatchTableModel(ProcessMemory &scanner, QObject *parent = nullptr);
+    ~MatchTableModel() override = default;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+    /**
+     * @brief begin_scan detaches the model from the match list while a scan
+     * is modifying it
+     */
+    void begin_scan();
+
+    /**
+     * @brief end_scan attaches the model to the match list again
+     * @param type type of the values that were searched for
+     */
+    void end_scan(value_type type);
+
+    void clear();
+
+    void *address(int row) const;
+
+    value_type type() const {
+        return type_;
+    }
+
+    /**
+     * @brief apply_updates stores values read by the memory monitor and
+     * emits dataChanged for the rows they belong to
+     */
+    void apply_updates(const std::vector<monitor_update> &updates);
+
+    /** @brief history_changed repaints the Previous column after a snapshot */
+    void history_changed();
+
+private:
+    struct block {
+        std::unique_ptr<std::uint64_t[]> values;
+        std::unique_ptr<bool[]> valid;
+    };
+
+    /** Upper bound of cached blocks before the cache is dropped */
+    static constexpr std::size_t max_blocks = 128;
+
+    ProcessMemory &scanner_;
+    value_type type_{VALUE_U32};
+    int rows_{};
+    mutable std::unordered_map<int, block> cache_{};
+
+    const block &fetch_block(int block_index) const;
+    QString history_tooltip(int row) const;
+    void read_rows(int first, int count, std::uint64_t *values, bool *valid) const;
+};
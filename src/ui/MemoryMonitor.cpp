@@ -0,0 +1,80 @@
+#include "ui/MemoryMonitor.h"
+
+#include <QTimer>
+
+#include "ProcessMemory.h"
+
+MemoryMonitor::MemoryMonitor(QObject *parent) : QObject(parent) {
+    qRegisterMetaType<std::vector<monitor_update>>();
+}
+
+void MemoryMonitor::set_targets(pid_t pid, std::vector<monitor_target> targets) {
+    std::lock_guard lock{lock_};
+    pending_pid_ = pid;
+    pending_ = std::move(targets);
+    dirty_ = true;
+}
+
+void MemoryMonitor::start(int interval) {
+    if (timer_ == nullptr) {
+        timer_ = new QTimer(this);
+        connect(timer_, &QTimer::timeout, this, &MemoryMonitor::tick);
+    }
+    timer_->start(interval);
+}
+
+void MemoryMonitor::set_interval(int interval) {
+    if (timer_ != nullptr) {
+        timer_->setInterval(interval);
+    }
+}
+
+void MemoryMonitor::stop() {
+    if (timer_ != nullptr) {
+        timer_->stop();
+    }
+}
+
+void MemoryMonitor::tick() {
+    {
+        std::lock_guard lock{lock_};
+        if (dirty_) {
+            pid_ = pending_pid_;
+            targets_.swap(pending_);
+            pending_.clear();
+            dirty_ = false;
+            values_.assign(targets_.size(), 0);
+            valid_.assign(targets_.size(), false);
+            known_.assign(targets_.size(), false);
+        }
+    }
+    if (pid_ <= 0 || targets_.empty()) {
+        return;
+    }
+
+    const std::size_t count = targets_.size();
+    std::vector<std::uint64_t> values(count, 0);
+    std::vector<ReadRequest> requests(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const monitor_target &t = targets_[i];
+        requests[i] = {t.address, &values[i], t.size};
+    }
+    ProcessMemory::read_many(pid_, requests);
+
+    std::vector<monitor_update> updates;
+    for (std::size_t i = 0; i < count; ++i) {
+        const bool valid = requests[i].result > 0;
+        if (known_[i] && valid_[i] == valid && values_[i] == values[i]) {
+            continue;
+        }
+        known_[i] = true;
+        valid_[i] = valid;
+        values_[i] = values[i];
+        const monitor_target &t = targets_[i];
+        updates.push_back({t.address, values[i], t.table, valid, t.row});
+    }
+
+    if (!updates.empty()) {
+        emit values_changed(std::move(updates));
+    }
+}
@@ -4,58 +4,83 @@
 
 #pragma once
 #include <QObject>
-#include <variant>
+#include <QMetaType>
 
-#include "ProcessMemory.h"
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <sys/types.h>
 
+class QTimer;
+
+/**
+ * One address the monitor keeps an eye on, `table` and `row` are opaque to
+ * the monitor and only passed back so the ui knows which cell to update.
+ */
+struct monitor_target {
+    void            *address;
+    std::uint8_t    size;
+    std::uint8_t    table;
+    int             row;
+};
+
+struct monitor_update {
+    void            *address;
+    std::uint64_t   value;
+    std::uint8_t    table;
+    bool            valid;
+    int             row;
+};
+
+Q_DECLARE_METATYPE(std::vector<monitor_update>)
+
+/**
+ * Periodically reads a set of addresses on its own thread. All targets are
+ * read with a handful of vectored reads per tick and only the values that
+ * differ from the previous tick are reported back.
+ */
 class MemoryMonitor : public QObject {
     Q_OBJECT
-    const ProcessMemory &scanner;
 public:
-    explicit MemoryMonitor(const ProcessMemory &scanner, QObject *parent = nullptr) : QObject(parent), scanner(scanner) {}
-    ~MemoryMonitor() override {}
+    enum tables : std::uint8_t {
+        TABLE_MATCHES = 0,
+        TABLE_SAVED
+    };
+
+    explicit MemoryMonitor(QObject *parent = nullptr);
+    ~MemoryMonitor() override = default;
+
+    /**
+     * @brief set_targets replaces the watched addresses, safe to call from
+     * any thread. Everything is reported again on the next tick.
+     */
+    void set_targets(pid_t pid, std::vector<monitor_target> targets);
 
 public slots:
-    // Call this whenever you want the worker to do “one pass” of updating.
-    // You pass in the current scroll position, and the list of Matches (so
-    // that the worker can loop over them and read memory).
-    void doOneUpdate(int firstRow, int lastRow, const std::vector<Match> &matches) {
-        // For each row in [firstRow..lastRow), read the pointer and produce (row, newValue) pairs.
-        // We'll accumulate them in a temporary list and then emit them all at once.
-
-        std::vector<std::pair<int, QString>> updates;
-        updates.reserve(lastRow - firstRow);
-
-        for (const auto &m : matches) {
-            // We want only those whose “row index” is between firstRow and lastRow.
-            // Let’s say you also store somewhere a vector<int> that maps each match → its row index.
-            // For simplicity, I’ll assume “matches” is in exactly the same order as your table rows,
-            // so row = index. If you had a more complicated mapping, adjust accordingly.
-
-            // In practice, the worker doesn’t know “widget->verticalScrollBar()->value()”. The
-            // main thread will pass in firstRow/lastRow from the current scrollbar. So here:
-            int row = 0;
-            if (row < firstRow || row >= lastRow)
-                continue;
-
-            // Now actually do the read‐memory:
-            std::visit([&](auto *ptr) {
-                using U = std::remove_pointer_t<decltype(ptr)>;
-                if (!ptr) return;
-
-                U val{};
-                [[maybe_unused]] ssize_t n = scanner.read_process_memory(ptr, &val, sizeof(val));
-                assert(n == sizeof(val));
-
-                updates.push_back({ row, QString::number(val) });
-            }, m);
-        }
-
-        // Once we’ve collected all the (row,newText) that need repainting, emit one signal.
-        emit valuesReady(updates);
-    }
+    /** Must be invoked on the monitor thread */
+    void start(int interval);
+    void set_interval(int interval);
+    void stop();
 
 signals:
-    // This signal carries a list of (row, new‐text). It will be queued to the main thread.
-    void valuesReady(std::vector<std::pair<int, QString>> updates);
+    // Carries only the cells that changed, queued to the main thread.
+    void values_changed(std::vector<monitor_update> updates);
+
+private slots:
+    void tick();
+
+private:
+    QTimer *timer_{};
+
+    std::mutex lock_{};
+    pid_t pending_pid_{-1};
+    std::vector<monitor_target> pending_{};
+    bool dirty_{};
+
+    // Only touched from the monitor thread
+    pid_t pid_{-1};
+    std::vector<monitor_target> targets_{};
+    std::vector<std::uint64_t> values_{};
+    std::vector<bool> valid_{};
+    std::vector<bool> known_{};
 };
@@ -0,0 +1,89 @@
+#include "ui/MemoryViewer.h"
+#include "ui/HexView.h"
+#include "ProcessMemory.h"
+
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QVBoxLayout>
+
+MemoryViewer::MemoryViewer(ProcessMemory &scanner, QWidget *parent)
+    : QDialog(parent),
+      scanner_(scanner),
+      addressEdit_(new QLineEdit(this)),
+      range_(new QLabel(this)),
+      selection_(new QLabel(this)),
+      view_(new HexView(scanner.pid(), this))
+{
+    setWindowTitle(tr("Memory viewer"));
+    resize(820, 600);
+
+    addressEdit_->setPlaceholderText(tr("Address (hex)"));
+    auto *goButton = new QPushButton(tr("Go"), this);
+
+    auto *top = new QHBoxLayout();
+    top->addWidget(addressEdit_);
+    top->addWidget(goButton);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addLayout(top);
+    layout->addWidget(range_);
+    layout->addWidget(view_, 1);
+    layout->addWidget(selection_);
+    setLayout(layout);
+
+    connect(goButton, &QPushButton::clicked, this, &MemoryViewer::go);
+    connect(addressEdit_, &QLineEdit::returnPressed, this, &MemoryViewer::go);
+    connect(view_, &HexView::addressSelected, this, &MemoryViewer::selectionChanged);
+}
+
+bool MemoryViewer::gotoAddress(std::uintptr_t address) {
+    auto maps = scanner_.maps();
+    std::ptrdiff_t i = maps->index.find(address);
+    if (i == address_range_index::npos) {
+        // The mapping may be newer than the snapshot
+        maps = scanner_.refresh_maps();
+        i = maps->index.find(address);
+    }
+    if (i == address_range_index::npos) {
+        return false;
+    }
+    const address_range &range = maps->ranges[static_cast<std::size_t>(i)];
+    const auto start = reinterpret_cast<std::uintptr_t>(range.start);
+    if (start != view_->rangeStart() || range.length != view_->rangeLength()) {
+        view_->setRange(start, range.length);
+        range_->setText(QString("0x%1-0x%2 %3")
+                            .arg(start, 0, 16)
+                            .arg(start + range.length, 0, 16)
+                            .arg(QString::fromLocal8Bit(range.name)));
+    }
+    view_->gotoAddress(address);
+    addressEdit_->setText(QString::number(address, 16));
+    selectionChanged(address);
+    return true;
+}
+
+void MemoryViewer::go() {
+    bool ok = false;
+    QString text = addressEdit_->text().trimmed();
+    if (text.startsWith("0x", Qt::CaseInsensitive)) {
+        text = text.mid(2);
+    }
+    const std::uintptr_t address = text.toULongLong(&ok, 16);
+    if (!ok) {
+        QMessageBox::warning(this, tr("Invalid address"),
+                             tr("Please enter a hexadecimal address"));
+        return;
+    }
+    if (!gotoAddress(address)) {
+        QMessageBox::warning(this, tr("Not mapped"),
+                             tr("0x%1 isn't in any mapping of the process").arg(address, 0, 16));
+    }
+}
+
+void MemoryViewer::selectionChanged(std::uintptr_t address) {
+    const std::uintptr_t offset = address - view_->rangeStart();
+    selection_->setText(tr("Selected 0x%1 (+0x%2)").arg(address, 0, 16).arg(offset, 0, 16));
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QDialog>
+#include <cstdint>
+
+class HexView;
+class ProcessMemory;
+class QLabel;
+class QLineEdit;
+
+/**
+ * Hex view of the mapping around an address, following the address typed
+ * into it to whichever mapping contains it.
+ */
+class MemoryViewer : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit MemoryViewer(ProcessMemory &scanner, QWidget *parent = nullptr);
+    ~MemoryViewer() override = default;
+
+    /**
+     * @brief gotoAddress shows the mapping containing `address`
+     * @return false if no mapping contains it
+     */
+    bool gotoAddress(std::uintptr_t address);
+
+private slots:
+    void go();
+    void selectionChanged(std::uintptr_t address);
+
+private:
+    ProcessMemory   &scanner_;
+    QLineEdit       *addressEdit_;
+    QLabel          *range_;
+    QLabel          *selection_;
+    HexView         *view_;
+};
@@ -1,56 +1,108 @@
 #include "ui/PidDialog.h"
+#include "ui/ProcessListModel.h"
 
 #include <qcoreapplication.h>
 #include <QVBoxLayout>
 #include <QKeyEvent>
-#include <QDir>
-#include <QVector>
-#include <QTextStream>
-#include <QDebug>
+#include <QHeaderView>
+#include <QtConcurrent/QtConcurrent>
 #include <qnamespace.h>
 
 PidDialog::PidDialog(QWidget *parent) : QDialog(parent),
-	search{new QLineEdit(this)}, listWidget{new QListWidget(this)} {
+	search{new QLineEdit(this)}, view{new QTableView(this)}, status{new QLabel(this)},
+	model{new ProcessListModel(this)}, filter{new ProcessFilterModel(this)},
+	refreshTimer{new QTimer(this)} {
 
 	setWindowTitle("Select a PID");
+	resize(800, 500);
 	auto *layout = new QVBoxLayout(this);
 
 	search->setPlaceholderText(tr("Search..."));
 	layout->addWidget(search);
-	layout->addWidget(listWidget);
-
-	populateList();
+	layout->addWidget(view);
+	layout->addWidget(status);
+
+	filter->setSourceModel(model);
+	view->setModel(filter);
+	view->setSelectionBehavior(QAbstractItemView::SelectRows);
+	view->setSelectionMode(QAbstractItemView::SingleSelection);
+	view->setEditTriggers(QAbstractItemView::NoEditTriggers);
+	view->verticalHeader()->setVisible(false);
+	view->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+	view->horizontalHeader()->setSectionResizeMode(ProcessListModel::COLUMN_COMMAND,
+	                                               QHeaderView::Stretch);
+	view->setSortingEnabled(true);
+	view->sortByColumn(ProcessListModel::COLUMN_PID, Qt::AscendingOrder);
 
 	// Filter as the user types
 	connect(search, &QLineEdit::textChanged,
 		 this, &PidDialog::filterItems);
 
 	// Selection by double-click or Enter key
-	connect(listWidget, &QListWidget::itemActivated,
-		 this, &PidDialog::onItemActivated);
+	connect(view, &QTableView::activated,
+		 this, &PidDialog::onActivated);
 
 	connect(search, &QLineEdit::returnPressed, this, [this]() {
-		if (auto *it = listWidget->currentItem())
-			onItemActivated(it);
+		onActivated(view->currentIndex());
 	});
+
+	// The list fills in as /proc is walked in the background, then keeps
+	// itself up to date
+	connect(&enumeration, &QFutureWatcher<void>::finished,
+		 this, &PidDialog::enumerationFinished);
+	connect(refreshTimer, &QTimer::timeout, this, &PidDialog::refresh);
+	refreshTimer->start(2000);
+	refresh();
+
 	search->installEventFilter(this);
-	listWidget->installEventFilter(this);
+	view->installEventFilter(this);
 	search->setFocus();
 
 }
 
-void PidDialog::filterItems(const QString &text) {
-	for (int i = 0; i < listWidget->count(); ++i) {
-		auto *item = listWidget->item(i);
-		bool match = item->text().contains(text, Qt::CaseInsensitive);
-		item->setHidden(!match);
+PidDialog::~PidDialog() {
+	cancel = true;
+	enumeration.waitForFinished();
+}
+
+void PidDialog::refresh() {
+	if (enumeration.isRunning()) {
+		return;
 	}
-	// select first visible
-	for (int i = 0; i < listWidget->count(); ++i) {
-		if (!listWidget->item(i)->isHidden()) {
-			listWidget->setCurrentRow(i);
-			break;
-		}
+	const unsigned current = ++generation;
+	enumeration.setFuture(QtConcurrent::run([this, current] {
+		enumerate_processes([this, current](std::vector<process_info> &&batch) {
+			QMetaObject::invokeMethod(this, [this, current, batch = std::move(batch)]() mutable {
+				model->merge(std::move(batch), current);
+				selectFirst();
+			}, Qt::QueuedConnection);
+		}, cancel);
+	}));
+}
+
+void PidDialog::enumerationFinished() {
+	if (cancel) {
+		return;
+	}
+	// Queued batches are delivered before this, so everything not seen by
+	// this pass has exited
+	model->prune(generation);
+	status->setText(tr("%1 processes").arg(model->rowCount()));
+	selectFirst();
+}
+
+void PidDialog::selectFirst() {
+	if (!view->currentIndex().isValid() && filter->rowCount() > 0) {
+		view->setCurrentIndex(filter->index(0, 0));
+	}
+}
+
+void PidDialog::filterItems(const QString &text) {
+	filter->setPattern(text);
+	// select the best match
+	if (filter->rowCount() > 0) {
+		view->setCurrentIndex(filter->index(0, 0));
+		view->scrollToTop();
 	}
 }
 
@@ -59,92 +111,41 @@ bool PidDialog::eventFilter(QObject *watched, QEvent *event) {
 		return QDialog::eventFilter(watched, event);
 
 	auto *ke = static_cast<QKeyEvent*>(event);
+	const bool navigation = ke->key() == Qt::Key_Down || ke->key() == Qt::Key_Up ||
+		ke->key() == Qt::Key_PageDown || ke->key() == Qt::Key_PageUp;
 
 	// 1) In the search box: Up/Down → move focus into the list and replay the arrow
-	if (watched == search &&
-		(ke->key() == Qt::Key_Down || ke->key() == Qt::Key_Up))
-	{
-		listWidget->setFocus();
+	if (watched == search && navigation) {
+		view->setFocus();
 		// repost the same arrow key event so the list will act on it
 		auto *clone = ke->clone();
-		QCoreApplication::postEvent(listWidget, clone);
+		QCoreApplication::postEvent(view, clone);
 		return true;
 	}
 
-	// 2) In the list: Up/Down → custom nav that skips hidden items
-	if (watched == listWidget &&
-		(ke->key() == Qt::Key_Down || ke->key() == Qt::Key_Up))
-	{
-		const int step  = (ke->key() == Qt::Key_Down) ? 1 : -1;
-		const int count = listWidget->count();
-		int row         = listWidget->currentRow();
-
-		for (int i = row + step; i >= 0 && i < count; i += step) {
-			if (!listWidget->item(i)->isHidden()) {
-				listWidget->setCurrentRow(i);
-				listWidget->scrollToItem(listWidget->currentItem(), QAbstractItemView::PositionAtCenter);
-				break;
-			}
-		}
+	// 2) Enter/Return anywhere → activate the current item
+	if (ke->key() == Qt::Key_Return || ke->key() == Qt::Key_Enter) {
+		onActivated(view->currentIndex());
 		return true;
 	}
 
 	// 3) In the list: any other key → send back to search so they can keep typing
-	if (watched == listWidget) {
+	if (watched == view && !navigation) {
 		search->setFocus();
 		auto *clone = ke->clone();
 		QCoreApplication::postEvent(search, clone);
 		return true;
 	}
 
-	// 4) Enter/Return anywhere → activate the current item
-	if (ke->key() == Qt::Key_Return || ke->key() == Qt::Key_Enter) {
-		if (auto *it = listWidget->currentItem())
-			onItemActivated(it);
-		return true;
-	}
-
 	return QDialog::eventFilter(watched, event);
 }
 
-void PidDialog::onItemActivated(QListWidgetItem *item) {
-	int pid = item->data(Qt::UserRole).toInt();
-	QString displayText = item->text();
-	emit pidSelected(pid, displayText);
-	accept();
-}
-
-void PidDialog::populateList() {
-	QDir procDir("/proc");
-	QStringList entries = procDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
-	int maxPidDigits = 0;
-	struct Entry { int pid; QString name; };
-	QVector<Entry> entriesData;
-
-	for (const QString &entry : entries) {
-		bool ok = false;
-		int pid = entry.toInt(&ok);
-		if (!ok) continue;
-
-		QString commPath = QString("/proc/%1/comm").arg(pid);
-		QFile commFile(commPath);
-		QString procName = tr("<unknown>");
-		if (commFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-			QTextStream in(&commFile);
-			procName = in.readLine().trimmed();
-		}
-
-		entriesData.append({pid, procName});
-		maxPidDigits = qMax(maxPidDigits, QString::number(pid).length());
+void PidDialog::onActivated(const QModelIndex &index) {
+	if (!index.isValid()) {
+		return;
 	}
-
-	for (const auto &e : entriesData) {
-		QString itemText = QString("%1: %2")
-			.arg(e.pid, -maxPidDigits)
-			.arg(e.name);
-		auto *item = new QListWidgetItem(itemText, listWidget);
-		item->setData(Qt::UserRole, e.pid);
-	}
-	if (listWidget->count() > 0)
-		listWidget->setCurrentRow(0);
+	const process_info &info = model->process(filter->mapToSource(index).row());
+	QString displayText = QString("%1: %2").arg(info.pid).arg(QString::fromStdString(info.comm));
+	emit pidSelected(info.pid, displayText);
+	accept();
 }
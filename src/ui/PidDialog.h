@@ -1,16 +1,32 @@
 #pragma once
 #include <QDialog>
+#include <QFutureWatcher>
+#include <QLabel>
 #include <QLineEdit>
-#include <QListWidget>
+#include <QTableView>
+#include <QTimer>
+
+#include <atomic>
+
+class ProcessListModel;
+class ProcessFilterModel;
 
 class PidDialog : public QDialog {
 	Q_OBJECT;
 
 	QLineEdit *search;
-	QListWidget *listWidget;
+	QTableView *view;
+	QLabel *status;
+	ProcessListModel *model;
+	ProcessFilterModel *filter;
+	QTimer *refreshTimer;
+	QFutureWatcher<void> enumeration;
+	std::atomic<bool> cancel{false};
+	unsigned generation = 0;
 
 public:
 	explicit PidDialog(QWidget *parent = nullptr);
+	~PidDialog() override;
 
 
 signals:
@@ -21,9 +37,10 @@ protected:
 
 private slots:
 	void filterItems(const QString &text);
-	void onItemActivated(QListWidgetItem *item);
+	void onActivated(const QModelIndex &index);
+	void refresh();
+	void enumerationFinished();
 
 private:
-	void populateList();
-
+	void selectFirst();
 };
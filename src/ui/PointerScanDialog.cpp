@@ -0,0 +1,314 @@
+#include "ui/PointerScanDialog.h"
+#include "PointerMapFile.h"
+#include "ProcessMemory.h"
+
+#include <QApplication>
+#include <QFileDialog>
+#include <QFormLayout>
+#include <QFutureWatcher>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QInputDialog>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMenu>
+#include <QMessageBox>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <QVBoxLayout>
+#include <QtConcurrent/QtConcurrent>
+
+PointerScanDialog::PointerScanDialog(ProcessMemory &scanner, uintptr_t target,
+                                     QWidget *parent)
+    : QDialog(parent),
+      scanner_(scanner),
+      targetEdit_(new QLineEdit(this)),
+      depthSpin_(new QSpinBox(this)),
+      offsetEdit_(new QLineEdit(this)),
+      scanButton_(new QPushButton(tr("Scan"), this)),
+      refreshButton_(new QPushButton(tr("Refresh map"), this)),
+      saveButton_(new QPushButton(tr("Save map..."), this)),
+      loadButton_(new QPushButton(tr("Load map..."), this)),
+      compareButton_(new QPushButton(tr("Compare with..."), this)),
+      progress_(new QProgressBar(this)),
+      status_(new QLabel(this)),
+      table_(new QTableWidget(this))
+{
+    setWindowTitle(tr("Pointer scan"));
+    resize(800, 500);
+
+    if (target != 0) {
+        targetEdit_->setText(QString("0x%1").arg(target, 0, 16));
+    }
+    targetEdit_->setPlaceholderText("e.g. 0x7f3e2a500000");
+    depthSpin_->setRange(1, 8);
+    depthSpin_->setValue(4);
+    offsetEdit_->setText("0x1000");
+    progress_->setRange(0, 100);
+    compareButton_->setToolTip(tr("Keep only the paths that also lead to the "
+                                  "address in a map saved from another run"));
+
+    auto *form = new QFormLayout();
+    form->addRow(tr("Address:"), targetEdit_);
+    form->addRow(tr("Max depth:"), depthSpin_);
+    form->addRow(tr("Max offset:"), offsetEdit_);
+
+    auto *buttons = new QHBoxLayout();
+    buttons->addWidget(scanButton_);
+    buttons->addWidget(refreshButton_);
+    buttons->addWidget(saveButton_);
+    buttons->addWidget(loadButton_);
+    buttons->addWidget(compareButton_);
+    buttons->addWidget(progress_);
+
+    table_->setColumnCount(2);
+    table_->setHorizontalHeaderLabels({tr("Path"), tr("Points to")});
+    table_->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    table_->horizontalHeader()->setSectionResizeMode(1, QHeaderView::ResizeToContents);
+    table_->verticalHeader()->setVisible(false);
+    table_->setEditTriggers(QTableWidget::NoEditTriggers);
+    table_->setSelectionBehavior(QTableWidget::SelectRows);
+    table_->setContextMenuPolicy(Qt::CustomContextMenu);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addLayout(form);
+    layout->addLayout(buttons);
+    layout->addWidget(status_);
+    layout->addWidget(table_);
+    setLayout(layout);
+
+    connect(scanButton_, &QPushButton::clicked, this, &PointerScanDialog::startScan);
+    connect(refreshButton_, &QPushButton::clicked, this, &PointerScanDialog::refreshMap);
+    connect(saveButton_, &QPushButton::clicked, this, &PointerScanDialog::saveMap);
+    connect(loadButton_, &QPushButton::clicked, this, &PointerScanDialog::loadMap);
+    connect(compareButton_, &QPushButton::clicked, this, &PointerScanDialog::compareWith);
+    connect(table_, &QTableWidget::customContextMenuRequested, this,
+            &PointerScanDialog::showContextMenu);
+}
+
+PointerScanDialog::~PointerScanDialog() {
+    // The scan refers to the dialog for progress updates
+    cancel_ = true;
+    future_.waitForFinished();
+}
+
+void PointerScanDialog::refreshMap() {
+    map_.reset();
+    maps_.reset();
+    file_.reset();
+    status_->setText(tr("Pointer map will be rebuilt on the next scan"));
+}
+
+bool PointerScanDialog::readOptions(uintptr_t &target, pointer_scan_options &options) {
+    bool ok = false;
+    target = targetEdit_->text().trimmed().toULongLong(&ok, 16);
+    if (!ok) {
+        QMessageBox::warning(this, tr("Invalid Address"),
+                             tr("Could not parse the given address."));
+        return false;
+    }
+    uintptr_t max_offset = offsetEdit_->text().trimmed().toULongLong(&ok, 16);
+    if (!ok) {
+        QMessageBox::warning(this, tr("Invalid Offset"),
+                             tr("Could not parse the maximum offset."));
+        return false;
+    }
+    options.max_depth = static_cast<unsigned>(depthSpin_->value());
+    options.max_offset = max_offset;
+    options.cancel = &cancel_;
+    return true;
+}
+
+void PointerScanDialog::setBusy(bool busy) {
+    scanButton_->setEnabled(!busy);
+    refreshButton_->setEnabled(!busy);
+    saveButton_->setEnabled(!busy);
+    loadButton_->setEnabled(!busy);
+    compareButton_->setEnabled(!busy);
+}
+
+void PointerScanDialog::run(std::function<scan_result()> job) {
+    setBusy(true);
+    progress_->setValue(0);
+    cancel_ = false;
+    future_ = QtConcurrent::run(std::move(job));
+
+    auto *watcher = new QFutureWatcher<scan_result>(this);
+    connect(watcher, &QFutureWatcher<scan_result>::finished, this, [this, watcher] {
+        scan_result r = watcher->result();
+        if (r.map) {
+            maps_ = r.maps;
+            map_ = r.map;
+        }
+        paths_ = std::move(r.paths);
+        showResults(paths_, r.stats);
+        setBusy(false);
+        watcher->deleteLater();
+    });
+    watcher->setFuture(future_);
+}
+
+void PointerScanDialog::startScan() {
+    uintptr_t target = 0;
+    pointer_scan_options options{};
+    if (!readOptions(target, options)) {
+        return;
+    }
+
+    if (file_) {
+        status_->setText(tr("Searching saved map..."));
+        run([file = file_, target, options] {
+            scan_result r{};
+            r.paths = find_pointer_paths(*file, file->maps(), target, options, &r.stats);
+            return r;
+        });
+        return;
+    }
+
+    status_->setText(map_ ? tr("Searching...") : tr("Building pointer map..."));
+    run([this, cached_maps = maps_, cached_map = map_, target, options] {
+        auto maps = cached_maps;
+        auto map = cached_map;
+        if (!map) {
+            maps = scanner_.refresh_maps();
+            map = std::make_shared<const pointer_map>(pointer_map::build(
+                scanner_.pid(), *maps, scanner_.max_read_size(),
+                [this](size_t current, size_t total) {
+                    QMetaObject::invokeMethod(progress_, [this, current, total] {
+                        progress_->setValue(int(double(current) / double(total) * 100));
+                    }, Qt::QueuedConnection);
+                }));
+        }
+        pointer_scan_stats stats{};
+        auto paths = find_pointer_paths(*map, *maps, target, options, &stats);
+        return scan_result{maps, map, std::move(paths), stats};
+    });
+}
+
+void PointerScanDialog::saveMap() {
+    if (!map_) {
+        QMessageBox::information(this, tr("No pointer map"),
+                                 tr("Run a scan first to build the pointer map."));
+        return;
+    }
+    QString path = QFileDialog::getSaveFileName(this, tr("Save pointer map"), QString(),
+                                                tr("Pointer maps (*.ptrmap)"));
+    if (path.isEmpty()) {
+        return;
+    }
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    bool ok = save_pointer_map(path.toStdString(), *map_, *maps_);
+    QApplication::restoreOverrideCursor();
+    if (!ok) {
+        QMessageBox::warning(this, tr("Save failed"),
+                             tr("Could not write %1").arg(path));
+    }
+}
+
+void PointerScanDialog::loadMap() {
+    QString path = QFileDialog::getOpenFileName(this, tr("Load pointer map"), QString(),
+                                                tr("Pointer maps (*.ptrmap)"));
+    if (path.isEmpty()) {
+        return;
+    }
+    std::shared_ptr<const pointer_map_file> file = pointer_map_file::open(path.toStdString());
+    if (!file) {
+        QMessageBox::warning(this, tr("Load failed"),
+                             tr("%1 is not a valid pointer map").arg(path));
+        return;
+    }
+    file_ = file;
+    status_->setText(tr("Loaded %1 pointers from %2, scans use the saved map "
+                        "until it is refreshed")
+                         .arg(file_->size())
+                         .arg(path));
+}
+
+void PointerScanDialog::compareWith() {
+    if (paths_.empty()) {
+        QMessageBox::information(this, tr("No results"),
+                                 tr("Run a scan first, its results are compared "
+                                    "against the other map."));
+        return;
+    }
+    uintptr_t target = 0;
+    pointer_scan_options options{};
+    if (!readOptions(target, options)) {
+        return;
+    }
+    QString path = QFileDialog::getOpenFileName(this, tr("Compare with pointer map"),
+                                                QString(), tr("Pointer maps (*.ptrmap)"));
+    if (path.isEmpty()) {
+        return;
+    }
+    std::shared_ptr<const pointer_map_file> other = pointer_map_file::open(path.toStdString());
+    if (!other) {
+        QMessageBox::warning(this, tr("Load failed"),
+                             tr("%1 is not a valid pointer map").arg(path));
+        return;
+    }
+    bool ok = false;
+    QString address = QInputDialog::getText(this, tr("Address in other run"),
+                                            tr("Address of the value when that map was saved:"),
+                                            QLineEdit::Normal, QString(), &ok);
+    uintptr_t other_target = address.trimmed().toULongLong(&ok, 16);
+    if (!ok) {
+        return;
+    }
+
+    status_->setText(tr("Comparing..."));
+    run([other, other_target, options, current = paths_] {
+        scan_result r{};
+        auto theirs = find_pointer_paths(*other, other->maps(), other_target, options, &r.stats);
+        r.paths = intersect_pointer_paths(current, theirs);
+        return r;
+    });
+}
+
+void PointerScanDialog::showResults(const std::vector<pointer_path> &paths,
+                                    const pointer_scan_stats &stats) {
+    constexpr int max_rows = 10000;
+    const int rows = int(std::min<std::size_t>(paths.size(), max_rows));
+    auto live = scanner_.maps();
+    table_->clearContents();
+    table_->setRowCount(rows);
+    for (int row = 0; row < rows; ++row) {
+        const pointer_path &path = paths[std::size_t(row)];
+        auto resolved = path.resolve(scanner_.pid(), *live);
+        QString points_to = resolved ? QString("0x%1").arg(*resolved, 0, 16)
+                                     : QStringLiteral("??");
+        table_->setItem(row, 0, new QTableWidgetItem(
+                                    QString::fromStdString(path.to_string())));
+        table_->setItem(row, 1, new QTableWidgetItem(points_to));
+    }
+    if (stats.complete) {
+        status_->setText(tr("%1 paths found").arg(paths.size()));
+    } else {
+        status_->setText(tr("%1 paths found, the search stopped after %2 pointers. "
+                            "Lower the depth or offset to search everything.")
+                             .arg(paths.size())
+                             .arg(stats.visits));
+    }
+}
+
+void PointerScanDialog::showContextMenu(const QPoint &pos) {
+    const int row = table_->rowAt(pos.y());
+    if (row < 0 || static_cast<std::size_t>(row) >= paths_.size()) {
+        return;
+    }
+    const pointer_path &path = paths_[static_cast<std::size_t>(row)];
+    auto resolved = path.resolve(scanner_.pid(), *scanner_.maps());
+
+    QMenu menu(this);
+    QAction *save = menu.addAction(tr("Add to saved addresses"));
+    save->setToolTip(tr("The address is found through this path again "
+                        "when the process restarts"));
+    save->setEnabled(resolved.has_value());
+    connect(save, &QAction::triggered, this, [this, address = resolved.value_or(0),
+                                              locator = QString::fromStdString(path.to_string())] {
+        emit saveAddress(address, locator);
+    });
+    menu.exec(table_->viewport()->mapToGlobal(pos));
+}
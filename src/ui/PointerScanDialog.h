@@ -0,0 +1,83 @@
+#pragma once
+
+#include <QDialog>
+#include <QFuture>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "PointerScanner.h"
+
+class ProcessMemory;
+class QLineEdit;
+class QSpinBox;
+class QPushButton;
+class QProgressBar;
+class QTableWidget;
+class QLabel;
+class pointer_map_file;
+
+/**
+ * Finds pointer paths from static module memory to an address. The pointer
+ * map is built once per dialog and reused for every query until refreshed,
+ * it can also be saved to disk and queried or compared against later.
+ */
+class PointerScanDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    PointerScanDialog(ProcessMemory &scanner, uintptr_t target,
+                      QWidget *parent = nullptr);
+    ~PointerScanDialog() override;
+
+signals:
+    /** @param locator the pointer path the address was resolved with */
+    void saveAddress(std::uintptr_t address, QString locator);
+
+private slots:
+    void startScan();
+    void refreshMap();
+    void saveMap();
+    void loadMap();
+    void compareWith();
+    void showContextMenu(const QPoint &pos);
+
+private:
+    struct scan_result {
+        std::shared_ptr<const maps_snapshot>    maps;
+        std::shared_ptr<const pointer_map>      map;
+        std::vector<pointer_path>               paths;
+        pointer_scan_stats                      stats{};
+    };
+
+    ProcessMemory                           &scanner_;
+    QLineEdit                               *targetEdit_;
+    QSpinBox                                *depthSpin_;
+    QLineEdit                               *offsetEdit_;
+    QPushButton                             *scanButton_;
+    QPushButton                             *refreshButton_;
+    QPushButton                             *saveButton_;
+    QPushButton                             *loadButton_;
+    QPushButton                             *compareButton_;
+    QProgressBar                            *progress_;
+    QLabel                                  *status_;
+    QTableWidget                            *table_;
+
+    std::shared_ptr<const maps_snapshot>    maps_{};
+    std::shared_ptr<const pointer_map>      map_{};
+    /** Set instead of map_ when querying a saved map */
+    std::shared_ptr<const pointer_map_file> file_{};
+    std::vector<pointer_path>               paths_{};
+    QFuture<scan_result>                    future_{};
+    /** Set to stop the running search, closing the dialog mustn't wait for it */
+    std::atomic<bool>                       cancel_{};
+
+    bool readOptions(uintptr_t &target, pointer_scan_options &options);
+    void run(std::function<scan_result()> job);
+    void setBusy(bool busy);
+    void showResults(const std::vector<pointer_path> &paths,
+                     const pointer_scan_stats &stats = {});
+};
@@ -0,0 +1,166 @@
+#include "ui/ProcessListModel.h"
+
+#include <QLocale>
+
+#include <algorithm>
+
+ProcessListModel::ProcessListModel(QObject *parent)
+    : QAbstractTableModel(parent) {}
+
+int ProcessListModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : static_cast<int>(processes_.size());
+}
+
+int ProcessListModel::columnCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : COLUMN_COUNT;
+}
+
+QVariant ProcessListModel::headerData(int section, Qt::Orientation orientation,
+                                      int role) const {
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal) {
+        return {};
+    }
+    switch (section) {
+    case COLUMN_PID:
+        return tr("PID");
+    case COLUMN_NAME:
+        return tr("Name");
+    case COLUMN_USER:
+        return tr("User");
+    case COLUMN_MEMORY:
+        return tr("Memory");
+    case COLUMN_COMMAND:
+        return tr("Command line");
+    default:
+        return {};
+    }
+}
+
+QVariant ProcessListModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || static_cast<std::size_t>(index.row()) >= processes_.size()) {
+        return {};
+    }
+    const process_info &info = processes_[static_cast<std::size_t>(index.row())].info;
+
+    // Sorting goes through EditRole so numbers sort as numbers
+    if (role == Qt::EditRole) {
+        switch (index.column()) {
+        case COLUMN_PID:
+            return info.pid;
+        case COLUMN_MEMORY:
+            return static_cast<qulonglong>(info.rss);
+        default:
+            break;
+        }
+    }
+    if (role != Qt::DisplayRole && role != Qt::EditRole) {
+        if (role == Qt::ToolTipRole && index.column() == COLUMN_COMMAND) {
+            return QString::fromStdString(info.cmdline);
+        }
+        return {};
+    }
+    switch (index.column()) {
+    case COLUMN_PID:
+        return info.pid;
+    case COLUMN_NAME:
+        return QString::fromStdString(info.comm);
+    case COLUMN_USER:
+        return QString::fromStdString(info.user);
+    case COLUMN_MEMORY:
+        return QLocale().formattedDataSize(static_cast<qint64>(info.rss));
+    case COLUMN_COMMAND:
+        // Kernel threads have no command line
+        return info.cmdline.empty() ? QString("[%1]").arg(QString::fromStdString(info.comm))
+                                    : QString::fromStdString(info.cmdline);
+    default:
+        return {};
+    }
+}
+
+void ProcessListModel::merge(std::vector<process_info> &&batch, unsigned generation) {
+    std::vector<process_info> added;
+    for (process_info &info : batch) {
+        auto it = rows_.find(info.pid);
+        if (it == rows_.end()) {
+            added.push_back(std::move(info));
+            continue;
+        }
+        entry &existing = processes_[static_cast<std::size_t>(it->second)];
+        existing.generation = generation;
+        // A pid may have been reused by a different process meanwhile
+        if (existing.info.rss != info.rss || existing.info.comm != info.comm ||
+            existing.info.cmdline != info.cmdline || existing.info.uid != info.uid) {
+            existing.info = std::move(info);
+            emit dataChanged(index(it->second, 0), index(it->second, COLUMN_COUNT - 1));
+        }
+    }
+    if (added.empty()) {
+        return;
+    }
+
+    const int first = static_cast<int>(processes_.size());
+    beginInsertRows(QModelIndex(), first, first + static_cast<int>(added.size()) - 1);
+    for (process_info &info : added) {
+        rows_[info.pid] = static_cast<int>(processes_.size());
+        processes_.push_back({std::move(info), generation});
+    }
+    endInsertRows();
+}
+
+void ProcessListModel::prune(unsigned generation) {
+    // Remove runs of exited processes back to front so rows stay valid
+    for (int row = static_cast<int>(processes_.size()) - 1; row >= 0;) {
+        if (processes_[static_cast<std::size_t>(row)].generation == generation) {
+            --row;
+            continue;
+        }
+        int first = row;
+        while (first > 0 && processes_[static_cast<std::size_t>(first - 1)].generation != generation) {
+            --first;
+        }
+        beginRemoveRows(QModelIndex(), first, row);
+        processes_.erase(processes_.begin() + first, processes_.begin() + row + 1);
+        endRemoveRows();
+        row = first - 1;
+    }
+
+    rows_.clear();
+    for (std::size_t i = 0; i < processes_.size(); ++i) {
+        rows_[processes_[i].info.pid] = static_cast<int>(i);
+    }
+}
+
+void ProcessFilterModel::setPattern(const QString &pattern) {
+    pattern_ = pattern.trimmed().toStdString();
+    scores_.clear();
+    invalidate();
+}
+
+bool ProcessFilterModel::filterAcceptsRow(int sourceRow, const QModelIndex &) const {
+    if (pattern_.empty()) {
+        return true;
+    }
+    const auto *model = static_cast<const ProcessListModel *>(sourceModel());
+    const process_info &info = model->process(sourceRow);
+
+    const std::string pid = std::to_string(info.pid);
+    const std::string_view command = std::string_view(info.cmdline).substr(0, max_command);
+    // The name is what one usually types, weigh it over the command line
+    int score = std::max({fuzzy_score(pattern_, pid) * 2, fuzzy_score(pattern_, info.comm) * 2,
+                          fuzzy_score(pattern_, command)});
+    scores_.insert(info.pid, score);
+    return score >= 0;
+}
+
+bool ProcessFilterModel::lessThan(const QModelIndex &left, const QModelIndex &right) const {
+    if (!pattern_.empty()) {
+        const auto *model = static_cast<const ProcessListModel *>(sourceModel());
+        const int l = scores_.value(model->process(left.row()).pid, -1);
+        const int r = scores_.value(model->process(right.row()).pid, -1);
+        if (l != r) {
+            // Best match first whichever way the column is sorted
+            return sortOrder() == Qt::AscendingOrder ? l > r : l < r;
+        }
+    }
+    return QSortFilterProxyModel::lessThan(left, right);
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QSortFilterProxyModel>
+#include <QString>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "ProcessList.h"
+
+/**
+ * Processes of the system as found by enumerate_processes. Batches are
+ * merged in by pid as they arrive, so a refresh updates rows in place and
+ * only processes that exited or started change the row count.
+ */
+class ProcessListModel : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    enum columns {
+        COLUMN_PID = 0,
+        COLUMN_NAME,
+        COLUMN_USER,
+        COLUMN_MEMORY,
+        COLUMN_COMMAND,
+        COLUMN_COUNT
+    };
+
+    explicit ProcessListModel(QObject *parent = nullptr);
+    ~ProcessListModel() override = default;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+    /**
+     * @brief merge adds or updates the processes of one batch
+     * @param generation the enumeration the batch belongs to, see prune()
+     */
+    void merge(std::vector<process_info> &&batch, unsigned generation);
+
+    /** @brief prune removes the processes not seen by enumeration `generation` */
+    void prune(unsigned generation);
+
+    const process_info &process(int row) const {
+        return processes_[static_cast<std::size_t>(row)].info;
+    }
+
+private:
+    struct entry {
+        process_info    info;
+        unsigned        generation;
+    };
+
+    std::vector<entry>                  processes_{};
+    std::unordered_map<pid_t, int>      rows_{};
+};
+
+/**
+ * Fuzzy filter over a ProcessListModel matching the pattern against the
+ * pid, name and command line, best matches first.
+ */
+class ProcessFilterModel : public QSortFilterProxyModel {
+    Q_OBJECT
+
+public:
+    /** Command line characters matched, the rest is mostly arguments */
+    static constexpr std::size_t max_command = 512;
+
+    explicit ProcessFilterModel(QObject *parent = nullptr)
+        : QSortFilterProxyModel(parent) {
+        setSortRole(Qt::EditRole);
+    }
+
+    void setPattern(const QString &pattern);
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+    bool lessThan(const QModelIndex &left, const QModelIndex &right) const override;
+
+private:
+    std::string             pattern_{};
+    /** Score per pid of the current pattern, filled in by filterAcceptsRow */
+    mutable QHash<int, int> scores_{};
+};
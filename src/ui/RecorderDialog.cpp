@@ -0,0 +1,146 @@
+#include "ui/RecorderDialog.h"
+#include "ui/ValueFormat.h"
+#include "ProcessMemory.h"
+
+#include <QFileDialog>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <QTimer>
+#include <QVBoxLayout>
+
+RecorderDialog::RecorderDialog(ProcessMemory &scanner,
+                               std::function<std::vector<recorder_channel>()> channels,
+                               QWidget *parent)
+    : QDialog(parent),
+      scanner_(scanner),
+      channels_(std::move(channels)),
+      recorder_(std::make_unique<ValueRecorder>()),
+      rateSpin_(new QSpinBox(this)),
+      startButton_(new QPushButton(tr("Start"), this)),
+      csvButton_(new QPushButton(tr("Export CSV..."), this)),
+      binaryButton_(new QPushButton(tr("Export binary..."), this)),
+      status_(new QLabel(this)),
+      table_(new QTableWidget(this)),
+      timer_(new QTimer(this))
+{
+    setWindowTitle(tr("Value recorder"));
+    resize(600, 400);
+
+    rateSpin_->setRange(1, 10000);
+    rateSpin_->setValue(1000);
+    rateSpin_->setSuffix(tr(" Hz"));
+    rateSpin_->setToolTip(tr("How often every saved address is read"));
+
+    auto *form = new QFormLayout();
+    form->addRow(tr("Sample rate:"), rateSpin_);
+
+    auto *buttons = new QHBoxLayout();
+    buttons->addWidget(startButton_);
+    buttons->addWidget(csvButton_);
+    buttons->addWidget(binaryButton_);
+    buttons->addStretch();
+
+    table_->setColumnCount(3);
+    table_->setHorizontalHeaderLabels({tr("Description"), tr("Address"), tr("Type")});
+    table_->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    table_->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    table_->verticalHeader()->setVisible(false);
+    table_->setEditTriggers(QTableWidget::NoEditTriggers);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addLayout(form);
+    layout->addLayout(buttons);
+    layout->addWidget(status_);
+    layout->addWidget(table_);
+    setLayout(layout);
+
+    connect(startButton_, &QPushButton::clicked, this, &RecorderDialog::toggleRecording);
+    connect(csvButton_, &QPushButton::clicked, this, &RecorderDialog::exportCsv);
+    connect(binaryButton_, &QPushButton::clicked, this, &RecorderDialog::exportBinary);
+    connect(timer_, &QTimer::timeout, this, &RecorderDialog::refresh);
+
+    setChannels(channels_());
+    refresh();
+}
+
+RecorderDialog::~RecorderDialog() = default;
+
+void RecorderDialog::setChannels(const std::vector<recorder_channel> &channels) {
+    table_->setRowCount(int(channels.size()));
+    for (int row = 0; row < int(channels.size()); ++row) {
+        const recorder_channel &channel = channels[std::size_t(row)];
+        table_->setItem(row, 0, new QTableWidgetItem(QString::fromStdString(channel.name)));
+        table_->setItem(row, 1, new QTableWidgetItem(QString("0x%1").arg(channel.address, 0, 16)));
+        table_->setItem(row, 2, new QTableWidgetItem(value_type_name(channel.type)));
+    }
+}
+
+void RecorderDialog::toggleRecording() {
+    if (recorder_->running()) {
+        recorder_->stop();
+        timer_->stop();
+        startButton_->setText(tr("Start"));
+        rateSpin_->setEnabled(true);
+        refresh();
+        return;
+    }
+
+    std::vector<recorder_channel> channels = channels_();
+    setChannels(channels);
+    const auto period = std::chrono::microseconds(1000000 / rateSpin_->value());
+    if (!recorder_->start(scanner_.pid(), std::move(channels), period)) {
+        QMessageBox::information(this, tr("Nothing to record"),
+                                 tr("Save the addresses to record first."));
+        return;
+    }
+    startButton_->setText(tr("Stop"));
+    rateSpin_->setEnabled(false);
+    timer_->start(250);
+}
+
+void RecorderDialog::refresh() {
+    if (!recorder_->running() && timer_->isActive()) {
+        // Stopped on its own because the buffer filled up
+        timer_->stop();
+        startButton_->setText(tr("Start"));
+        rateSpin_->setEnabled(true);
+    }
+    QString status = tr("%1 ticks, %2 changes, %3 KiB")
+                         .arg(recorder_->ticks())
+                         .arg(recorder_->changes())
+                         .arg(recorder_->bytes() / 1024);
+    if (std::uint64_t late = recorder_->late(); late > 0) {
+        status += tr(", %1 late").arg(late);
+    }
+    status_->setText(status);
+    csvButton_->setEnabled(recorder_->ticks() > 0);
+    binaryButton_->setEnabled(recorder_->ticks() > 0);
+}
+
+void RecorderDialog::exportCsv() {
+    QString path = QFileDialog::getSaveFileName(this, tr("Export timeline"), QString(),
+                                                tr("CSV files (*.csv)"));
+    if (path.isEmpty()) {
+        return;
+    }
+    if (!recorder_->export_csv(path.toStdString())) {
+        QMessageBox::warning(this, tr("Export failed"), tr("Could not write %1").arg(path));
+    }
+}
+
+void RecorderDialog::exportBinary() {
+    QString path = QFileDialog::getSaveFileName(this, tr("Export timeline"), QString(),
+                                                tr("Timelines (*.timeline)"));
+    if (path.isEmpty()) {
+        return;
+    }
+    if (!recorder_->export_binary(path.toStdString())) {
+        QMessageBox::warning(this, tr("Export failed"), tr("Could not write %1").arg(path));
+    }
+}
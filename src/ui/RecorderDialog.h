@@ -0,0 +1,55 @@
+#pragma once
+
+#include <QDialog>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "ValueRecorder.h"
+
+class ProcessMemory;
+class QLabel;
+class QPushButton;
+class QSpinBox;
+class QTableWidget;
+class QTimer;
+
+/**
+ * Records the saved addresses at a fixed rate with ValueRecorder and exports
+ * the timeline, so value changes can be lined up with what happened in the
+ * target without scanning in between.
+ */
+class RecorderDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @param channels called when recording starts, returns the addresses
+     * to record
+     */
+    RecorderDialog(ProcessMemory &scanner,
+                   std::function<std::vector<recorder_channel>()> channels,
+                   QWidget *parent = nullptr);
+    ~RecorderDialog() override;
+
+private slots:
+    void toggleRecording();
+    void refresh();
+    void exportCsv();
+    void exportBinary();
+
+private:
+    ProcessMemory                                   &scanner_;
+    std::function<std::vector<recorder_channel>()>  channels_;
+    std::unique_ptr<ValueRecorder>                  recorder_;
+    QSpinBox                                        *rateSpin_;
+    QPushButton                                     *startButton_;
+    QPushButton                                     *csvButton_;
+    QPushButton                                     *binaryButton_;
+    QLabel                                          *status_;
+    QTableWidget                                    *table_;
+    QTimer                                          *timer_;
+
+    void setChannels(const std::vector<recorder_channel> &channels);
+};
@@ -0,0 +1,247 @@
+#include "ui/SavedAddressModel.h"
+#include "ui/MemoryMonitor.h"
+#include "ui/ValueFormat.h"
+
+#include <QBrush>
+#include <QColor>
+#include <QComboBox>
+
+SavedAddressModel::SavedAddressModel(QObject *parent)
+    : QAbstractTableModel(parent) {}
+
+int SavedAddressModel::rowCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : static_cast<int>(store_.size());
+}
+
+int SavedAddressModel::columnCount(const QModelIndex &parent) const {
+    return parent.isValid() ? 0 : COLUMN_COUNT;
+}
+
+QVariant SavedAddressModel::headerData(int section, Qt::Orientation orientation,
+                                       int role) const {
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal) {
+        return {};
+    }
+    switch (section) {
+    case COLUMN_ACTIVE:
+        return tr("Active");
+    case COLUMN_DESCRIPTION:
+        return tr("Description");
+    case COLUMN_ADDRESS:
+        return tr("Address");
+    case COLUMN_TYPE:
+        return tr("Type");
+    case COLUMN_VALUE:
+        return tr("Value");
+    default:
+        return {};
+    }
+}
+
+Qt::ItemFlags SavedAddressModel::flags(const QModelIndex &index) const {
+    Qt::ItemFlags flags = QAbstractTableModel::flags(index);
+    switch (index.column()) {
+    case COLUMN_ACTIVE:
+        return flags | Qt::ItemIsUserCheckable;
+    case COLUMN_DESCRIPTION:
+    case COLUMN_TYPE:
+        return flags | Qt::ItemIsEditable;
+    default:
+        return flags;
+    }
+}
+
+QVariant SavedAddressModel::data(const QModelIndex &index, int role) const {
+    if (!index.isValid() || static_cast<std::size_t>(index.row()) >= store_.size()) {
+        return {};
+    }
+    const saved_address &entry = store_[static_cast<std::size_t>(index.row())];
+
+    switch (index.column()) {
+    case COLUMN_ACTIVE:
+        if (role == Qt::CheckStateRole) {
+            return entry.frozen ? Qt::Checked : Qt::Unchecked;
+        }
+        return {};
+    case COLUMN_DESCRIPTION:
+        if (role == Qt::DisplayRole || role == Qt::EditRole) {
+            return QString::fromStdString(entry.description);
+        }
+        return {};
+    case COLUMN_ADDRESS:
+        if (role == Qt::DisplayRole) {
+            return QString("0x%1").arg(entry.address, 0, 16);
+        }
+        if (role == Qt::ToolTipRole && !entry.locator.empty()) {
+            return tr("Found with %1").arg(QString::fromStdString(entry.locator));
+        }
+        return {};
+    case COLUMN_TYPE:
+        if (role == Qt::DisplayRole) {
+            return value_type_name(entry.type);
+        }
+        if (role == Qt::EditRole) {
+            return static_cast<int>(entry.type);
+        }
+        return {};
+    case COLUMN_VALUE:
+        if (role == Qt::DisplayRole) {
+            return entry.valid ? format_value(entry.type, entry.value) : QStringLiteral("??");
+        }
+        if (role == Qt::ForegroundRole && entry.changed) {
+            return QBrush(QColor::fromRgb(200, 0, 0));
+        }
+        if (role == Qt::ToolTipRole && entry.changed) {
+            return tr("Previous: %1").arg(format_value(entry.type, entry.previous));
+        }
+        return {};
+    default:
+        return {};
+    }
+}
+
+bool SavedAddressModel::setData(const QModelIndex &index, const QVariant &value, int role) {
+    if (!index.isValid() || static_cast<std::size_t>(index.row()) >= store_.size()) {
+        return false;
+    }
+    const auto row = static_cast<std::size_t>(index.row());
+
+    if (index.column() == COLUMN_ACTIVE && role == Qt::CheckStateRole) {
+        const bool frozen = value.toInt() == Qt::Checked;
+        store_.set_frozen(row, frozen);
+        emit dataChanged(index, index, {Qt::CheckStateRole});
+        emit freezeToggled(index.row(), frozen);
+        return true;
+    }
+    if (role != Qt::EditRole) {
+        return false;
+    }
+    if (index.column() == COLUMN_DESCRIPTION) {
+        store_.set_description(row, value.toString().toStdString());
+        emit dataChanged(index, index);
+        return true;
+    }
+    if (index.column() == COLUMN_TYPE) {
+        const int type = value.toInt();
+        if (type < 0 || type >= VALUE_TYPE_COUNT || type == store_[row].type) {
+            return false;
+        }
+        store_.set_type(row, static_cast<value_type>(type));
+        emit dataChanged(this->index(index.row(), COLUMN_TYPE),
+                         this->index(index.row(), COLUMN_VALUE));
+        emit typeChanged(index.row());
+        return true;
+    }
+    return false;
+}
+
+int SavedAddressModel::add(std::uintptr_t address, value_type type, const QString &description,
+                           const QString &locator) {
+    if (store_.find(address) >= 0) {
+        return -1;
+    }
+    const int row = static_cast<int>(store_.size());
+    beginInsertRows(QModelIndex(), row, row);
+    store_.add(address, type, description.toStdString(), locator.toStdString());
+    endInsertRows();
+    return row;
+}
+
+void SavedAddressModel::remove(int row) {
+    if (row < 0 || static_cast<std::size_t>(row) >= store_.size()) {
+        return;
+    }
+    beginRemoveRows(QModelIndex(), row, row);
+    store_.remove(static_cast<std::size_t>(row));
+    endRemoveRows();
+}
+
+void SavedAddressModel::clear() {
+    beginResetModel();
+    store_.clear();
+    endResetModel();
+}
+
+void SavedAddressModel::set_frozen(int row, bool frozen) {
+    store_.set_frozen(static_cast<std::size_t>(row), frozen);
+    emit dataChanged(index(row, COLUMN_ACTIVE), index(row, COLUMN_ACTIVE), {Qt::CheckStateRole});
+}
+
+void SavedAddressModel::set_value(int row, std::uint64_t value) {
+    if (store_.set_value(static_cast<std::size_t>(row), value, true)) {
+        rowsUpdated(row, row);
+    }
+}
+
+void SavedAddressModel::refresh(pid_t pid) {
+    std::vector<std::size_t> changed;
+    store_.refresh(pid, 0, store_.size(), &changed);
+    if (!changed.empty()) {
+        rowsUpdated(static_cast<int>(changed.front()), static_cast<int>(changed.back()));
+    }
+}
+
+std::size_t SavedAddressModel::relocate(pid_t pid, const maps_snapshot &maps,
+                                       std::vector<std::size_t> *unresolved) {
+    const std::vector<std::string> locators = store_.locators();
+    return apply_locations(locators, SavedAddressStore::resolve_locators(locators, pid, maps),
+                           unresolved);
+}
+
+std::size_t SavedAddressModel::apply_locations(
+    const std::vector<std::string> &locators,
+    const std::vector<std::optional<std::uintptr_t>> &addresses,
+    std::vector<std::size_t> *unresolved) {
+    const std::size_t resolved = store_.apply_locations(locators, addresses, unresolved);
+    // Rows that didn't resolve turned invalid without moving, repaint all
+    if (store_.size() > 0) {
+        emit dataChanged(index(0, COLUMN_ADDRESS), index(static_cast<int>(store_.size()) - 1,
+                                                         COLUMN_VALUE));
+    }
+    return resolved;
+}
+
+void SavedAddressModel::apply_updates(const std::vector<monitor_update> &updates) {
+    int changed_first = -1, changed_last = -1;
+    for (const monitor_update &update : updates) {
+        // Rows may have been removed since the monitor was given its targets
+        if (update.table != MemoryMonitor::TABLE_SAVED || update.row < 0 ||
+            static_cast<std::size_t>(update.row) >= store_.size() ||
+            store_[static_cast<std::size_t>(update.row)].address !=
+                reinterpret_cast<std::uintptr_t>(update.address)) {
+            continue;
+        }
+        if (!store_.set_value(static_cast<std::size_t>(update.row), update.value, update.valid)) {
+            continue;
+        }
+        changed_first = changed_first < 0 ? update.row : std::min(changed_first, update.row);
+        changed_last = std::max(changed_last, update.row);
+    }
+    if (changed_first >= 0) {
+        rowsUpdated(changed_first, changed_last);
+    }
+}
+
+void SavedAddressModel::rowsUpdated(int first, int last) {
+    emit dataChanged(index(first, COLUMN_VALUE), index(last, COLUMN_VALUE),
+                     {Qt::DisplayRole, Qt::ForegroundRole, Qt::ToolTipRole});
+}
+
+QWidget *SavedAddressTypeDelegate::createEditor(QWidget *parent,
+                                                const QStyleOptionViewItem &,
+                                                const QModelIndex &) const {
+    auto *combo = new QComboBox(parent);
+    for (int type = 0; type < VALUE_TYPE_COUNT; ++type) {
+        combo->addItem(value_type_name(static_cast<value_type>(type)));
+    }
+    return combo;
+}
+
+void SavedAddressTypeDelegate::setEditorData(QWidget *editor, const QModelIndex &index) const {
+    static_cast<QComboBox *>(editor)->setCurrentIndex(index.data(Qt::EditRole).toInt());
+}
+
+void SavedAddressTypeDelegate::setModelData(QWidget *editor, QAbstractItemModel *model,
+                                            const QModelIndex &index) const {
+    model->setData(index, static_cast<QComboBox *>(editor)->currentIndex(), Qt::EditRole);
+}
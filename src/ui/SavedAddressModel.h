@@ -0,0 +1,112 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QStyledItemDelegate>
+
+#include <cstdint>
+#include <vector>
+
+#include "SavedAddressStore.h"
+
+struct monitor_update;
+
+/**
+ * Table model owning the saved addresses. Checking the Active column asks
+ * for the address to be frozen, description and type are edited in place.
+ */
+class SavedAddressModel : public QAbstractTableModel {
+    Q_OBJECT
+
+public:
+    enum columns {
+        COLUMN_ACTIVE = 0,
+        COLUMN_DESCRIPTION,
+        COLUMN_ADDRESS,
+        COLUMN_TYPE,
+        COLUMN_VALUE,
+        COLUMN_COUNT
+    };
+
+    explicit SavedAddressModel(QObject *parent = nullptr);
+    ~SavedAddressModel() override = default;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+    const SavedAddressStore &store() const {
+        return store_;
+    }
+
+    /**
+     * @param locator pointer path or signature the address was found with,
+     * see resolve_locator
+     * @return the new row, -1 if the address was already saved
+     */
+    int add(std::uintptr_t address, value_type type, const QString &description = QString(),
+            const QString &locator = QString());
+    void remove(int row);
+    void clear();
+
+    /** @brief set_frozen updates the checkbox without emitting freezeToggled */
+    void set_frozen(int row, bool frozen);
+
+    /** @brief set_value shows a value that wasn't read from the process */
+    void set_value(int row, std::uint64_t value);
+
+    /** @brief refresh reads every saved address with one batched read */
+    void refresh(pid_t pid);
+
+    /**
+     * @brief relocate resolves the locators again in a new process image,
+     * see SavedAddressStore::relocate
+     */
+    std::size_t relocate(pid_t pid, const maps_snapshot &maps,
+                         std::vector<std::size_t> *unresolved = nullptr);
+
+    /**
+     * @brief apply_locations applies a relocation resolved on another
+     * thread, see SavedAddressStore::apply_locations
+     */
+    std::size_t apply_locations(const std::vector<std::string> &locators,
+                                const std::vector<std::optional<std::uintptr_t>> &addresses,
+                                std::vector<std::size_t> *unresolved = nullptr);
+
+    /**
+     * @brief apply_updates stores values read by the memory monitor and
+     * emits dataChanged for the rows they belong to
+     */
+    void apply_updates(const std::vector<monitor_update> &updates);
+
+signals:
+    /** The Active checkbox of `row` was toggled by the user */
+    void freezeToggled(int row, bool frozen);
+
+    /** The type of `row` changed, it has to be monitored at its new size */
+    void typeChanged(int row);
+
+private:
+    SavedAddressStore store_{};
+
+    void rowsUpdated(int first, int last);
+};
+
+/**
+ * Type combobox for the Type column of SavedAddressModel
+ */
+class SavedAddressTypeDelegate : public QStyledItemDelegate {
+    Q_OBJECT
+
+public:
+    using QStyledItemDelegate::QStyledItemDelegate;
+
+    QWidget *createEditor(QWidget *parent, const QStyleOptionViewItem &option,
+                          const QModelIndex &index) const override;
+    void setEditorData(QWidget *editor, const QModelIndex &index) const override;
+    void setModelData(QWidget *editor, QAbstractItemModel *model,
+                      const QModelIndex &index) const override;
+};
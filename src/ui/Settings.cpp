@@ -1,4 +1,6 @@
 #include "ui/Settings.h"
+#include "AttachWatcher.h"
+#include "ProcessMemory.h"
 #include <QSettings>
 #include <QLineEdit>
 #include <QSpinBox>
@@ -12,6 +14,7 @@
 #include <QLineEdit>
 #include <QFormLayout>
 #include <QDialogButtonBox>
+#include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QSettings>
 #include <QRegularExpressionValidator>
@@ -21,8 +24,14 @@
 SettingsDialog::SettingsDialog(QWidget *parent)
     : QDialog(parent),
     updateIntervalSpin(new QSpinBox(this)),
+    freezeIntervalSpin(new QSpinBox(this)),
+    historyTicksSpin(new QSpinBox(this)),
     autoAttachPid(new QSpinBox(this)),
+    attachRuleEdit(new QLineEdit(this)),
+    attachCmdline(new QCheckBox(tr("Command line"), this)),
+    attachReattach(new QCheckBox(tr("Reattach on restart"), this)),
     scanBlockSizeEdit(new QLineEdit(this)),
+    scanBlockSizeAuto(new QCheckBox(tr("Auto"), this)),
     epsilonLineEdit(new QLineEdit(this)),
     formLayout(new QFormLayout),
     buttonBox(new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, this))
@@ -31,18 +40,44 @@ SettingsDialog::SettingsDialog(QWidget *parent)
 
     updateIntervalSpin->setRange(1, 60000);
     updateIntervalSpin->setSuffix("ms");
+    freezeIntervalSpin->setRange(100, 10000000);
+    freezeIntervalSpin->setSuffix("us");
+    freezeIntervalSpin->setToolTip("How often frozen values are written back");
+    historyTicksSpin->setRange(0, 10000);
+    historyTicksSpin->setSuffix(" updates");
+    historyTicksSpin->setSpecialValueText("Scans only");
+    historyTicksSpin->setToolTip("Add the current match values to the value history every this "
+                                 "many updates, the Previous column and change scans compare "
+                                 "against the newest entry");
     autoAttachPid->setMaximum(std::numeric_limits<int>::max());
     autoAttachPid->setMinimum(-1);
 
     formLayout->addRow(tr("Update Interval:"), updateIntervalSpin);
+    formLayout->addRow(tr("Freeze Interval:"), freezeIntervalSpin);
+    formLayout->addRow(tr("History Every:"), historyTicksSpin);
     formLayout->addRow(tr("Auto-Attach:"), autoAttachPid);
-    formLayout->addRow(tr("Scan Block Size:"), scanBlockSizeEdit);
+    attachRuleEdit->setPlaceholderText("e.g. ^game$");
+    attachRuleEdit->setToolTip("Attach to the first process whose name matches this regex");
+    attachCmdline->setToolTip("Match the command line instead of the process name");
+    attachReattach->setToolTip("Attach to the next matching process when the attached one exits, "
+                               "saved pointer paths and signatures are resolved again");
+    QHBoxLayout *attachRuleLayout = new QHBoxLayout();
+    attachRuleLayout->addWidget(attachRuleEdit);
+    attachRuleLayout->addWidget(attachCmdline);
+    formLayout->addRow(tr("Attach Rule:"), attachRuleLayout);
+    formLayout->addRow(QString(), attachReattach);
+    QHBoxLayout *blockSizeLayout = new QHBoxLayout();
+    blockSizeLayout->addWidget(scanBlockSizeEdit);
+    blockSizeLayout->addWidget(scanBlockSizeAuto);
+    formLayout->addRow(tr("Scan Block Size:"), blockSizeLayout);
     formLayout->addRow(tr("Epsilon"), epsilonLineEdit);
 
     QRegularExpression size_regex("^(0[xX][0-9a-fA-F]+|\\d+)$");
     QRegularExpressionValidator *size_validator = new QRegularExpressionValidator(size_regex, scanBlockSizeEdit);
     scanBlockSizeEdit->setValidator(size_validator);
     scanBlockSizeEdit->setToolTip("C language convention used, no prefix = dec, 0x = hex, 0b = binary, 0 = octal");
+    scanBlockSizeAuto->setToolTip("Benchmark the process when attaching and use the fastest size");
+    connect(scanBlockSizeAuto, &QCheckBox::toggled, scanBlockSizeEdit, &QLineEdit::setDisabled);
 
     QRegularExpression epsilonRegex("^\\d+([,.]\\d*)?");
 
@@ -70,12 +105,20 @@ void SettingsDialog::loadSettings()
     settings.beginGroup("General");
     updateIntervalSpin->setValue(
         settings.value("update-interval", 100).toInt());
+    freezeIntervalSpin->setValue(
+        settings.value("freeze-interval", 1000).toInt());
+    historyTicksSpin->setValue(settings.value("history-ticks", 50).toInt());
 
     autoAttachPid->setValue(settings.value("auto-attach", -1).toInt());
+    attachRuleEdit->setText(settings.value("attach-rule").toString());
+    attachCmdline->setChecked(settings.value("attach-cmdline", false).toBool());
+    attachReattach->setChecked(settings.value("attach-reattach", true).toBool());
 
     QString hexstr = QString("0x%1").arg(
-        settings.value("scan-block-size", 0x1000000).toULongLong(), 0, 16);
+        settings.value("scan-block-size",
+                       qulonglong(ProcessMemory::default_max_read_size)).toULongLong(), 0, 16);
     scanBlockSizeEdit->setText(hexstr);
+    scanBlockSizeAuto->setChecked(settings.value("scan-block-size-auto", true).toBool());
 
     double epsilon = settings.value("epsilon", 0.00000001).toDouble();
     epsilonLineEdit->setText(QString::number(epsilon, 'f', 9));
@@ -89,17 +132,28 @@ bool SettingsDialog::saveSettings()
 
     settings.beginGroup("General");
     qulonglong size = scanBlockSizeEdit->text().toULongLong(&ok, 0);
-    if (!ok) {
+    if (!ok || size == 0) {
         return false;
     }
     double epsilon = epsilonLineEdit->text().toDouble(&ok);
     if (!ok) {
         return false;
     }
+    // Checked with the engine AttachWatcher matches with, the syntaxes differ
+    const QString rule = attachRuleEdit->text();
+    if (!rule.isEmpty() && !attach_rule::make(rule.toStdString(), attachCmdline->isChecked())) {
+        return false;
+    }
 
     settings.setValue("update-interval", updateIntervalSpin->value());
+    settings.setValue("freeze-interval", freezeIntervalSpin->value());
+    settings.setValue("history-ticks", historyTicksSpin->value());
     settings.setValue("auto-attach", autoAttachPid->value());
+    settings.setValue("attach-rule", attachRuleEdit->text());
+    settings.setValue("attach-cmdline", attachCmdline->isChecked());
+    settings.setValue("attach-reattach", attachReattach->isChecked());
     settings.setValue("scan-block-size", size);
+    settings.setValue("scan-block-size-auto", scanBlockSizeAuto->isChecked());
     settings.setValue("epsilon", epsilon);
 
     settings.endGroup();
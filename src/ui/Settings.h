@@ -26,8 +26,14 @@ public:
 private:
     // General settings provided by user
     QSpinBox  *updateIntervalSpin;     // "update-interval"
+    QSpinBox  *freezeIntervalSpin;     // "freeze-interval"
+    QSpinBox  *historyTicksSpin;       // "history-ticks"
     QSpinBox  *autoAttachPid;       // "auto-attach"
+    QLineEdit *attachRuleEdit;        // "attach-rule"
+    QCheckBox *attachCmdline;         // "attach-cmdline"
+    QCheckBox *attachReattach;        // "attach-reattach"
     QLineEdit *scanBlockSizeEdit;     // "scan-block-size"
+    QCheckBox *scanBlockSizeAuto;     // "scan-block-size-auto"
     QLineEdit *epsilonLineEdit;
 
     QFormLayout *formLayout;
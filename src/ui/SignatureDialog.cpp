@@ -0,0 +1,287 @@
+#include "ui/SignatureDialog.h"
+#include "ProcessMemory.h"
+#include "SavedAddressStore.h"
+#include "ui/Disassembly.h"
+
+#include <QFileDialog>
+#include <QFormLayout>
+#include <QFutureWatcher>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMenu>
+#include <QMessageBox>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QVBoxLayout>
+#include <QtConcurrent/QtConcurrent>
+
+#include <algorithm>
+#include <set>
+
+enum SignatureColumn {
+    SIGNATURE_NAME,
+    SIGNATURE_MODULE,
+    SIGNATURE_PATTERN,
+    SIGNATURE_MATCHES,
+    SIGNATURE_ADDRESS,
+    SIGNATURE_RESOLVED,
+};
+
+SignatureDialog::SignatureDialog(ProcessMemory &scanner, QWidget *parent)
+    : QDialog(parent),
+      scanner_(scanner),
+      nameEdit_(new QLineEdit(this)),
+      moduleEdit_(new QLineEdit(this)),
+      patternEdit_(new QLineEdit(this)),
+      optionsEdit_(new QLineEdit(this)),
+      addButton_(new QPushButton(tr("Add"), this)),
+      removeButton_(new QPushButton(tr("Remove"), this)),
+      scanButton_(new QPushButton(tr("Scan"), this)),
+      loadButton_(new QPushButton(tr("Load database..."), this)),
+      saveButton_(new QPushButton(tr("Save database..."), this)),
+      progress_(new QProgressBar(this)),
+      status_(new QLabel(this)),
+      table_(new QTableWidget(this))
+{
+    setWindowTitle(tr("Signature scan"));
+    resize(900, 500);
+
+    moduleEdit_->setPlaceholderText(tr("basename, empty for every module"));
+    patternEdit_->setPlaceholderText("e.g. 48 8B 05 ?? ?? ?? ?? 89 C3");
+    optionsEdit_->setPlaceholderText("e.g. rel=3 off=0x10");
+    optionsEdit_->setToolTip(tr("rel=N[:L] resolves the rel32 at offset N of the match, "
+                                "relative to the end of the instruction at offset L.\n"
+                                "off=N is added to the result."));
+    progress_->setRange(0, 100);
+
+    auto *form = new QFormLayout();
+    form->addRow(tr("Name:"), nameEdit_);
+    form->addRow(tr("Module:"), moduleEdit_);
+    form->addRow(tr("Pattern:"), patternEdit_);
+    form->addRow(tr("Options:"), optionsEdit_);
+
+    auto *buttons = new QHBoxLayout();
+    buttons->addWidget(addButton_);
+    buttons->addWidget(removeButton_);
+    buttons->addWidget(scanButton_);
+    buttons->addWidget(loadButton_);
+    buttons->addWidget(saveButton_);
+    buttons->addWidget(progress_);
+
+    QFont monoFont("Courier New");
+    monoFont.setStyleHint(QFont::Monospace);
+    table_->setFont(monoFont);
+    table_->setColumnCount(6);
+    table_->setHorizontalHeaderLabels({tr("Name"), tr("Module"), tr("Pattern"),
+                                       tr("Matches"), tr("Address"), tr("Resolved")});
+    table_->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    table_->horizontalHeader()->setSectionResizeMode(SIGNATURE_PATTERN, QHeaderView::Stretch);
+    table_->verticalHeader()->setVisible(false);
+    table_->setEditTriggers(QTableWidget::NoEditTriggers);
+    table_->setSelectionBehavior(QTableWidget::SelectRows);
+    table_->setContextMenuPolicy(Qt::CustomContextMenu);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addLayout(form);
+    layout->addLayout(buttons);
+    layout->addWidget(status_);
+    layout->addWidget(table_);
+    setLayout(layout);
+
+    connect(addButton_, &QPushButton::clicked, this, &SignatureDialog::addSignature);
+    connect(removeButton_, &QPushButton::clicked, this, &SignatureDialog::removeSignature);
+    connect(scanButton_, &QPushButton::clicked, this, &SignatureDialog::startScan);
+    connect(loadButton_, &QPushButton::clicked, this, &SignatureDialog::loadDatabase);
+    connect(saveButton_, &QPushButton::clicked, this, &SignatureDialog::saveDatabase);
+    connect(table_, &QTableWidget::cellDoubleClicked, this,
+            [this](int row, int) { showInDisassembler(row); });
+    connect(table_, &QTableWidget::customContextMenuRequested, this,
+            &SignatureDialog::showContextMenu);
+}
+
+SignatureDialog::~SignatureDialog() {
+    // The scan refers to the dialog for progress updates
+    future_.waitForFinished();
+}
+
+void SignatureDialog::setBusy(bool busy) {
+    addButton_->setEnabled(!busy);
+    removeButton_->setEnabled(!busy);
+    scanButton_->setEnabled(!busy);
+    loadButton_->setEnabled(!busy);
+    saveButton_->setEnabled(!busy);
+}
+
+void SignatureDialog::addSignature() {
+    QString name = nameEdit_->text().trimmed();
+    if (name.isEmpty()) {
+        name = QString("sig%1").arg(signatures_.size());
+    }
+    QString module = moduleEdit_->text().trimmed();
+    if (module.isEmpty()) {
+        module = "*";
+    }
+    // Same syntax as a database line, so both are parsed the same way
+    const QString line = QString("%1 %2 %3 %4").arg(name.replace(' ', '_'), module,
+                                                     patternEdit_->text(), optionsEdit_->text());
+    std::optional<signature> sig = signature::parse(line.toStdString());
+    if (!sig) {
+        QMessageBox::warning(this, tr("Invalid Signature"),
+                             tr("Could not parse the pattern or options. Bytes are two hex "
+                                "digits, ?? is a wildcard and at least one byte must be exact."));
+        return;
+    }
+    signatures_.push_back(std::move(*sig));
+    matches_.clear();
+    scanned_ = false;
+    showSignatures();
+}
+
+void SignatureDialog::removeSignature() {
+    std::set<int, std::greater<>> rows;
+    for (const QModelIndex &index : table_->selectionModel()->selectedRows()) {
+        rows.insert(index.row());
+    }
+    for (int row : rows) {
+        signatures_.erase(signatures_.begin() + row);
+    }
+    matches_.clear();
+    scanned_ = false;
+    showSignatures();
+}
+
+void SignatureDialog::startScan() {
+    if (signatures_.empty()) {
+        return;
+    }
+    setBusy(true);
+    progress_->setValue(0);
+    status_->setText(tr("Scanning..."));
+    future_ = QtConcurrent::run([this, signatures = signatures_] {
+        auto maps = scanner_.refresh_maps();
+        return scan_signatures(scanner_.pid(), *maps, signatures,
+                               [this](size_t current, size_t total) {
+            QMetaObject::invokeMethod(progress_, [this, current, total] {
+                progress_->setValue(int(double(current) / double(total) * 100));
+            }, Qt::QueuedConnection);
+        });
+    });
+
+    auto *watcher = new QFutureWatcher<std::vector<signature_match>>(this);
+    connect(watcher, &QFutureWatcher<std::vector<signature_match>>::finished, this,
+            [this, watcher] {
+        matches_ = watcher->result();
+        scanned_ = true;
+        showSignatures();
+        setBusy(false);
+        watcher->deleteLater();
+    });
+    watcher->setFuture(future_);
+}
+
+void SignatureDialog::showSignatures() {
+    table_->setRowCount(int(signatures_.size()));
+    std::size_t unique = 0;
+    auto match = matches_.begin();
+    for (std::size_t i = 0; i < signatures_.size(); ++i) {
+        const signature &sig = signatures_[i];
+        auto first = match;
+        while (match != matches_.end() && match->signature == i) {
+            ++match;
+        }
+        const auto count = std::size_t(match - first);
+        const int row = int(i);
+        table_->setItem(row, SIGNATURE_NAME, new QTableWidgetItem(QString::fromStdString(sig.name)));
+        table_->setItem(row, SIGNATURE_MODULE, new QTableWidgetItem(
+            sig.module.empty() ? "*" : QString::fromStdString(sig.module)));
+        table_->setItem(row, SIGNATURE_PATTERN, new QTableWidgetItem(
+            QString::fromStdString(sig.pattern_string())));
+        table_->setItem(row, SIGNATURE_MATCHES, new QTableWidgetItem(
+            scanned_ ? QString::number(count) : QString()));
+        // Only a unique match says where the signature is
+        QString address;
+        QString resolved;
+        if (count == 1) {
+            address = QString("0x%1").arg(first->address, 0, 16);
+            resolved = QString("0x%1").arg(first->resolved, 0, 16);
+            ++unique;
+        } else if (scanned_) {
+            address = count == 0 ? tr("not found") : tr("not unique");
+        }
+        table_->setItem(row, SIGNATURE_ADDRESS, new QTableWidgetItem(address));
+        table_->setItem(row, SIGNATURE_RESOLVED, new QTableWidgetItem(resolved));
+    }
+    if (scanned_ && unique == 0) {
+        status_->setText(tr("No unique match for any of the %n signature(s)", nullptr,
+                            int(signatures_.size())));
+    } else if (scanned_) {
+        status_->setText(tr("%1 of %2 signatures matched exactly once")
+                             .arg(unique).arg(signatures_.size()));
+    } else {
+        status_->setText(tr("%n signature(s)", nullptr, int(signatures_.size())));
+    }
+}
+
+void SignatureDialog::loadDatabase() {
+    QString path = QFileDialog::getOpenFileName(this, tr("Load signatures"));
+    if (path.isEmpty()) {
+        return;
+    }
+    std::vector<signature> loaded;
+    if (!load_signatures(path.toStdString(), loaded)) {
+        QMessageBox::warning(this, tr("Load failed"),
+                             tr("Could not read %1, see stderr for the line at fault").arg(path));
+        return;
+    }
+    signatures_ = std::move(loaded);
+    matches_.clear();
+    scanned_ = false;
+    showSignatures();
+}
+
+void SignatureDialog::saveDatabase() {
+    QString path = QFileDialog::getSaveFileName(this, tr("Save signatures"));
+    if (path.isEmpty()) {
+        return;
+    }
+    if (!save_signatures(path.toStdString(), signatures_)) {
+        QMessageBox::warning(this, tr("Save failed"), tr("Could not write %1").arg(path));
+    }
+}
+
+void SignatureDialog::showInDisassembler(int row) {
+    QTableWidgetItem *item = table_->item(row, SIGNATURE_ADDRESS);
+    if (item == nullptr || item->text().isEmpty()) {
+        return;
+    }
+    auto *disassembler = new Disassembly(scanner_.pid(), item->text().toULongLong(nullptr, 16));
+    disassembler->setAttribute(Qt::WA_DeleteOnClose);
+    disassembler->show();
+}
+
+void SignatureDialog::showContextMenu(const QPoint &pos) {
+    const int row = table_->rowAt(pos.y());
+    if (row < 0 || static_cast<std::size_t>(row) >= signatures_.size()) {
+        return;
+    }
+    QTableWidgetItem *item = table_->item(row, SIGNATURE_RESOLVED);
+    const bool unique = item != nullptr && !item->text().isEmpty();
+
+    QMenu menu(this);
+    QAction *save = menu.addAction(tr("Add to saved addresses"));
+    save->setToolTip(tr("The address is found through this signature again "
+                        "when the process restarts"));
+    save->setEnabled(unique);
+    if (unique) {
+        const std::uintptr_t address = item->text().toULongLong(nullptr, 16);
+        const QString locator = QString(signature_locator_prefix) +
+            QString::fromStdString(signatures_[static_cast<std::size_t>(row)].to_string());
+        connect(save, &QAction::triggered, this, [this, address, locator] {
+            emit saveAddress(address, locator);
+        });
+    }
+    menu.exec(table_->viewport()->mapToGlobal(pos));
+}
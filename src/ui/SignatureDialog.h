@@ -0,0 +1,67 @@
+#pragma once
+
+#include <QDialog>
+#include <QFuture>
+#include <cstdint>
+#include <vector>
+
+#include "Signature.h"
+
+class ProcessMemory;
+class QLineEdit;
+class QPushButton;
+class QProgressBar;
+class QTableWidget;
+class QLabel;
+
+/**
+ * Scans executable module memory for byte signatures. Signatures can be
+ * entered one at a time or loaded from a database file, all of them are
+ * re-located in one pass. Double clicking a row opens the disassembler at
+ * the match.
+ */
+class SignatureDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit SignatureDialog(ProcessMemory &scanner, QWidget *parent = nullptr);
+    ~SignatureDialog() override;
+
+signals:
+    /** @param locator the signature the address was resolved with */
+    void saveAddress(std::uintptr_t address, QString locator);
+
+private slots:
+    void addSignature();
+    void removeSignature();
+    void startScan();
+    void loadDatabase();
+    void saveDatabase();
+    void showInDisassembler(int row);
+    void showContextMenu(const QPoint &pos);
+
+private:
+    ProcessMemory                           &scanner_;
+    QLineEdit                               *nameEdit_;
+    QLineEdit                               *moduleEdit_;
+    QLineEdit                               *patternEdit_;
+    QLineEdit                               *optionsEdit_;
+    QPushButton                             *addButton_;
+    QPushButton                             *removeButton_;
+    QPushButton                             *scanButton_;
+    QPushButton                             *loadButton_;
+    QPushButton                             *saveButton_;
+    QProgressBar                            *progress_;
+    QLabel                                  *status_;
+    QTableWidget                            *table_;
+
+    std::vector<signature>                  signatures_{};
+    std::vector<signature_match>            matches_{};
+    /** matches_ holds the result of a scan of the current signatures */
+    bool                                    scanned_{};
+    QFuture<std::vector<signature_match>>   future_{};
+
+    void setBusy(bool busy);
+    void showSignatures();
+};
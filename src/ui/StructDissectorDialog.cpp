@@ -0,0 +1,221 @@
+#include "ui/StructDissectorDialog.h"
+#include "ProcessMemory.h"
+#include "StructDissector.h"
+
+#include <QBrush>
+#include <QColor>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMenu>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <QTimer>
+#include <QVBoxLayout>
+
+namespace {
+enum column {
+    COLUMN_OFFSET = 0,
+    COLUMN_ADDRESS,
+    COLUMN_TYPE,
+    COLUMN_VALUE,
+    COLUMN_COUNT
+};
+
+/** Refreshes a changed field stays highlighted for */
+constexpr std::uint8_t highlight_refreshes = 4;
+}
+
+StructDissectorDialog::StructDissectorDialog(ProcessMemory &scanner, QWidget *parent)
+    : QDialog(parent),
+      scanner_(scanner),
+      dissector_(std::make_unique<StructDissector>()),
+      addressEdit_(new QLineEdit(this)),
+      beforeSpin_(new QSpinBox(this)),
+      sizeSpin_(new QSpinBox(this)),
+      backButton_(new QPushButton(tr("Back"), this)),
+      status_(new QLabel(this)),
+      table_(new QTableWidget(this)),
+      timer_(new QTimer(this))
+{
+    setWindowTitle(tr("Dissect structure"));
+    resize(700, 600);
+    dissector_->pid(scanner_.pid());
+
+    addressEdit_->setPlaceholderText(tr("Address (hex)"));
+    beforeSpin_->setRange(0, 4096);
+    beforeSpin_->setSingleStep(8);
+    beforeSpin_->setValue(0);
+    beforeSpin_->setSuffix(tr(" bytes"));
+    beforeSpin_->setToolTip(tr("Start the window this far before the address, for when "
+                               "the value isn't the first field"));
+    sizeSpin_->setRange(8, 4096);
+    sizeSpin_->setSingleStep(8);
+    sizeSpin_->setValue(256);
+    sizeSpin_->setSuffix(tr(" bytes"));
+    backButton_->setEnabled(false);
+    auto *goButton = new QPushButton(tr("Go"), this);
+
+    auto *top = new QHBoxLayout();
+    top->addWidget(addressEdit_);
+    top->addWidget(goButton);
+    top->addWidget(backButton_);
+
+    auto *form = new QFormLayout();
+    form->addRow(tr("Address:"), top);
+    form->addRow(tr("Before:"), beforeSpin_);
+    form->addRow(tr("Size:"), sizeSpin_);
+
+    table_->setColumnCount(COLUMN_COUNT);
+    table_->setHorizontalHeaderLabels({tr("Offset"), tr("Address"), tr("Type"), tr("Value")});
+    table_->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    table_->horizontalHeader()->setSectionResizeMode(COLUMN_VALUE, QHeaderView::Stretch);
+    table_->verticalHeader()->setVisible(false);
+    table_->setEditTriggers(QTableWidget::NoEditTriggers);
+    table_->setSelectionBehavior(QTableWidget::SelectRows);
+    table_->setContextMenuPolicy(Qt::CustomContextMenu);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addLayout(form);
+    layout->addWidget(table_);
+    layout->addWidget(status_);
+    setLayout(layout);
+
+    connect(goButton, &QPushButton::clicked, this, &StructDissectorDialog::go);
+    connect(addressEdit_, &QLineEdit::returnPressed, this, &StructDissectorDialog::go);
+    connect(backButton_, &QPushButton::clicked, this, &StructDissectorDialog::back);
+    connect(beforeSpin_, &QSpinBox::valueChanged, this, &StructDissectorDialog::refresh);
+    connect(sizeSpin_, &QSpinBox::valueChanged, this, &StructDissectorDialog::refresh);
+    connect(table_, &QTableWidget::cellDoubleClicked, this, &StructDissectorDialog::follow);
+    connect(table_, &QTableWidget::customContextMenuRequested, this,
+            &StructDissectorDialog::showContextMenu);
+    connect(timer_, &QTimer::timeout, this, &StructDissectorDialog::refresh);
+}
+
+StructDissectorDialog::~StructDissectorDialog() = default;
+
+std::uintptr_t StructDissectorDialog::base() const {
+    const auto before = static_cast<std::uintptr_t>(beforeSpin_->value());
+    return (address_ > before ? address_ - before : 0) & ~static_cast<std::uintptr_t>(7);
+}
+
+void StructDissectorDialog::dissect(std::uintptr_t address) {
+    address_ = address;
+    addressEdit_->setText(QString::number(address, 16));
+    table_->setRowCount(0);
+    refresh();
+    timer_->start(500);
+}
+
+void StructDissectorDialog::go() {
+    bool ok = false;
+    QString text = addressEdit_->text().trimmed();
+    if (text.startsWith("0x", Qt::CaseInsensitive)) {
+        text = text.mid(2);
+    }
+    const std::uintptr_t address = text.toULongLong(&ok, 16);
+    if (!ok) {
+        QMessageBox::warning(this, tr("Invalid address"),
+                             tr("Please enter a hexadecimal address"));
+        return;
+    }
+    trail_.clear();
+    backButton_->setEnabled(false);
+    dissect(address);
+}
+
+void StructDissectorDialog::back() {
+    if (trail_.empty()) {
+        return;
+    }
+    const std::uintptr_t address = trail_.back();
+    trail_.pop_back();
+    backButton_->setEnabled(!trail_.empty());
+    dissect(address);
+}
+
+void StructDissectorDialog::follow(int row) {
+    const auto &fields = dissector_->fields();
+    if (row < 0 || static_cast<std::size_t>(row) >= fields.size()) {
+        return;
+    }
+    const dissected_field &field = fields[static_cast<std::size_t>(row)];
+    if (field.kind != FIELD_POINTER && field.kind != FIELD_STRING_POINTER) {
+        return;
+    }
+    trail_.push_back(address_);
+    backButton_->setEnabled(true);
+    dissect(field.raw);
+}
+
+void StructDissectorDialog::refresh() {
+    if (address_ == 0) {
+        return;
+    }
+    // Pointers are resolved against whatever the scanner last saw, the maps
+    // are re-read on attach and before every scan
+    auto maps = scanner_.maps();
+    const std::uintptr_t start = base();
+    const auto &fields = dissector_->refresh(start, static_cast<std::size_t>(sizeSpin_->value()),
+                                             *maps);
+
+    const int rows = static_cast<int>(fields.size());
+    if (table_->rowCount() != rows) {
+        table_->setRowCount(rows);
+        for (int row = 0; row < rows; ++row) {
+            for (int column = 0; column < COLUMN_COUNT; ++column) {
+                table_->setItem(row, column, new QTableWidgetItem());
+            }
+        }
+    }
+
+    const QBrush normal = palette().brush(QPalette::Text);
+    const QBrush changed = QBrush(QColor::fromRgb(200, 0, 0));
+    std::size_t unreadable = 0;
+    for (int row = 0; row < rows; ++row) {
+        const dissected_field &field = fields[static_cast<std::size_t>(row)];
+        const std::uintptr_t address = start + field.offset;
+        const auto offset = static_cast<long long>(address) - static_cast<long long>(address_);
+        table_->item(row, COLUMN_OFFSET)->setText(
+            offset < 0 ? QString("-0x%1").arg(-offset, 0, 16) : QString("+0x%1").arg(offset, 0, 16));
+        table_->item(row, COLUMN_ADDRESS)->setText(QString("0x%1").arg(address, 0, 16));
+        table_->item(row, COLUMN_TYPE)->setText(field_kind_name(field.kind));
+        table_->item(row, COLUMN_VALUE)->setText(
+            QString::fromStdString(format_field(field, maps->index)));
+        table_->item(row, COLUMN_VALUE)->setForeground(field.age < highlight_refreshes ? changed
+                                                                                       : normal);
+        unreadable += field.kind == FIELD_UNREADABLE;
+    }
+    status_->setText(unreadable == fields.size() ? tr("The address isn't readable")
+                                                 : QString());
+}
+
+void StructDissectorDialog::showContextMenu(const QPoint &pos) {
+    const int row = table_->rowAt(pos.y());
+    const auto &fields = dissector_->fields();
+    if (row < 0 || static_cast<std::size_t>(row) >= fields.size()) {
+        return;
+    }
+    const dissected_field &field = fields[static_cast<std::size_t>(row)];
+    const std::uintptr_t address = base() + field.offset;
+
+    const value_type type = field_value_type(field.kind);
+    const QString description = table_->item(row, COLUMN_OFFSET)->text();
+
+    QMenu menu(this);
+    QAction *save = menu.addAction(tr("Add to saved addresses"));
+    connect(save, &QAction::triggered, this, [this, address, type, description] {
+        emit saveAddress(address, type, description);
+    });
+    if (field.kind == FIELD_POINTER || field.kind == FIELD_STRING_POINTER) {
+        QAction *followAction = menu.addAction(tr("Follow pointer"));
+        connect(followAction, &QAction::triggered, this, [this, row] {
+            follow(row);
+        });
+    }
+    menu.exec(table_->viewport()->mapToGlobal(pos));
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QDialog>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "value_type.h"
+
+class ProcessMemory;
+class QLabel;
+class QLineEdit;
+class QPushButton;
+class QSpinBox;
+class QTableWidget;
+class QTimer;
+class StructDissector;
+
+/**
+ * Live view of the struct around an address as typed by StructDissector.
+ * Pointers can be followed by double clicking them and any field can be
+ * added to the saved addresses.
+ */
+class StructDissectorDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit StructDissectorDialog(ProcessMemory &scanner, QWidget *parent = nullptr);
+    ~StructDissectorDialog() override;
+
+    /** @brief dissect shows the window starting `before` bytes ahead of `address` */
+    void dissect(std::uintptr_t address);
+
+signals:
+    void saveAddress(std::uintptr_t address, value_type type, QString description);
+
+private slots:
+    void go();
+    void back();
+    void refresh();
+    void follow(int row);
+    void showContextMenu(const QPoint &pos);
+
+private:
+    ProcessMemory                       &scanner_;
+    std::unique_ptr<StructDissector>    dissector_;
+    std::uintptr_t                      address_{};
+    /** Addresses dissected before following a pointer */
+    std::vector<std::uintptr_t>         trail_{};
+    QLineEdit                           *addressEdit_;
+    QSpinBox                            *beforeSpin_;
+    QSpinBox                            *sizeSpin_;
+    QPushButton                         *backButton_;
+    QLabel                              *status_;
+    QTableWidget                        *table_;
+    QTimer                              *timer_;
+
+    std::uintptr_t base() const;
+};
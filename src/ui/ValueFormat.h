@@ -0,0 +1,49 @@
+#pragma once
+
+#include <QString>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include "value_type.h"
+
+/**
+ * @brief format_value formats the raw little-endian bytes of a value read
+ * from the target, `raw` holds the value zero-extended to 64 bits
+ */
+inline QString format_value(value_type type, std::uint64_t raw) {
+    return visit_value_type(type, [raw](auto value) {
+        std::memcpy(&value, &raw, sizeof(value));
+        return QString::number(value);
+    });
+}
+
+/**
+ * @brief parse_value parses `text` as `type` into the low bytes of `raw`
+ * @return false if the text isn't a valid value of the type
+ */
+inline bool parse_value(value_type type, const QString &text, std::uint64_t &raw) {
+    return visit_value_type(type, [&text, &raw](auto value) {
+        using T = decltype(value);
+        bool ok = false;
+        if constexpr (std::is_floating_point_v<T>) {
+            value = static_cast<T>(text.toDouble(&ok));
+        } else {
+            const qulonglong parsed = text.toULongLong(&ok, 0);
+            ok = ok && parsed <= std::numeric_limits<T>::max();
+            value = static_cast<T>(parsed);
+        }
+        raw = 0;
+        std::memcpy(&raw, &value, sizeof(value));
+        return ok;
+    });
+}
+
+/**
+ * @brief value_type_name is the name shown in the type comboboxes
+ */
+inline QString value_type_name(value_type type) {
+    static const char *names[] = {"Byte", "2 Bytes", "4 Bytes", "8 Bytes", "Float", "Double"};
+    return type < VALUE_TYPE_COUNT ? QString(names[type]) : QString();
+}
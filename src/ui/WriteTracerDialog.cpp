@@ -0,0 +1,133 @@
+#include "ui/WriteTracerDialog.h"
+#include "ProcessMemory.h"
+#include "WriteTracer.h"
+#include "ui/Disassembly.h"
+
+#include <QHeaderView>
+#include <QLabel>
+#include <QTableWidget>
+#include <QTimer>
+#include <QVBoxLayout>
+
+#include <cstring>
+
+WriteTracerDialog::WriteTracerDialog(ProcessMemory &scanner, void *address,
+                                     std::size_t size, QWidget *parent)
+    : QDialog(parent),
+      scanner_(scanner),
+      address_(address),
+      tracer_(std::make_unique<WriteTracer>()),
+      status_(new QLabel(this)),
+      table_(new QTableWidget(this)),
+      timer_(new QTimer(this))
+{
+    setWindowTitle(tr("Writes to %1").arg(reinterpret_cast<std::uintptr_t>(address), 0, 16));
+    resize(700, 400);
+
+    QFont monoFont("Courier New");
+    monoFont.setStyleHint(QFont::Monospace);
+    table_->setFont(monoFont);
+    table_->setColumnCount(3);
+    table_->setHorizontalHeaderLabels({tr("Count"), tr("Address"), tr("Instruction")});
+    table_->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    table_->horizontalHeader()->setStretchLastSection(true);
+    table_->verticalHeader()->setVisible(false);
+    table_->setEditTriggers(QTableWidget::NoEditTriggers);
+    table_->setSelectionBehavior(QTableWidget::SelectRows);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addWidget(status_);
+    layout->addWidget(table_);
+    setLayout(layout);
+
+    connect(table_, &QTableWidget::cellDoubleClicked, this,
+            [this](int row, int) { showInDisassembler(row); });
+    connect(timer_, &QTimer::timeout, this, &WriteTracerDialog::refresh);
+
+    if (!tracer_->watch(scanner_.pid(), address, size)) {
+        status_->setText(tr("Could not set a watchpoint, the address must be "
+                            "aligned to its size and at most four can be "
+                            "active per thread. Check perf_event_paranoid."));
+        return;
+    }
+    status_->setText(tr("Waiting for writes..."));
+    timer_->start(250);
+}
+
+WriteTracerDialog::~WriteTracerDialog() = default;
+
+std::uintptr_t WriteTracerDialog::findWriter(std::uintptr_t ip, QString &text) const {
+    std::uint8_t code[max_instruction]{};
+    if (!capstone_.ok || ip < max_instruction ||
+        ProcessMemory::read_process_memory_nosplit(scanner_.pid(),
+                                                   reinterpret_cast<void *>(ip - max_instruction),
+                                                   code, sizeof(code)) != sizeof(code)) {
+        return 0;
+    }
+
+    // Try every start that gives one instruction ending exactly at ip,
+    // prefer the shortest one that touches memory
+    std::uintptr_t found = 0;
+    cs_insn *ins = capstone_.insn;
+    for (std::size_t length = 1; length <= max_instruction; ++length) {
+        const std::uint8_t *start = code + max_instruction - length;
+        std::size_t size = length;
+        std::uint64_t address = ip - length;
+        if (cs_disasm_iter(capstone_.handle, &start, &size, &address, ins) && size == 0) {
+            const bool memory = std::strchr(ins->op_str, '[') != nullptr;
+            if (found == 0 || memory) {
+                found = ip - length;
+                text = QString(ins->mnemonic) + " " + QString(ins->op_str);
+            }
+            if (memory) {
+                break;
+            }
+        }
+    }
+    return found;
+}
+
+void WriteTracerDialog::refresh() {
+    std::vector<write_hit> hits = tracer_->hits(address_);
+    auto maps = scanner_.maps();
+
+    table_->setRowCount(int(hits.size()));
+    for (int row = 0; row < int(hits.size()); ++row) {
+        const write_hit &hit = hits[std::size_t(row)];
+        auto it = writers_.find(hit.ip);
+        if (it == writers_.end()) {
+            QString text;
+            std::uintptr_t writer = findWriter(hit.ip, text);
+            if (writer == 0) {
+                writer = hit.ip;
+                text = tr("(instruction before this address)");
+            }
+            it = writers_.emplace(hit.ip, std::make_pair(writer, text)).first;
+        }
+        const auto &[writer, text] = it->second;
+
+        auto *count = new QTableWidgetItem(QString::number(hit.count));
+        count->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        auto *address = new QTableWidgetItem(
+            QString::fromStdString(maps->index.label(writer)));
+        address->setData(Qt::UserRole, QVariant::fromValue<qulonglong>(writer));
+        table_->setItem(row, 0, count);
+        table_->setItem(row, 1, address);
+        table_->setItem(row, 2, new QTableWidgetItem(text));
+    }
+
+    QString status = tr("%1 instructions wrote to the address").arg(hits.size());
+    if (std::uint64_t lost = tracer_->lost(); lost > 0) {
+        status += tr(", %1 samples lost").arg(lost);
+    }
+    status_->setText(status);
+}
+
+void WriteTracerDialog::showInDisassembler(int row) {
+    QTableWidgetItem *item = table_->item(row, 1);
+    if (item == nullptr) {
+        return;
+    }
+    auto *window = new Disassembly(scanner_.pid(), item->data(Qt::UserRole).toULongLong());
+    window->show();
+}
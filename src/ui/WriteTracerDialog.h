@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QDialog>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+#include "X86Code.h"
+
+class ProcessMemory;
+class QLabel;
+class QTableWidget;
+class QTimer;
+class WriteTracer;
+
+/**
+ * Lists the instructions writing to an address, collected with a hardware
+ * watchpoint for as long as the dialog is open. Double clicking a row
+ * opens the disassembler at the writer.
+ */
+class WriteTracerDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    WriteTracerDialog(ProcessMemory &scanner, void *address, std::size_t size,
+                      QWidget *parent = nullptr);
+    ~WriteTracerDialog() override;
+
+private slots:
+    void refresh();
+    void showInDisassembler(int row);
+
+private:
+    ProcessMemory                   &scanner_;
+    void                            *address_;
+    std::unique_ptr<WriteTracer>    tracer_;
+    QLabel                          *status_;
+    QTableWidget                    *table_;
+    QTimer                          *timer_;
+    mutable capstone                capstone_{};
+    /** Decoded writer for every ip seen so far */
+    std::unordered_map<std::uintptr_t, std::pair<std::uintptr_t, QString>> writers_{};
+
+    /**
+     * @brief findWriter finds the instruction ending at `ip`, the watchpoint
+     * reports the instruction after the one that wrote
+     * @return the address of the writer or 0 if it couldn't be decoded
+     */
+    std::uintptr_t findWriter(std::uintptr_t ip, QString &text) const;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+/**
+ * Scalar types the scanner knows how to search for. The order matches the
+ * "Value Type" combobox in the main window so the index can be used directly.
+ */
+enum value_type : std::uint8_t {
+    VALUE_U8 = 0,
+    VALUE_U16,
+    VALUE_U32,
+    VALUE_U64,
+    VALUE_FLOAT,
+    VALUE_DOUBLE,
+    VALUE_TYPE_COUNT
+};
+
+template<typename T>
+constexpr value_type value_type_of() {
+    if constexpr (std::is_same_v<T, std::uint8_t>) {
+        return VALUE_U8;
+    } else if constexpr (std::is_same_v<T, std::uint16_t>) {
+        return VALUE_U16;
+    } else if constexpr (std::is_same_v<T, std::uint32_t>) {
+        return VALUE_U32;
+    } else if constexpr (std::is_same_v<T, std::uint64_t>) {
+        return VALUE_U64;
+    } else if constexpr (std::is_same_v<T, float>) {
+        return VALUE_FLOAT;
+    } else {
+        static_assert(std::is_same_v<T, double>, "unsupported value type");
+        return VALUE_DOUBLE;
+    }
+}
+
+/**
+ * @brief visit_value_type calls `f` with a value-initialised object of the
+ * C++ type matching `type`, e.g. visit_value_type(VALUE_U32, f) calls
+ * f(std::uint32_t{})
+ */
+template<typename F>
+decltype(auto) visit_value_type(value_type type, F &&f) {
+    switch (type) {
+    case VALUE_U8:
+        return std::forward<F>(f)(std::uint8_t{});
+    case VALUE_U16:
+        return std::forward<F>(f)(std::uint16_t{});
+    case VALUE_U32:
+        return std::forward<F>(f)(std::uint32_t{});
+    case VALUE_U64:
+        return std::forward<F>(f)(std::uint64_t{});
+    case VALUE_FLOAT:
+        return std::forward<F>(f)(float{});
+    case VALUE_DOUBLE:
+    default:
+        return std::forward<F>(f)(double{});
+    }
+}
+
+constexpr std::size_t value_type_size(value_type type) {
+    constexpr std::size_t sizes[] = {1, 2, 4, 8, sizeof(float), sizeof(double)};
+    return type < VALUE_TYPE_COUNT ? sizes[type] : 0;
+}